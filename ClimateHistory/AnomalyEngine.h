@@ -0,0 +1,343 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateTable.h"
+#include <map>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// monthly temperature anomalies computed in two passes over the month
+// columns of a climate table:
+//
+//	1. the baseline of every station and calendar month is the mean of its
+//	   valid readings over the reference period (at least MinimumYears of
+//	   them), computed once and kept until the period changes
+//
+//	2. every valid reading of a station with a baseline is replaced by its
+//	   departure from the baseline and the departures are summed by year
+//
+// Absolute means shift whenever the mix of reporting stations changes,
+// departures from each station's own climate do not. Each measurement type
+// lives in its own blocks so the types are processed in parallel.
+class CAnomalyEngine
+{
+// public definitions
+public:
+	// sum of the departures of a year and the number of readings summed
+	typedef pair<double, int> ANOMALY_SUM;
+
+// protected data
+protected:
+	// first year of the reference period (inclusive)
+	int m_nFirstYear;
+
+	// last year of the reference period (inclusive)
+	int m_nLastYear;
+
+	// fewest readings of a calendar month needed for a baseline
+	int m_nMinimumYears;
+
+	// reference period and station count the baselines were computed for
+	int m_nBaselineFirst;
+	int m_nBaselineLast;
+	int m_nBaselineStations;
+
+	// baselines indexed by measurement type then station index * 12 +
+	// month (degrees centigrade or missing)
+	vector<float> m_arrBaselines[ 4 ];
+
+	// departures summed by year indexed by measurement type
+	map<int, ANOMALY_SUM> m_mapAnomalies[ 4 ];
+
+	// were the anomalies computed?
+	bool m_bComputed;
+
+// public properties
+public:
+	// first year of the reference period (inclusive)
+	inline int GetFirstYear()
+	{
+		return m_nFirstYear;
+	}
+	// first year of the reference period (inclusive)
+	inline void SetFirstYear( int value )
+	{
+		m_nFirstYear = value;
+	}
+	// first year of the reference period (inclusive)
+	__declspec( property( get = GetFirstYear, put = SetFirstYear ) )
+		int FirstYear;
+
+	// last year of the reference period (inclusive)
+	inline int GetLastYear()
+	{
+		return m_nLastYear;
+	}
+	// last year of the reference period (inclusive)
+	inline void SetLastYear( int value )
+	{
+		m_nLastYear = value;
+	}
+	// last year of the reference period (inclusive)
+	__declspec( property( get = GetLastYear, put = SetLastYear ) )
+		int LastYear;
+
+	// fewest readings of a calendar month needed for a baseline
+	inline int GetMinimumYears()
+	{
+		return m_nMinimumYears;
+	}
+	// fewest readings of a calendar month needed for a baseline
+	inline void SetMinimumYears( int value )
+	{
+		m_nMinimumYears = value;
+	}
+	// fewest readings of a calendar month needed for a baseline
+	__declspec( property( get = GetMinimumYears, put = SetMinimumYears ) )
+		int MinimumYears;
+
+	// were the anomalies computed?
+	inline bool GetComputed()
+	{
+		return m_bComputed;
+	}
+	// were the anomalies computed?
+	__declspec( property( get = GetComputed ) )
+		bool Computed;
+
+// protected methods
+protected:
+	// pass one for a single measurement type
+	void ComputeBaselines
+	(
+		CClimateTable& table, CClimateTemperature::MEASURE_TYPE eType,
+		int nStations
+	)
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		const float fFirst = float( FirstYear );
+		const float fLast = float( LastYear );
+
+		vector<double> sums( nStations * 12, 0.0 );
+		vector<int> counts( nStations * 12, 0 );
+
+		// first accumulator of each row of a block within the reference
+		// period or -1
+		vector<int> bases;
+
+		for ( auto& block : table.Blocks )
+		{
+			// blocks outside the reference period are skipped whole
+			if ( block->MeasurementType != eType ||
+				!block->YearZone.CanContain( fFirst, fLast ))
+			{
+				continue;
+			}
+
+			const int nRows = block->Rows;
+			bases.assign( nRows, -1 );
+			for ( int row = 0; row < nRows; row++ )
+			{
+				const int nYear = block->Year[ row ];
+				const int nStation = block->StationIndex[ row ];
+				if ( nYear >= FirstYear && nYear <= LastYear &&
+					nStation >= 0 && nStation < nStations )
+				{
+					bases[ row ] = nStation * 12;
+				}
+			}
+
+			// one contiguous month column at a time
+			for ( int nMonth = 0; nMonth < 12; nMonth++ )
+			{
+				const float* pValues = block->GetMonthColumn( nMonth );
+				for ( int row = 0; row < nRows; row++ )
+				{
+					// valid readings are all far above the missing value
+					if ( bases[ row ] != -1 && pValues[ row ] > fMissing )
+					{
+						sums[ bases[ row ] + nMonth ] += pValues[ row ];
+						counts[ bases[ row ] + nMonth ]++;
+					}
+				}
+			}
+		}
+
+		vector<float>& baselines = m_arrBaselines[ eType ];
+		baselines.assign( nStations * 12, fMissing );
+		for ( int n = 0; n < nStations * 12; n++ )
+		{
+			if ( counts[ n ] >= MinimumYears && counts[ n ] > 0 )
+			{
+				baselines[ n ] = float( sums[ n ] / counts[ n ] );
+			}
+		}
+	}
+
+	// pass two for a single measurement type
+	void ComputeAnomalies
+	(
+		CClimateTable& table, CClimateTemperature::MEASURE_TYPE eType
+	)
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		vector<float>& baselines = m_arrBaselines[ eType ];
+		const int nBaselines = (int)baselines.size();
+		map<int, ANOMALY_SUM>& anomalies = m_mapAnomalies[ eType ];
+		anomalies.clear();
+
+		// departures of each row of a block summed across its months
+		vector<double> sums;
+		vector<int> counts;
+		vector<int> bases;
+
+		for ( auto& block : table.Blocks )
+		{
+			if ( block->MeasurementType != eType )
+			{
+				continue;
+			}
+
+			const int nRows = block->Rows;
+			sums.assign( nRows, 0.0 );
+			counts.assign( nRows, 0 );
+			bases.assign( nRows, -1 );
+			for ( int row = 0; row < nRows; row++ )
+			{
+				const int nBase = block->StationIndex[ row ] * 12;
+				if ( nBase >= 0 && nBase < nBaselines )
+				{
+					bases[ row ] = nBase;
+				}
+			}
+
+			// one contiguous month column at a time
+			for ( int nMonth = 0; nMonth < 12; nMonth++ )
+			{
+				const float* pValues = block->GetMonthColumn( nMonth );
+				for ( int row = 0; row < nRows; row++ )
+				{
+					if ( bases[ row ] == -1 )
+					{
+						continue;
+					}
+
+					const float fBaseline = baselines[ bases[ row ] + nMonth ];
+					if ( pValues[ row ] > fMissing && fBaseline > fMissing )
+					{
+						sums[ row ] += pValues[ row ] - fBaseline;
+						counts[ row ]++;
+					}
+				}
+			}
+
+			for ( int row = 0; row < nRows; row++ )
+			{
+				if ( counts[ row ] > 0 )
+				{
+					ANOMALY_SUM& sum = anomalies[ block->Year[ row ]];
+					sum.first += sums[ row ];
+					sum.second += counts[ row ];
+				}
+			}
+		}
+	}
+
+// public methods
+public:
+	// compute the baselines (unless they are cached for the reference
+	// period) and the yearly anomalies of every measurement type
+	void Compute( CClimateTable& table, int nStations )
+	{
+		const bool bCached =
+			m_nBaselineFirst == FirstYear && m_nBaselineLast == LastYear &&
+			m_nBaselineStations == nStations;
+
+		concurrency::parallel_for
+		(
+			int( CClimateTemperature::mtMaximum ),
+			int( CClimateTemperature::mtAverage ) + 1,
+			[&]( int nType )
+			{
+				const CClimateTemperature::MEASURE_TYPE eType =
+					CClimateTemperature::MEASURE_TYPE( nType );
+				if ( !bCached )
+				{
+					ComputeBaselines( table, eType, nStations );
+				}
+				ComputeAnomalies( table, eType );
+			}
+		);
+
+		m_nBaselineFirst = FirstYear;
+		m_nBaselineLast = LastYear;
+		m_nBaselineStations = nStations;
+		m_bComputed = true;
+	}
+
+	// baseline of a station index and month (0 to 11) in degrees
+	// centigrade or missing
+	float GetBaseline
+	(
+		CClimateTemperature::MEASURE_TYPE eType, int nStation, int nMonth
+	)
+	{
+		vector<float>& baselines = m_arrBaselines[ eType ];
+		const int n = nStation * 12 + nMonth;
+		if ( nStation < 0 || n >= (int)baselines.size() )
+		{
+			return CClimateTemperature::GetMissingValue();
+		}
+
+		return baselines[ n ];
+	}
+
+	// mean departure in degrees centigrade of the readings of a year or
+	// missing, the number of readings is returned in nReadings
+	float GetAnomaly
+	(
+		CClimateTemperature::MEASURE_TYPE eType, int nYear, int& nReadings
+	)
+	{
+		nReadings = 0;
+		map<int, ANOMALY_SUM>& anomalies = m_mapAnomalies[ eType ];
+		auto pos = anomalies.find( nYear );
+		if ( pos == anomalies.end() || pos->second.second == 0 )
+		{
+			return CClimateTemperature::GetMissingValue();
+		}
+
+		nReadings = pos->second.second;
+		return float( pos->second.first / pos->second.second );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CAnomalyEngine()
+	{
+		FirstYear = 1951;
+		LastYear = 1980;
+		MinimumYears = 10;
+		m_nBaselineFirst = 0;
+		m_nBaselineLast = 0;
+		m_nBaselineStations = -1;
+		m_bComputed = false;
+	}
+
+	// destructor
+	~CAnomalyEngine()
+	{
+	}
+};
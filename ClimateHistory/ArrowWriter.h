@@ -0,0 +1,580 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include "FlatBuilder.h"
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// Apache Arrow IPC file (Feather version 2) written without the Arrow
+// library. The layout follows the Arrow columnar format specification:
+//
+//	"ARROW1" and two bytes of padding
+//	schema message
+//	dictionary batch messages
+//	record batch messages
+//	end of stream marker
+//	footer (the schema again and the file positions of every batch)
+//	footer size (int32) and "ARROW1"
+//
+// Each message is 0xFFFFFFFF, the size of its FlatBuffers metadata, the
+// metadata padded to 8 bytes, and a body holding the column buffers, each
+// padded to 8 bytes. A column's buffers are a validity bitmap (left empty
+// when nothing is missing) followed by its values, or by 32-bit offsets
+// and the characters for strings. The values are written straight from the
+// caller's arrays so a reader can memory map the file and use the columns
+// in place.
+class CArrowWriter
+{
+// public definitions
+public:
+	// column types that can be written
+	typedef enum
+	{
+		atInt32,
+		atFloat32,
+		atUtf8,
+
+	} ARROW_TYPE;
+
+	// a field of the schema
+	typedef struct tagARROW_FIELD
+	{
+		CString Name;
+
+		// value type, a dictionary encoded field has atUtf8 values and
+		// 32-bit indexes in its batches
+		ARROW_TYPE Type;
+
+		bool Nullable;
+
+		// dictionary ID or -1 if the field is not dictionary encoded
+		LONGLONG Dictionary;
+
+	} ARROW_FIELD;
+
+	// the buffers of one column of a record batch
+	typedef struct tagARROW_COLUMN
+	{
+		// number of null values
+		LONGLONG NullCount;
+
+		// validity bitmap or nullptr if nothing is null
+		const BYTE* Validity;
+
+		// 32-bit offsets of a string column (nullptr otherwise)
+		const BYTE* Offsets;
+
+		// values (or string characters) and their size in bytes
+		const BYTE* Values;
+		ULONGLONG ValueBytes;
+
+	} ARROW_COLUMN;
+
+	// file position of a message for the footer
+	typedef struct tagARROW_BLOCK
+	{
+		LONGLONG Offset;
+		int MetadataLength;
+		int Padding;
+		LONGLONG BodyLength;
+
+	} ARROW_BLOCK;
+
+	// Arrow metadata version V5, whose value in the MetadataVersion enum
+	// of Schema.fbs is 4
+	enum { METADATA_VERSION = 4 };
+
+	// message header and type union members
+	enum
+	{
+		MESSAGE_SCHEMA = 1,
+		MESSAGE_DICTIONARY = 2,
+		MESSAGE_RECORD_BATCH = 3,
+		TYPE_INT = 2,
+		TYPE_FLOATING_POINT = 3,
+		TYPE_UTF8 = 5,
+	};
+
+// protected data
+protected:
+	// output file
+	CFile m_file;
+
+	// is the file open?
+	bool m_bOpen;
+
+	// current position in the file
+	ULONGLONG m_ullPosition;
+
+	// fields of the schema
+	vector<ARROW_FIELD> m_arrFields;
+
+	// dictionary batches and record batches written
+	vector<ARROW_BLOCK> m_arrDictionaries;
+	vector<ARROW_BLOCK> m_arrBatches;
+
+	// rows written in record batches
+	LONGLONG m_llRows;
+
+// public properties
+public:
+	// is the file open?
+	inline bool GetOpen()
+	{
+		return m_bOpen;
+	}
+	// is the file open?
+	__declspec( property( get = GetOpen ) )
+		bool Open;
+
+	// rows written in record batches
+	inline LONGLONG GetRows()
+	{
+		return m_llRows;
+	}
+	// rows written in record batches
+	__declspec( property( get = GetRows ) )
+		LONGLONG Rows;
+
+	// size of the file so far
+	inline ULONGLONG GetBytes()
+	{
+		return m_ullPosition;
+	}
+	// size of the file so far
+	__declspec( property( get = GetBytes ) )
+		ULONGLONG Bytes;
+
+// protected methods
+protected:
+	// write bytes and advance the position
+	void Write( const void* pData, ULONGLONG ullBytes )
+	{
+		const BYTE* pBytes = (const BYTE*)pData;
+		while ( ullBytes > 0 )
+		{
+			const UINT nBytes =
+				ullBytes > 0x40000000 ? 0x40000000 : UINT( ullBytes );
+			m_file.Write( pBytes, nBytes );
+			pBytes += nBytes;
+			ullBytes -= nBytes;
+			m_ullPosition += nBytes;
+		}
+	}
+
+	// write zeros up to the next multiple of 8 bytes
+	void Align()
+	{
+		static const BYTE zeros[ 8 ] = { 0 };
+		const ULONGLONG ullPad = GetPadding( m_ullPosition );
+		if ( ullPad > 0 )
+		{
+			Write( zeros, ullPad );
+		}
+	}
+
+	// bytes needed to pad a size to a multiple of 8
+	static inline ULONGLONG GetPadding( ULONGLONG ullBytes )
+	{
+		return ( 8 - ullBytes % 8 ) % 8;
+	}
+
+	// write a type table and return its offset
+	static UINT BuildType( CFlatBuilder& builder, ARROW_TYPE eType )
+	{
+		builder.StartTable();
+		switch ( eType )
+		{
+			case atInt32:
+			{
+				builder.AddScalar<int>( 0, 32 ); // bitWidth
+				builder.AddScalar<BYTE>( 1, 1 ); // is_signed
+				break;
+			}
+			case atFloat32:
+			{
+				builder.AddScalar<short>( 0, 1 ); // precision SINGLE
+				break;
+			}
+			default: // Utf8 has no fields
+			{
+				break;
+			}
+		}
+		return builder.EndTable();
+	}
+
+	// type union member of a type
+	static inline BYTE GetTypeType( ARROW_TYPE eType )
+	{
+		switch ( eType )
+		{
+			case atInt32: return TYPE_INT;
+			case atFloat32: return TYPE_FLOATING_POINT;
+			default: return TYPE_UTF8;
+		}
+	}
+
+	// write the schema table and return its offset
+	UINT BuildSchema( CFlatBuilder& builder )
+	{
+		vector<UINT> fields;
+		for ( auto& field : m_arrFields )
+		{
+			const CStringA csName( field.Name );
+			const UINT nName = builder.CreateString( csName, csName.GetLength() );
+			const UINT nType = BuildType( builder, field.Type );
+
+			UINT nDictionary = 0;
+			if ( field.Dictionary != -1 )
+			{
+				const UINT nIndex = BuildType( builder, atInt32 );
+				builder.StartTable();
+				builder.AddScalar<LONGLONG>( 0, field.Dictionary ); // id
+				builder.AddOffset( 1, nIndex ); // indexType
+				builder.AddScalar<BYTE>( 2, 0 ); // isOrdered
+				nDictionary = builder.EndTable();
+			}
+
+			const UINT nChildren = builder.CreateOffsets( vector<UINT>() );
+
+			builder.StartTable();
+			builder.AddOffset( 0, nName );
+			builder.AddScalar<BYTE>( 1, field.Nullable ? 1 : 0 );
+			builder.AddScalar<BYTE>( 2, GetTypeType( field.Type ));
+			builder.AddOffset( 3, nType );
+			if ( nDictionary != 0 )
+			{
+				builder.AddOffset( 4, nDictionary );
+			}
+			builder.AddOffset( 5, nChildren );
+			fields.push_back( builder.EndTable() );
+		}
+
+		const UINT nFields = builder.CreateOffsets( fields );
+		builder.StartTable();
+		builder.AddScalar<short>( 0, 0 ); // little endian
+		builder.AddOffset( 1, nFields );
+		return builder.EndTable();
+	}
+
+	// write a record batch table for the given columns and return its
+	// offset, the buffer positions within the body are returned in
+	// buffers and the size of the body in llBody
+	static UINT BuildRecordBatch
+	(
+		CFlatBuilder& builder, LONGLONG llRows, vector<ARROW_COLUMN>& columns,
+		vector<LONGLONG>& buffers, LONGLONG& llBody
+	)
+	{
+		// FieldNode { length, null_count }
+		vector<LONGLONG> nodes;
+		llBody = 0;
+		buffers.clear();
+		for ( auto& column : columns )
+		{
+			nodes.push_back( llRows );
+			nodes.push_back( column.NullCount );
+
+			// Buffer { offset, length } of the validity bitmap
+			const LONGLONG llValidity =
+				column.Validity == nullptr ? 0 : ( llRows + 7 ) / 8;
+			buffers.push_back( llBody );
+			buffers.push_back( llValidity );
+			llBody += llValidity + GetPadding( llValidity );
+
+			if ( column.Offsets != nullptr )
+			{
+				const LONGLONG llOffsets = ( llRows + 1 ) * sizeof( int );
+				buffers.push_back( llBody );
+				buffers.push_back( llOffsets );
+				llBody += llOffsets + GetPadding( llOffsets );
+			}
+
+			buffers.push_back( llBody );
+			buffers.push_back( column.ValueBytes );
+			llBody += column.ValueBytes + GetPadding( column.ValueBytes );
+		}
+
+		const UINT nNodes = builder.CreateVector
+		(
+			nodes.data(), UINT( nodes.size() / 2 ), 2 * sizeof( LONGLONG ),
+			sizeof( LONGLONG )
+		);
+		const UINT nBuffers = builder.CreateVector
+		(
+			buffers.data(), UINT( buffers.size() / 2 ), 2 * sizeof( LONGLONG ),
+			sizeof( LONGLONG )
+		);
+
+		builder.StartTable();
+		builder.AddScalar<LONGLONG>( 0, llRows );
+		builder.AddOffset( 1, nNodes );
+		builder.AddOffset( 2, nBuffers );
+		return builder.EndTable();
+	}
+
+	// write a message with its metadata and body and return its block
+	ARROW_BLOCK WriteMessage
+	(
+		CFlatBuilder& builder, BYTE nHeaderType, UINT nHeader, LONGLONG llBody,
+		vector<ARROW_COLUMN>* pColumns, LONGLONG llRows
+	)
+	{
+		builder.StartTable();
+		builder.AddScalar<short>( 0, METADATA_VERSION );
+		builder.AddScalar<BYTE>( 1, nHeaderType );
+		builder.AddOffset( 2, nHeader );
+		builder.AddScalar<LONGLONG>( 3, llBody );
+		builder.Finish( builder.EndTable() );
+
+		ARROW_BLOCK block;
+		block.Offset = LONGLONG( m_ullPosition );
+		block.Padding = 0;
+		block.BodyLength = llBody;
+
+		const UINT nMetadata = builder.GetSize();
+		const int nLength = int( nMetadata + GetPadding( nMetadata ));
+		const UINT nContinuation = 0xFFFFFFFF;
+		Write( &nContinuation, sizeof( nContinuation ));
+		Write( &nLength, sizeof( nLength ));
+		Write( builder.GetData(), nMetadata );
+		Align();
+		block.MetadataLength = int( m_ullPosition - block.Offset );
+
+		if ( pColumns != nullptr )
+		{
+			for ( auto& column : *pColumns )
+			{
+				if ( column.Validity != nullptr )
+				{
+					Write( column.Validity, ( llRows + 7 ) / 8 );
+					Align();
+				}
+				if ( column.Offsets != nullptr )
+				{
+					Write( column.Offsets, ( llRows + 1 ) * sizeof( int ));
+					Align();
+				}
+				Write( column.Values, column.ValueBytes );
+				Align();
+			}
+		}
+
+		return block;
+	}
+
+	// write a block vector for the footer and return its offset
+	static UINT BuildBlocks( CFlatBuilder& builder, vector<ARROW_BLOCK>& blocks )
+	{
+		return builder.CreateVector
+		(
+			blocks.data(), (UINT)blocks.size(), sizeof( ARROW_BLOCK ),
+			sizeof( LONGLONG )
+		);
+	}
+
+// public methods
+public:
+	// add a field to the schema before the file is created
+	void AddField
+	(
+		LPCTSTR name, ARROW_TYPE eType, bool bNullable, LONGLONG llDictionary = -1
+	)
+	{
+		ARROW_FIELD field;
+		field.Name = name;
+		field.Type = eType;
+		field.Nullable = bNullable;
+		field.Dictionary = llDictionary;
+		m_arrFields.push_back( field );
+	}
+
+	// create the file and write the schema
+	bool Create( LPCTSTR pathname )
+	{
+		if ( !m_file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+		m_bOpen = true;
+		m_ullPosition = 0;
+		m_llRows = 0;
+		m_arrDictionaries.clear();
+		m_arrBatches.clear();
+
+		const char magic[ 8 ] = { 'A', 'R', 'R', 'O', 'W', '1', 0, 0 };
+		Write( magic, sizeof( magic ));
+
+		CFlatBuilder builder;
+		const UINT nSchema = BuildSchema( builder );
+		WriteMessage( builder, MESSAGE_SCHEMA, nSchema, 0, nullptr, 0 );
+
+		return true;
+	}
+
+	// write the string values of a dictionary
+	void WriteDictionary( LONGLONG llDictionary, vector<CString>& values )
+	{
+		vector<int> offsets( 1, 0 );
+		vector<char> characters;
+		for ( auto& value : values )
+		{
+			const CStringA csValue( value );
+			characters.insert
+			(
+				characters.end(),
+				(LPCSTR)csValue, (LPCSTR)csValue + csValue.GetLength()
+			);
+			offsets.push_back( (int)characters.size() );
+		}
+
+		ARROW_COLUMN column;
+		column.NullCount = 0;
+		column.Validity = nullptr;
+		column.Offsets = (const BYTE*)offsets.data();
+		column.Values = (const BYTE*)characters.data();
+		column.ValueBytes = characters.size();
+		vector<ARROW_COLUMN> columns( 1, column );
+
+		const LONGLONG llRows = (LONGLONG)values.size();
+		CFlatBuilder builder;
+		vector<LONGLONG> buffers;
+		LONGLONG llBody = 0;
+		const UINT nBatch =
+			BuildRecordBatch( builder, llRows, columns, buffers, llBody );
+
+		builder.StartTable();
+		builder.AddScalar<LONGLONG>( 0, llDictionary ); // id
+		builder.AddOffset( 1, nBatch ); // data
+		builder.AddScalar<BYTE>( 2, 0 ); // isDelta
+		const UINT nDictionary = builder.EndTable();
+
+		m_arrDictionaries.push_back
+		(
+			WriteMessage
+			(
+				builder, MESSAGE_DICTIONARY, nDictionary, llBody, &columns, llRows
+			)
+		);
+	}
+
+	// write a record batch with one column per field of the schema
+	void WriteBatch( LONGLONG llRows, vector<ARROW_COLUMN>& columns )
+	{
+		CFlatBuilder builder;
+		vector<LONGLONG> buffers;
+		LONGLONG llBody = 0;
+		const UINT nBatch =
+			BuildRecordBatch( builder, llRows, columns, buffers, llBody );
+
+		m_arrBatches.push_back
+		(
+			WriteMessage
+			(
+				builder, MESSAGE_RECORD_BATCH, nBatch, llBody, &columns, llRows
+			)
+		);
+		m_llRows += llRows;
+	}
+
+	// write the end of stream marker, the footer and close the file
+	void Close()
+	{
+		if ( !m_bOpen )
+		{
+			return;
+		}
+
+		const UINT nEnd[ 2 ] = { 0xFFFFFFFF, 0 };
+		Write( nEnd, sizeof( nEnd ));
+
+		CFlatBuilder builder;
+		const UINT nSchema = BuildSchema( builder );
+		const UINT nDictionaries = BuildBlocks( builder, m_arrDictionaries );
+		const UINT nBatches = BuildBlocks( builder, m_arrBatches );
+		builder.StartTable();
+		builder.AddScalar<short>( 0, METADATA_VERSION );
+		builder.AddOffset( 1, nSchema );
+		builder.AddOffset( 2, nDictionaries );
+		builder.AddOffset( 3, nBatches );
+		builder.Finish( builder.EndTable() );
+
+		const int nFooter = (int)builder.GetSize();
+		Write( builder.GetData(), nFooter );
+		Write( &nFooter, sizeof( nFooter ));
+		Write( "ARROW1", 6 );
+
+		m_file.Close();
+		m_bOpen = false;
+	}
+
+	// fill a validity bitmap for the values that are not missing and
+	// return the number of missing values
+	static LONGLONG GetValidity
+	(
+		const float* pValues, int nRows, float fMissing, vector<BYTE>& bits
+	)
+	{
+		LONGLONG value = 0;
+		bits.assign(( nRows + 7 ) / 8, 0 );
+		for ( int row = 0; row < nRows; row++ )
+		{
+			if ( CHelper::NearlyEqual( pValues[ row ], fMissing ))
+			{
+				value++;
+
+			} else
+			{
+				bits[ row / 8 ] |= BYTE( 1 << ( row % 8 ));
+			}
+		}
+
+		return value;
+	}
+
+	// a column of fixed width values, the validity bitmap (if any) and
+	// values must stay in place until the batch is written
+	static ARROW_COLUMN GetColumn
+	(
+		const void* pValues, ULONGLONG ullBytes, vector<BYTE>* pValidity = nullptr,
+		LONGLONG llNullCount = 0
+	)
+	{
+		ARROW_COLUMN value;
+		value.NullCount = llNullCount;
+		value.Validity =
+			pValidity == nullptr || llNullCount == 0 ? nullptr : pValidity->data();
+		value.Offsets = nullptr;
+		value.Values = (const BYTE*)pValues;
+		value.ValueBytes = ullBytes;
+		return value;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CArrowWriter()
+	{
+		m_bOpen = false;
+		m_ullPosition = 0;
+		m_llRows = 0;
+	}
+
+	// destructor
+	~CArrowWriter()
+	{
+		Close();
+	}
+};
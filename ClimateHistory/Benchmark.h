@@ -0,0 +1,241 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <concrt.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// times the phases of a run with the performance counter at several
+// thread counts. A scheduler limited to the thread count is attached to
+// the calling thread between Begin and End so every parallel_for of the
+// phases runs on at most that many threads. Each phase reports the number
+// of lines and bytes it processed so the results can be compared as
+// throughput, and the results are written as JSON so runs on different
+// machines or builds can be compared.
+class CBenchmark
+{
+// public definitions
+public:
+	// lines and bytes processed by a phase
+	typedef pair<LONGLONG, LONGLONG> PHASE_VOLUME;
+
+	// one timed phase
+	typedef struct tagBENCHMARK_RESULT
+	{
+		// name of the phase (i.e. parse)
+		CString Phase;
+
+		// maximum number of threads
+		int Threads;
+
+		// elapsed time
+		double Milliseconds;
+
+		// number of lines processed
+		LONGLONG Lines;
+
+		// number of bytes processed
+		LONGLONG Bytes;
+
+	} BENCHMARK_RESULT;
+
+// protected data
+protected:
+	// timed phases in the order they ran
+	vector<BENCHMARK_RESULT> m_arrResults;
+
+	// thread count of the current scheduler (0 if none is attached)
+	int m_nThreads;
+
+// public properties
+public:
+	// number of timed phases
+	inline int GetCount()
+	{
+		return (int)m_arrResults.size();
+	}
+	// number of timed phases
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+	// timed phase by index
+	inline BENCHMARK_RESULT& GetResult( int index )
+	{
+		return m_arrResults[ index ];
+	}
+	// timed phase by index
+	__declspec( property( get = GetResult ) )
+		BENCHMARK_RESULT Result[];
+
+	// thread count of the current scheduler (0 if none is attached)
+	inline int GetThreads()
+	{
+		return m_nThreads;
+	}
+	// thread count of the current scheduler (0 if none is attached)
+	__declspec( property( get = GetThreads ) )
+		int Threads;
+
+// protected methods
+protected:
+	// lines per second of a result
+	static inline double GetLinesPerSecond( const BENCHMARK_RESULT& result )
+	{
+		return result.Milliseconds <= 0.0 ?
+			0.0 : result.Lines * 1000.0 / result.Milliseconds;
+	}
+
+	// megabytes per second of a result
+	static inline double GetMegabytesPerSecond( const BENCHMARK_RESULT& result )
+	{
+		return result.Milliseconds <= 0.0 ?
+			0.0 : result.Bytes * 1000.0 / ( result.Milliseconds * 1048576.0 );
+	}
+
+// public methods
+public:
+	// the thread counts to measure: the powers of two below the number
+	// of processors and the number of processors
+	static void GetThreadCounts( vector<int>& counts )
+	{
+		counts.clear();
+		const int nProcessors = max( 1, int( concurrency::GetProcessorCount() ));
+		for ( int nThreads = 1; nThreads < nProcessors; nThreads *= 2 )
+		{
+			counts.push_back( nThreads );
+		}
+		counts.push_back( nProcessors );
+	}
+
+	// limit the parallel work of the calling thread to the thread count
+	void Begin( int nThreads )
+	{
+		End();
+
+		concurrency::SchedulerPolicy policy
+		(
+			2,
+			concurrency::MinConcurrency, nThreads,
+			concurrency::MaxConcurrency, nThreads
+		);
+		concurrency::CurrentScheduler::Create( policy );
+		m_nThreads = nThreads;
+	}
+
+	// return the calling thread to the default scheduler
+	void End()
+	{
+		if ( m_nThreads != 0 )
+		{
+			concurrency::CurrentScheduler::Detach();
+			m_nThreads = 0;
+		}
+	}
+
+	// add a phase timed elsewhere (i.e. the phase totals of the run
+	// statistics) in performance counter ticks
+	BENCHMARK_RESULT& Add( LPCTSTR phase, LONGLONG llTicks, PHASE_VOLUME volume )
+	{
+		LARGE_INTEGER frequency;
+		::QueryPerformanceFrequency( &frequency );
+
+		BENCHMARK_RESULT result;
+		result.Phase = phase;
+		result.Threads = m_nThreads;
+		result.Milliseconds = llTicks * 1000.0 / frequency.QuadPart;
+		result.Lines = volume.first;
+		result.Bytes = volume.second;
+		m_arrResults.push_back( result );
+
+		return m_arrResults.back();
+	}
+
+	// time a phase, which returns the lines and bytes it processed
+	template <class PHASE> BENCHMARK_RESULT& Time( LPCTSTR phase, PHASE function )
+	{
+		const LONGLONG llStart = CHelper::GetTicks();
+		const PHASE_VOLUME volume = function();
+		const LONGLONG llTicks = CHelper::GetTicks() - llStart;
+
+		return Add( phase, llTicks, volume );
+	}
+
+	// one line describing a result
+	CString GetReport( const BENCHMARK_RESULT& result )
+	{
+		CString value;
+		value.Format
+		(
+			_T( "%-20s %3d threads %10.1f ms %12.0f lines/s %9.1f MB/s\n" ),
+			result.Phase, result.Threads, result.Milliseconds,
+			GetLinesPerSecond( result ), GetMegabytesPerSecond( result )
+		);
+		return value;
+	}
+
+	// write the results and a description of the data as JSON
+	bool Write( LPCTSTR pathname, LPCTSTR dataset )
+	{
+		CStdioFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+
+		CString csText;
+		csText.Format
+		(
+			_T( "{\n  \"dataset\": %s,\n  \"processors\": %d,\n  \"results\": [" ),
+			CHelper::GetJsonString( dataset ), int( concurrency::GetProcessorCount() )
+		);
+		file.WriteString( csText );
+
+		const int nResults = Count;
+		for ( int index = 0; index < nResults; index++ )
+		{
+			const BENCHMARK_RESULT& result = m_arrResults[ index ];
+			csText.Format
+			(
+				_T( "%s\n    { \"phase\": %s, \"threads\": %d, " )
+				_T( "\"milliseconds\": %0.3f, \"lines\": %I64d, \"bytes\": %I64d, " )
+				_T( "\"lines_per_second\": %0.1f, \"mb_per_second\": %0.3f }" ),
+				index == 0 ? _T( "" ) : _T( "," ),
+				CHelper::GetJsonString( result.Phase ), result.Threads,
+				result.Milliseconds, result.Lines, result.Bytes,
+				GetLinesPerSecond( result ), GetMegabytesPerSecond( result )
+			);
+			file.WriteString( csText );
+		}
+
+		file.WriteString( _T( "\n  ]\n}\n" ) );
+		file.Close();
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CBenchmark()
+	{
+		m_nThreads = 0;
+	}
+
+	// destructor
+	~CBenchmark()
+	{
+		End();
+	}
+};
@@ -737,6 +737,61 @@ public:
 		return csGuid;
 	};
 
+	/////////////////////////////////////////////////////////////////////////////
+	// current performance counter
+	static inline LONGLONG GetTicks()
+	{
+		LARGE_INTEGER value;
+		::QueryPerformanceCounter( &value );
+		return value.QuadPart;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// text as a JSON string with its backslashes and double quotes escaped
+	static CString GetJsonString( LPCTSTR text )
+	{
+		CString value( _T( "\"" ));
+		for ( LPCTSTR p = text; *p != 0; p++ )
+		{
+			if ( *p == _T( '\\' ) || *p == _T( '"' ))
+			{
+				value += _T( '\\' );
+			}
+			value += *p;
+		}
+		value += _T( "\"" );
+		return value;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// the block of the calling thread that belongs to an owner (i.e. the
+	// run statistics or the trace), found again through a thread local
+	// cache so only the first call of a thread calls create to add one. An
+	// owner changes its generation when it discards its blocks so the
+	// pointers cached by the threads are not used again.
+	template <class T, class CREATE> static inline T* GetThreadBlock
+	(
+		const void* pOwner, int nGeneration, CREATE create
+	)
+	{
+		struct THREAD_CACHE
+		{
+			const void* Owner;
+			int Generation;
+			T* Block;
+		};
+		static thread_local THREAD_CACHE cache = { nullptr, 0, nullptr };
+		if ( cache.Owner == pOwner && cache.Generation == nGeneration )
+		{
+			return cache.Block;
+		}
+
+		cache.Block = create();
+		cache.Owner = pOwner;
+		cache.Generation = nGeneration;
+		return cache.Block;
+	}
+
 	/////////////////////////////////////////////////////////////////////////////
 	CHelper()
 	{
@@ -0,0 +1,6 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "ChunkStore.h"
@@ -0,0 +1,247 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include "MappedFile.h"
+#include <map>
+#include <memory>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// content addressed storage of stream chunks shared by every version of a
+// store. A chunk is named after a 64-bit hash of its bytes, so writing a
+// chunk that any version already wrote costs a hash and a comparison
+// instead of a copy:
+//
+//	Chunks\<hash>.chk	the cells of one block of rows of a stream
+//
+// Versioned collections persist a small manifest per stream listing the
+// references of its chunks, which makes opening an old version exactly as
+// cheap as opening the latest one.
+class CChunkStore
+{
+// public definitions
+public:
+	// reference to a chunk as persisted in a stream manifest
+	typedef struct tagCHUNK_REFERENCE
+	{
+		ULONGLONG Hash; // names the chunk file
+		DWORD Bytes; // size of the chunk in bytes
+		DWORD Rows; // number of rows in the chunk
+
+	} CHUNK_REFERENCE;
+
+// protected data
+protected:
+	// folder holding the chunk files
+	CString m_csFolder;
+
+	// chunks mapped for reading keyed by hash
+	map<ULONGLONG, shared_ptr<CMappedFile> > m_mapChunks;
+
+	// number of chunks written to disk
+	int m_nChunksWritten;
+
+	// number of chunks that were already on disk
+	int m_nChunksShared;
+
+	// number of bytes written to disk
+	ULONGLONG m_ullBytesWritten;
+
+	// number of bytes that did not need to be written
+	ULONGLONG m_ullBytesShared;
+
+// public properties
+public:
+	// folder holding the chunk files
+	inline CString GetFolder()
+	{
+		return m_csFolder;
+	}
+	// folder holding the chunk files
+	inline void SetFolder( CString value )
+	{
+		m_csFolder = value.TrimRight( _T( "\\" ));
+		m_mapChunks.clear();
+	}
+	// folder holding the chunk files
+	__declspec( property( get = GetFolder, put = SetFolder ) )
+		CString Folder;
+
+	// number of chunks written to disk
+	inline int GetChunksWritten()
+	{
+		return m_nChunksWritten;
+	}
+	// number of chunks written to disk
+	__declspec( property( get = GetChunksWritten ) )
+		int ChunksWritten;
+
+	// number of chunks that were already on disk
+	inline int GetChunksShared()
+	{
+		return m_nChunksShared;
+	}
+	// number of chunks that were already on disk
+	__declspec( property( get = GetChunksShared ) )
+		int ChunksShared;
+
+	// number of bytes written to disk
+	inline ULONGLONG GetBytesWritten()
+	{
+		return m_ullBytesWritten;
+	}
+	// number of bytes written to disk
+	__declspec( property( get = GetBytesWritten ) )
+		ULONGLONG BytesWritten;
+
+	// number of bytes that did not need to be written
+	inline ULONGLONG GetBytesShared()
+	{
+		return m_ullBytesShared;
+	}
+	// number of bytes that did not need to be written
+	__declspec( property( get = GetBytesShared ) )
+		ULONGLONG BytesShared;
+
+	// file extension of a stream's chunk manifest
+	inline static CString GetManifestExtension()
+	{
+		return _T( ".chunks" );
+	}
+	// file extension of a stream's chunk manifest
+	__declspec( property( get = GetManifestExtension ) )
+		CString ManifestExtension;
+
+// protected methods
+protected:
+	// pathname of the chunk with the given hash
+	CString GetPathname( ULONGLONG ullHash )
+	{
+		CString value;
+		value.Format( _T( "%s\\%016I64x.chk" ), m_csFolder, ullHash );
+		return value;
+	}
+
+	// does the chunk file hold exactly the given bytes?
+	bool Matches( LPCTSTR pathname, const BYTE* pData, DWORD dwBytes )
+	{
+		CMappedFile file;
+		if ( !file.Open( pathname ))
+		{
+			return false;
+		}
+
+		return
+			file.Size == dwBytes &&
+			memcmp( file.Data, pData, dwBytes ) == 0;
+	}
+
+// public methods
+public:
+	// 64-bit FNV-1a hash of a block of bytes
+	static ULONGLONG GetHash( const BYTE* pData, DWORD dwBytes )
+	{
+		ULONGLONG value = 14695981039346656037ULL;
+		for ( DWORD n = 0; n < dwBytes; n++ )
+		{
+			value ^= pData[ n ];
+			value *= 1099511628211ULL;
+		}
+
+		return value;
+	}
+
+	// store a chunk unless an identical one is already stored and return
+	// its reference in the given structure
+	bool Put
+	(
+		const BYTE* pData, DWORD dwBytes, DWORD dwRows,
+		CHUNK_REFERENCE& reference
+	)
+	{
+		if ( !::PathFileExists( m_csFolder ) && !CHelper::CreatePath( m_csFolder ))
+		{
+			return false;
+		}
+
+		reference.Bytes = dwBytes;
+		reference.Rows = dwRows;
+		reference.Hash = GetHash( pData, dwBytes );
+
+		// a different chunk that happens to have the same hash moves on
+		// to the next free name
+		do
+		{
+			const CString csPath = GetPathname( reference.Hash );
+			if ( !::PathFileExists( csPath ))
+			{
+				CFile file;
+				if ( !file.Open( csPath, CFile::modeCreate | CFile::modeWrite ))
+				{
+					return false;
+				}
+				file.Write( pData, dwBytes );
+				file.Close();
+
+				m_nChunksWritten++;
+				m_ullBytesWritten += dwBytes;
+				return true;
+			}
+
+			if ( Matches( csPath, pData, dwBytes ))
+			{
+				m_nChunksShared++;
+				m_ullBytesShared += dwBytes;
+				return true;
+			}
+
+			reference.Hash++;
+
+		} while ( true );
+	}
+
+	// map a chunk for reading (cached for the life of the store)
+	shared_ptr<CMappedFile> Get( ULONGLONG ullHash )
+	{
+		auto pos = m_mapChunks.find( ullHash );
+		if ( pos != m_mapChunks.end() )
+		{
+			return pos->second;
+		}
+
+		shared_ptr<CMappedFile> file = shared_ptr<CMappedFile>( new CMappedFile );
+		if ( !file->Open( GetPathname( ullHash )))
+		{
+			file.reset();
+		}
+
+		m_mapChunks[ ullHash ] = file;
+		return file;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CChunkStore()
+	{
+		m_nChunksWritten = 0;
+		m_nChunksShared = 0;
+		m_ullBytesWritten = 0;
+		m_ullBytesShared = 0;
+	}
+
+	// destructor
+	~CChunkStore()
+	{
+	}
+};
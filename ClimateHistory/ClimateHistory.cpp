@@ -37,197 +37,1814 @@ void OutputCSV( CStdioFile& fOut )
 		_T( "%>110," )
 		_T( "%>120," )
 		_T( "%>125" )
-		_T( "\n" )
 	);
 
+	// anomalies from the --baseline period follow the absolute values
+	const bool bAnomalies = m_AnomalyEngine.Computed;
+	if ( bAnomalies )
+	{
+		csHeading += _T( ",Max Anom,Min Anom,Avg Anom" );
+	}
+
+	// heat waves and cold spells of the daily readings follow the anomalies
+	const bool bRuns = m_GhcnDaily.Years > 0;
+	if ( bRuns )
+	{
+		csHeading +=
+			_T( ",Heat Waves,Heat Wave Days,Longest Heat Wave,Heat Wave Stations" )
+			_T( ",Cold Spells,Cold Spell Days,Longest Cold Spell,Cold Spell Stations" );
+	}
+	csHeading += _T( "\n" );
+
+	CCsvWriter writer( fOut );
+	writer.Trace = m_RunStatistics.Trace;
+	writer.WriteText( csHeading );
+	const float fMissing = CClimateTemperature::GetMissingValue();
+
+	// the rows are formatted in parallel so each needs its year by index
+	vector<shared_ptr<CClimateYear> > arrYears;
+	for ( auto& node : m_ClimateYears.Items )
+	{
+		arrYears.push_back( node.second );
+	}
+
+	writer.WriteRows
+	(
+		(int)arrYears.size(),
+		[&]( int row, CCsvWriter::CSV_BUFFER& buffer )
+		{
+			shared_ptr<CClimateYear>& pYear = arrYears[ row ];
+			const CString csYear = pYear->Year;
+			const vector<CStationYear::GREATER_COUNT>& counts = pYear->GreaterCounts;
+			const int nMaxRead = pYear->MaxReadings;
+			const int nGreaterRead = pYear->GreaterReadings;
+
+			CCsvWriter::AppendText( buffer, csYear );
+			const int nCounts[ 6 ] =
+			{
+				pYear->MaxStations, pYear->MinStations, pYear->AvgStations,
+				nMaxRead, pYear->MinReadings, pYear->AvgReadings
+			};
+			for ( int nCount : nCounts )
+			{
+				CCsvWriter::AppendChar( buffer, ',' );
+				CCsvWriter::AppendInt( buffer, nCount );
+			}
+
+			const float fValues[ 3 ] =
+			{
+				CHelper::GetFahrenheit( pYear->Maximum, fMissing ),
+				CHelper::GetFahrenheit( pYear->Minimum, fMissing ),
+				CHelper::GetFahrenheit( pYear->Average, fMissing )
+			};
+			for ( float fValue : fValues )
+			{
+				CCsvWriter::AppendChar( buffer, ',' );
+				CCsvWriter::AppendFixed( buffer, fValue, 2 );
+			}
+
+			// convert the greater than counts into percentage of 
+			// valid readings (the daily readings when there are any)
+			for ( int index = 0; index < 7; index++ )
+			{
+				float fPercent = 0.0f;
+				if ( index < (int)counts.size() && nGreaterRead > 0 )
+				{
+					fPercent = float( counts[ index ].second * 100.0 / nGreaterRead );
+				}
+				CCsvWriter::AppendChar( buffer, ',' );
+				CCsvWriter::AppendFixed( buffer, fPercent, 2 );
+			}
+
+			if ( bAnomalies )
+			{
+				// anomalies are differences so only the scale is converted
+				const int nYear = _ttoi( csYear );
+				const CClimateTemperature::MEASURE_TYPE eTypes[ 3 ] =
+				{
+					CClimateTemperature::mtMaximum,
+					CClimateTemperature::mtMinimum,
+					CClimateTemperature::mtAverage
+				};
+				for ( int n = 0; n < 3; n++ )
+				{
+					int nReadings = 0;
+					float fAnomaly =
+						m_AnomalyEngine.GetAnomaly( eTypes[ n ], nYear, nReadings );
+					if ( !CHelper::NearlyEqual( fAnomaly, fMissing ))
+					{
+						fAnomaly *= 1.8f;
+					}
+					CCsvWriter::AppendChar( buffer, ',' );
+					CCsvWriter::AppendFixed( buffer, fAnomaly, 2 );
+				}
+			}
+
+			if ( bRuns )
+			{
+				CGhcnDaily::DAILY_YEAR daily;
+				if ( !m_GhcnDaily.GetYear( _ttoi( csYear ), daily ))
+				{
+					ZeroMemory( &daily, sizeof( daily ));
+				}
+				for ( int eRun = 0; eRun < CGhcnDaily::rtCount; eRun++ )
+				{
+					const int nRuns[ 4 ] =
+					{
+						daily.Runs[ eRun ], daily.RunDays[ eRun ],
+						daily.LongestRun[ eRun ], daily.RunStations[ eRun ]
+					};
+					for ( int nRun : nRuns )
+					{
+						CCsvWriter::AppendChar( buffer, ',' );
+						CCsvWriter::AppendInt( buffer, nRun );
+					}
+				}
+			}
+			CCsvWriter::AppendChar( buffer, '\n' );
+		}
+	);
+
+} // OutputCSV
+
+/////////////////////////////////////////////////////////////////////////////
+// output the area weighted yearly series for each of a comma separated
+// list of cell sizes in degrees, i.e. "1,2.5,5"
+bool OutputGridded( CString& csSizes, CStdioFile& fOut )
+{
+	vector<float> arrSizes;
+	int nStart = 0;
+	CString csSize = csSizes.Tokenize( _T( "," ), nStart );
+	while ( nStart != -1 )
+	{
+		const float fSize = (float)_tstof( csSize );
+		if ( fSize <= 0.0f || fSize > 180.0f )
+		{
+			return false;
+		}
+		arrSizes.push_back( fSize );
+		csSize = csSizes.Tokenize( _T( "," ), nStart );
+	}
+	if ( arrSizes.empty() )
+	{
+		return false;
+	}
+
+	// each grid is reduced over the years in parallel
+	vector<CGriddedAverage> grids( arrSizes.size() );
+	CString csHeading( _T( "Year" ));
+	for ( size_t n = 0; n < arrSizes.size(); n++ )
+	{
+		grids[ n ].Compute( m_ClimateYears, m_StationList, arrSizes[ n ] );
+
+		CString csColumns;
+		csColumns.Format
+		(
+			_T( ",Max Cells %g,Min Cells %g,Avg Cells %g" )
+			_T( ",Maximum %g,Minimum %g,Average %g" ),
+			arrSizes[ n ], arrSizes[ n ], arrSizes[ n ], 
+			arrSizes[ n ], arrSizes[ n ], arrSizes[ n ]
+		);
+		csHeading += csColumns;
+	}
+	csHeading += _T( "\n" );
+	fOut.WriteString( csHeading );
+
+	const float fMissing = CClimateTemperature::GetMissingValue();
+	const size_t nYears = grids[ 0 ].Years.size();
+	for ( size_t nYear = 0; nYear < nYears; nYear++ )
+	{
+		CString csOut = grids[ 0 ].Years[ nYear ].Year;
+		for ( auto& grid : grids )
+		{
+			CGriddedAverage::GRIDDED_YEAR& year = grid.Years[ nYear ];
+
+			CString csColumns;
+			csColumns.Format
+			(
+				_T( ",%d,%d,%d,%0.2f,%0.2f,%0.2f" ),
+				year.Cells[ CClimateTemperature::mtMaximum ],
+				year.Cells[ CClimateTemperature::mtMinimum ],
+				year.Cells[ CClimateTemperature::mtAverage ],
+				CHelper::GetFahrenheit
+				(
+					year.Value[ CClimateTemperature::mtMaximum ], fMissing
+				),
+				CHelper::GetFahrenheit
+				(
+					year.Value[ CClimateTemperature::mtMinimum ], fMissing
+				),
+				CHelper::GetFahrenheit
+				(
+					year.Value[ CClimateTemperature::mtAverage ], fMissing
+				)
+			);
+			csOut += csColumns;
+		}
+		csOut += _T( "\n" );
+		fOut.WriteString( csOut );
+	}
+
+	return true;
+
+} // OutputGridded
+
+/////////////////////////////////////////////////////////////////////////////
+// output the least squares trend of every station and measurement type for
+// each of a comma separated list of year windows, i.e. "1900-2020,1970-2020"
+bool OutputTrends( CString& csWindows, CStdioFile& fOut )
+{
+	vector<CTrendEngine::WINDOW> arrWindows;
+	int nStart = 0;
+	CString csWindow = csWindows.Tokenize( _T( "," ), nStart );
+	while ( nStart != -1 )
+	{
+		const int nDash = csWindow.Find( _T( '-' ));
+		const int nFirst = _ttoi( csWindow );
+		const int nLast = nDash == -1 ? 0 : _ttoi( csWindow.Mid( nDash + 1 ));
+		if ( nFirst <= 0 || nLast <= nFirst )
+		{
+			return false;
+		}
+		arrWindows.push_back( CTrendEngine::WINDOW( nFirst, nLast ));
+		csWindow = csWindows.Tokenize( _T( "," ), nStart );
+	}
+	if ( arrWindows.empty() )
+	{
+		return false;
+	}
+
+	// the annual means are gathered once and every station is fitted in
+	// parallel for all of the windows
+	m_TrendEngine.Build( m_ClimateTable, m_StationList.Count );
+	vector<CTrendEngine::TREND> trends;
+	m_TrendEngine.Fit( arrWindows, trends );
+
+	CCsvWriter writer( fOut );
+	writer.Trace = m_RunStatistics.Trace;
+	writer.WriteText
+	(
+		_T( "Station,Measure,First Year,Last Year,Years," )
+		_T( "Trend F/Decade,Standard Error\n" )
+	);
+
+	LPCTSTR pTypes[ 4 ] =
+	{
+		_T( "Missing" ), _T( "Maximum" ), _T( "Minimum" ), _T( "Average" )
+	};
+
+	writer.WriteRows
+	(
+		(int)trends.size(),
+		[&]( int row, CCsvWriter::CSV_BUFFER& buffer )
+		{
+			CTrendEngine::TREND& trend = trends[ row ];
+			CCsvWriter::AppendText( buffer, m_StationList.Station[ trend.Station ] );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendText( buffer, pTypes[ trend.Type ] );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendInt( buffer, trend.FirstYear );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendInt( buffer, trend.LastYear );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendInt( buffer, trend.Years );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendFixed( buffer, trend.Slope, 3 );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendFixed( buffer, trend.StandardError, 3 );
+			CCsvWriter::AppendChar( buffer, '\n' );
+		}
+	);
+
+	return true;
+
+} // OutputTrends
+
+/////////////////////////////////////////////////////////////////////////////
+// output the yearly averages of every dataset variant side by side followed
+// by each variant's mean adjustment (variant minus base) of the stations
+// reported by both
+void OutputVariants( CStdioFile& fOut )
+{
+	const int nVariants = m_DatasetVariants.Count;
+	const CString csBase = m_DatasetVariants.Variant[ 0 ]->Name;
+
+	CString csHeading( _T( "Year" ));
+	for ( int index = 0; index < nVariants; index++ )
+	{
+		const CString csName = m_DatasetVariants.Variant[ index ]->Name;
+		CString csColumns;
+		csColumns.Format
+		(
+			_T( ",Maximum %s,Minimum %s,Average %s" ),
+			csName, csName, csName
+		);
+		csHeading += csColumns;
+	}
+	for ( int index = 1; index < nVariants; index++ )
+	{
+		const CString csName = m_DatasetVariants.Variant[ index ]->Name;
+		CString csColumns;
+		csColumns.Format
+		(
+			_T( ",Max %s-%s,Min %s-%s,Avg %s-%s" ),
+			csName, csBase, csName, csBase, csName, csBase
+		);
+		csHeading += csColumns;
+	}
+	csHeading += _T( "\n" );
+	fOut.WriteString( csHeading );
+
+	const float fMissing = CClimateTemperature::GetMissingValue();
+	const CClimateTemperature::MEASURE_TYPE eTypes[ 3 ] =
+	{
+		CClimateTemperature::mtMaximum,
+		CClimateTemperature::mtMinimum,
+		CClimateTemperature::mtAverage
+	};
+
+	set<CString> years;
+	m_DatasetVariants.GetYears( years );
+	for ( auto& csYear : years )
+	{
+		CString csOut = csYear;
+		for ( int index = 0; index < nVariants; index++ )
+		{
+			float fValues[ 3 ] = { fMissing, fMissing, fMissing };
+			shared_ptr<CClimateYear> pYear =
+				m_DatasetVariants.Variant[ index ]->ClimateYears.find( csYear );
+			if ( pYear != nullptr )
+			{
+				fValues[ 0 ] = CHelper::GetFahrenheit( pYear->Maximum, fMissing );
+				fValues[ 1 ] = CHelper::GetFahrenheit( pYear->Minimum, fMissing );
+				fValues[ 2 ] = CHelper::GetFahrenheit( pYear->Average, fMissing );
+			}
+
+			CString csColumns;
+			csColumns.Format
+			(
+				_T( ",%0.2f,%0.2f,%0.2f" ), fValues[ 0 ], fValues[ 1 ], fValues[ 2 ]
+			);
+			csOut += csColumns;
+		}
+
+		for ( int index = 1; index < nVariants; index++ )
+		{
+			// deltas are differences so only the scale is converted
+			float fDeltas[ 3 ];
+			for ( int n = 0; n < 3; n++ )
+			{
+				int nPairs = 0;
+				fDeltas[ n ] =
+					m_DatasetVariants.GetDelta( index, csYear, eTypes[ n ], nPairs );
+				if ( !CHelper::NearlyEqual( fDeltas[ n ], fMissing ))
+				{
+					fDeltas[ n ] *= 1.8f;
+				}
+			}
+
+			CString csColumns;
+			csColumns.Format
+			(
+				_T( ",%0.2f,%0.2f,%0.2f" ), fDeltas[ 0 ], fDeltas[ 1 ], fDeltas[ 2 ]
+			);
+			csOut += csColumns;
+		}
+		csOut += _T( "\n" );
+
+		fOut.WriteString( csOut );
+	}
+
+} // OutputVariants
+
+/////////////////////////////////////////////////////////////////////////////
+// output a row for every year and month with the station counts, valid
+// readings, mean, highest and lowest readings of each measurement type and
+// the percentage of the valid readings of each measurement type above each
+// greater than limit
+void OutputMonthly( CStdioFile& fOut )
+{
+	// the twelve months are reduced in parallel in a single pass
+	m_MonthlySummary.ExcludeMask = m_FlagPolicy.ExcludeMask;
+	m_MonthlySummary.Compute( m_ClimateTable );
+
+	CString csHeading
+	(
+		_T( "Year,Month," )
+		_T( "Max Stat,Min Stat,Avg Stat," )
+		_T( "Max Read,Min Read,Avg Read," )
+		_T( "Maximum,Minimum,Average," )
+		_T( "Max High,Max Low,Min High,Min Low,Avg High,Avg Low" )
+	);
+	const LPCTSTR pTypes[ 3 ] = { _T( "Max" ), _T( "Min" ), _T( "Avg" ) };
+	for ( LPCTSTR pType : pTypes )
+	{
+		for ( int index = 0; index < CMonthlySummary::GREATER_LIMITS; index++ )
+		{
+			CString csColumn;
+			csColumn.Format
+			(
+				_T( ",%s %%>%d" ), pType, CMonthlySummary::GetGreaterLimit( index )
+			);
+			csHeading += csColumn;
+		}
+	}
+	csHeading += _T( "\n" );
+	CCsvWriter writer( fOut );
+	writer.Trace = m_RunStatistics.Trace;
+	writer.WriteText( csHeading );
+
+	const float fMissing = CClimateTemperature::GetMissingValue();
+	const CClimateTemperature::MEASURE_TYPE eMax = CClimateTemperature::mtMaximum;
+	const CClimateTemperature::MEASURE_TYPE eMin = CClimateTemperature::mtMinimum;
+	const CClimateTemperature::MEASURE_TYPE eAvg = CClimateTemperature::mtAverage;
+
+	// every year and month is a row, the months without data are empty
+	const int nFirstYear = m_MonthlySummary.FirstYear;
+	const int nYears = m_MonthlySummary.Years;
+	writer.WriteRows
+	(
+		nYears * 12,
+		[&]( int row, CCsvWriter::CSV_BUFFER& buffer )
+		{
+			const int nYear = nFirstYear + row / 12;
+			const int nMonth = row % 12;
+			CMonthlySummary::MONTH_SUMMARY& month =
+				m_MonthlySummary.GetSummary( nYear, nMonth );
+			if ( month.Stations[ eMax ] + month.Stations[ eMin ] +
+				month.Stations[ eAvg ] == 0 )
+			{
+				return;
+			}
+
+			const int nCounts[ 8 ] =
+			{
+				nYear, nMonth + 1,
+				month.Stations[ eMax ], month.Stations[ eMin ], month.Stations[ eAvg ],
+				month.Readings[ eMax ], month.Readings[ eMin ], month.Readings[ eAvg ]
+			};
+			for ( int n = 0; n < 8; n++ )
+			{
+				if ( n > 0 )
+				{
+					CCsvWriter::AppendChar( buffer, ',' );
+				}
+				CCsvWriter::AppendInt( buffer, nCounts[ n ] );
+			}
+
+			const float fValues[ 9 ] =
+			{
+				CMonthlySummary::GetMean( month, eMax ),
+				CMonthlySummary::GetMean( month, eMin ),
+				CMonthlySummary::GetMean( month, eAvg ),
+				month.High[ eMax ], month.Low[ eMax ],
+				month.High[ eMin ], month.Low[ eMin ],
+				month.High[ eAvg ], month.Low[ eAvg ]
+			};
+			for ( float fValue : fValues )
+			{
+				CCsvWriter::AppendChar( buffer, ',' );
+				CCsvWriter::AppendFixed
+				(
+					buffer, CHelper::GetFahrenheit( fValue, fMissing ), 2
+				);
+			}
+
+			// percentages of the valid readings of each measurement type
+			for ( int eType = eMax; eType <= eAvg; eType++ )
+			{
+				const int nReadings = month.Readings[ eType ];
+				for ( int index = 0; index < CMonthlySummary::GREATER_LIMITS; index++ )
+				{
+					const float fPercent = nReadings == 0 ? 0.0f :
+						float( month.Greater[ eType ][ index ] * 100 ) / nReadings;
+					CCsvWriter::AppendChar( buffer, ',' );
+					CCsvWriter::AppendFixed( buffer, fPercent, 2 );
+				}
+			}
+			CCsvWriter::AppendChar( buffer, '\n' );
+		}
+	);
+
+} // OutputMonthly
+
+/////////////////////////////////////////////////////////////////////////////
+// output a row for every year and measurement type with the number of
+// station years by how many months have data and the number of them the
+// coverage filter kept
+void OutputCoverage( CStdioFile& fOut )
+{
+	CString csHeading( _T( "Year,Type" ));
+	for ( int nMonths = 0; nMonths <= 12; nMonths++ )
+	{
+		CString csColumn;
+		csColumn.Format( _T( ",%d Months" ), nMonths );
+		csHeading += csColumn;
+	}
+	csHeading += _T( ",Aggregated\n" );
 	fOut.WriteString( csHeading );
+
+	const LPCTSTR pTypes[ 4 ] = { _T( "" ), _T( "Max" ), _T( "Min" ), _T( "Avg" ) };
+	const int nMinimumMonths = m_QueryFilter.MinimumMonths;
+	for ( auto& node : m_ClimateYears.Items )
+	{
+		for ( int eType = CClimateTemperature::mtMaximum;
+			eType <= CClimateTemperature::mtAverage; eType++ )
+		{
+			const CClimateTemperature::MEASURE_TYPE eMeasure =
+				(CClimateTemperature::MEASURE_TYPE)eType;
+			if ( node.second->GetCoveredStations( eMeasure, 0 ) == 0 )
+			{
+				continue;
+			}
+
+			CString csOut;
+			csOut.Format( _T( "%s,%s" ), node.first, pTypes[ eType ] );
+			for ( int nMonths = 0; nMonths <= 12; nMonths++ )
+			{
+				CString csColumn;
+				csColumn.Format
+				(
+					_T( ",%d" ), node.second->GetCoverage( eMeasure, nMonths )
+				);
+				csOut += csColumn;
+			}
+
+			CString csColumn;
+			csColumn.Format
+			(
+				_T( ",%d\n" ),
+				node.second->GetCoveredStations( eMeasure, nMinimumMonths )
+			);
+			csOut += csColumn;
+			fOut.WriteString( csOut );
+		}
+	}
+
+} // OutputCoverage
+
+/////////////////////////////////////////////////////////////////////////////
+// output a row for every station year of the GHCN-Daily files with a heat
+// wave or cold spell, the runs are counted in the year they started
+void OutputStationRuns( CStdioFile& fOut )
+{
+	CCsvWriter writer( fOut );
+	writer.Trace = m_RunStatistics.Trace;
+	writer.WriteText
+	(
+		_T( "Station,Year" )
+		_T( ",Heat Waves,Heat Wave Days,Longest Heat Wave" )
+		_T( ",Cold Spells,Cold Spell Days,Longest Cold Spell\n" )
+	);
+
+	writer.WriteRows
+	(
+		m_GhcnDaily.StationRunCount,
+		[&]( int row, CCsvWriter::CSV_BUFFER& buffer )
+		{
+			const CGhcnDaily::STATION_RUNS& runs = m_GhcnDaily.StationRun[ row ];
+			CCsvWriter::AppendText( buffer, runs.Station );
+			CCsvWriter::AppendChar( buffer, ',' );
+			CCsvWriter::AppendInt( buffer, runs.Year );
+			for ( int eRun = 0; eRun < CGhcnDaily::rtCount; eRun++ )
+			{
+				const int nRuns[ 3 ] =
+				{
+					runs.Runs[ eRun ], runs.RunDays[ eRun ], runs.LongestRun[ eRun ]
+				};
+				for ( int nRun : nRuns )
+				{
+					CCsvWriter::AppendChar( buffer, ',' );
+					CCsvWriter::AppendInt( buffer, nRun );
+				}
+			}
+			CCsvWriter::AppendChar( buffer, '\n' );
+		}
+	);
+
+} // OutputStationRuns
+
+/////////////////////////////////////////////////////////////////////////////
+// write the yearly table to an Arrow IPC file, the temperatures are in
+// degrees Fahrenheit with missing values null and the greater than columns
+// are counts of maximum readings
+bool OutputArrow( LPCTSTR pathname )
+{
+	const float fMissing = CClimateTemperature::GetMissingValue();
+	const bool bAnomalies = m_AnomalyEngine.Computed;
+	const int nLimits = CMonthlySummary::GREATER_LIMITS;
+
+	CArrowWriter writer;
+	writer.AddField( _T( "Year" ), CArrowWriter::atInt32, false );
+	LPCTSTR pCounts[ 6 ] =
+	{
+		_T( "Max Stat" ), _T( "Min Stat" ), _T( "Avg Stat" ),
+		_T( "Max Read" ), _T( "Min Read" ), _T( "Avg Read" )
+	};
+	for ( LPCTSTR pName : pCounts )
+	{
+		writer.AddField( pName, CArrowWriter::atInt32, false );
+	}
+	LPCTSTR pValues[ 6 ] =
+	{
+		_T( "Maximum" ), _T( "Minimum" ), _T( "Average" ),
+		_T( "Max Anom" ), _T( "Min Anom" ), _T( "Avg Anom" )
+	};
+	const int nValues = bAnomalies ? 6 : 3;
+	for ( int n = 0; n < nValues; n++ )
+	{
+		writer.AddField( pValues[ n ], CArrowWriter::atFloat32, true );
+	}
+	for ( int index = 0; index < nLimits; index++ )
+	{
+		CString csName;
+		csName.Format( _T( ">%d" ), CMonthlySummary::GetGreaterLimit( index ));
+		writer.AddField( csName, CArrowWriter::atInt32, false );
+	}
+
+	// gather each column of the years
+	vector<int> arrYears;
+	vector<int> arrCounts[ 6 ];
+	vector<float> arrValues[ 6 ];
+	vector<int> arrGreater[ CMonthlySummary::GREATER_LIMITS ];
+	const CClimateTemperature::MEASURE_TYPE eTypes[ 3 ] =
+	{
+		CClimateTemperature::mtMaximum,
+		CClimateTemperature::mtMinimum,
+		CClimateTemperature::mtAverage
+	};
+	for ( auto& node : m_ClimateYears.Items )
+	{
+		shared_ptr<CClimateYear>& pYear = node.second;
+		const int nYear = _ttoi( pYear->Year );
+		arrYears.push_back( nYear );
+
+		arrCounts[ 0 ].push_back( pYear->MaxStations );
+		arrCounts[ 1 ].push_back( pYear->MinStations );
+		arrCounts[ 2 ].push_back( pYear->AvgStations );
+		arrCounts[ 3 ].push_back( pYear->MaxReadings );
+		arrCounts[ 4 ].push_back( pYear->MinReadings );
+		arrCounts[ 5 ].push_back( pYear->AvgReadings );
+
+		arrValues[ 0 ].push_back( CHelper::GetFahrenheit( pYear->Maximum, fMissing ));
+		arrValues[ 1 ].push_back( CHelper::GetFahrenheit( pYear->Minimum, fMissing ));
+		arrValues[ 2 ].push_back( CHelper::GetFahrenheit( pYear->Average, fMissing ));
+		for ( int n = 3; n < nValues; n++ )
+		{
+			// anomalies are differences so only the scale is converted
+			int nReadings = 0;
+			float fAnomaly =
+				m_AnomalyEngine.GetAnomaly( eTypes[ n - 3 ], nYear, nReadings );
+			if ( !CHelper::NearlyEqual( fAnomaly, fMissing ))
+			{
+				fAnomaly *= 1.8f;
+			}
+			arrValues[ n ].push_back( fAnomaly );
+		}
+
+		const vector<CStationYear::GREATER_COUNT>& counts = pYear->GreaterCounts;
+		for ( int index = 0; index < nLimits; index++ )
+		{
+			arrGreater[ index ].push_back
+			(
+				index < (int)counts.size() ? counts[ index ].second : 0
+			);
+		}
+	}
+
+	if ( !writer.Create( pathname ))
+	{
+		return false;
+	}
+
+	const int nRows = (int)arrYears.size();
+	vector<CArrowWriter::ARROW_COLUMN> columns;
+	columns.push_back
+	(
+		CArrowWriter::GetColumn( arrYears.data(), nRows * sizeof( int ))
+	);
+	for ( auto& counts : arrCounts )
+	{
+		columns.push_back
+		(
+			CArrowWriter::GetColumn( counts.data(), nRows * sizeof( int ))
+		);
+	}
+	vector<BYTE> arrValidity[ 6 ];
+	for ( int n = 0; n < nValues; n++ )
+	{
+		const LONGLONG llNulls = CArrowWriter::GetValidity
+		(
+			arrValues[ n ].data(), nRows, fMissing, arrValidity[ n ]
+		);
+		columns.push_back
+		(
+			CArrowWriter::GetColumn
+			(
+				arrValues[ n ].data(), nRows * sizeof( float ),
+				&arrValidity[ n ], llNulls
+			)
+		);
+	}
+	for ( auto& greater : arrGreater )
+	{
+		columns.push_back
+		(
+			CArrowWriter::GetColumn( greater.data(), nRows * sizeof( int ))
+		);
+	}
+
+	writer.WriteBatch( nRows, columns );
+	writer.Close();
+
+	return true;
+
+} // OutputArrow
+
+/////////////////////////////////////////////////////////////////////////////
+// write every station year to an Arrow IPC file with a record batch per
+// column block. The station IDs are dictionary encoded with the dense
+// station index as the dictionary index, so the year and month columns of
+// the blocks are written as they are without being copied.
+bool OutputArrowStations( LPCTSTR pathname )
+{
 	const float fMissing = CClimateTemperature::GetMissingValue();
+	LPCTSTR pMonths[ 12 ] =
+	{
+		_T( "Jan" ), _T( "Feb" ), _T( "Mar" ), _T( "Apr" ),
+		_T( "May" ), _T( "Jun" ), _T( "Jul" ), _T( "Aug" ),
+		_T( "Sep" ), _T( "Oct" ), _T( "Nov" ), _T( "Dec" )
+	};
+
+	CArrowWriter writer;
+	writer.AddField( _T( "Station" ), CArrowWriter::atUtf8, false, 0 );
+	writer.AddField( _T( "Measure" ), CArrowWriter::atUtf8, false, 1 );
+	writer.AddField( _T( "Year" ), CArrowWriter::atInt32, false );
+	for ( LPCTSTR pMonth : pMonths )
+	{
+		writer.AddField( pMonth, CArrowWriter::atFloat32, true );
+	}
+
+	if ( !writer.Create( pathname ))
+	{
+		return false;
+	}
+
+	// the station dictionary is the station list in dense index order
+	vector<CString> arrStations;
+	const int nStations = m_StationList.Count;
+	for ( int index = 0; index < nStations; index++ )
+	{
+		arrStations.push_back( m_StationList.Station[ index ] );
+	}
+	writer.WriteDictionary( 0, arrStations );
+
+	// the measure dictionary is indexed by the measurement type
+	vector<CString> arrMeasures;
+	arrMeasures.push_back( _T( "Missing" ));
+	arrMeasures.push_back( _T( "Maximum" ));
+	arrMeasures.push_back( _T( "Minimum" ));
+	arrMeasures.push_back( _T( "Average" ));
+	writer.WriteDictionary( 1, arrMeasures );
+
+	vector<int> arrMeasure;
+	vector<BYTE> arrValidity[ 12 ];
+	for ( auto& block : m_ClimateTable.Blocks )
+	{
+		const int nRows = block->Rows;
+		if ( nRows == 0 )
+		{
+			continue;
+		}
+
+		arrMeasure.assign( nRows, block->MeasurementType );
+
+		vector<CArrowWriter::ARROW_COLUMN> columns;
+		columns.push_back
+		(
+			CArrowWriter::GetColumn
+			(
+				block->GetStationIndexColumn(), nRows * sizeof( int )
+			)
+		);
+		columns.push_back
+		(
+			CArrowWriter::GetColumn( arrMeasure.data(), nRows * sizeof( int ))
+		);
+		columns.push_back
+		(
+			CArrowWriter::GetColumn( block->GetYearColumn(), nRows * sizeof( int ))
+		);
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			const float* pValues = block->GetMonthColumn( nMonth );
+			const LONGLONG llNulls = CArrowWriter::GetValidity
+			(
+				pValues, nRows, fMissing, arrValidity[ nMonth ]
+			);
+			columns.push_back
+			(
+				CArrowWriter::GetColumn
+				(
+					pValues, nRows * sizeof( float ), &arrValidity[ nMonth ],
+					llNulls
+				)
+			);
+		}
+
+		writer.WriteBatch( nRows, columns );
+	}
+	writer.Close();
+
+	return true;
+
+} // OutputArrowStations
+
+/////////////////////////////////////////////////////////////////////////////
+// set the query filter from the --years, --stations, --states, --types and
+// --min-months switches and the flags the quality control policy leaves out of the
+// aggregates from --exclude-flags, false if any of them is invalid
+bool SetQueryFilter( COptions& options, CStdioFile& fErr )
+{
+	CString csMessage;
+	CString csValue;
+	bool value = true;
+
+	if ( options.Exists[ _T( "years" ) ] )
+	{
+		csValue = options.Value[ _T( "years" ) ];
+		if ( !m_QueryFilter.SetYears( csValue ))
+		{
+			csMessage.Format( _T( "Invalid --years range: %s\n" ), csValue );
+			value = false;
+		}
+	}
+
+	if ( value && options.Exists[ _T( "stations" ) ] )
+	{
+		csValue = options.Value[ _T( "stations" ) ];
+		if ( m_QueryFilter.SetStations( csValue ) == 0 )
+		{
+			csMessage.Format( _T( "Invalid --stations list: %s\n" ), csValue );
+			value = false;
+		}
+	}
+
+	if ( value && options.Exists[ _T( "states" ) ] )
+	{
+		csValue = options.Value[ _T( "states" ) ];
+		if ( m_QueryFilter.SetStates( csValue ) == 0 )
+		{
+			csMessage.Format( _T( "Invalid --states list: %s\n" ), csValue );
+			value = false;
+		}
+	}
+
+	if ( value && options.Exists[ _T( "types" ) ] )
+	{
+		csValue = options.Value[ _T( "types" ) ];
+		if ( m_QueryFilter.SetTypes( csValue ) == 0 )
+		{
+			csMessage.Format( _T( "Invalid --types list: %s\n" ), csValue );
+			value = false;
+		}
+	}
+
+	if ( value && options.Exists[ _T( "min-months" ) ] )
+	{
+		csValue = options.Value[ _T( "min-months" ) ];
+		if ( !m_QueryFilter.SetMinimumMonths( csValue ))
+		{
+			csMessage.Format( _T( "Invalid --min-months count: %s\n" ), csValue );
+			value = false;
+		}
+	}
+
+	if ( value && options.Exists[ _T( "exclude-flags" ) ] )
+	{
+		csValue = options.Value[ _T( "exclude-flags" ) ];
+		if ( m_FlagPolicy.SetExcludeFlags( csValue ) == 0 )
+		{
+			csMessage.Format( _T( "Invalid --exclude-flags letters: %s\n" ), csValue );
+			value = false;
+		}
+	}
+
+	if ( !value )
+	{
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+	}
+
+	return value;
+
+} // SetQueryFilter
+
+/////////////////////////////////////////////////////////////////////////////
+// add a parsed station year to the climate year of its year
+bool InsertStationYear( shared_ptr< CStationYear >& StationYear )
+{
+	bool value = false;
+	CRunStatistics::CPhaseTimer timer( m_RunStatistics, CRunStatistics::spInsert );
+
+	// out of core the station year is only written to its partition
+	if ( m_SpillPartitions.Active )
+	{
+		m_SpillPartitions.Add( StationYear );
+		return true;
+	}
+
+	const CString csYear = StationYear->Year;
+
+	const bool bExists = m_ClimateYears.Exists[ csYear ];
+
+	shared_ptr<CClimateYear> ClimateYear;
+
+	if ( bExists )
+	{
+		ClimateYear = m_ClimateYears.find( csYear );
+
+	} else
+	{
+		ClimateYear = shared_ptr<CClimateYear>( new CClimateYear );
+		ClimateYear->Year = csYear;
+		m_ClimateYears.add( csYear, ClimateYear );
+	}
+
+	value = ClimateYear->WriteStationYear
+	(
+		StationYear, m_QueryFilter.MinimumMonths
+	);
+	if ( !value )
+	{
+		m_RunStatistics.Add( CRunStatistics::scDuplicates );
+	}
+
+	return value;
+} // InsertStationYear
+
+/////////////////////////////////////////////////////////////////////////////
+// parse a given line of source and persist it
+bool ParseSource
+( 
+	CString& source, CClimateTemperature::MEASURE_TYPE eType
+)
+{
+
+	// decode the line into a CStationYear object, the parse cache passes
+	// it straight through unless it is enabled for --variants, readings
+	// share the station list's dense index
+	shared_ptr< CStationYear > StationYear = m_RunStatistics.Time
+	(
+		CRunStatistics::spParse,
+		[&]()
+		{
+			return m_ParseCache.Parse
+			(
+				source, eType,
+				[]( const CString& station )
+				{
+					m_RunStatistics.Add( CRunStatistics::scDecoded );
+					return m_StationList.Add( station );
+				}
+			);
+		}
+	);
+	m_RunStatistics.AddRecord( StationYear->ValidReadings );
+
+	return InsertStationYear( StationYear );
+} // ParseSource
+
+/////////////////////////////////////////////////////////////////////////////
+// crawl through the directory tree looking for given climate extension
+void RecursePath
+( 
+	LPCTSTR path, // pathname to recurse
+	// extension of climate files to process (tmax, tmin, or tavg)
+	LPCTSTR ext, 
+	CStdioFile& fOut, // standard output
+	CStdioFile& fErr // error output
+)
+{
+	USES_CONVERSION;
+
+	// determine measurement type from the given extension
+	CClimateTemperature::MEASURE_TYPE eType = CClimateTemperature::mtMaximum;
+	const CString csExtention = CString( ext ).MakeLower();
+	if ( csExtention == _T( ".tmin" ))
+	{
+		eType = CClimateTemperature::mtMinimum;
+
+	} else if ( csExtention == _T( ".tavg" ))
+	{
+		eType = CClimateTemperature::mtAverage;
+	}
+
+	// an excluded measurement type is never crawled
+	if ( !m_QueryFilter.AcceptType( eType ))
+	{
+		return;
+	}
+	const bool bFilter = m_QueryFilter.Active;
+
+	// get the folder which will trim any wild card data
+	CString csPathname = CString( path ).Trim( _T( "\\" ));
+
+	// build a pathname with wild-card extension
+	CString strWildcard;
+	strWildcard.Format( _T( "%s\\*.*" ), csPathname );
+	
+	// start trolling for files we are interested in
+	CFileFind finder;
+	BOOL bWorking = m_RunStatistics.Time
+	(
+		CRunStatistics::spCrawl,
+		[&]() { return finder.FindFile( strWildcard ); }
+	);
+	while ( bWorking )
+	{
+		bWorking = m_RunStatistics.Time
+		(
+			CRunStatistics::spCrawl,
+			[&]() { return finder.FindNextFile(); }
+		);
+
+		// skip "." and ".." folder names
+		if ( finder.IsDots() )
+		{
+			continue;
+		}
+
+		// if it's a directory, recursively search it
+		if ( finder.IsDirectory() )
+		{
+			// get the new folder name
+			const CString folder =
+				finder.GetFilePath().TrimRight( _T( "\\" ) );
+
+			// recurse into the new directory with wild cards
+			RecursePath( folder, ext, fOut, fErr );
+
+		} else // write the properties for valid extension
+		{
+			const CString csPath = finder.GetFilePath();
+			const CString csExt = CHelper::GetExtension( csPath ).MakeLower();
+			if ( csExt == ext )
+			{
+				// the file name tells whether the station is of interest
+				if ( !m_QueryFilter.AcceptFile( csPath, eType, m_StationList ))
+				{
+					continue;
+				}
+
+				// open the stations text file
+				CTraceLog::CTraceScope scope
+				(
+					m_RunStatistics.Trace, _T( "parse file" ), csPath
+				);
+				CStdioFile file;
+				const bool value =
+					file.Open( csPath, CFile::modeRead | CFile::shareDenyNone );
+
+				// if the open was successful, read each line of the file and 
+				// collect the station data
+				if ( value == true )
+				{
+					m_RunStatistics.AddFile( file );
+
+					CString csLine;
+					while ( m_RunStatistics.ReadString( file, csLine ) )
+					{
+						// reject the line by its station and year before
+						// any of its months are decoded
+						if ( bFilter &&
+							!m_QueryFilter.AcceptLine( csLine, m_StationList ))
+						{
+							if ( m_QueryFilter.IsPast( csLine ))
+							{
+								break;
+							}
+							continue;
+						}
+
+						ParseSource( csLine, eType );
+					}
+				}
+
+				//fErr.WriteString( csPath );
+				//fErr.WriteString( _T( "\n" ));
+			}
+		}
+	}
 
-	for ( auto& node : m_ClimateYears.Items )
+	finder.Close();
+
+} // RecursePath
+
+/////////////////////////////////////////////////////////////////////////////
+// crawl through the directory tree looking for GHCN-Monthly version 4
+// files (.dat), each of which is parsed in parallel byte ranges
+void RecurseGhcn
+( 
+	LPCTSTR path, // pathname to recurse
+	CStdioFile& fErr // error output
+)
+{
+	// get the folder which will trim any wild card data
+	CString csPathname = CString( path ).Trim( _T( "\\" ));
+
+	// build a pathname with wild-card extension
+	CString strWildcard;
+	strWildcard.Format( _T( "%s\\*.*" ), csPathname );
+
+	CFileFind finder;
+	BOOL bWorking = m_RunStatistics.Time
+	(
+		CRunStatistics::spCrawl,
+		[&]() { return finder.FindFile( strWildcard ); }
+	);
+	while ( bWorking )
 	{
-		CString csOut;
-		CString csYear = node.first;
-		vector<CStationYear::GREATER_COUNT> counts = node.second->GreaterCounts;
-		const int nCounts = (int)counts.size();
-		const int nMaxStat = node.second->MaxStations;
-		const int nMinStat = node.second->MinStations;
-		const int nAvgStat = node.second->AvgStations;
-		const int nMaxRead = node.second->MaxReadings;
-		const int nMinRead = node.second->MinReadings;
-		const int nAvgRead = node.second->AvgReadings;
-		const float fMaximum = CHelper::GetFahrenheit( node.second->Maximum, fMissing );
-		const float fMinimum = CHelper::GetFahrenheit( node.second->Minimum, fMissing );
-		const float fAverage = CHelper::GetFahrenheit( node.second->Average, fMissing );
-
-		// convert the greater than counts into percentage of 
-		// valid readings (nMaxRead)
-		vector<float> percents( 9, 0.0f );
-
-		// handle exceptional cases
-		if ( counts.size() != 0 && nMaxRead > 0 )
-		{
-			int index = 0;
-			for ( auto& count : counts )
-			{
-				if ( index < 9 )
+		bWorking = m_RunStatistics.Time
+		(
+			CRunStatistics::spCrawl,
+			[&]() { return finder.FindNextFile(); }
+		);
+
+		// skip "." and ".." folder names
+		if ( finder.IsDots() )
+		{
+			continue;
+		}
+
+		if ( finder.IsDirectory() )
+		{
+			const CString folder =
+				finder.GetFilePath().TrimRight( _T( "\\" ) );
+			RecurseGhcn( folder, fErr );
+			continue;
+		}
+
+		// the extension is shared with other data so the first line must
+		// be in the GHCN-Monthly layout
+		const CString csPath = finder.GetFilePath();
+		const CString csExt = CHelper::GetExtension( csPath ).MakeLower();
+		if ( csExt != _T( ".dat" ) || !CGhcnMonthly::IsSourceFile( csPath ))
+		{
+			continue;
+		}
+
+		// under --mem-limit a batch of the file's text and the station
+		// years parsed from it fit in the limit, and each batch is spilled
+		// before the next is read
+		LONGLONG llBatch = 0;
+		if ( m_SpillPartitions.Active )
+		{
+			const LONGLONG llLine = CGhcnMonthly::GetSourceLength();
+			llBatch = max
+			(
+				llLine, m_SpillPartitions.Limit * llLine /
+					( llLine * (LONGLONG)sizeof( TCHAR ) + CSpillPartitions::GetRecordBytes() )
+			);
+		}
+
+		int nRows = 0;
+		CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "parse file" ), csPath );
+		CGhcnMonthly::Parse
+		(
+			csPath, m_StationList, m_ParseCache, m_QueryFilter, m_RunStatistics,
+			llBatch,
+			[&]( vector<shared_ptr<CStationYear> >& rows )
+			{
+				// stations missing from the inventory are indexed here where
+				// the station list can safely grow, then the rows are added
+				// in order
+				CTraceLog::CTraceScope merge( m_RunStatistics.Trace, _T( "merge" ), csPath );
+				for ( auto& StationYear : rows )
 				{
-					percents[ index ] = 
-						float( counts[ index ].second * 100 ) / nMaxRead;
-					index++;
+					if ( StationYear->StationIndex == -1 )
+					{
+						StationYear->StationIndex =
+							m_StationList.Add( StationYear->Station );
+					}
+					InsertStationYear( StationYear );
 				}
+				nRows += (int)rows.size();
 			}
-		}
+		);
 
-		csOut.Format
+		CString csMessage;
+		csMessage.Format
 		(
-			_T( "%s,%d,%d,%d,%d,%d,%d,%0.2f,%0.2f,%0.2f," )
-			_T( "%0.2f,%0.2f,%0.2f,%0.2f,%0.2f,%0.2f,%0.2f\n" ),
-			csYear, nMaxStat, nMinStat, nAvgStat, nMaxRead, nMinRead, nAvgRead, 
-			fMaximum, fMinimum, fAverage,
-			percents[ 0 ], percents[ 1 ], percents[ 2 ], 
-			percents[ 3 ], percents[ 4 ], percents[ 5 ], percents[ 6 ]
+			_T( "GHCN-Monthly file: %d station years\n\t%s\n" ),
+			nRows, csPath
 		);
-
-		fOut.WriteString( csOut );
+		m_RunStatistics.Progress->Post( csMessage );
 	}
 
-} // OutputCSV
+	finder.Close();
+
+} // RecurseGhcn
 
 /////////////////////////////////////////////////////////////////////////////
-// parse a given line of source and persist it
-bool ParseSource
-( 
-	CString& source, CClimateTemperature::MEASURE_TYPE eType
+// count the number of maximum readings greater than several temperatures
+// for every year by scanning the column blocks of the given table. The
+// zone maps let the scan skip every block whose hottest reading is not
+// above the limit, which is nearly all of them for the higher limits.
+void CountGreaterValues
+(
+	CKeyedCollection<CString, CClimateYear>& ClimateYears, CClimateTable& table
 )
 {
-	bool value = false;
+	// greater than counts for each year that has maximum readings
+	map<int, vector<CStationYear::GREATER_COUNT> > mapCounts;
+	for ( auto& node : ClimateYears.Items )
+	{
+		if ( node.second->Maximums.Count == 0 )
+		{
+			continue;
+		}
+
+		vector<CStationYear::GREATER_COUNT> counts;
+		for ( int n = 90; n <= 130; n += 5 )
+		{
+			counts.push_back( CStationYear::GREATER_COUNT( n, 0 ));
+		}
+
+		mapCounts[ _ttoi( node.first ) ] = counts;
+	}
+
+	// the blocks scanned and skipped by this call go to the run statistics
+	const int nBlocksScanned = table.BlocksScanned;
+	const int nBlocksSkipped = table.BlocksSkipped;
+
+	// generate entries for 90 to 130 degrees in 5 degree increments
+	int index = 0;
+	for ( int n = 90; n <= 130; n += 5, index++ )
+	{
+		CScanPredicate predicate;
+		predicate.MeasurementType = CClimateTemperature::mtMaximum;
+		predicate.Above = float( n );
+		predicate.ExcludeMask = m_FlagPolicy.ExcludeMask;
 
-	// create a new CStationYear object based on the source and type
-	shared_ptr< CStationYear > StationYear = shared_ptr< CStationYear >
+		table.Scan
 		(
-			new CStationYear( source, eType )
+			predicate,
+			[&]( CColumnBlock& block, int row )
+			{
+				auto pos = mapCounts.find( block.Year[ row ] );
+				if ( pos == mapCounts.end() )
+				{
+					return;
+				}
+
+				// count the months of the row above the limit
+				for ( int nMonth = 0; nMonth < 12; nMonth++ )
+				{
+					if ( predicate.MatchesMonth( block, row, nMonth ))
+					{
+						pos->second[ index ].second++;
+					}
+				}
+			}
 		);
+	}
 
-	const CString csYear = StationYear->Year;
-	const CString csStation = StationYear->Station;
+	m_RunStatistics.Add
+	(
+		CRunStatistics::scBlocksScanned, table.BlocksScanned - nBlocksScanned
+	);
+	m_RunStatistics.Add
+	(
+		CRunStatistics::scBlocksSkipped, table.BlocksSkipped - nBlocksSkipped
+	);
 
-	const bool bExists = m_ClimateYears.Exists[ csYear ];
+	// store the counts with their years
+	for ( auto& node : ClimateYears.Items )
+	{
+		auto pos = mapCounts.find( _ttoi( node.first ));
+		if ( pos != mapCounts.end() )
+		{
+			node.second->GreaterCounts = pos->second;
+		}
+	}
 
-	shared_ptr<CClimateYear> ClimateYear;
+} // CountGreaterValues
 
-	if ( bExists )
+/////////////////////////////////////////////////////////////////////////////
+// count the greater than values of one partition of the years spilled to
+// disk with column blocks of its own, which lets several partitions be
+// aggregated at once
+void AggregatePartition( CKeyedCollection<CString, CClimateYear>& ClimateYears )
+{
+	CClimateTable table;
+	table.Build( ClimateYears );
+	CountGreaterValues( ClimateYears, table );
+
+} // AggregatePartition
+
+/////////////////////////////////////////////////////////////////////////////
+// output the nearest neighbors of every station in the station file, the
+// --neighbors value is the number of neighbors optionally followed by a
+// colon and the search radius in kilometers
+int OutputNeighbors( CString& csValue, CStdioFile& fOut, CStdioFile& fErr )
+{
+	CString csMessage;
+
+	int nNeighbors = _ttoi( csValue );
+	float fKilometers = FLT_MAX;
+	const int nColon = csValue.Find( _T( ':' ));
+	if ( nColon != -1 )
 	{
-		ClimateYear = m_ClimateYears.find( csYear );
+		fKilometers = (float)_tstof( csValue.Mid( nColon + 1 ));
+	}
+	if ( nNeighbors <= 0 || fKilometers <= 0 )
+	{
+		csMessage.Format( _T( "Invalid --neighbors value: %s\n" ), csValue );
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		return 3;
+	}
 
-	} else
+	// the neighbor lists of all stations are queried in parallel
+	const ULONGLONG ullStart = ::GetTickCount64();
+	m_SpatialIndex.Build( m_StationList );
+	vector<vector<CSpatialIndex::NEIGHBOR> > lists;
+	m_SpatialIndex.GetNeighborLists( nNeighbors, fKilometers, lists );
+	const ULONGLONG ullElapsed = ::GetTickCount64() - ullStart;
+
+	fOut.WriteString( _T( "Station,Neighbor,Rank,Kilometers\n" ) );
+	for ( int index = 0; index < (int)lists.size(); index++ )
 	{
-		ClimateYear = shared_ptr<CClimateYear>( new CClimateYear );
-		ClimateYear->Year = csYear;
-		m_ClimateYears.add( csYear, ClimateYear );
+		const CString csStation = m_StationList.Station[ index ];
+		int nRank = 1;
+		for ( auto& neighbor : lists[ index ] )
+		{
+			csMessage.Format
+			(
+				_T( "%s,%s,%d,%0.1f\n" ), csStation,
+				m_StationList.Station[ neighbor.second ], nRank++, neighbor.first
+			);
+			fOut.WriteString( csMessage );
+		}
 	}
 
-	value = ClimateYear->WriteStationYear( StationYear );
+	csMessage.Format
+	(
+		_T( "Neighbors of %d stations found in %I64u ms using %d grid cells\n" ),
+		m_SpatialIndex.Count, ullElapsed, m_SpatialIndex.CellCount
+	);
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
 
-	return value;
-} // ParseSource
+	return 0;
+
+} // OutputNeighbors
 
 /////////////////////////////////////////////////////////////////////////////
-// crawl through the directory tree looking for given climate extension
-void RecursePath
-( 
-	LPCTSTR path, // pathname to recurse
-	// extension of climate files to process (tmax, tmin, or tavg)
-	LPCTSTR ext, 
-	CStdioFile& fOut, // standard output
-	CStdioFile& fErr // error output
+// read a station's months back from a store through its indexes, the
+// --lookup value is the station ID optionally followed by a colon and
+// the first and last years separated by a dash
+int LookupStation
+(
+	COptions& options, CString& csExe, CStdioFile& fOut, CStdioFile& fErr
 )
 {
-	USES_CONVERSION;
+	CString csMessage;
+	if ( !options.Exists[ _T( "store" ) ] )
+	{
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( _T( "--lookup requires a --store folder\n" ) );
+		return 3;
+	}
 
-	int nStation = 0;
+	CString csLookup = options.Value[ _T( "lookup" ) ];
+	CString csStation = csLookup;
 
-	// determine measurement type from the given extension
-	CClimateTemperature::MEASURE_TYPE eType = CClimateTemperature::mtMaximum;
-	const CString csExtention = CString( ext ).MakeLower();
-	if ( csExtention == _T( ".tmin" ))
+	// without years every date the store can hold is read
+	int nFirstYear = CClimateStore::FIRST_DATE_YEAR;
+	int nLastYear = CClimateStore::LAST_DATE_YEAR;
+
+	const int nColon = csLookup.Find( _T( ':' ));
+	if ( nColon != -1 )
 	{
-		eType = CClimateTemperature::mtMinimum;
+		csStation = csLookup.Left( nColon );
+		const CString csYears = csLookup.Mid( nColon + 1 );
+		const int nDash = csYears.Find( _T( '-' ));
+		if ( nDash == -1 )
+		{
+			nFirstYear = nLastYear = _ttoi( csYears );
 
-	} else if ( csExtention == _T( ".tavg" ))
+		} else
+		{
+			nFirstYear = _ttoi( csYears.Left( nDash ));
+			nLastYear = _ttoi( csYears.Mid( nDash + 1 ));
+		}
+
+		if ( nFirstYear < CClimateStore::FIRST_DATE_YEAR ||
+			nLastYear > CClimateStore::LAST_DATE_YEAR || nLastYear < nFirstYear )
+		{
+			csMessage.Format( _T( "Invalid --lookup years: %s\n" ), csYears );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+	}
+
+	CClimateStore store;
+	store.Root = options.Value[ _T( "store" ) ];
+	store.Version = options.Value[ _T( "version" ) ];
+	if ( !store.LoadSchema( csExe ))
 	{
-		eType = CClimateTemperature::mtAverage;
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( _T( "Unable to load DataSchema.xml\n" ) );
+		return 6;
 	}
 
-	// get the folder which will trim any wild card data
-	CString csPathname = CString( path ).Trim( _T( "\\" ));
+	vector<CClimateStore::STATION_MONTH> months;
+	if ( !store.ReadStation( csStation, nFirstYear, nLastYear, months ))
+	{
+		csMessage.Format
+		( 
+			_T( "Station not found in the store:\n\t%s\n" ), csStation 
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		return 8;
+	}
 
-	// build a pathname with wild-card extension
-	CString strWildcard;
-	strWildcard.Format( _T( "%s\\*.*" ), csPathname );
-	
-	// start trolling for files we are interested in
-	CFileFind finder;
-	BOOL bWorking = finder.FindFile( strWildcard );
-	while ( bWorking )
+	fOut.WriteString
+	(
+		_T( "Station,Year,Month,Maximum,Minimum,Average," )
+		_T( "MaxQcFlag,MinQcFlag,AvgQcFlag\n" )
+	);
+
+	// output the months in Fahrenheit like the yearly summary
+	const float fMissing = CClimateTemperature::GetMissingValue();
+	for ( auto& month : months )
 	{
-		bWorking = finder.FindNextFile();
+		csMessage.Format
+		(
+			_T( "%s,%d,%d,%0.2f,%0.2f,%0.2f,%c,%c,%c\n" ),
+			csStation, month.Year, month.Month,
+			CHelper::GetFahrenheit( month.Maximum, fMissing ),
+			CHelper::GetFahrenheit( month.Minimum, fMissing ),
+			CHelper::GetFahrenheit( month.Average, fMissing ),
+			month.MaxQcFlag, month.MinQcFlag, month.AvgQcFlag
+		);
+		fOut.WriteString( csMessage );
+	}
 
-		// skip "." and ".." folder names
-		if ( finder.IsDots() )
+	csMessage.Format
+	( 
+		_T( "%d months of %s read through the store indexes\n" ), 
+		(int)months.size(), csStation 
+	);
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
+
+	return 0;
+
+} // LookupStation
+
+/////////////////////////////////////////////////////////////////////////////
+// write a synthetic tree of the --generate size, i.e. stations:years[:seed],
+// into the given folder or a folder under the temporary folder when none
+// is given, the folder written is returned in csPath
+int GenerateData( COptions& options, CString& csPath, CStdioFile& fErr )
+{
+	CString csMessage;
+	const CString csValue = options.Value[ _T( "generate" ) ];
+
+	CDataGenerator generator;
+	if ( !generator.Define( csValue ))
+	{
+		csMessage.Format( _T( "Invalid --generate size: %s\n" ), csValue );
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		return 3;
+	}
+
+	if ( csPath.IsEmpty() )
+	{
+		csPath = generator.GetTempFolder();
+	}
+
+	const ULONGLONG ullStart = ::GetTickCount64();
+	if ( !generator.Generate( csPath ))
+	{
+		csMessage.Format
+		(
+			_T( "Unable to generate the climate data:\n\t%s\n" ), csPath
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		return 10;
+	}
+	const ULONGLONG ullElapsed = ::GetTickCount64() - ullStart;
+
+	csMessage.Format
+	(
+		_T( "Generated %d files of %d stations of \"%s\" (%I64d lines, " )
+		_T( "%I64d bytes) in %I64u ms:\n\t%s\n" ),
+		generator.Files, generator.Stations, generator.DatasetLetters,
+		generator.Lines, generator.Bytes, ullElapsed, csPath
+	);
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
+
+	return 0;
+
+} // GenerateData
+
+/////////////////////////////////////////////////////////////////////////////
+// time the ingest, aggregate, count and output phases at each thread count
+// and write the results to the --benchmark JSON file. Every thread count
+// starts over from the station file with empty collections and an empty
+// parse cache so no run benefits from the one before it. The ingest is the
+// path of a normal run, timed a dataset at a time as the "ushcn ingest"
+// (RecursePath), "ghcn-monthly ingest" (RecurseGhcn) and "ghcn-daily
+// ingest" (CGhcnDaily Crawl and Parse) phases with the lines and bytes
+// they read. Each is followed by its crawl, read, parse and insert totals
+// from the run statistics, which are summed over the threads that did the
+// work. RecursePath reads one file at a time on the calling thread so the
+// USHCN files are only timed at the first thread count (one thread) and
+// are read untimed at the others. With --variants the crawl and parse of
+// the parallel dataset variant path are timed instead as the "variants
+// crawl" and "variants parse" phases, the crawl reads no lines so only
+// its bytes are counted. The aggregate and count phases count the station
+// years and bytes ingested and the output counts the rows and characters
+// it wrote.
+int RunBenchmark
+(
+	COptions& options, CString& csPath, const CString& csStationPath,
+	CStdioFile& fErr
+)
+{
+	CString csMessage;
+	const CString csResults = options.Value[ _T( "benchmark" ) ];
+
+	// the files of the first --variants name
+	CString csVariant;
+	const bool bVariants = options.Exists[ _T( "variants" ) ];
+	if ( bVariants )
+	{
+		const CString csVariants = options.Value[ _T( "variants" ) ];
+		int nStart = 0;
+		csVariant = csVariants.Tokenize( _T( "," ), nStart );
+	}
+
+	// the output is formatted into a temporary file
+	TCHAR pFolder[ _MAX_PATH ];
+	TCHAR pOutput[ _MAX_PATH ];
+	::GetTempPath( _MAX_PATH, pFolder );
+	::GetTempFileName( pFolder, _T( "chb" ), 0, pOutput );
+
+	CBenchmark benchmark;
+	vector<int> counts;
+	CBenchmark::GetThreadCounts( counts );
+	fErr.WriteString( _T( ".\n" ) );
+	for ( int nThreads : counts )
+	{
+		m_ClimateYears.clear();
+		m_ClimateTable.Clear();
+		m_ParseCache.Clear();
+		m_ParseCache.Enabled = bVariants;
+		m_arrMaximums.clear();
+		m_arrMinimums.clear();
+		m_arrAverages.clear();
+		m_StationList.Clear();
+		m_StationList.Load( csStationPath );
+		m_GhcnDaily.Clear();
+		if ( bVariants && m_DatasetVariants.Define( csVariant ) == 0 )
 		{
-			continue;
+			csMessage.Format( _T( "Invalid --variants names: %s\n" ), csVariant );
+			fErr.WriteString( csMessage );
+			return 3;
 		}
 
-		// if it's a directory, recursively search it
-		if ( finder.IsDirectory() )
+		// the counters of the ingest phase start from zero
+		m_RunStatistics.Enable( true );
+
+		benchmark.Begin( nThreads );
+
+		LONGLONG llLines = 0;
+		LONGLONG llBytes = 0;
+		if ( !bVariants )
 		{
-			// get the new folder name
-			const CString folder =
-				finder.GetFilePath().TrimRight( _T( "\\" ) );
+			// read a dataset with the counters starting from zero, timing
+			// it and its phase totals if asked to
+			auto ingest = [&]( LPCTSTR dataset, bool bTimed, function<void()> read )
+			{
+				m_RunStatistics.Enable( true );
 
-			// recurse into the new directory with wild cards
-			RecursePath( folder, ext, fOut, fErr );
+				CRunStatistics::THREAD_STATISTICS totals;
+				CString csPhase;
+				csPhase.Format( _T( "%s ingest" ), dataset );
+				if ( !bTimed )
+				{
+					read();
+					m_RunStatistics.GetTotals( totals );
+
+				} else
+				{
+					fErr.WriteString( benchmark.GetReport( benchmark.Time
+					(
+						csPhase,
+						[&]()
+						{
+							read();
+							m_RunStatistics.GetTotals( totals );
+							return CBenchmark::PHASE_VOLUME
+							(
+								totals.Counters[ CRunStatistics::scLines ],
+								totals.Counters[ CRunStatistics::scBytes ]
+							);
+						}
+					)));
+
+					const int pPhases[] =
+					{
+						CRunStatistics::spCrawl, CRunStatistics::spRead,
+						CRunStatistics::spParse, CRunStatistics::spInsert
+					};
+					for ( int ePhase : pPhases )
+					{
+						csPhase.Format
+						(
+							_T( "%s %s" ), dataset, CRunStatistics::GetPhaseName( ePhase )
+						);
+						fErr.WriteString( benchmark.GetReport( benchmark.Add
+						(
+							csPhase, totals.Ticks[ ePhase ], CBenchmark::PHASE_VOLUME
+							(
+								totals.Counters[ CRunStatistics::scLines ],
+								totals.Counters[ CRunStatistics::scBytes ]
+							)
+						)));
+					}
+				}
 
-		} else // write the properties for valid extension
-		{
-			const CString csPath = finder.GetFilePath();
-			const CString csExt = CHelper::GetExtension( csPath ).MakeLower();
-			if ( csExt == ext )
-			{
-				// open the stations text file
-				CStdioFile file;
-				const bool value =
-					file.Open( csPath, CFile::modeRead | CFile::shareDenyNone );
+				llLines += totals.Counters[ CRunStatistics::scRecords ];
+				llBytes += totals.Counters[ CRunStatistics::scBytes ];
+			};
 
-				// if the open was successful, read each line of the file and 
-				// collect the station data
-				if ( value == true )
+			ingest
+			(
+				_T( "ushcn" ), nThreads == counts.front(),
+				[&]()
+				{
+					RecursePath( csPath, _T( ".tmax" ), fErr, fErr );
+					RecursePath( csPath, _T( ".tmin" ), fErr, fErr );
+					RecursePath( csPath, _T( ".tavg" ), fErr, fErr );
+				}
+			);
+			ingest
+			(
+				_T( "ghcn-monthly" ), true,
+				[&]() { RecurseGhcn( csPath, fErr ); }
+			);
+			ingest
+			(
+				_T( "ghcn-daily" ), true,
+				[&]()
 				{
-					bool bFirst = true;
+					m_GhcnDaily.Crawl( csPath, m_RunStatistics );
+					m_GhcnDaily.Parse( m_StationList, m_QueryFilter, m_RunStatistics );
+				}
+			);
 
-					CString csLine;
-					while ( file.ReadString( csLine ) )
+		} else
+		{
+			fErr.WriteString( benchmark.GetReport( benchmark.Time
+			(
+				_T( "variants crawl" ),
+				[&]()
+				{
+					m_DatasetVariants.Crawl
+					(
+						csPath, m_StationList, m_QueryFilter, m_RunStatistics
+					);
+					for ( auto& file : m_DatasetVariants.Variant[ 0 ]->Files )
 					{
-						ParseSource( csLine, eType );
-						if ( bFirst )
+						CFileStatus status;
+						if ( CFile::GetStatus( file.first, status ))
 						{
-							CString csStation;
-							csStation.Format( _T( "%5d %s\n" ), ++nStation, csLine.Left( 11 ));
-							fErr.WriteString( csStation );
-							bFirst = false;
+							llBytes += (LONGLONG)status.m_size;
 						}
 					}
+					return CBenchmark::PHASE_VOLUME( 0, llBytes );
 				}
+			)));
 
-				//fErr.WriteString( csPath );
-				//fErr.WriteString( _T( "\n" ));
-			}
+			fErr.WriteString( benchmark.GetReport( benchmark.Time
+			(
+				_T( "variants parse" ),
+				[&]()
+				{
+					m_DatasetVariants.Parse
+					(
+						m_StationList, m_ParseCache, m_QueryFilter, m_RunStatistics
+					);
+					shared_ptr<CDatasetVariants::DATASET_VARIANT> pVariant =
+						m_DatasetVariants.Variant[ 0 ];
+					for ( auto& node : pVariant->ClimateYears.Items )
+					{
+						m_ClimateYears.add( node.first, node.second );
+					}
+					llLines = pVariant->Rows;
+					return CBenchmark::PHASE_VOLUME( llLines, llBytes );
+				}
+			)));
 		}
+
+		fErr.WriteString( benchmark.GetReport( benchmark.Time
+		(
+			_T( "aggregate" ),
+			[&]()
+			{
+				// the yearly means are calculated on first use and
+				// collected in Fahrenheit as a normal run does
+				m_ClimateTable.Build( m_ClimateYears );
+				const float fMissing = CClimateTemperature::GetMissingValue();
+				for ( auto& node : m_ClimateYears.Items )
+				{
+					const CString csYear = node.second->Year;
+					m_arrMaximums.push_back( YEAR_VALUE
+					(
+						csYear, CHelper::GetFahrenheit( node.second->Maximum, fMissing )
+					));
+					m_arrMinimums.push_back( YEAR_VALUE
+					(
+						csYear, CHelper::GetFahrenheit( node.second->Minimum, fMissing )
+					));
+					m_arrAverages.push_back( YEAR_VALUE
+					(
+						csYear, CHelper::GetFahrenheit( node.second->Average, fMissing )
+					));
+				}
+				return CBenchmark::PHASE_VOLUME( llLines, llBytes );
+			}
+		)));
+
+		fErr.WriteString( benchmark.GetReport( benchmark.Time
+		(
+			_T( "count" ),
+			[&]()
+			{
+				CountGreaterValues( m_ClimateYears, m_ClimateTable );
+				m_GhcnDaily.Apply( m_ClimateYears );
+				return CBenchmark::PHASE_VOLUME( llLines, llBytes );
+			}
+		)));
+
+		fErr.WriteString( benchmark.GetReport( benchmark.Time
+		(
+			_T( "output" ),
+			[&]()
+			{
+				LONGLONG llCharacters = 0;
+				CStdioFile fCsv;
+				if ( fCsv.Open( pOutput, CFile::modeCreate | CFile::modeWrite ))
+				{
+					OutputCSV( fCsv );
+					fCsv.Flush();
+					llCharacters = (LONGLONG)fCsv.GetLength();
+					fCsv.Close();
+				}
+				return CBenchmark::PHASE_VOLUME
+				(
+					m_ClimateYears.Count, llCharacters
+				);
+			}
+		)));
+
+		benchmark.End();
 	}
+	::DeleteFile( pOutput );
 
-	finder.Close();
+	if ( !benchmark.Write( csResults, csPath ))
+	{
+		csMessage.Format
+		(
+			_T( "Unable to write the benchmark results:\n\t%s\n" ), csResults
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		return 11;
+	}
 
-} // RecursePath
+	csMessage.Format
+	(
+		_T( "Benchmark of %d phases written:\n\t%s\n" ), benchmark.Count,
+		csResults
+	);
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
+
+	return 0;
+
+} // RunBenchmark
 
 /////////////////////////////////////////////////////////////////////////////
 // a console application that can crawl through the file
@@ -249,7 +1866,213 @@ int _tmain( int argc, TCHAR* argv[], TCHAR* envp[] )
 	}
 
 	// do some common command line argument corrections
-	vector<CString> arrArgs = CHelper::CorrectedCommandLine( argc, argv );
+	vector<CString> arrCommandLine = 
+		CHelper::CorrectedCommandLine( argc, argv );
+
+	// optional switches which may appear anywhere on the command line
+	COptions options;
+	options.Define
+	( 
+		_T( "store" ), true, 
+		_T( "folder to persist the parsed data into as described by\n" )
+		_T( ".      DataSchema.xml along with its indexes and zone maps" )
+	);
+	options.Define
+	( 
+		_T( "lookup" ), true, 
+		_T( "station[:first-last] reads a station's months back from\n" )
+		_T( ".      the --store folder through its indexes" )
+	);
+	options.Define
+	( 
+		_T( "version" ), true, 
+		_T( "name of the --store version to write or --lookup to read,\n" )
+		_T( ".      versions share every chunk of data that did not change" )
+	);
+	options.Define
+	( 
+		_T( "neighbors" ), true, 
+		_T( "k[:km] outputs the k nearest stations (within km) of every\n" )
+		_T( ".      station in the station file instead of the climate data" )
+	);
+	options.Define
+	( 
+		_T( "baseline" ), true, 
+		_T( "first-last adds each year's mean departure from the station\n" )
+		_T( ".      monthly means of the reference years (i.e. 1951-1980)" )
+	);
+	options.Define
+	( 
+		_T( "gridded" ), true, 
+		_T( "sizes outputs area weighted yearly averages of stations in\n" )
+		_T( ".      latitude / longitude cells for each comma separated\n" )
+		_T( ".      cell size in degrees (i.e. 1,2.5,5)" )
+	);
+	options.Define
+	( 
+		_T( "trends" ), true, 
+		_T( "windows outputs the least squares trend in degrees F per\n" )
+		_T( ".      decade of every station for each comma separated\n" )
+		_T( ".      window of years (i.e. 1900-2020,1970-2020)" )
+	);
+	options.Define
+	( 
+		_T( "monthly" ), false, 
+		_T( "outputs a row for every year and month instead of every year" )
+	);
+	options.Define
+	( 
+		_T( "variants" ), true, 
+		_T( "names parses the comma separated dataset variants (i.e.\n" )
+		_T( ".      raw,tob,FLs.52j) in one pass and outputs their yearly\n" )
+		_T( ".      averages and adjustments from the first variant" )
+	);
+	options.Define
+	( 
+		_T( "arrow" ), true, 
+		_T( "pathname also writes the yearly table to an Apache Arrow IPC\n" )
+		_T( ".      file with typed columns and nulls for missing values" )
+	);
+	options.Define
+	( 
+		_T( "arrow-stations" ), true, 
+		_T( "pathname also writes every station year to an Apache Arrow\n" )
+		_T( ".      IPC file with dictionary encoded station IDs" )
+	);
+	options.Define
+	( 
+		_T( "years" ), true, 
+		_T( "first-last only reads the station years in the range" )
+	);
+	options.Define
+	( 
+		_T( "stations" ), true, 
+		_T( "list only reads the comma separated station IDs or wild\n" )
+		_T( ".      card patterns (i.e. USH00011084,USH0004*)" )
+	);
+	options.Define
+	( 
+		_T( "states" ), true, 
+		_T( "list only reads stations of the comma separated states\n" )
+		_T( ".      in the station file (i.e. AL,GA)" )
+	);
+	options.Define
+	( 
+		_T( "types" ), true, 
+		_T( "list only reads the comma separated measurement types\n" )
+		_T( ".      (i.e. tmax,tmin)" )
+	);
+	options.Define
+	( 
+		_T( "min-months" ), true, 
+		_T( "n leaves the station years with fewer than n valid\n" )
+		_T( ".      months (0 - 12) out of the aggregates" )
+	);
+	options.Define
+	( 
+		_T( "coverage" ), false, 
+		_T( "outputs the number of station years of each year and\n" )
+		_T( ".      measurement type by how many months have data" )
+	);
+	options.Define
+	( 
+		_T( "exclude-flags" ), true, 
+		_T( "letters leaves readings with any of the quality control\n" )
+		_T( ".      flags out of the yearly means, greater than counts\n" )
+		_T( ".      and monthly summary (i.e. DIOS)" )
+	);
+	options.Define
+	( 
+		_T( "weight-days" ), false, 
+		_T( "weights each month of a station year's mean by the share\n" )
+		_T( ".      of days its a - i measurement flag says were present\n" )
+		_T( ".      (the yearly means only)" )
+	);
+	options.Define
+	( 
+		_T( "generate" ), true, 
+		_T( "stations:years[:seed[:datasets]] first writes a synthetic\n" )
+		_T( ".      tree of USHCN (u), GHCN-Monthly (m) and GHCN-Daily (d)\n" )
+		_T( ".      files, \"um\" if left out, (i.e. 1000:100:1221:umd) into\n" )
+		_T( ".      the pathname, or a temporary folder if the pathname is\n" )
+		_T( ".      left out, and reads it" )
+	);
+	options.Define
+	( 
+		_T( "benchmark" ), true, 
+		_T( "pathname times the ingest of each dataset (and its crawl,\n" )
+		_T( ".      read, parse and insert), aggregate, count and output\n" )
+		_T( ".      phases at several thread counts and writes the\n" )
+		_T( ".      throughput to a JSON file instead of the output,\n" )
+		_T( ".      with --variants the variant crawl and parse are\n" )
+		_T( ".      timed in place of the ingest" )
+	);
+	options.Define
+	( 
+		_T( "stats" ), true, 
+		_T( "pathname writes the time of each phase and counts of the\n" )
+		_T( ".      files, lines and records read by thread to a JSON file" )
+	);
+	options.Define
+	( 
+		_T( "trace" ), true, 
+		_T( "pathname writes a timeline of the files parsed, merges and\n" )
+		_T( ".      output chunks of every thread in the Chrome trace event\n" )
+		_T( ".      format (open it in Perfetto or about:tracing)" )
+	);
+	options.Define
+	( 
+		_T( "memory-report" ), false, 
+		_T( "writes the bytes and objects held by each structure of the\n" )
+		_T( ".      climate years, the bytes per station year, and the peak\n" )
+		_T( ".      working set instead of the output" )
+	);
+	options.Define
+	( 
+		_T( "memory-budget" ), true, 
+		_T( "bytes fails the run with exit code 14 when the estimated\n" )
+		_T( ".      bytes per station year exceed the budget (i.e. 4096)" )
+	);
+	options.Define
+	( 
+		_T( "mem-limit" ), true, 
+		_T( "bytes spills the station years to disk by decade once they\n" )
+		_T( ".      hold the limit and aggregates the decades in parallel,\n" )
+		_T( ".      only the yearly output is written (i.e. 4000000000)" )
+	);
+	options.Define
+	( 
+		_T( "heatwave" ), true, 
+		_T( "F:days counts runs of at least days daily maximums above\n" )
+		_T( ".      F degrees Fahrenheit from .dly files (default is 95:3)" )
+	);
+	options.Define
+	( 
+		_T( "cold-spell" ), true, 
+		_T( "F:days counts runs of at least days daily minimums below\n" )
+		_T( ".      F degrees Fahrenheit from .dly files (default is 32:3)" )
+	);
+	options.Define
+	( 
+		_T( "station-runs" ), false, 
+		_T( "outputs the heat waves and cold spells of each station year\n" )
+		_T( ".      of the .dly files instead of the yearly output" )
+	);
+	options.Define
+	( 
+		_T( "progress" ), true, 
+		_T( "seconds between the progress lines of the files read\n" )
+		_T( ".      (default is 1)" )
+	);
+	options.Define
+	( 
+		_T( "quiet" ), false, 
+		_T( "does not write the progress of the files read" )
+	);
+	const bool bOptions = options.Parse( arrCommandLine );
+
+	// the positional arguments with the switches removed
+	vector<CString> arrArgs = options.Arguments;
 	size_t nArgs = arrArgs.size();
 
 	CStdioFile fOut( stdout );
@@ -279,10 +2102,37 @@ int _tmain( int argc, TCHAR* argv[], TCHAR* envp[] )
 		}
 	}
 
+	// a version only names the data of a --store folder
+	if ( bOptions && options.Exists[ _T( "version" ) ] &&
+		!options.Exists[ _T( "store" ) ] )
+	{
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( _T( "--version requires a --store folder\n" ) );
+		return 3;
+	}
+
+	// a lookup only needs the --store folder
+	const bool bLookup = bOptions && options.Exists[ _T( "lookup" ) ];
+	if ( bLookup )
+	{
+		return LookupStation( options, arrArgs[ 0 ], fOut, fErr );
+	}
+
+	// a generated tree may leave out the pathname
+	const bool bGenerate = bOptions && options.Exists[ _T( "generate" ) ];
+
 	// two arguments if a pathname to the climate data is given
 	// three arguments if the station text file name is also given
-	if ( nArgs != 2 && nArgs != 3 )
+	if ( !bOptions || 
+		( nArgs != 2 && nArgs != 3 && !( bGenerate && nArgs == 1 )))
 	{
+		if ( !bOptions )
+		{
+			csMessage.Format( _T( "%s\n" ), options.Error );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+		}
+
 		fErr.WriteString( _T( ".\n" ) );
 		fErr.WriteString
 		(
@@ -304,7 +2154,7 @@ int _tmain( int argc, TCHAR* argv[], TCHAR* envp[] )
 			_T( ".\n" )
 			_T( "Usage:\n" )
 			_T( ".\n" )
-			_T( ".  ClimateHistory pathname [station_file_name]\n" )
+			_T( ".  ClimateHistory pathname [station_file_name] [switches]\n" )
 			_T( ".\n" )
 			_T( "Where:\n" )
 			_T( ".\n" )
@@ -317,99 +2167,551 @@ int _tmain( int argc, TCHAR* argv[], TCHAR* envp[] )
 			_T( ".    \"*.tavg - average temperature files\"\n" )
 			_T( ".    \"*.tmax - maximum temperature files\"\n" )
 			_T( ".    \"*.tmin - minimum temperature files\"\n" )
+			_T( ".    \"*.dat - GHCN-Monthly v4 files of any element\"\n" )
+			_T( ".    (it may be left out with --generate)\n" )
 			_T( ".  station_file_name is the optional station file name: \n" )
 			_T( ".    defaults to: \"ushcn-v2.5-stations.txt\"\n" )
+			_T( ".    (a GHCN-Monthly v4 \".inv\" inventory is also read)\n" )
+			_T( ".\n" )
+			_T( "Switches:\n" )
 			_T( ".\n" )
 		);
 
-		return 3;
+		fErr.WriteString( options.Usage );
+		fErr.WriteString( _T( ".\n" ) );
+
+		return 3;
+	}
+
+	// display the executable path
+	csMessage.Format( _T( "Executable pathname: %s\n" ), arrArgs[ 0 ] );
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
+	fErr.WriteString( _T( ".\n" ) );
+
+	// retrieve the pathname which may be a single period
+	CString csPath = nArgs > 1 ? arrArgs[ 1 ].Trim( _T( "//" )) : CString();
+
+	// the synthetic tree is written first and then read like any other
+	if ( bGenerate )
+	{
+		const int nGenerate = GenerateData( options, csPath, fErr );
+		if ( nGenerate != 0 )
+		{
+			return nGenerate;
+		}
+	}
+
+	// test for current folder character (a period)
+	bool bExists = csPath == _T( "." );
+
+	// if it is not a period, test for existence of the given folder name
+	if ( !bExists )
+	{
+		if ( ::PathFileExists( csPath ) )
+		{
+			bExists = true;
+		}
+	}
+
+	if ( !bExists )
+	{
+		csMessage.Format( _T( "Invalid pathname:\n\t%s\n" ), csPath );
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		fErr.WriteString( _T( ".\n" ) );
+		return 4;
+
+	} else
+	{
+		csMessage.Format( _T( "Given pathname:\n\t%s\n" ), csPath );
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+	}
+
+	// read the station data
+	CString csStationFile( _T( "ushcn-v2.5-stations.txt" ) );
+	if ( nArgs == 3 )
+	{
+		csStationFile = arrArgs[ 2 ];
+	}
+
+	// full pathname of the station file
+	const CString csStationPath = csPath + _T( "\\" ) + csStationFile;
+
+	if ( !::PathFileExists( csStationPath ))
+	{
+		csMessage.Format
+		( 
+			_T( "Invalid Station File Name:\n\t%s\n" ), csStationFile 
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		fErr.WriteString( _T( ".\n" ) );
+		return 5;
+
+	}
+
+	// read the station metadata so the readings can share its indexes
+	const int nStations = m_StationList.Load( csStationPath );
+	csMessage.Format
+	( 
+		_T( "Station file describes %d stations:\n\t%s\n" ), 
+		nStations, csStationFile 
+	);
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
+
+	// the neighbor lists only need the station file
+	if ( options.Exists[ _T( "neighbors" ) ] )
+	{
+		CString csNeighbors = options.Value[ _T( "neighbors" ) ];
+		return OutputNeighbors( csNeighbors, fOut, fErr );
+	}
+
+	// the filters are applied while the files are read
+	if ( !SetQueryFilter( options, fErr ))
+	{
+		return 3;
+	}
+
+	// the phases are timed and counted from here on
+	m_RunStatistics.Enable( options.Exists[ _T( "stats" ) ] );
+	m_RunStatistics.Trace->Enable( options.Exists[ _T( "trace" ) ] );
+
+	// start up COM
+	AfxOleInit();
+	::CoInitialize( NULL );
+
+	// the pathname of the executable
+	const CString csExe = arrArgs[ 0 ];
+
+	//// create a context block so the project goes 
+	//// out of context before the program ends to prevent
+	//// memory leaks
+	//{
+	//	shared_ptr<CProject> pProject = shared_ptr<CProject>
+	//	(	
+	//		new CProject( csExe, csPath, csStationPath )
+	//	);
+
+	//	// there should only be one reference count at this point
+	//	const long lCount = pProject.use_count();
+
+	//}
+
+	// time the phases instead of producing the output
+	if ( options.Exists[ _T( "benchmark" ) ] )
+	{
+		return RunBenchmark( options, csPath, csStationPath, fErr );
+	}
+
+	// the progress of the files read is written by a thread of its own
+	double dProgress = 1.0;
+	if ( options.Exists[ _T( "progress" ) ] )
+	{
+		const CString csProgress = options.Value[ _T( "progress" ) ];
+		dProgress = _tstof( csProgress );
+		if ( dProgress <= 0.0 )
+		{
+			csMessage.Format( _T( "Invalid --progress seconds: %s\n" ), csProgress );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+	}
+	// limits and lengths of the heat waves and cold spells of daily files
+	if ( options.Exists[ _T( "heatwave" ) ] )
+	{
+		const CString csHeat = options.Value[ _T( "heatwave" ) ];
+		if ( !m_GhcnDaily.DefineRun( CGhcnDaily::rtHeat, csHeat ))
+		{
+			csMessage.Format( _T( "Invalid --heatwave F:days: %s\n" ), csHeat );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+	}
+	if ( options.Exists[ _T( "cold-spell" ) ] )
+	{
+		const CString csCold = options.Value[ _T( "cold-spell" ) ];
+		if ( !m_GhcnDaily.DefineRun( CGhcnDaily::rtCold, csCold ))
+		{
+			csMessage.Format( _T( "Invalid --cold-spell F:days: %s\n" ), csCold );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+	}
+	m_GhcnDaily.KeepStationRuns = options.Exists[ _T( "station-runs" ) ];
+
+	// out of core the station years are spilled to disk by decade, which
+	// only the yearly output can be written from
+	// the quality control policy only reaches the yearly means, the greater
+	// than counts and the monthly summary (which has no days weights), the
+	// other outputs read the readings as they were parsed
+	const LPCTSTR pPolicies[] = { _T( "exclude-flags" ), _T( "weight-days" ) };
+	const LPCTSTR pUnfiltered[] =
+	{
+		_T( "baseline" ), _T( "gridded" ), _T( "trends" ), _T( "variants" ),
+		_T( "arrow-stations" ), _T( "coverage" ), _T( "monthly" )
+	};
+	for ( LPCTSTR pPolicy : pPolicies )
+	{
+		if ( !options.Exists[ pPolicy ] )
+		{
+			continue;
+		}
+
+		const bool bWeights = _tcscmp( pPolicy, _T( "weight-days" )) == 0;
+		for ( LPCTSTR pName : pUnfiltered )
+		{
+			const bool bMonthly = _tcscmp( pName, _T( "monthly" )) == 0;
+			if ( options.Exists[ pName ] && ( bWeights || !bMonthly ))
+			{
+				csMessage.Format
+				(
+					_T( "--%s cannot be used with --%s\n" ), pPolicy, pName
+				);
+				fErr.WriteString( _T( ".\n" ) );
+				fErr.WriteString( csMessage );
+				return 3;
+			}
+		}
+	}
+
+	// the budget is tested once the output is written but a value that
+	// is not a number of bytes fails before any data is read
+	double dBudget = 0.0;
+	if ( options.Exists[ _T( "memory-budget" ) ] )
+	{
+		const CString csBudget = options.Value[ _T( "memory-budget" ) ];
+		dBudget = _tstof( csBudget );
+		if ( dBudget <= 0.0 )
+		{
+			csMessage.Format( _T( "Invalid --memory-budget bytes: %s\n" ), csBudget );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+	}
+
+	if ( options.Exists[ _T( "mem-limit" ) ] )
+	{
+		const CString csLimit = options.Value[ _T( "mem-limit" ) ];
+		const LONGLONG llLimit = _ttoi64( csLimit );
+		if ( llLimit <= 0 )
+		{
+			csMessage.Format( _T( "Invalid --mem-limit bytes: %s\n" ), csLimit );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+
+		// these read the station years Release lets go of once their
+		// partition is aggregated
+		const LPCTSTR pWhole[] =
+		{
+			_T( "baseline" ), _T( "gridded" ), _T( "trends" ), _T( "monthly" ),
+			_T( "variants" ), _T( "arrow" ), _T( "arrow-stations" ),
+			_T( "store" ), _T( "exclude-flags" ), _T( "weight-days" ),
+			_T( "coverage" ), _T( "memory-report" ), _T( "memory-budget" )
+		};
+		for ( LPCTSTR pName : pWhole )
+		{
+			if ( options.Exists[ pName ] )
+			{
+				csMessage.Format
+				(
+					_T( "--mem-limit cannot be used with --%s\n" ), pName
+				);
+				fErr.WriteString( _T( ".\n" ) );
+				fErr.WriteString( csMessage );
+				return 3;
+			}
+		}
+
+		if ( !m_SpillPartitions.Start( llLimit ))
+		{
+			csMessage.Format
+			(
+				_T( "Unable to create the spill folder:\n\t%s\n" ),
+				m_SpillPartitions.Folder
+			);
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 15;
+		}
 	}
 
-	// display the executable path
-	csMessage.Format( _T( "Executable pathname: %s\n" ), arrArgs[ 0 ] );
-	fErr.WriteString( _T( ".\n" ) );
-	fErr.WriteString( csMessage );
-	fErr.WriteString( _T( ".\n" ) );
+	CProgressLog* pProgress = m_RunStatistics.Progress;
+	pProgress->Start( dProgress, options.Exists[ _T( "quiet" ) ] );
 
-	// retrieve the pathname which may be a single period
-	CString csPath = arrArgs[ 1 ].Trim( _T( "//" ));
+	// several dataset variants are crawled once and parsed together, the
+	// first variant stands in for the climate data everywhere else
+	if ( options.Exists[ _T( "variants" ) ] )
+	{
+		const CString csVariants = options.Value[ _T( "variants" ) ];
+		if ( m_DatasetVariants.Define( csVariants ) == 0 )
+		{
+			csMessage.Format( _T( "Invalid --variants names: %s\n" ), csVariants );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
 
-	// test for current folder character (a period)
-	bool bExists = csPath == _T( "." );
+		// the variants repeat most lines so they share their decodes
+		m_ParseCache.Enabled = true;
+		{
+			CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "crawl" ));
+			m_DatasetVariants.Crawl
+			(
+				csPath, m_StationList, m_QueryFilter, m_RunStatistics
+			);
+		}
+		m_DatasetVariants.Parse
+		(
+			m_StationList, m_ParseCache, m_QueryFilter, m_RunStatistics
+		);
 
-	// if it is not a period, test for existence of the given folder name
-	if ( !bExists )
+		fErr.WriteString( _T( ".\n" ) );
+		for ( int index = 0; index < m_DatasetVariants.Count; index++ )
+		{
+			shared_ptr<CDatasetVariants::DATASET_VARIANT> pVariant =
+				m_DatasetVariants.Variant[ index ];
+			csMessage.Format
+			(
+				_T( "Variant %s: %d files, %d station years, %d shared\n" ),
+				pVariant->Name, (int)pVariant->Files.size(), pVariant->Rows,
+				pVariant->SharedRows
+			);
+			fErr.WriteString( csMessage );
+		}
+
+		for ( auto& node : m_DatasetVariants.Variant[ 0 ]->ClimateYears.Items )
+		{
+			m_ClimateYears.add( node.first, node.second );
+		}
+
+	} else
 	{
-		if ( ::PathFileExists( csPath ) )
+		// crawl through directory tree defined by the command line
+		// parameter trolling for given climate file extensions
+		CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "crawl and parse" ));
+		RecursePath( csPath, _T( ".tmax" ), fOut, fErr );
+		RecursePath( csPath, _T( ".tmin" ), fOut, fErr );
+		RecursePath( csPath, _T( ".tavg" ), fOut, fErr );
+
+		// GHCN-Monthly files hold every station in one file
+		RecurseGhcn( csPath, fErr );
+
+		// GHCN-Daily files count the days above the greater than limits
+		m_GhcnDaily.Crawl( csPath, m_RunStatistics );
+		if ( m_GhcnDaily.Files > 0 )
 		{
-			bExists = true;
+			CTraceLog::CTraceScope daily( m_RunStatistics.Trace, _T( "parse daily" ));
+			m_GhcnDaily.Parse( m_StationList, m_QueryFilter, m_RunStatistics );
 		}
 	}
+	pProgress->Stop();
 
-	if ( !bExists )
+	// report the daily readings behind the greater than counts
+	if ( m_GhcnDaily.Files > 0 )
 	{
-		csMessage.Format( _T( "Invalid pathname:\n\t%s\n" ), csPath );
+		csMessage.Format
+		(
+			_T( "GHCN-Daily files: %d files, %d years, %I64d valid days, " )
+			_T( "%I64d days failed a quality check\n" ),
+			m_GhcnDaily.Files, m_GhcnDaily.Years, m_GhcnDaily.Days,
+			m_GhcnDaily.Excluded
+		);
 		fErr.WriteString( _T( ".\n" ) );
 		fErr.WriteString( csMessage );
-		fErr.WriteString( _T( ".\n" ) );
-		return 4;
+	}
 
-	} else
+	// report how much of the data the filters kept from being parsed
+	if ( m_QueryFilter.Active )
 	{
-		csMessage.Format( _T( "Given pathname:\n\t%s\n" ), csPath );
+		csMessage.Format
+		(
+			_T( "Query filter skipped %d files and rejected %d of %d " )
+			_T( "lines before decoding\n" ),
+			m_QueryFilter.FilesSkipped, m_QueryFilter.LinesRejected,
+			m_QueryFilter.LinesRead
+		);
 		fErr.WriteString( _T( ".\n" ) );
 		fErr.WriteString( csMessage );
 	}
 
-	// read the station data
-	CString csStationFile( _T( "ushcn-v2.5-stations.txt" ) );
-	if ( nArgs == 3 )
+	// report how much decoding the repeated lines saved
+	if ( m_ParseCache.Enabled )
 	{
-		csStationFile = arrArgs[ 2 ];
+		csMessage.Format
+		(
+			_T( "Parse cache found %d of %d lines (%0.1f%%), saving about %0.0f ms\n" ),
+			m_ParseCache.Hits, m_ParseCache.Lookups, m_ParseCache.HitRate,
+			m_ParseCache.MillisecondsSaved
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
 	}
 
-	// full pathname of the station file
-	const CString csStationPath = csPath + _T( "\\" ) + csStationFile;
-
-	if ( !::PathFileExists( csStationPath ))
+	// the spilled partitions are aggregated into the values of each year
+	const bool bSpilled = m_SpillPartitions.Active;
+	if ( bSpilled )
 	{
+		if ( m_SpillPartitions.Failed )
+		{
+			csMessage.Format
+			(
+				_T( "Unable to write the spill files:\n\t%s\n" ),
+				m_SpillPartitions.Folder
+			);
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 15;
+		}
+
+		const bool bAggregated = m_RunStatistics.Time
+		(
+			CRunStatistics::spAggregate,
+			[&]()
+			{
+				CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "aggregate partitions" ));
+				return m_SpillPartitions.Aggregate
+				(
+					m_ClimateYears, m_RunStatistics,
+					m_QueryFilter.MinimumMonths, AggregatePartition
+				);
+			}
+		);
+		if ( !bAggregated )
+		{
+			csMessage.Format
+			(
+				_T( "Unable to read the spill files:\n\t%s\n" ),
+				m_SpillPartitions.Folder
+			);
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 15;
+		}
+
 		csMessage.Format
-		( 
-			_T( "Invalid Station File Name:\n\t%s\n" ), csStationFile 
+		(
+			_T( "Spilled %d station years (%I64d bytes) %d times into %d " )
+			_T( "partitions and aggregated them in %d batches\n" ),
+			m_SpillPartitions.Records, m_SpillPartitions.SpilledBytes,
+			m_SpillPartitions.Spills, m_SpillPartitions.Partitions,
+			m_SpillPartitions.Batches
 		);
 		fErr.WriteString( _T( ".\n" ) );
 		fErr.WriteString( csMessage );
-		fErr.WriteString( _T( ".\n" ) );
-		return 5;
+	}
 
+	// report the station years the coverage filter left out
+	const int nMinimumMonths = m_QueryFilter.MinimumMonths;
+	if ( nMinimumMonths > 0 )
+	{
+		int nStationYears = 0;
+		int nCovered = 0;
+		for ( auto& node : m_ClimateYears.Items )
+		{
+			for ( int eType = CClimateTemperature::mtMaximum;
+				eType <= CClimateTemperature::mtAverage; eType++ )
+			{
+				const CClimateTemperature::MEASURE_TYPE eMeasure =
+					(CClimateTemperature::MEASURE_TYPE)eType;
+				nStationYears += node.second->GetCoveredStations( eMeasure, 0 );
+				nCovered += node.second->GetCoveredStations( eMeasure, nMinimumMonths );
+			}
+		}
+
+		csMessage.Format
+		(
+			_T( "Coverage filter left out %d of %d station years with " )
+			_T( "fewer than %d valid months\n" ),
+			nStationYears - nCovered, nStationYears, nMinimumMonths
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
 	}
 
-	// start up COM
-	AfxOleInit();
-	::CoInitialize( NULL );
+	// arrange the parsed station years into column blocks with zone maps
+	m_RunStatistics.Time
+	(
+		CRunStatistics::spAggregate,
+		[&]()
+		{
+			CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "build table" ));
+			m_ClimateTable.Build( m_ClimateYears );
+		}
+	);
 
-	// the pathname of the executable
-	const CString csExe = arrArgs[ 0 ];
+	// aggregate the column blocks under the quality control policy
+	m_FlagPolicy.WeightDays = options.Exists[ _T( "weight-days" ) ];
+	if ( m_FlagPolicy.Active )
+	{
+		m_RunStatistics.Time
+		(
+			CRunStatistics::spAggregate,
+			[&]()
+			{
+				m_FlagPolicy.Compute( m_ClimateTable );
+				m_FlagPolicy.Apply( m_ClimateYears );
+			}
+		);
 
-	//// create a context block so the project goes 
-	//// out of context before the program ends to prevent
-	//// memory leaks
-	//{
-	//	shared_ptr<CProject> pProject = shared_ptr<CProject>
-	//	(	
-	//		new CProject( csExe, csPath, csStationPath )
-	//	);
+		csMessage.Format
+		(
+			_T( "Quality control policy excluded %d valid readings%s\n" ),
+			m_FlagPolicy.Excluded,
+			m_FlagPolicy.WeightDays ? _T( " and weighted days missing" ) : _T( "" )
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+	}
 
-	//	// there should only be one reference count at this point
-	//	const long lCount = pProject.use_count();
+	// count the readings greater than several temperatures
+	m_RunStatistics.Time
+	(
+		CRunStatistics::spAggregate,
+		[&]()
+		{
+			CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "count" ));
+			if ( !bSpilled )
+			{
+				CountGreaterValues( m_ClimateYears, m_ClimateTable );
+			}
 
-	//}
+			// daily readings replace the counts of the monthly means
+			m_GhcnDaily.Apply( m_ClimateYears );
+		}
+	);
 
-	// crawl through directory tree defined by the command line
-	// parameter trolling for given climate file extensions
-	RecursePath( csPath, _T( ".tmax" ), fOut, fErr );
-	RecursePath( csPath, _T( ".tmin" ), fOut, fErr );
-	RecursePath( csPath, _T( ".tavg" ), fOut, fErr );
+	// departures from the station baselines of the reference period
+	if ( options.Exists[ _T( "baseline" ) ] )
+	{
+		const CString csBaseline = options.Value[ _T( "baseline" ) ];
+		const int nDash = csBaseline.Find( _T( '-' ));
+		const int nFirst = _ttoi( csBaseline );
+		const int nLast = nDash == -1 ? 0 : _ttoi( csBaseline.Mid( nDash + 1 ));
+		if ( nFirst <= 0 || nLast < nFirst )
+		{
+			csMessage.Format( _T( "Invalid --baseline period: %s\n" ), csBaseline );
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 3;
+		}
+
+		m_AnomalyEngine.FirstYear = nFirst;
+		m_AnomalyEngine.LastYear = nLast;
+		m_RunStatistics.Time
+		(
+			CRunStatistics::spAggregate,
+			[&]() { m_AnomalyEngine.Compute( m_ClimateTable, m_StationList.Count ); }
+		);
+	}
 
 	for ( auto& node : m_ClimateYears.Items )
 	{
@@ -441,10 +2743,7 @@ int _tmain( int argc, TCHAR* argv[], TCHAR* envp[] )
 		const int nMinReadings = node.second->MinReadings;
 		const int nAvgReadings = node.second->AvgReadings;
 
-		// count the number value greater than several temperatures
-		node.second->CountGreaterValues();
-
-		// get the yearly collection
+		// get the yearly collection counted by CountGreaterValues
 		vector<CStationYear::GREATER_COUNT> greaterValues = 
 			node.second->GreaterCounts;
 
@@ -456,9 +2755,229 @@ int _tmain( int argc, TCHAR* argv[], TCHAR* envp[] )
 
 	}
 
+	// the memory held by the climate years while they are all loaded
+	CMemoryReport memory;
+	const bool bMemoryReport = options.Exists[ _T( "memory-report" ) ];
+	const bool bMemoryBudget = options.Exists[ _T( "memory-budget" ) ];
+	if ( bMemoryReport || bMemoryBudget )
+	{
+		memory.Measure( m_ClimateYears, m_ParseCache );
+	}
+
 	// the actual goal is to output comma separated values (CSV)
-	OutputCSV( fOut );
+	{
+		CRunStatistics::CPhaseTimer timer( m_RunStatistics, CRunStatistics::spOutput );
+		CTraceLog::CTraceScope scope( m_RunStatistics.Trace, _T( "output" ));
+		if ( bMemoryReport )
+		{
+			memory.Write( fOut );
+
+		} else if ( options.Exists[ _T( "gridded" ) ] )
+		{
+			CString csSizes = options.Value[ _T( "gridded" ) ];
+			if ( !OutputGridded( csSizes, fOut ))
+			{
+				csMessage.Format( _T( "Invalid --gridded cell sizes: %s\n" ), csSizes );
+				fErr.WriteString( _T( ".\n" ) );
+				fErr.WriteString( csMessage );
+				return 3;
+			}
+
+		} else if ( options.Exists[ _T( "trends" ) ] )
+		{
+			CString csWindows = options.Value[ _T( "trends" ) ];
+			if ( !OutputTrends( csWindows, fOut ))
+			{
+				csMessage.Format( _T( "Invalid --trends windows: %s\n" ), csWindows );
+				fErr.WriteString( _T( ".\n" ) );
+				fErr.WriteString( csMessage );
+				return 3;
+			}
+
+		} else if ( options.Exists[ _T( "monthly" ) ] )
+		{
+			OutputMonthly( fOut );
+
+		} else if ( options.Exists[ _T( "coverage" ) ] )
+		{
+			OutputCoverage( fOut );
+
+		} else if ( options.Exists[ _T( "station-runs" ) ] )
+		{
+			OutputStationRuns( fOut );
+
+		} else if ( options.Exists[ _T( "variants" ) ] )
+		{
+			OutputVariants( fOut );
+
+		} else
+		{
+			OutputCSV( fOut );
+		}
+	}
+
+	// report how much of the data the zone maps allowed the scans to skip
+	csMessage.Format
+	(
+		_T( "Zone map scans skipped %d of %d blocks (%0.1f%%), " )
+		_T( "scanned %d rows and matched %d rows\n" ),
+		m_ClimateTable.BlocksSkipped, m_ClimateTable.BlocksScanned,
+		m_ClimateTable.SkipRate, m_ClimateTable.RowsScanned,
+		m_ClimateTable.RowsMatched
+	);
+	fErr.WriteString( _T( ".\n" ) );
+	fErr.WriteString( csMessage );
+
+	// columnar binary copies of the output for analysis tools
+	const CString csArrows[ 2 ] = { _T( "arrow" ), _T( "arrow-stations" ) };
+	for ( int n = 0; n < 2; n++ )
+	{
+		if ( !options.Exists[ csArrows[ n ] ] )
+		{
+			continue;
+		}
+
+		const CString csArrow = options.Value[ csArrows[ n ] ];
+		const bool bArrow = m_RunStatistics.Time
+		(
+			CRunStatistics::spOutput,
+			[&]()
+			{
+				return n == 0 ?
+					OutputArrow( csArrow ) : OutputArrowStations( csArrow );
+			}
+		);
+		if ( bArrow )
+		{
+			csMessage.Format( _T( "Arrow file written:\n\t%s\n" ), csArrow );
+
+		} else
+		{
+			csMessage.Format( _T( "Unable to write the Arrow file:\n\t%s\n" ), csArrow );
+		}
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		if ( !bArrow )
+		{
+			return 9;
+		}
+	}
+
+	// persist the parsed data with its indexes and zone maps
+	if ( options.Exists[ _T( "store" ) ] )
+	{
+		CClimateStore store;
+		store.Root = options.Value[ _T( "store" ) ];
+		store.Version = options.Value[ _T( "version" ) ];
+		if ( !store.LoadSchema( csExe ))
+		{
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( _T( "Unable to load DataSchema.xml\n" ) );
+			return 6;
+		}
+
+		const bool bStored = m_RunStatistics.Time
+		(
+			CRunStatistics::spOutput,
+			[&]() { return store.Write( m_ClimateYears, m_StationList ); }
+		);
+		if ( !bStored )
+		{
+			csMessage.Format
+			( 
+				_T( "Unable to write the store:\n\t%s\n" ), store.Root 
+			);
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 7;
+		}
+
+		csMessage.Format( _T( "Data stored in:\n\t%s\n" ), store.Root );
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+
+		// report how much of the version was shared with earlier versions
+		if ( !store.Version.IsEmpty() )
+		{
+			shared_ptr<CChunkStore> pChunks = store.Chunks;
+			csMessage.Format
+			(
+				_T( "Version %s wrote %d chunks (%I64u bytes) and shared " )
+				_T( "%d chunks (%I64u bytes)\n" ),
+				store.Version, pChunks->ChunksWritten, pChunks->BytesWritten,
+				pChunks->ChunksShared, pChunks->BytesShared
+			);
+			fErr.WriteString( csMessage );
+		}
+	}
+
+	// where the time of the run went
+	if ( options.Exists[ _T( "stats" ) ] )
+	{
+		const CString csStats = options.Value[ _T( "stats" ) ];
+		if ( !m_RunStatistics.Write( csStats ))
+		{
+			csMessage.Format
+			( 
+				_T( "Unable to write the run statistics:\n\t%s\n" ), csStats 
+			);
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 12;
+		}
+
+		csMessage.Format
+		(
+			_T( "Run statistics of %d threads written:\n\t%s\n" ),
+			m_RunStatistics.Threads, csStats
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+	}
+
+	// the timeline of the run
+	if ( options.Exists[ _T( "trace" ) ] )
+	{
+		CTraceLog* pTrace = m_RunStatistics.Trace;
+		const CString csTrace = options.Value[ _T( "trace" ) ];
+		if ( !pTrace->Write( csTrace ))
+		{
+			csMessage.Format
+			( 
+				_T( "Unable to write the trace:\n\t%s\n" ), csTrace 
+			);
+			fErr.WriteString( _T( ".\n" ) );
+			fErr.WriteString( csMessage );
+			return 13;
+		}
 
+		csMessage.Format
+		(
+			_T( "Trace of %d events written:\n\t%s\n" ), pTrace->Events, csTrace
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+	}
+
+	// fail the run when the footprint grew past the budget so a change
+	// that bloats the station years is caught by the scripts that run it
+	if ( bMemoryBudget )
+	{
+		const double dBytes = memory.BytesPerStationYear;
+		csMessage.Format
+		(
+			_T( "%0.1f bytes per station year of %I64d station years, " )
+			_T( "budget %0.1f, peak working set %I64d bytes\n" ),
+			dBytes, memory.StationYears, dBudget, memory.PeakWorkingSet
+		);
+		fErr.WriteString( _T( ".\n" ) );
+		fErr.WriteString( csMessage );
+		if ( dBytes > dBudget )
+		{
+			fErr.WriteString( _T( "The memory budget was exceeded.\n" ) );
+			return 14;
+		}
+	}
 
 	// all is good
 	return 0;
@@ -7,6 +7,28 @@
 #include "resource.h"
 #include "StationYear.h"
 #include "ClimateYear.h"
+#include "ClimateTable.h"
+#include "ClimateStore.h"
+#include "Options.h"
+#include "StationList.h"
+#include "SpatialIndex.h"
+#include "GriddedAverage.h"
+#include "AnomalyEngine.h"
+#include "TrendEngine.h"
+#include "ParseCache.h"
+#include "DatasetVariants.h"
+#include "MonthlySummary.h"
+#include "CsvWriter.h"
+#include "ArrowWriter.h"
+#include "QueryFilter.h"
+#include "FlagPolicy.h"
+#include "DataGenerator.h"
+#include "Benchmark.h"
+#include "RunStatistics.h"
+#include "MemoryReport.h"
+#include "GhcnMonthly.h"
+#include "GhcnDaily.h"
+#include "SpillPartitions.h"
 #include <memory>
 
 using namespace std;
@@ -23,6 +45,45 @@ vector<YEAR_VALUE> m_arrAverages;
 
 vector< CLIMATE_COUNT > m_ClimaterCounts;
 
+// parsed station years in column blocks with zone maps
+CClimateTable m_ClimateTable;
+
+// station metadata indexed by the dense station index
+CStationList m_StationList;
+
+// latitude / longitude grid over the station list
+CSpatialIndex m_SpatialIndex;
+
+// monthly baselines and yearly anomalies of the station data
+CAnomalyEngine m_AnomalyEngine;
+
+// per station least squares trends of the annual means
+CTrendEngine m_TrendEngine;
+
+// year by month statistics of the column blocks
+CMonthlySummary m_MonthlySummary;
+
+// decoded station years keyed by the hash of their source lines
+CParseCache m_ParseCache;
+
+// raw, time of observation, and homogenized variants ingested together
+CDatasetVariants m_DatasetVariants;
+
+// year, station, state and type filters applied while parsing
+CQueryFilter m_QueryFilter;
+
+// quality control exclusions and days missing weights of the aggregates
+CFlagPolicy m_FlagPolicy;
+
+// phase timers and counters of the run reported by --stats
+CRunStatistics m_RunStatistics;
+
+// days above the greater than limits counted from GHCN-Daily files
+CGhcnDaily m_GhcnDaily;
+
+// station years spilled to disk by decade under --mem-limit
+CSpillPartitions m_SpillPartitions;
+
 
 
 
@@ -0,0 +1,593 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "DataSchema.h"
+#include "CollectionReader.h"
+#include "ClimateYear.h"
+#include "StationList.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// persists the parsed climate data in the folder hierarchy described at
+// the top of DataSchema.xml and reads it back through the indexes:
+//
+//	root
+//		Directory			every stream written (Version,Group,Collection,Name)
+//		StationList			station metadata, one row per station (Station)
+//		Stations.grp
+//			USH00011084		"Station" collection of monthly rows (Date)
+//			...
+//
+// Every collection is indexed by the IndexKeys of its schema, so reading
+// one station, or a range of dates of one station, costs a few page reads
+// of the Directory and Station indexes instead of a scan of the data.
+//
+// When a version name is given, StationList and Stations.grp are written
+// beneath root\<version>.ver instead and their streams are stored as
+// content addressed chunks in root\Chunks. A release that only changes a
+// few stations only writes the chunks of those stations, every other
+// chunk is shared with the versions already in the store. The Directory
+// stays in the root and lists the streams of every version.
+class CClimateStore
+{
+// public definitions
+public:
+	// the years an OLE automation date can hold
+	enum { FIRST_DATE_YEAR = 100, LAST_DATE_YEAR = 9999 };
+
+	// a month of data read back for a station
+	typedef struct tagSTATION_MONTH
+	{
+		int Year;
+		int Month; // 1 to 12
+		float Maximum; // degrees centigrade or missing
+		float Minimum; // degrees centigrade or missing
+		float Average; // degrees centigrade or missing
+		TCHAR MaxQcFlag;
+		TCHAR MinQcFlag;
+		TCHAR AvgQcFlag;
+
+	} STATION_MONTH;
+
+// protected data
+protected:
+	// collection definitions
+	CDataSchema m_Schema;
+
+	// root folder of the store
+	CString m_csRoot;
+
+	// version being written or read (blank when not versioned)
+	CString m_csVersion;
+
+	// chunks shared by the versions of the store
+	shared_ptr<CChunkStore> m_pChunks;
+
+// public properties
+public:
+	// collection definitions
+	inline CDataSchema& GetSchema()
+	{
+		return m_Schema;
+	}
+	// collection definitions
+	__declspec( property( get = GetSchema ) )
+		CDataSchema Schema;
+
+	// root folder of the store
+	inline CString GetRoot()
+	{
+		return m_csRoot;
+	}
+	// root folder of the store
+	inline void SetRoot( CString value )
+	{
+		m_csRoot = value.TrimRight( _T( "\\" ));
+		m_pChunks->Folder = m_csRoot + _T( "\\Chunks" );
+	}
+	// root folder of the store
+	__declspec( property( get = GetRoot, put = SetRoot ) )
+		CString Root;
+
+	// version being written or read (blank when not versioned)
+	inline CString GetVersion()
+	{
+		return m_csVersion;
+	}
+	// version being written or read (blank when not versioned)
+	inline void SetVersion( CString value )
+	{
+		m_csVersion = value;
+	}
+	// version being written or read (blank when not versioned)
+	__declspec( property( get = GetVersion, put = SetVersion ) )
+		CString Version;
+
+	// chunks shared by the versions of the store
+	inline shared_ptr<CChunkStore> GetChunks()
+	{
+		return m_pChunks;
+	}
+	// chunks shared by the versions of the store
+	__declspec( property( get = GetChunks ) )
+		shared_ptr<CChunkStore> Chunks;
+
+	// group folder holding one collection per station
+	inline static CString GetStationGroup()
+	{
+		return _T( "Stations" );
+	}
+	// group folder holding one collection per station
+	__declspec( property( get = GetStationGroup ) )
+		CString StationGroup;
+
+// protected methods
+protected:
+	// folder of a collection given its version and group (either of
+	// which may be blank)
+	CString GetFolder( LPCTSTR version, LPCTSTR group, LPCTSTR collection )
+	{
+		CString value = Root;
+		if ( _tcslen( version ) > 0 )
+		{
+			value += _T( "\\" );
+			value += version;
+			value += _T( ".ver" );
+		}
+		if ( _tcslen( group ) > 0 )
+		{
+			value += _T( "\\" );
+			value += group;
+			value += _T( ".grp" );
+		}
+		value += _T( "\\" );
+		value += collection;
+
+		return value;
+	}
+
+	// date expressed as days since 1900 (OLE automation date) of the
+	// first day of a month, false if the year is outside 100 - 9999
+	static bool GetDate( int nYear, int nMonth, double& dDate )
+	{
+		SYSTEMTIME st;
+		memset( &st, 0, sizeof( st ));
+		st.wYear = (WORD)nYear;
+		st.wMonth = (WORD)nMonth;
+		st.wDay = 1;
+
+		dDate = 0.0;
+		if ( nYear < FIRST_DATE_YEAR || nYear > LAST_DATE_YEAR )
+		{
+			return false;
+		}
+
+		return ::SystemTimeToVariantTime( &st, &dDate ) != FALSE;
+	}
+
+	// year and month of a date expressed as days since 1900
+	static void GetYearMonth( double dDate, int& nYear, int& nMonth )
+	{
+		SYSTEMTIME st;
+		memset( &st, 0, sizeof( st ));
+		::VariantTimeToSystemTime( dDate, &st );
+		nYear = st.wYear;
+		nMonth = st.wMonth;
+	}
+
+	// write one row per stream into the Directory collection
+	void AddDirectory
+	(
+		CCollectionWriter& directory, LPCTSTR version, LPCTSTR group,
+		shared_ptr<CSchemaCollection>& schema, LPCTSTR collection,
+		vector<CString>& arrStreams, double dNow
+	)
+	{
+		for ( auto& csStream : arrStreams )
+		{
+			const int row = directory.Rows;
+			directory.SetText( _T( "GUID" ), row, CHelper::MakeGUID() );
+			directory.SetText( _T( "Version" ), row, version );
+			directory.SetText( _T( "Group" ), row, group );
+			directory.SetText( _T( "Collection" ), row, collection );
+			directory.SetText( _T( "Name" ), row, csStream );
+			directory.SetText( _T( "Schema" ), row, schema->Name );
+			directory.SetText( _T( "Description" ), row, schema->Description );
+			directory.SetInteger( _T( "Classification" ), row, 1 ); // Tabular
+			directory.SetReal( _T( "CreateionDate" ), row, dNow );
+			directory.SetReal( _T( "ModificationDate" ), row, dNow );
+		}
+	}
+
+	// write the monthly rows of one measurement type into the Station
+	// collections of each station
+	void AddStationYears
+	(
+		map<CString, shared_ptr<CCollectionWriter> >& stations,
+		map<CString, map<int, int> >& rows,
+		CKeyedCollection<CString, CStationYear>& StationYears,
+		LPCTSTR value, LPCTSTR dmFlag, LPCTSTR qcFlag, LPCTSTR dsFlag
+	)
+	{
+		shared_ptr<CSchemaCollection> schema = Schema.Find( _T( "Station" ));
+		shared_ptr<CSchemaStream> streamDM = schema->Find( dmFlag );
+		shared_ptr<CSchemaStream> streamQC = schema->Find( qcFlag );
+		shared_ptr<CSchemaStream> streamDS = schema->Find( dsFlag );
+
+		for ( auto& node : StationYears.Items )
+		{
+			const CString csStation = node.first;
+			const int nYear = _ttoi( node.second->Year );
+
+			shared_ptr<CCollectionWriter>& writer = stations[ csStation ];
+			if ( writer == nullptr )
+			{
+				writer = shared_ptr<CCollectionWriter>
+				(
+					new CCollectionWriter( schema )
+				);
+				if ( !Version.IsEmpty() )
+				{
+					writer->Chunks = m_pChunks;
+				}
+			}
+
+			// a station's rows are allocated in the order they are seen
+			map<int, int>& mapRows = rows[ csStation ];
+
+			for ( int nMonth = 0; nMonth < 12; nMonth++ )
+			{
+				const int nKey = nYear * 12 + nMonth;
+				auto pos = mapRows.find( nKey );
+				int row = 0;
+				if ( pos == mapRows.end() )
+				{
+					row = writer->Rows;
+					mapRows[ nKey ] = row;
+					double dDate = 0.0;
+					GetDate( nYear, nMonth + 1, dDate );
+					writer->SetReal( _T( "Date" ), row, dDate );
+
+				} else
+				{
+					row = pos->second;
+				}
+
+				shared_ptr<CClimateTemperature> pMonth = node.second->Month[ nMonth ];
+				writer->SetReal( value, row, pMonth->Centigrade );
+
+				const CString csDM = pMonth->DataMeasurementFlag;
+				const CString csQC = pMonth->QualityControlFlag;
+				const CString csDS = pMonth->DataSourceFlag;
+				writer->SetInteger
+				(
+					dmFlag, row,
+					streamDM->EncodeFlag( csDM.IsEmpty() ? _T( ' ' ) : csDM[ 0 ] )
+				);
+				writer->SetInteger
+				(
+					qcFlag, row,
+					streamQC->EncodeFlag( csQC.IsEmpty() ? _T( ' ' ) : csQC[ 0 ] )
+				);
+				writer->SetInteger
+				(
+					dsFlag, row,
+					streamDS->EncodeFlag( csDS.IsEmpty() ? _T( ' ' ) : csDS[ 0 ] )
+				);
+			}
+		}
+	}
+
+	// copy the Directory rows of the other versions already in the store
+	// so writing one version keeps the streams of the rest listed
+	void CopyDirectory( CCollectionWriter& directory )
+	{
+		shared_ptr<CSchemaCollection> schema = Schema.Find( _T( "Directory" ));
+
+		CCollectionReader reader;
+		if ( !reader.Open( schema, GetFolder( _T( "" ), _T( "" ), _T( "Directory" ))))
+		{
+			return;
+		}
+
+		for ( int row = 0; row < reader.Rows; row++ )
+		{
+			const CString csVersion = reader.GetText( _T( "Version" ), row );
+			if ( csVersion == Version )
+			{
+				continue;
+			}
+
+			// the directory lists itself again when it is written
+			if ( csVersion.IsEmpty() &&
+				reader.GetText( _T( "Collection" ), row ) == _T( "Directory" ))
+			{
+				continue;
+			}
+
+			const int nRow = directory.Rows;
+			for ( auto& stream : schema->Streams )
+			{
+				if ( stream->Text )
+				{
+					directory.SetText
+					(
+						stream->Name, nRow, reader.GetText( stream->Name, row )
+					);
+
+				} else if ( stream->Real )
+				{
+					directory.SetReal
+					(
+						stream->Name, nRow, reader.GetReal( stream->Name, row )
+					);
+
+				} else
+				{
+					directory.SetInteger
+					(
+						stream->Name, nRow, reader.GetInteger( stream->Name, row )
+					);
+				}
+			}
+		}
+	}
+
+	// write the metadata of every station into the StationList collection
+	void AddStationList( CCollectionWriter& stationList, CStationList& StationList )
+	{
+		const int nCount = StationList.Count;
+		for ( int index = 0; index < nCount; index++ )
+		{
+			const int row = stationList.Rows;
+			stationList.SetText( _T( "Station" ), row, StationList.Station[ index ] );
+
+			// stations that are only known from their readings have no
+			// metadata so their cells stay null
+			if ( !StationList.Described[ index ] )
+			{
+				continue;
+			}
+
+			stationList.SetReal( _T( "Latitude" ), row, StationList.Latitude[ index ] );
+			stationList.SetReal( _T( "Longitude" ), row, StationList.Longitude[ index ] );
+			stationList.SetReal( _T( "Elevation" ), row, StationList.Elevation[ index ] );
+			stationList.SetText( _T( "State" ), row, StationList.State[ index ] );
+			stationList.SetText( _T( "Location" ), row, StationList.Location[ index ] );
+			stationList.SetText
+			(
+				_T( "Component1" ), row, StationList.GetComponent( index, 0 )
+			);
+			stationList.SetText
+			(
+				_T( "Component2" ), row, StationList.GetComponent( index, 1 )
+			);
+			stationList.SetText
+			(
+				_T( "Component3" ), row, StationList.GetComponent( index, 2 )
+			);
+			stationList.SetInteger( _T( "OffsetUTC" ), row, StationList.OffsetUTC[ index ] );
+		}
+	}
+
+// public methods
+public:
+	// load the collection definitions from DataSchema.xml which is looked
+	// for beside the executable and then in the current directory
+	bool LoadSchema( LPCTSTR exePath )
+	{
+		const CString csName( _T( "DataSchema.xml" ));
+
+		CString csPath = CHelper::GetFolder( exePath ) + csName;
+		if ( !::PathFileExists( csPath ))
+		{
+			csPath = CHelper::GetCurrentDirectory() + csName;
+		}
+
+		return m_Schema.Load( csPath );
+	}
+
+	// persist the climate years and the station metadata into the store
+	bool Write
+	(
+		CKeyedCollection<CString, CClimateYear>& ClimateYears,
+		CStationList& StationList
+	)
+	{
+		shared_ptr<CSchemaCollection> schemaDirectory = Schema.Find( _T( "Directory" ));
+		shared_ptr<CSchemaCollection> schemaStations = Schema.Find( _T( "StationList" ));
+		shared_ptr<CSchemaCollection> schemaStation = Schema.Find( _T( "Station" ));
+		if ( schemaDirectory == nullptr || schemaStations == nullptr ||
+			schemaStation == nullptr )
+		{
+			return false;
+		}
+
+		// gather the monthly rows of every station
+		map<CString, shared_ptr<CCollectionWriter> > stations;
+		map<CString, map<int, int> > rows;
+		for ( auto& node : ClimateYears.Items )
+		{
+			AddStationYears
+			(
+				stations, rows, node.second->Maximums,
+				_T( "Maximum" ), _T( "MaxDmFlag" ), _T( "MaxQcFlag" ), _T( "MaxDsFlag" )
+			);
+			AddStationYears
+			(
+				stations, rows, node.second->Minimums,
+				_T( "Minimum" ), _T( "MinDmFlag" ), _T( "MinQcFlag" ), _T( "MinDsFlag" )
+			);
+			AddStationYears
+			(
+				stations, rows, node.second->Averages,
+				_T( "Average" ), _T( "AvgDmFlag" ), _T( "AvgQcFlag" ), _T( "AvgDsFlag" )
+			);
+		}
+
+		SYSTEMTIME st;
+		::GetLocalTime( &st );
+		double dNow = 0.0;
+		::SystemTimeToVariantTime( &st, &dNow );
+
+		CCollectionWriter directory( schemaDirectory );
+		CopyDirectory( directory );
+
+		CCollectionWriter stationList( schemaStations );
+		if ( !Version.IsEmpty() )
+		{
+			stationList.Chunks = m_pChunks;
+		}
+
+		for ( auto& node : stations )
+		{
+			const CString csStation = node.first;
+
+			vector<CString> arrStreams;
+			const CString csFolder = GetFolder( Version, StationGroup, csStation );
+			if ( !node.second->Write( csFolder, arrStreams ))
+			{
+				return false;
+			}
+
+			AddDirectory
+			(
+				directory, Version, StationGroup, schemaStation, csStation,
+				arrStreams, dNow
+			);
+		}
+
+		AddStationList( stationList, StationList );
+
+		vector<CString> arrStreams;
+		if ( !stationList.Write( GetFolder( Version, _T( "" ), _T( "StationList" )), arrStreams ))
+		{
+			return false;
+		}
+		AddDirectory
+		(
+			directory, Version, _T( "" ), schemaStations, _T( "StationList" ),
+			arrStreams, dNow
+		);
+
+		// the directory lists itself too
+		vector<CString> arrDirectory;
+		for ( auto& stream : schemaDirectory->Streams )
+		{
+			arrDirectory.push_back( stream->Name );
+		}
+		AddDirectory
+		(
+			directory, _T( "" ), _T( "" ), schemaDirectory, _T( "Directory" ),
+			arrDirectory, dNow
+		);
+
+		arrStreams.clear();
+		return directory.Write( GetFolder( _T( "" ), _T( "" ), _T( "Directory" )), arrStreams );
+	}
+
+	// read the months of one station between two years (inclusive) using
+	// the Directory and Station indexes, false if the station is not in
+	// the store or the years are outside 100 - 9999
+	bool ReadStation
+	(
+		LPCTSTR station, int nFirstYear, int nLastYear,
+		vector<STATION_MONTH>& months
+	)
+	{
+		// is the station's collection listed in the directory?
+		CCollectionReader directory;
+		if ( !directory.Open
+		(
+			Schema.Find( _T( "Directory" )),
+			GetFolder( _T( "" ), _T( "" ), _T( "Directory" ))
+		))
+		{
+			return false;
+		}
+
+		vector<_variant_t> key;
+		key.push_back( _variant_t( (LPCTSTR)Version ));
+		key.push_back( _variant_t( (LPCTSTR)StationGroup ));
+		key.push_back( _variant_t( station ));
+
+		vector<int> rows;
+		directory.Find( key, rows );
+		if ( rows.empty() )
+		{
+			return false;
+		}
+
+		// range lookup of the station's months
+		shared_ptr<CSchemaCollection> schema = Schema.Find( _T( "Station" ));
+		CCollectionReader reader;
+		reader.Chunks = m_pChunks;
+		if ( !reader.Open( schema, GetFolder( Version, StationGroup, station )))
+		{
+			return false;
+		}
+
+		double dFirst = 0.0;
+		double dLast = 0.0;
+		if ( !GetDate( nFirstYear, 1, dFirst ) || !GetDate( nLastYear, 12, dLast ))
+		{
+			return false;
+		}
+
+		vector<_variant_t> low;
+		low.push_back( _variant_t( dFirst ));
+		vector<_variant_t> high;
+		high.push_back( _variant_t( dLast ));
+
+		rows.clear();
+		reader.FindRange( low, high, rows );
+
+		shared_ptr<CSchemaStream> streamMax = schema->Find( _T( "MaxQcFlag" ));
+		shared_ptr<CSchemaStream> streamMin = schema->Find( _T( "MinQcFlag" ));
+		shared_ptr<CSchemaStream> streamAvg = schema->Find( _T( "AvgQcFlag" ));
+
+		for ( int row : rows )
+		{
+			STATION_MONTH month;
+			GetYearMonth( reader.GetReal( _T( "Date" ), row ), month.Year, month.Month );
+			month.Maximum = (float)reader.GetReal( _T( "Maximum" ), row );
+			month.Minimum = (float)reader.GetReal( _T( "Minimum" ), row );
+			month.Average = (float)reader.GetReal( _T( "Average" ), row );
+			month.MaxQcFlag = streamMax->DecodeFlag
+			(
+				(int)reader.GetInteger( _T( "MaxQcFlag" ), row )
+			);
+			month.MinQcFlag = streamMin->DecodeFlag
+			(
+				(int)reader.GetInteger( _T( "MinQcFlag" ), row )
+			);
+			month.AvgQcFlag = streamAvg->DecodeFlag
+			(
+				(int)reader.GetInteger( _T( "AvgQcFlag" ), row )
+			);
+			months.push_back( month );
+		}
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CClimateStore()
+	{
+		m_pChunks = shared_ptr<CChunkStore>( new CChunkStore );
+	}
+
+	// destructor
+	~CClimateStore()
+	{
+	}
+};
@@ -0,0 +1,253 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "KeyedCollection.h"
+#include "ClimateYear.h"
+#include "ScanPredicate.h"
+#include <functional>
+
+/////////////////////////////////////////////////////////////////////////////
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// all of the parsed station years arranged as a sequence of column blocks.
+// Rows are appended in measurement type, year and station order so the
+// zone maps of each block cover a narrow range of years, which is what
+// makes skipping blocks on year and temperature predicates effective.
+class CClimateTable
+{
+// public definitions
+public:
+	// called for each row of a block that satisfies a scan predicate
+	typedef function<void( CColumnBlock& block, int row )> SCAN_CALLBACK;
+
+// protected data
+protected:
+	// blocks of rows
+	vector<shared_ptr<CColumnBlock> > m_arrBlocks;
+
+	// number of blocks examined by scans
+	int m_nBlocksScanned;
+
+	// number of blocks skipped by scans because of their zone maps
+	int m_nBlocksSkipped;
+
+	// number of rows examined by scans
+	int m_nRowsScanned;
+
+	// number of rows that satisfied the scan predicates
+	int m_nRowsMatched;
+
+// public properties
+public:
+	// blocks of rows
+	inline vector<shared_ptr<CColumnBlock> >& GetBlocks()
+	{
+		return m_arrBlocks;
+	}
+	// blocks of rows
+	__declspec( property( get = GetBlocks ) )
+		vector<shared_ptr<CColumnBlock> > Blocks;
+
+	// number of rows in the table
+	inline int GetRows()
+	{
+		int value = 0;
+		for ( auto& block : m_arrBlocks )
+		{
+			value += block->Rows;
+		}
+
+		return value;
+	}
+	// number of rows in the table
+	__declspec( property( get = GetRows ) )
+		int Rows;
+
+	// number of blocks examined by scans
+	inline int GetBlocksScanned()
+	{
+		return m_nBlocksScanned;
+	}
+	// number of blocks examined by scans
+	__declspec( property( get = GetBlocksScanned ) )
+		int BlocksScanned;
+
+	// number of blocks skipped by scans because of their zone maps
+	inline int GetBlocksSkipped()
+	{
+		return m_nBlocksSkipped;
+	}
+	// number of blocks skipped by scans because of their zone maps
+	__declspec( property( get = GetBlocksSkipped ) )
+		int BlocksSkipped;
+
+	// number of rows examined by scans
+	inline int GetRowsScanned()
+	{
+		return m_nRowsScanned;
+	}
+	// number of rows examined by scans
+	__declspec( property( get = GetRowsScanned ) )
+		int RowsScanned;
+
+	// number of rows that satisfied the scan predicates
+	inline int GetRowsMatched()
+	{
+		return m_nRowsMatched;
+	}
+	// number of rows that satisfied the scan predicates
+	__declspec( property( get = GetRowsMatched ) )
+		int RowsMatched;
+
+	// percentage of the examined blocks that were skipped
+	inline float GetSkipRate()
+	{
+		float value = 0.0f;
+		if ( m_nBlocksScanned > 0 )
+		{
+			value = float( m_nBlocksSkipped * 100 ) / m_nBlocksScanned;
+		}
+
+		return value;
+	}
+	// percentage of the examined blocks that were skipped
+	__declspec( property( get = GetSkipRate ) )
+		float SkipRate;
+
+// protected methods
+protected:
+	// append the station years of one measurement type
+	void AddStationYears
+	(
+		CKeyedCollection<CString, CStationYear>& StationYears,
+		shared_ptr<CColumnBlock>& block
+	)
+	{
+		for ( auto& node : StationYears.Items )
+		{
+			if ( !block->AddRow( node.second ))
+			{
+				// the block is full so start a new one
+				m_arrBlocks.push_back( block );
+				block = shared_ptr<CColumnBlock>
+				(
+					new CColumnBlock( block->MeasurementType )
+				);
+				block->AddRow( node.second );
+			}
+		}
+	}
+
+// public methods
+public:
+	// empty the table and reset the scan statistics
+	void Clear()
+	{
+		m_arrBlocks.clear();
+		ResetStatistics();
+	}
+
+	// reset the scan statistics
+	void ResetStatistics()
+	{
+		m_nBlocksScanned = 0;
+		m_nBlocksSkipped = 0;
+		m_nRowsScanned = 0;
+		m_nRowsMatched = 0;
+	}
+
+	// build the blocks from the climate years collected by the parser
+	void Build( CKeyedCollection<CString, CClimateYear>& ClimateYears )
+	{
+		Clear();
+
+		const CClimateTemperature::MEASURE_TYPE eTypes[] =
+		{
+			CClimateTemperature::mtMaximum,
+			CClimateTemperature::mtMinimum,
+			CClimateTemperature::mtAverage
+		};
+
+		// one sequence of blocks per type, ordered by year then station
+		for ( auto eType : eTypes )
+		{
+			shared_ptr<CColumnBlock> block =
+				shared_ptr<CColumnBlock>( new CColumnBlock( eType ));
+
+			for ( auto& node : ClimateYears.Items )
+			{
+				switch ( eType )
+				{
+					case CClimateTemperature::mtMaximum:
+					{
+						AddStationYears( node.second->Maximums, block );
+						break;
+					}
+					case CClimateTemperature::mtMinimum:
+					{
+						AddStationYears( node.second->Minimums, block );
+						break;
+					}
+					case CClimateTemperature::mtAverage:
+					{
+						AddStationYears( node.second->Averages, block );
+						break;
+					}
+				}
+			}
+
+			if ( block->Rows > 0 )
+			{
+				m_arrBlocks.push_back( block );
+			}
+		}
+	}
+
+	// visit every row satisfying the predicate, skipping the blocks whose
+	// zone maps prove they cannot contain a match
+	void Scan( CScanPredicate& predicate, SCAN_CALLBACK callback )
+	{
+		for ( auto& block : m_arrBlocks )
+		{
+			m_nBlocksScanned++;
+			if ( predicate.CanSkip( *block ))
+			{
+				m_nBlocksSkipped++;
+				continue;
+			}
+
+			const int nRows = block->Rows;
+			m_nRowsScanned += nRows;
+			for ( int row = 0; row < nRows; row++ )
+			{
+				if ( predicate.MatchesRow( *block, row ))
+				{
+					m_nRowsMatched++;
+					callback( *block, row );
+				}
+			}
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CClimateTable()
+	{
+		ResetStatistics();
+	}
+
+	// destructor
+	~CClimateTable()
+	{
+	}
+};
@@ -53,6 +53,17 @@ public:
 
 	} MEASURE_TYPE;
 
+	// decoded flags are packed into 32 bits with the quality control
+	// letter A - Z as bits 0 - 25 and the days missing of a data
+	// measurement flag a - i (1 - 9 in the DMFLAG enumeration of
+	// DataSchema.xml) in the four bits starting at bit 27
+	enum
+	{
+		FLAG_LETTERS = 0x03FFFFFF,
+		DAYS_MISSING_SHIFT = 27,
+		DAYS_MISSING_MASK = 0xF,
+	};
+
 // protected data
 protected:
 	// each month contains a value representing the one of three possible
@@ -73,7 +84,7 @@ protected:
 	// 			the pairwise homogenization algorithm removed the value
 	// 		because of too many apparent inhomogeneities occurring
 	// 		close together in time.
-	CString m_csFlagDM;
+	TCHAR m_chFlagDM;
 
 	// Fragment of readme.txt file referenced at the top of this file:
 	// QCFLAG: quality control flag, seven possibilities within
@@ -125,7 +136,7 @@ protected:
 	//	M = values with a non - blank quality control flag in the "qcu"
 	//		dataset are set to missing the adjusted dataset and given
 	//		an "M" quality control flag.
-	CString m_csFlagQC;
+	TCHAR m_chFlagQC;
 
 	// Fragment of readme.txt file referenced at the top of this file:
 	// DSFLAG: data source flag for monthly value :
@@ -151,7 +162,10 @@ protected:
 	//	D = Dr.Henry Diaz, a compilation of data from Bulletin W, LCD, and NCDC Tape
 	//		Deck 3220 ( 1983 )
 	//	G = Professor John Griffiths - primarily from Climatological Data
-	CString m_csFlagDS;
+	TCHAR m_chFlagDS;
+
+	// decoded quality control letter and days missing (see FLAG_LETTERS)
+	DWORD m_dwFlagBits;
 
 // public properties
 public:
@@ -271,14 +285,15 @@ public:
 	// data measurement flag
 	inline CString GetDataMeasurementFlag()
 	{
-		const CString value = m_csFlagDM;
+		const CString value = GetFlagText( m_chFlagDM );
 
 		return value;
 	}
 	// data measurement flag
 	inline void SetDataMeasurementFlag( CString value )
 	{
-		m_csFlagDM = value;
+		m_chFlagDM = GetFlagCharacter( value );
+		DecodeFlags();
 	}
 	// data measurement flag
 	__declspec( property( get = GetDataMeasurementFlag, put = SetDataMeasurementFlag ) )
@@ -287,14 +302,15 @@ public:
 	// quality control flag
 	inline CString GetQualityControlFlag()
 	{
-		const CString value = m_csFlagQC;
+		const CString value = GetFlagText( m_chFlagQC );
 
 		return value;
 	}
 	// quality control flag
 	inline void SetQualityControlFlag( CString value )
 	{
-		m_csFlagQC = value;
+		m_chFlagQC = GetFlagCharacter( value );
+		DecodeFlags();
 	}
 	// quality control flag
 	__declspec( property( get = GetQualityControlFlag, put = SetQualityControlFlag ) )
@@ -303,24 +319,103 @@ public:
 	// data source flag
 	inline CString GetDataSourceFlag()
 	{
-		const CString value = m_csFlagDS;
+		const CString value = GetFlagText( m_chFlagDS );
 
 		return value;
 	}
 	// data source flag
 	inline void SetDataSourceFlag( CString value )
 	{
-		m_csFlagDS = value;
+		m_chFlagDS = GetFlagCharacter( value );
 	}
 	// data source flag
 	__declspec( property( get = GetDataSourceFlag, put = SetDataSourceFlag ) )
 		CString DataSourceFlag;
 
+	// decoded quality control letter and days missing (see FLAG_LETTERS)
+	inline DWORD GetFlagBits()
+	{
+		return m_dwFlagBits;
+	}
+	// decoded quality control letter and days missing (see FLAG_LETTERS)
+	__declspec( property( get = GetFlagBits ) )
+		DWORD FlagBits;
+
+	// days missing from the monthly mean (a - i is 1 - 9, otherwise 0)
+	inline int GetDaysMissing()
+	{
+		return int( m_dwFlagBits >> DAYS_MISSING_SHIFT ) & DAYS_MISSING_MASK;
+	}
+	// days missing from the monthly mean (a - i is 1 - 9, otherwise 0)
+	__declspec( property( get = GetDaysMissing ) )
+		int DaysMissing;
+
 // protected methods
 protected:
+	// a flag is a single character, zero when the line was too short
+	static inline TCHAR GetFlagCharacter( const CString& value )
+	{
+		return value.IsEmpty() ? 0 : value[ 0 ];
+	}
+
+	// text of a flag character as it was read from the line
+	static inline CString GetFlagText( TCHAR flag )
+	{
+		return flag == 0 ? CString() : CString( flag, 1 );
+	}
+
+	// decode the quality control letter and the days missing
+	void DecodeFlags()
+	{
+		m_dwFlagBits = GetQualityControlBit( m_chFlagQC );
+		if ( m_chFlagDM >= _T( 'a' ) && m_chFlagDM <= _T( 'i' ))
+		{
+			const DWORD dwDays = DWORD( m_chFlagDM - _T( 'a' ) + 1 );
+			m_dwFlagBits |= dwDays << DAYS_MISSING_SHIFT;
+		}
+	}
 
 // public methods
 public:
+	// map a quality control flag character to its bit in a flag mask,
+	// a blank flag has no bit
+	static inline DWORD GetQualityControlBit( TCHAR flag )
+	{
+		if ( flag >= _T( 'A' ) && flag <= _T( 'Z' ))
+		{
+			return DWORD( 1 ) << ( flag - _T( 'A' ));
+		}
+
+		return 0;
+	}
+
+	// mask of quality control flag letters (i.e. "DIOS" or "D,I,O,S")
+	// and return the number of letters, zero if any is not a letter
+	static int GetQualityControlMask( const CString& csFlags, DWORD& dwMask )
+	{
+		int value = 0;
+		dwMask = 0;
+		const int nLength = csFlags.GetLength();
+		for ( int n = 0; n < nLength; n++ )
+		{
+			const TCHAR ch = (TCHAR)_totupper( csFlags[ n ] );
+			if ( ch == _T( ',' ) || ch == _T( ' ' ))
+			{
+				continue;
+			}
+
+			const DWORD dwBit = GetQualityControlBit( ch );
+			if ( dwBit == 0 )
+			{
+				dwMask = 0;
+				return 0;
+			}
+			dwMask |= dwBit;
+			value++;
+		}
+
+		return value;
+	}
 
 // protected overrides
 protected:
@@ -335,6 +430,10 @@ public:
 	{
 		Centigrade = MissingValue;
 		MeasurementType = mtMissing;
+		m_chFlagDM = 0;
+		m_chFlagQC = 0;
+		m_chFlagDS = 0;
+		m_dwFlagBits = 0;
 	}
 
 	// constructor given a source line of text, the starting position of
@@ -366,14 +465,16 @@ public:
 		const CString csValue = source.Mid( nStart, ValueLength ).Trim();
 		const float fValue = (float)_tstof( csValue );
 
-		// parse the flags from the source line
+		// parse the flags from the source line without building strings
 		nStart += ValueLength;
-		DataMeasurementFlag = source.Mid( nStart, FlagLength );
+		const int nLength = source.GetLength();
+		m_chFlagDM = nStart < nLength ? source[ nStart ] : 0;
 		nStart += FlagLength;
-		QualityControlFlag = source.Mid( nStart, FlagLength );
+		m_chFlagQC = nStart < nLength ? source[ nStart ] : 0;
 		nStart += FlagLength;
-		DataSourceFlag = source.Mid( nStart, FlagLength );
+		m_chFlagDS = nStart < nLength ? source[ nStart ] : 0;
 		nStart += FlagLength;
+		DecodeFlags();
 
 		// is our data missing?
 		const float fMissing = MissingValue;
@@ -27,6 +27,10 @@ protected:
 	// average temperature
 	float m_fAverage;
 
+	// has the temperature of each measurement type been calculated or
+	// set? a value set to missing (i.e. by the flag policy) stays missing
+	bool m_bComputed[ 4 ];
+
 	// number of maximum stations
 	int m_nMaxStations;
 
@@ -59,6 +63,14 @@ protected:
 	// number of valid average readings
 	int m_nAvgReadings;
 
+	// number of daily readings the greater than counts were taken from
+	// (0 when they were taken from the monthly maximum readings)
+	int m_nGreaterReadings;
+
+	// station years by measurement type and number of valid months,
+	// including those left out for having too few valid months
+	int m_nCoverage[ 4 ][ 13 ];
+
 // public properties
 public:
 	// year of readings
@@ -80,6 +92,12 @@ public:
 	// number of maximum stations
 	inline int GetMaxStations()
 	{
+		// the persisted count remains after the station years are released
+		if ( m_Maximums.Count == 0 )
+		{
+			return m_nMaxStations;
+		}
+
 		const int value = m_Maximums.Count;
 		MaxStations = value;
 
@@ -97,6 +115,12 @@ public:
 	// number of minimum stations
 	inline int GetMinStations()
 	{
+		// the persisted count remains after the station years are released
+		if ( m_Minimums.Count == 0 )
+		{
+			return m_nMinStations;
+		}
+
 		const int value = m_Minimums.Count;
 		MinStations = value;
 
@@ -114,6 +138,12 @@ public:
 	// number of average stations
 	inline int GetAvgStations()
 	{
+		// the persisted count remains after the station years are released
+		if ( m_Averages.Count == 0 )
+		{
+			return m_nAvgStations;
+		}
+
 		const int value = m_Averages.Count;
 		AvgStations = value;
 
@@ -128,6 +158,33 @@ public:
 	__declspec( property( get = GetAvgStations, put = SetAvgStations ) )
 		int AvgStations;
 
+	// rapid station lookup of maximum temperatures
+	inline CKeyedCollection<CString, CStationYear>& GetMaximums()
+	{
+		return m_Maximums;
+	}
+	// rapid station lookup of maximum temperatures
+	__declspec( property( get = GetMaximums ) )
+		CKeyedCollection<CString, CStationYear> Maximums;
+
+	// rapid station lookup of minimum temperatures
+	inline CKeyedCollection<CString, CStationYear>& GetMinimums()
+	{
+		return m_Minimums;
+	}
+	// rapid station lookup of minimum temperatures
+	__declspec( property( get = GetMinimums ) )
+		CKeyedCollection<CString, CStationYear> Minimums;
+
+	// rapid station lookup of average temperatures
+	inline CKeyedCollection<CString, CStationYear>& GetAverages()
+	{
+		return m_Averages;
+	}
+	// rapid station lookup of average temperatures
+	__declspec( property( get = GetAverages ) )
+		CKeyedCollection<CString, CStationYear> Averages;
+
 	// average maximum temperature
 	inline float GetMaximum()
 	{
@@ -137,9 +194,9 @@ public:
 		// begin with the persisted value
 		float value = m_fMaximum;
 
-		// if the average maximum has already been calculated, use the 
-		// persisted value;
-		if ( !CHelper::NearlyEqual( value, fMissing ) )
+		// if the average maximum has already been calculated or set, use
+		// the persisted value even when it is missing
+		if ( m_bComputed[ CClimateTemperature::mtMaximum ] )
 		{
 			return value;
 		}
@@ -190,6 +247,7 @@ public:
 	inline void SetMaximum( float value )
 	{
 		m_fMaximum = value;
+		m_bComputed[ CClimateTemperature::mtMaximum ] = true;
 	}
 	// average maximum temperature
 	__declspec( property( get = GetMaximum, put = SetMaximum ) )
@@ -204,9 +262,9 @@ public:
 		// begin with the persisted value
 		float value = m_fMinimum;
 
-		// if the average minimum has already been calculated, use the 
-		// persisted value;
-		if ( !CHelper::NearlyEqual( value, fMissing ) )
+		// if the average minimum has already been calculated or set, use
+		// the persisted value even when it is missing
+		if ( m_bComputed[ CClimateTemperature::mtMinimum ] )
 		{
 			return value;
 		}
@@ -257,6 +315,7 @@ public:
 	inline void SetMinimum( float value )
 	{
 		m_fMinimum = value;
+		m_bComputed[ CClimateTemperature::mtMinimum ] = true;
 	}
 	// average minimum temperature
 	__declspec( property( get = GetMinimum, put = SetMinimum ) )
@@ -271,9 +330,9 @@ public:
 		// begin with the persisted value
 		float value = m_fAverage;
 
-		// if the average has already been calculated, use the 
-		// persisted value;
-		if ( !CHelper::NearlyEqual( value, fMissing ) )
+		// if the average has already been calculated or set, use the
+		// persisted value even when it is missing
+		if ( m_bComputed[ CClimateTemperature::mtAverage ] )
 		{
 			return value;
 		}
@@ -324,6 +383,7 @@ public:
 	inline void SetAverage( float value )
 	{
 		m_fAverage = value;
+		m_bComputed[ CClimateTemperature::mtAverage ] = true;
 	}
 	// average temperature
 	__declspec( property( get = GetAverage, put = SetAverage ) )
@@ -332,22 +392,8 @@ public:
 	// number of valid maximum readings
 	inline int GetMaxReadings()
 	{
-		int value = m_nMaxReadings;
-
-		// if the value is zero, calculate it
-		if ( value == 0 )
-		{
-			// sum up the valid readings from each station
-			for ( auto& node : m_Maximums.Items )
-			{
-				value += node.second->ValidReadings;
-			}
-		}
-
-		// persist the reading
-		MaxReadings = value;
-
-		return value;
+		// counted as the station years are written
+		return m_nMaxReadings;
 	}
 	// number of valid maximum readings
 	inline void SetMaxReadings( int value )
@@ -361,22 +407,8 @@ public:
 	// number of valid minimum readings
 	inline int GetMinReadings()
 	{
-		int value = m_nMinReadings;
-
-		// if the value is zero, calculate it
-		if ( value == 0 )
-		{
-			// sum up the valid readings from each station
-			for ( auto& node : m_Minimums.Items )
-			{
-				value += node.second->ValidReadings;
-			}
-		}
-
-		// persist the reading
-		MinReadings = value;
-
-		return value;
+		// counted as the station years are written
+		return m_nMinReadings;
 	}
 	// number of valid minimum readings
 	inline void SetMinReadings( int value )
@@ -390,22 +422,8 @@ public:
 	// number of valid average readings
 	inline int GetAvgReadings()
 	{
-		int value = m_nAvgReadings;
-
-		// if the value is zero, calculate it
-		if ( value == 0 )
-		{
-			// sum up the valid readings from each station
-			for ( auto& node : m_Averages.Items )
-			{
-				value += node.second->ValidReadings;
-			}
-		}
-
-		// persist the reading
-		AvgReadings = value;
-
-		return value;
+		// counted as the station years are written
+		return m_nAvgReadings;
 	}
 	// number of valid average readings
 	inline void SetAvgReadings( int value )
@@ -419,7 +437,7 @@ public:
 	// array of Greater Than pairs
 	// first number is the Fahrenheit temperature 
 	// the second number is the number of temperatures greater than the first number
-	inline vector<CStationYear::GREATER_COUNT> GetGreaterCounts()
+	inline vector<CStationYear::GREATER_COUNT>& GetGreaterCounts()
 	{
 		return m_GreaterCounts;
 	}
@@ -436,18 +454,72 @@ public:
 	__declspec( property( get = GetGreaterCounts, put = SetGreaterCounts ) )
 		vector<CStationYear::GREATER_COUNT> GreaterCounts;
 
+	// number of readings the greater than counts were taken from, the
+	// valid maximum readings unless daily readings replaced the counts
+	inline int GetGreaterReadings()
+	{
+		return m_nGreaterReadings == 0 ? m_nMaxReadings : m_nGreaterReadings;
+	}
+	// number of readings the greater than counts were taken from, the
+	// valid maximum readings unless daily readings replaced the counts
+	inline void SetGreaterReadings( int value )
+	{
+		m_nGreaterReadings = value;
+	}
+	// number of readings the greater than counts were taken from, the
+	// valid maximum readings unless daily readings replaced the counts
+	__declspec( property( get = GetGreaterReadings, put = SetGreaterReadings ))
+		int GreaterReadings;
+
+	// number of station years of a measurement type with exactly the
+	// given number of valid months (0 to 12)
+	inline int GetCoverage
+	(
+		CClimateTemperature::MEASURE_TYPE eType, int nMonths
+	)
+	{
+		return m_nCoverage[ eType ][ nMonths ];
+	}
+
+	// number of station years of a measurement type with at least the
+	// given number of valid months
+	int GetCoveredStations
+	(
+		CClimateTemperature::MEASURE_TYPE eType, int nMinimum
+	)
+	{
+		int value = 0;
+		for ( int nMonths = max( nMinimum, 0 ); nMonths <= 12; nMonths++ )
+		{
+			value += m_nCoverage[ eType ][ nMonths ];
+		}
+
+		return value;
+	}
+
 // protected methods
 protected:
 
 // public methods
 public:
-	// store climate year data
-	bool WriteStationYear( shared_ptr< CStationYear >& Year )
+	// store climate year data, a station year with fewer valid months
+	// than the minimum is counted in the coverage but not stored
+	bool WriteStationYear
+	(
+		shared_ptr< CStationYear >& Year, int nMinimumMonths = 0
+	)
 	{
 		bool value = false;
 		CClimateTemperature::MEASURE_TYPE eType = Year->MeasurementType;
 		const CString csStation = Year->Station;
 
+		const int nValid = Year->ValidReadings;
+		if ( nValid < nMinimumMonths )
+		{
+			m_nCoverage[ eType ][ nValid ]++;
+			return true;
+		}
+
 		switch ( eType )
 		{
 			case CClimateTemperature::mtMaximum:
@@ -471,9 +543,50 @@ public:
 			}
 		}
 
+		// the readings and coverage are counted from the validity mask
+		// once here instead of by visiting every station year later
+		if ( value )
+		{
+			m_nCoverage[ eType ][ nValid ]++;
+			switch ( eType )
+			{
+				case CClimateTemperature::mtMaximum:
+				{
+					m_nMaxReadings += nValid;
+					break;
+				}
+				case CClimateTemperature::mtMinimum:
+				{
+					m_nMinReadings += nValid;
+					break;
+				}
+				default:
+				{
+					m_nAvgReadings += nValid;
+					break;
+				}
+			}
+		}
+
 		return value;
 	}
 
+	// persist the values of the year and let go of its station years,
+	// which is all an aggregated partition of spilled years keeps
+	void Release()
+	{
+		Maximum = GetMaximum();
+		Minimum = GetMinimum();
+		Average = GetAverage();
+		MaxStations = GetMaxStations();
+		MinStations = GetMinStations();
+		AvgStations = GetAvgStations();
+
+		m_Maximums.clear();
+		m_Minimums.clear();
+		m_Averages.clear();
+	}
+
 	// count the number values greater than several temperatures
 	void CountGreaterValues()
 	{
@@ -525,9 +638,10 @@ public:
 		const float fMissing = CClimateTemperature::GetMissingValue();
 
 		// initialize the values to missing to force a calculation
-		Maximum = fMissing;
-		Minimum = fMissing;
-		Average = fMissing;
+		m_fMaximum = fMissing;
+		m_fMinimum = fMissing;
+		m_fAverage = fMissing;
+		ZeroMemory( m_bComputed, sizeof( m_bComputed ));
 
 		// station count for each measurement type
 		MaxStations = 0;
@@ -538,6 +652,8 @@ public:
 		MaxReadings = 0;
 		MinReadings = 0;
 		AvgReadings = 0;
+		GreaterReadings = 0;
+		ZeroMemory( m_nCoverage, sizeof( m_nCoverage ));
 	}
 
 	// destructor
@@ -0,0 +1,582 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CollectionWriter.h"
+#include "comutil.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// reads a collection persisted by CCollectionWriter. The streams, zone
+// maps and index are memory mapped when they are first used, and the
+// Find methods use the collection's index automatically when one was
+// written, falling back on a scan of the key streams when it was not.
+// Streams persisted as chunks are read through their manifests, mapping
+// each chunk of rows from the chunk store as it is touched. The scan also
+// reads the zone maps of a real number leading key and skips the blocks
+// of rows whose minimum and maximum cannot be in the range.
+class CCollectionReader
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// definition of the collection
+	shared_ptr<CSchemaCollection> m_pSchema;
+
+	// folder the collection is persisted in
+	CString m_csFolder;
+
+	// mapped streams keyed by stream name
+	map<CString, shared_ptr<CMappedFile> > m_mapStreams;
+
+	// mapped zone maps keyed by stream name
+	map<CString, shared_ptr<CMappedFile> > m_mapZones;
+
+	// mapped chunk manifests keyed by stream name
+	map<CString, shared_ptr<CMappedFile> > m_mapManifests;
+
+	// first row of each chunk of a manifest keyed by stream name
+	map<CString, vector<int> > m_mapChunkStarts;
+
+	// optional store of chunks shared between versions
+	shared_ptr<CChunkStore> m_pChunks;
+
+	// index built from the IndexKeys streams
+	CIndexFile m_Index;
+
+	// number of rows in the collection
+	int m_nRows;
+
+// public properties
+public:
+	// definition of the collection
+	inline shared_ptr<CSchemaCollection> GetSchema()
+	{
+		return m_pSchema;
+	}
+	// definition of the collection
+	__declspec( property( get = GetSchema ) )
+		shared_ptr<CSchemaCollection> Schema;
+
+	// folder the collection is persisted in
+	inline CString GetFolder()
+	{
+		return m_csFolder;
+	}
+	// folder the collection is persisted in
+	__declspec( property( get = GetFolder ) )
+		CString Folder;
+
+	// number of rows in the collection
+	inline int GetRows()
+	{
+		return m_nRows;
+	}
+	// number of rows in the collection
+	__declspec( property( get = GetRows ) )
+		int Rows;
+
+	// optional store of chunks shared between versions
+	inline shared_ptr<CChunkStore> GetChunks()
+	{
+		return m_pChunks;
+	}
+	// optional store of chunks shared between versions
+	inline void SetChunks( shared_ptr<CChunkStore> value )
+	{
+		m_pChunks = value;
+	}
+	// optional store of chunks shared between versions
+	__declspec( property( get = GetChunks, put = SetChunks ) )
+		shared_ptr<CChunkStore> Chunks;
+
+	// was an index persisted with the collection?
+	inline bool GetHasIndex()
+	{
+		return m_Index.IsOpen;
+	}
+	// was an index persisted with the collection?
+	__declspec( property( get = GetHasIndex ) )
+		bool HasIndex;
+
+// protected methods
+protected:
+	// map a stream (or its zone maps) on first use
+	shared_ptr<CMappedFile> Map
+	(
+		map<CString, shared_ptr<CMappedFile> >& files,
+		LPCTSTR name, LPCTSTR extension
+	)
+	{
+		auto pos = files.find( name );
+		if ( pos != files.end() )
+		{
+			return pos->second;
+		}
+
+		shared_ptr<CMappedFile> file = shared_ptr<CMappedFile>( new CMappedFile );
+		const CString csPath = m_csFolder + _T( "\\" ) + name + extension;
+		if ( !file->Open( csPath ))
+		{
+			file.reset();
+		}
+
+		files[ name ] = file;
+		return file;
+	}
+
+	// chunk manifest of a stream or nullptr if it was not chunked
+	shared_ptr<CMappedFile> GetManifest( shared_ptr<CSchemaStream>& stream )
+	{
+		if ( m_pChunks == nullptr )
+		{
+			return nullptr;
+		}
+
+		return Map
+		(
+			m_mapManifests, stream->Name, CChunkStore::GetManifestExtension()
+		);
+	}
+
+	// first row of each chunk of a manifest, built on first use
+	vector<int>& GetChunkStarts
+	(
+		shared_ptr<CSchemaStream>& stream, shared_ptr<CMappedFile>& manifest
+	)
+	{
+		auto pos = m_mapChunkStarts.find( stream->Name );
+		if ( pos != m_mapChunkStarts.end() )
+		{
+			return pos->second;
+		}
+
+		typedef CChunkStore::CHUNK_REFERENCE CHUNK_REFERENCE;
+		const int nChunks = int( manifest->Size / sizeof( CHUNK_REFERENCE ));
+		vector<int>& value = m_mapChunkStarts[ stream->Name ];
+		int nStart = 0;
+		for ( int n = 0; n < nChunks; n++ )
+		{
+			CHUNK_REFERENCE reference;
+			memcpy
+			(
+				&reference, manifest->Data + n * sizeof( CHUNK_REFERENCE ),
+				sizeof( CHUNK_REFERENCE )
+			);
+			value.push_back( nStart );
+			nStart += (int)reference.Rows;
+		}
+
+		return value;
+	}
+
+	// address of a cell of a stream persisted as chunks
+	const BYTE* GetChunkCell( shared_ptr<CSchemaStream>& stream, int row )
+	{
+		shared_ptr<CMappedFile> manifest = GetManifest( stream );
+		if ( manifest == nullptr )
+		{
+			return nullptr;
+		}
+
+		// the chunks are cut on content so the chunk of a row is found
+		// from the first rows of the chunks
+		typedef CChunkStore::CHUNK_REFERENCE CHUNK_REFERENCE;
+		vector<int>& starts = GetChunkStarts( stream, manifest );
+		auto pos = upper_bound( starts.begin(), starts.end(), row );
+		if ( pos == starts.begin() )
+		{
+			return nullptr;
+		}
+		const int nChunk = int( pos - starts.begin() ) - 1;
+		const ULONGLONG ullReference = ULONGLONG( nChunk ) * sizeof( CHUNK_REFERENCE );
+
+		CHUNK_REFERENCE reference;
+		memcpy( &reference, manifest->Data + ullReference, sizeof( CHUNK_REFERENCE ));
+
+		shared_ptr<CMappedFile> chunk = m_pChunks->Get( reference.Hash );
+		if ( chunk == nullptr )
+		{
+			return nullptr;
+		}
+
+		const ULONGLONG ullOffset = ULONGLONG( row - starts[ nChunk ] ) * stream->Size;
+		if ( ullOffset + stream->Size > chunk->Size )
+		{
+			return nullptr;
+		}
+
+		return chunk->Data + ullOffset;
+	}
+
+	// number of rows of a stream persisted as chunks
+	int GetChunkRows( shared_ptr<CSchemaStream>& stream )
+	{
+		shared_ptr<CMappedFile> manifest = GetManifest( stream );
+		if ( manifest == nullptr )
+		{
+			return 0;
+		}
+
+		typedef CChunkStore::CHUNK_REFERENCE CHUNK_REFERENCE;
+		const int nChunks = int( manifest->Size / sizeof( CHUNK_REFERENCE ));
+
+		int value = 0;
+		for ( int n = 0; n < nChunks; n++ )
+		{
+			CHUNK_REFERENCE reference;
+			memcpy
+			(
+				&reference, manifest->Data + n * sizeof( CHUNK_REFERENCE ),
+				sizeof( CHUNK_REFERENCE )
+			);
+			value += (int)reference.Rows;
+		}
+
+		return value;
+	}
+
+	// address of a cell or nullptr if the stream was not persisted
+	const BYTE* GetCell
+	(
+		LPCTSTR name, int row, shared_ptr<CSchemaStream>& stream
+	)
+	{
+		stream = m_pSchema->Find( name );
+		if ( stream == nullptr || row < 0 || row >= m_nRows )
+		{
+			return nullptr;
+		}
+
+		shared_ptr<CMappedFile> file = Map( m_mapStreams, stream->Name, _T( ".dat" ));
+		if ( file == nullptr )
+		{
+			return GetChunkCell( stream, row );
+		}
+
+		const ULONGLONG ullOffset = ULONGLONG( row ) * stream->Size;
+		if ( ullOffset + stream->Size > file->Size )
+		{
+			return nullptr;
+		}
+
+		return file->Data + ullOffset;
+	}
+
+	// encode key values (which may be fewer than the number of key
+	// streams) into the memcmp ordered form used by the index and return
+	// the number of bytes encoded
+	int EncodeKey( vector<_variant_t>& values, vector<BYTE>& key )
+	{
+		key.clear();
+
+		vector<CString>& arrKeys = m_pSchema->IndexKeys;
+		const size_t nValues = min( values.size(), arrKeys.size() );
+		for ( size_t n = 0; n < nValues; n++ )
+		{
+			shared_ptr<CSchemaStream> stream = m_pSchema->Find( arrKeys[ n ] );
+			if ( stream == nullptr )
+			{
+				break;
+			}
+
+			// build the cell as the writer would have persisted it
+			vector<BYTE> cell( stream->Size, 0 );
+			_variant_t& value = values[ n ];
+			if ( stream->Text )
+			{
+				const CStringA csValue( (LPCTSTR)_bstr_t( value ));
+				memcpy( &cell[ 0 ], (LPCSTR)csValue, min( csValue.GetLength(), stream->Size ));
+
+			} else if ( stream->Type == VT_R4 )
+			{
+				const float fValue = (float)(double)value;
+				memcpy( &cell[ 0 ], &fValue, sizeof( float ));
+
+			} else if ( stream->Real )
+			{
+				const double dValue = (double)value;
+				memcpy( &cell[ 0 ], &dValue, sizeof( double ));
+
+			} else
+			{
+				const LONGLONG llValue = (LONGLONG)value;
+				memcpy( &cell[ 0 ], &llValue, min( stream->Size, (int)sizeof( LONGLONG )));
+			}
+
+			const size_t nOffset = key.size();
+			key.resize( nOffset + stream->Size );
+			stream->EncodeKey( &cell[ 0 ], &key[ nOffset ] );
+		}
+
+		return (int)key.size();
+	}
+
+	// the range of the leading key as the zone maps hold it, false if the
+	// leading key is not a real number or the range holds the missing
+	// value the zone maps leave out. Rounding to float keeps the order so
+	// a key in the range is still in the rounded range.
+	bool GetZoneRange
+	(
+		vector<_variant_t>& low, vector<_variant_t>& high,
+		float& fLow, float& fHigh
+	)
+	{
+		vector<CString>& arrKeys = m_pSchema->IndexKeys;
+		if ( arrKeys.empty() || low.empty() || high.empty() )
+		{
+			return false;
+		}
+
+		shared_ptr<CSchemaStream> stream = m_pSchema->Find( arrKeys[ 0 ] );
+		if ( stream == nullptr ||
+			( stream->Type != VT_R4 && stream->Type != VT_R8 ))
+		{
+			return false;
+		}
+
+		fLow = (float)(double)low[ 0 ];
+		fHigh = (float)(double)high[ 0 ];
+		const float fMissing = stream->HasNull ?
+			(float)stream->Null : CClimateTemperature::GetMissingValue();
+		return fMissing < fLow || fMissing > fHigh;
+	}
+
+	// encode the key of a persisted row for the scan used when the
+	// collection has no index
+	bool GetRowKey( int row, vector<BYTE>& key )
+	{
+		key.clear();
+		for ( auto& csKey : m_pSchema->IndexKeys )
+		{
+			shared_ptr<CSchemaStream> stream;
+			const BYTE* pCell = GetCell( csKey, row, stream );
+			if ( pCell == nullptr )
+			{
+				return false;
+			}
+
+			const size_t nOffset = key.size();
+			key.resize( nOffset + stream->Size );
+			stream->EncodeKey( pCell, &key[ nOffset ] );
+		}
+
+		return true;
+	}
+
+// public methods
+public:
+	// open a collection persisted in the given folder
+	bool Open( shared_ptr<CSchemaCollection> pSchema, LPCTSTR folder )
+	{
+		m_pSchema = pSchema;
+		m_csFolder = CString( folder ).TrimRight( _T( "\\" ));
+		m_mapStreams.clear();
+		m_mapZones.clear();
+		m_mapManifests.clear();
+		m_mapChunkStarts.clear();
+		m_Index.Close();
+		m_nRows = 0;
+
+		// the row count comes from the first persisted stream
+		for ( auto& stream : m_pSchema->Streams )
+		{
+			if ( stream->Size <= 0 )
+			{
+				continue;
+			}
+
+			shared_ptr<CMappedFile> file =
+				Map( m_mapStreams, stream->Name, _T( ".dat" ));
+			if ( file != nullptr )
+			{
+				m_nRows = int( file->Size / stream->Size );
+				break;
+			}
+
+			m_nRows = GetChunkRows( stream );
+			if ( m_nRows > 0 )
+			{
+				break;
+			}
+		}
+
+		m_Index.Open( m_csFolder + _T( "\\" ) + CCollectionWriter::GetIndexName() );
+
+		return m_nRows > 0;
+	}
+
+	// text of a cell with the zero padding removed
+	CString GetText( LPCTSTR name, int row )
+	{
+		CString value;
+
+		shared_ptr<CSchemaStream> stream;
+		const BYTE* pCell = GetCell( name, row, stream );
+		if ( pCell != nullptr )
+		{
+			const int nLength = (int)strnlen( (const char*)pCell, stream->Size );
+			value = CString( CStringA( (const char*)pCell, nLength ));
+		}
+
+		return value;
+	}
+
+	// real number of a cell (the stream's null value if not persisted)
+	double GetReal( LPCTSTR name, int row )
+	{
+		shared_ptr<CSchemaStream> stream;
+		const BYTE* pCell = GetCell( name, row, stream );
+		if ( pCell == nullptr )
+		{
+			return stream != nullptr ? stream->Null : 0.0;
+		}
+
+		if ( stream->Type == VT_R4 )
+		{
+			float fValue = 0.0f;
+			memcpy( &fValue, pCell, sizeof( float ));
+			return fValue;
+		}
+
+		double dValue = 0.0;
+		memcpy( &dValue, pCell, sizeof( double ));
+		return dValue;
+	}
+
+	// integer of a cell (sign extended for signed types)
+	LONGLONG GetInteger( LPCTSTR name, int row )
+	{
+		shared_ptr<CSchemaStream> stream;
+		const BYTE* pCell = GetCell( name, row, stream );
+		if ( pCell == nullptr )
+		{
+			return 0;
+		}
+
+		const int nSize = min( stream->Size, (int)sizeof( LONGLONG ));
+		LONGLONG value = 0;
+		memcpy( &value, pCell, nSize );
+
+		const VARTYPE vt = stream->Type;
+		const bool bSigned = vt == VT_I2 || vt == VT_I4 || vt == VT_I8;
+		if ( bSigned && nSize < (int)sizeof( LONGLONG ))
+		{
+			const int nShift = ( sizeof( LONGLONG ) - nSize ) * 8;
+			value = ( value << nShift ) >> nShift;
+		}
+
+		return value;
+	}
+
+	// persisted zone map of the block of rows containing the given row,
+	// returns false if the stream has no zone maps
+	bool GetZone( LPCTSTR name, int row, CZoneMap& zone )
+	{
+		shared_ptr<CSchemaStream> stream = m_pSchema->Find( name );
+		if ( stream == nullptr )
+		{
+			return false;
+		}
+
+		shared_ptr<CMappedFile> file = Map( m_mapZones, stream->Name, _T( ".zone" ));
+		if ( file == nullptr )
+		{
+			return false;
+		}
+
+		typedef CCollectionWriter::ZONE_RECORD ZONE_RECORD;
+		const ULONGLONG ullOffset =
+			ULONGLONG( row / CCollectionWriter::GetZoneRows() ) * sizeof( ZONE_RECORD );
+		if ( ullOffset + sizeof( ZONE_RECORD ) > file->Size )
+		{
+			return false;
+		}
+
+		ZONE_RECORD record;
+		memcpy( &record, file->Data + ullOffset, sizeof( ZONE_RECORD ));
+		zone.Restore( record.Minimum, record.Maximum, record.ValidCount, record.Count );
+
+		return true;
+	}
+
+	// rows whose leading key streams equal the given values
+	void Find( vector<_variant_t>& values, vector<int>& rows )
+	{
+		FindRange( values, values, rows );
+	}
+
+	// rows whose leading key streams fall between the given values
+	// (inclusive), in key order when the collection has an index
+	void FindRange
+	(
+		vector<_variant_t>& low, vector<_variant_t>& high, vector<int>& rows
+	)
+	{
+		vector<BYTE> keyLow;
+		vector<BYTE> keyHigh;
+		const int nBytes = min( EncodeKey( low, keyLow ), EncodeKey( high, keyHigh ));
+		if ( nBytes == 0 )
+		{
+			return;
+		}
+
+		// the index answers with O(log n) page reads
+		if ( HasIndex )
+		{
+			m_Index.FindRange( &keyLow[ 0 ], &keyHigh[ 0 ], nBytes, rows );
+			return;
+		}
+
+		// without an index every row's key has to be compared, except in
+		// the blocks whose zone map says the leading key is out of range
+		const int nZoneRows = CCollectionWriter::GetZoneRows();
+		float fLow = 0.0f;
+		float fHigh = 0.0f;
+		const bool bZones = GetZoneRange( low, high, fLow, fHigh );
+		vector<BYTE> key;
+		for ( int row = 0; row < m_nRows; row++ )
+		{
+			CZoneMap zone;
+			if ( bZones && row % nZoneRows == 0 &&
+				GetZone( m_pSchema->IndexKeys[ 0 ], row, zone ) &&
+				!zone.CanContain( fLow, fHigh ))
+			{
+				row += nZoneRows - 1;
+				continue;
+			}
+
+			if ( !GetRowKey( row, key ) || (int)key.size() < nBytes )
+			{
+				continue;
+			}
+
+			if ( memcmp( &key[ 0 ], &keyLow[ 0 ], nBytes ) >= 0 &&
+				memcmp( &key[ 0 ], &keyHigh[ 0 ], nBytes ) <= 0 )
+			{
+				rows.push_back( row );
+			}
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CCollectionReader()
+	{
+		m_nRows = 0;
+	}
+
+	// destructor
+	~CCollectionReader()
+	{
+	}
+};
@@ -0,0 +1,468 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "SchemaCollection.h"
+#include "IndexFile.h"
+#include "ColumnBlock.h"
+#include "ChunkStore.h"
+#include <map>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// collects the cells of a collection in memory and persists them into the
+// collection's folder as described by DataSchema.xml:
+//
+//	<Stream Name>.dat	flat array of fixed size cells, one per row
+//	<Stream Name>.zone	zone map (minimum, maximum, valid and total counts)
+//						of each block of rows of a real number stream
+//	Index.idx			sorted index built from the IndexKeys streams
+//
+// Only the streams that were given values are written. When a chunk store
+// is given, the cells of each stream are stored as content addressed
+// chunks and the collection folder only holds a <Stream Name>.chunks
+// manifest of their references. The chunks are cut where a rolling hash
+// of the last rows' cells hits a boundary (ZoneRows rows on average,
+// never fewer than a quarter or more than four times as many), so a row
+// inserted or removed by a new release only changes the chunk it falls in
+// and every later chunk is cut, and shared, exactly as before.
+class CCollectionWriter
+{
+// public definitions
+public:
+	// persisted zone map of a block of rows
+	typedef struct tagZONE_RECORD
+	{
+		float Minimum;
+		float Maximum;
+		int ValidCount;
+		int Count;
+
+	} ZONE_RECORD;
+
+// protected data
+protected:
+	// definition of the collection
+	shared_ptr<CSchemaCollection> m_pSchema;
+
+	// cells of each stream keyed by stream name
+	map<CString, vector<BYTE> > m_mapStreams;
+
+	// number of rows in the collection
+	int m_nRows;
+
+	// optional store of chunks shared between versions
+	shared_ptr<CChunkStore> m_pChunks;
+
+// public properties
+public:
+	// definition of the collection
+	inline shared_ptr<CSchemaCollection> GetSchema()
+	{
+		return m_pSchema;
+	}
+	// definition of the collection
+	__declspec( property( get = GetSchema ) )
+		shared_ptr<CSchemaCollection> Schema;
+
+	// number of rows in the collection
+	inline int GetRows()
+	{
+		return m_nRows;
+	}
+	// number of rows in the collection
+	__declspec( property( get = GetRows ) )
+		int Rows;
+
+	// optional store of chunks shared between versions
+	inline shared_ptr<CChunkStore> GetChunks()
+	{
+		return m_pChunks;
+	}
+	// optional store of chunks shared between versions
+	inline void SetChunks( shared_ptr<CChunkStore> value )
+	{
+		m_pChunks = value;
+	}
+	// optional store of chunks shared between versions
+	__declspec( property( get = GetChunks, put = SetChunks ) )
+		shared_ptr<CChunkStore> Chunks;
+
+	// file name of the index of a collection
+	inline static CString GetIndexName()
+	{
+		return _T( "Index.idx" );
+	}
+	// file name of the index of a collection
+	__declspec( property( get = GetIndexName ) )
+		CString IndexName;
+
+	// number of rows summarized by each persisted zone map
+	inline static int GetZoneRows()
+	{
+		return CColumnBlock::GetCapacity();
+	}
+	// number of rows summarized by each persisted zone map
+	__declspec( property( get = GetZoneRows ) )
+		int ZoneRows;
+
+// protected methods
+protected:
+	// fill a cell with the stream's null value (or zeros)
+	static void SetNull( shared_ptr<CSchemaStream>& stream, BYTE* pCell )
+	{
+		memset( pCell, 0, stream->Size );
+		if ( !stream->HasNull )
+		{
+			return;
+		}
+
+		if ( stream->Type == VT_R4 )
+		{
+			const float fValue = (float)stream->Null;
+			memcpy( pCell, &fValue, sizeof( float ));
+
+		} else if ( stream->Type == VT_R8 || stream->Type == VT_DATE )
+		{
+			const double dValue = stream->Null;
+			memcpy( pCell, &dValue, sizeof( double ));
+
+		} else
+		{
+			const LONGLONG llValue = (LONGLONG)stream->Null;
+			memcpy( pCell, &llValue, min( stream->Size, (int)sizeof( LONGLONG )));
+		}
+	}
+
+	// address of a cell, growing the stream as needed
+	BYTE* GetCell( LPCTSTR name, int row, shared_ptr<CSchemaStream>& stream )
+	{
+		stream = m_pSchema->Find( name );
+		if ( stream == nullptr || stream->Size <= 0 )
+		{
+			return nullptr;
+		}
+
+		const int nSize = stream->Size;
+		vector<BYTE>& cells = m_mapStreams[ stream->Name ];
+
+		// new rows begin as null values
+		const int nRows = (int)( cells.size() / nSize );
+		if ( row >= nRows )
+		{
+			cells.resize(( row + 1 ) * nSize );
+			for ( int n = nRows; n <= row; n++ )
+			{
+				SetNull( stream, &cells[ n * nSize ] );
+			}
+		}
+
+		m_nRows = max( m_nRows, row + 1 );
+
+		return &cells[ row * nSize ];
+	}
+
+	// write the zone maps of a real number stream
+	bool WriteZones
+	(
+		LPCTSTR pathname, shared_ptr<CSchemaStream>& stream, vector<BYTE>& cells
+	)
+	{
+		const float fMissing = stream->HasNull ?
+			(float)stream->Null : CClimateTemperature::GetMissingValue();
+		const int nSize = stream->Size;
+		vector<ZONE_RECORD> zones;
+
+		for ( int nFirst = 0; nFirst < m_nRows; nFirst += ZoneRows )
+		{
+			CZoneMap zone( fMissing );
+			const int nLast = min( m_nRows, nFirst + ZoneRows );
+			for ( int row = nFirst; row < nLast; row++ )
+			{
+				float fValue = 0.0f;
+				if ( stream->Type == VT_R4 )
+				{
+					memcpy( &fValue, &cells[ row * nSize ], sizeof( float ));
+
+				} else
+				{
+					double dValue = 0.0;
+					memcpy( &dValue, &cells[ row * nSize ], sizeof( double ));
+					fValue = (float)dValue;
+				}
+
+				zone.Update( fValue );
+			}
+
+			ZONE_RECORD record;
+			record.Minimum = zone.Minimum;
+			record.Maximum = zone.Maximum;
+			record.ValidCount = zone.ValidCount;
+			record.Count = zone.Count;
+			zones.push_back( record );
+		}
+
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+		if ( !zones.empty() )
+		{
+			file.Write( &zones[ 0 ], UINT( zones.size() * sizeof( ZONE_RECORD )));
+		}
+		file.Close();
+
+		return true;
+	}
+
+	// number of rows of the chunk starting at the given row, cut where
+	// the rolling hash of the rows' cells has its low bits clear. Each row
+	// shifts the hash one bit, so only the last 64 rows decide a boundary.
+	int GetChunkRows( vector<BYTE>& cells, int nSize, int nFirst )
+	{
+		const int nMinimum = ZoneRows / 4;
+		const int nMaximum = ZoneRows * 4;
+		const ULONGLONG ullMask = ULONGLONG( ZoneRows - 1 );
+		const int nLast = min( m_nRows, nFirst + nMaximum );
+
+		ULONGLONG ullHash = 0;
+		for ( int row = nFirst; row < nLast; row++ )
+		{
+			ullHash = ( ullHash << 1 ) +
+				CChunkStore::GetHash( &cells[ row * nSize ], DWORD( nSize ));
+			if ( row + 1 - nFirst >= nMinimum && ( ullHash & ullMask ) == 0 )
+			{
+				return row + 1 - nFirst;
+			}
+		}
+
+		return nLast - nFirst;
+	}
+
+	// store the cells of a stream as content defined chunks and write the
+	// manifest of their references
+	bool WriteChunks
+	(
+		LPCTSTR pathname, shared_ptr<CSchemaStream>& stream, vector<BYTE>& cells
+	)
+	{
+		const int nSize = stream->Size;
+		vector<CChunkStore::CHUNK_REFERENCE> references;
+
+		int nRows = 0;
+		for ( int nFirst = 0; nFirst < m_nRows; nFirst += nRows )
+		{
+			nRows = GetChunkRows( cells, nSize, nFirst );
+			CChunkStore::CHUNK_REFERENCE reference;
+			if ( !m_pChunks->Put
+			(
+				&cells[ nFirst * nSize ], DWORD( nRows * nSize ), DWORD( nRows ),
+				reference
+			))
+			{
+				return false;
+			}
+			references.push_back( reference );
+		}
+
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+		if ( !references.empty() )
+		{
+			file.Write
+			(
+				&references[ 0 ],
+				UINT( references.size() * sizeof( CChunkStore::CHUNK_REFERENCE ))
+			);
+		}
+		file.Close();
+
+		return true;
+	}
+
+// public methods
+public:
+	// set a text cell, the text is truncated or zero padded to the size
+	// of the stream
+	bool SetText( LPCTSTR name, int row, LPCTSTR value )
+	{
+		shared_ptr<CSchemaStream> stream;
+		BYTE* pCell = GetCell( name, row, stream );
+		if ( pCell == nullptr )
+		{
+			return false;
+		}
+
+		const CStringA csValue( value );
+		const int nLength = min( csValue.GetLength(), stream->Size );
+		memset( pCell, 0, stream->Size );
+		memcpy( pCell, (LPCSTR)csValue, nLength );
+
+		return true;
+	}
+
+	// set a real number cell (VT_R4, VT_R8 or VT_DATE)
+	bool SetReal( LPCTSTR name, int row, double value )
+	{
+		shared_ptr<CSchemaStream> stream;
+		BYTE* pCell = GetCell( name, row, stream );
+		if ( pCell == nullptr )
+		{
+			return false;
+		}
+
+		if ( stream->Type == VT_R4 )
+		{
+			const float fValue = (float)value;
+			memcpy( pCell, &fValue, sizeof( float ));
+
+		} else
+		{
+			memcpy( pCell, &value, sizeof( double ));
+		}
+
+		return true;
+	}
+
+	// set an integer cell of any size (little endian)
+	bool SetInteger( LPCTSTR name, int row, LONGLONG value )
+	{
+		shared_ptr<CSchemaStream> stream;
+		BYTE* pCell = GetCell( name, row, stream );
+		if ( pCell == nullptr )
+		{
+			return false;
+		}
+
+		memcpy( pCell, &value, min( stream->Size, (int)sizeof( LONGLONG )));
+
+		return true;
+	}
+
+	// persist the streams, zone maps and index into the given folder and
+	// add the names of the streams written to the given array
+	bool Write( LPCTSTR folder, vector<CString>& arrStreams )
+	{
+		CString csFolder = CString( folder ).TrimRight( _T( "\\" ));
+		if ( !::PathFileExists( csFolder ) && !CHelper::CreatePath( csFolder ))
+		{
+			return false;
+		}
+
+		for ( auto& node : m_mapStreams )
+		{
+			shared_ptr<CSchemaStream> stream = m_pSchema->Find( node.first );
+			const int nSize = stream->Size;
+
+			// streams that were not set for trailing rows are padded
+			vector<BYTE>& cells = node.second;
+			const int nRows = (int)( cells.size() / nSize );
+			if ( nRows < m_nRows )
+			{
+				cells.resize( m_nRows * nSize );
+				for ( int row = nRows; row < m_nRows; row++ )
+				{
+					SetNull( stream, &cells[ row * nSize ] );
+				}
+			}
+
+			if ( m_pChunks != nullptr )
+			{
+				const CString csPath =
+					csFolder + _T( "\\" ) + node.first + CChunkStore::GetManifestExtension();
+				if ( !WriteChunks( csPath, stream, cells ))
+				{
+					return false;
+				}
+
+			} else
+			{
+				const CString csPath = csFolder + _T( "\\" ) + node.first + _T( ".dat" );
+				CFile file;
+				if ( !file.Open( csPath, CFile::modeCreate | CFile::modeWrite ))
+				{
+					return false;
+				}
+				if ( !cells.empty() )
+				{
+					file.Write( &cells[ 0 ], (UINT)cells.size() );
+				}
+				file.Close();
+			}
+
+			arrStreams.push_back( node.first );
+
+			// the zone maps let readers skip blocks of real numbers
+			if ( stream->Type == VT_R4 || stream->Type == VT_R8 )
+			{
+				const CString csZone =
+					csFolder + _T( "\\" ) + node.first + _T( ".zone" );
+				if ( !WriteZones( csZone, stream, cells ))
+				{
+					return false;
+				}
+			}
+		}
+
+		// build the index from the key streams when all of them were set
+		vector<CString>& arrKeys = m_pSchema->IndexKeys;
+		if ( arrKeys.empty() )
+		{
+			return true;
+		}
+
+		vector<shared_ptr<CSchemaStream> > keyStreams;
+		for ( auto& csKey : arrKeys )
+		{
+			shared_ptr<CSchemaStream> stream = m_pSchema->Find( csKey );
+			if ( stream == nullptr ||
+				m_mapStreams.find( stream->Name ) == m_mapStreams.end() )
+			{
+				return true;
+			}
+			keyStreams.push_back( stream );
+		}
+
+		const int nKeySize = m_pSchema->KeySize;
+		vector<BYTE> keys( m_nRows * nKeySize );
+		for ( int row = 0; row < m_nRows; row++ )
+		{
+			BYTE* pKey = &keys[ row * nKeySize ];
+			for ( auto& stream : keyStreams )
+			{
+				vector<BYTE>& cells = m_mapStreams[ stream->Name ];
+				stream->EncodeKey( &cells[ row * stream->Size ], pKey );
+				pKey += stream->Size;
+			}
+		}
+
+		const CString csIndex = csFolder + _T( "\\" ) + IndexName;
+		return CIndexFile::Build( csIndex, nKeySize, keys );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// constructor given the definition of the collection
+	CCollectionWriter( shared_ptr<CSchemaCollection> pSchema )
+	{
+		m_pSchema = pSchema;
+		m_nRows = 0;
+	}
+
+	// destructor
+	~CCollectionWriter()
+	{
+	}
+};
@@ -0,0 +1,332 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "StationYear.h"
+#include "ZoneMap.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// a fixed size block of station year rows stored column by column for a
+// single measurement type. Each column carries a zone map (minimum,
+// maximum and valid count) and the block remembers the range of stations
+// and years it covers, so a scan can reject the whole block by looking at
+// a handful of numbers instead of every row.
+class CColumnBlock
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// measurement type of every row in the block
+	CClimateTemperature::MEASURE_TYPE m_eMeasurementType;
+
+	// station ID column
+	vector<CString> m_arrStations;
+
+	// dense station index column (see CStationList)
+	vector<int> m_arrStationIndexes;
+
+	// year column
+	vector<int> m_arrYears;
+
+	// validity mask column (see CStationYear::ValidMask)
+	vector<WORD> m_arrValidMasks;
+
+	// twelve monthly temperature columns in degrees centigrade
+	vector<float> m_arrMonths[ 12 ];
+
+	// twelve monthly quality control flag columns
+	vector<TCHAR> m_arrFlags[ 12 ];
+
+	// twelve monthly decoded flag columns (see CClimateTemperature::
+	// FLAG_LETTERS) lined up with the temperature columns
+	vector<DWORD> m_arrFlagBits[ 12 ];
+
+	// zone map of the year column
+	CZoneMap m_zmYear;
+
+	// zone map of each monthly temperature column
+	CZoneMap m_zmMonths[ 12 ];
+
+	// zone map of all twelve months combined
+	CZoneMap m_zmValue;
+
+	// one bit for each quality control flag found in the block
+	DWORD m_dwFlagMask;
+
+	// first station in the block
+	CString m_csFirstStation;
+
+	// last station in the block
+	CString m_csLastStation;
+
+// public properties
+public:
+	// number of rows a block holds before a new block is started
+	inline static int GetCapacity()
+	{
+		return 1024;
+	}
+	// number of rows a block holds before a new block is started
+	__declspec( property( get = GetCapacity ) )
+		int Capacity;
+
+	// number of rows in the block
+	inline int GetRows()
+	{
+		return (int)m_arrYears.size();
+	}
+	// number of rows in the block
+	__declspec( property( get = GetRows ) )
+		int Rows;
+
+	// true when the block cannot accept any more rows
+	inline bool GetFull()
+	{
+		return Rows >= Capacity;
+	}
+	// true when the block cannot accept any more rows
+	__declspec( property( get = GetFull ) )
+		bool Full;
+
+	// measurement type of every row in the block
+	inline CClimateTemperature::MEASURE_TYPE GetMeasurementType()
+	{
+		return m_eMeasurementType;
+	}
+	// measurement type of every row in the block
+	__declspec( property( get = GetMeasurementType ) )
+		CClimateTemperature::MEASURE_TYPE MeasurementType;
+
+	// station ID of a row
+	inline CString GetStation( int row )
+	{
+		return m_arrStations[ row ];
+	}
+	// station ID of a row
+	__declspec( property( get = GetStation ) )
+		CString Station[];
+
+	// dense station index of a row
+	inline int GetStationIndex( int row )
+	{
+		return m_arrStationIndexes[ row ];
+	}
+	// dense station index of a row
+	__declspec( property( get = GetStationIndex ) )
+		int StationIndex[];
+
+	// year of a row
+	inline int GetYear( int row )
+	{
+		return m_arrYears[ row ];
+	}
+	// year of a row
+	__declspec( property( get = GetYear ) )
+		int Year[];
+
+	// zone map of the year column
+	inline CZoneMap& GetYearZone()
+	{
+		return m_zmYear;
+	}
+	// zone map of the year column
+	__declspec( property( get = GetYearZone ) )
+		CZoneMap YearZone;
+
+	// zone map of all twelve months combined
+	inline CZoneMap& GetValueZone()
+	{
+		return m_zmValue;
+	}
+	// zone map of all twelve months combined
+	__declspec( property( get = GetValueZone ) )
+		CZoneMap ValueZone;
+
+	// one bit for each quality control flag found in the block
+	inline DWORD GetFlagMask()
+	{
+		return m_dwFlagMask;
+	}
+	// one bit for each quality control flag found in the block
+	__declspec( property( get = GetFlagMask ) )
+		DWORD FlagMask;
+
+	// first station in the block
+	inline CString GetFirstStation()
+	{
+		return m_csFirstStation;
+	}
+	// first station in the block
+	__declspec( property( get = GetFirstStation ) )
+		CString FirstStation;
+
+	// last station in the block
+	inline CString GetLastStation()
+	{
+		return m_csLastStation;
+	}
+	// last station in the block
+	__declspec( property( get = GetLastStation ) )
+		CString LastStation;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// map a quality control flag character to its bit in a flag mask,
+	// a blank flag has no bit
+	static inline DWORD GetFlagBit( TCHAR flag )
+	{
+		return CClimateTemperature::GetQualityControlBit( flag );
+	}
+
+	// temperature in degrees centigrade for a row and month (0 to 11)
+	inline float GetCentigrade( int row, int month )
+	{
+		return m_arrMonths[ month ][ row ];
+	}
+
+	// contiguous temperatures in degrees centigrade of a month column
+	// (0 to 11) for loops over all of the rows of the block
+	inline const float* GetMonthColumn( int month )
+	{
+		return m_arrMonths[ month ].data();
+	}
+
+	// contiguous years of the rows
+	inline const int* GetYearColumn()
+	{
+		return m_arrYears.data();
+	}
+
+	// contiguous dense station indexes of the rows
+	inline const int* GetStationIndexColumn()
+	{
+		return m_arrStationIndexes.data();
+	}
+
+	// contiguous validity masks of the rows (bit 0 is January)
+	inline const WORD* GetValidMaskColumn()
+	{
+		return m_arrValidMasks.data();
+	}
+
+	// quality control flag for a row and month (0 to 11)
+	inline TCHAR GetFlag( int row, int month )
+	{
+		return m_arrFlags[ month ][ row ];
+	}
+
+	// contiguous decoded flags of a month column (0 to 11)
+	inline const DWORD* GetFlagBitsColumn( int month )
+	{
+		return m_arrFlagBits[ month ].data();
+	}
+
+	// zone map of a monthly column (0 to 11)
+	inline CZoneMap& GetMonthZone( int month )
+	{
+		return m_zmMonths[ month ];
+	}
+
+	// append a station year to the block and update the zone maps,
+	// returns false if the block is full or the measurement type differs
+	bool AddRow( shared_ptr<CStationYear>& StationYear )
+	{
+		if ( Full || StationYear->MeasurementType != MeasurementType )
+		{
+			return false;
+		}
+
+		const CString csStation = StationYear->Station;
+		const int nYear = _ttoi( StationYear->Year );
+
+		// maintain the station range covered by the block
+		if ( Rows == 0 )
+		{
+			m_csFirstStation = csStation;
+			m_csLastStation = csStation;
+
+		} else
+		{
+			if ( csStation < m_csFirstStation )
+			{
+				m_csFirstStation = csStation;
+			}
+			if ( csStation > m_csLastStation )
+			{
+				m_csLastStation = csStation;
+			}
+		}
+
+		m_arrStations.push_back( csStation );
+		m_arrStationIndexes.push_back( StationYear->StationIndex );
+		m_arrYears.push_back( nYear );
+		m_arrValidMasks.push_back( StationYear->ValidMask );
+		m_zmYear.Update( float( nYear ));
+
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			shared_ptr<CClimateTemperature> pMonth = StationYear->Month[ nMonth ];
+			const float fValue = pMonth->Centigrade;
+
+			// only the first character of the flag is meaningful
+			const CString csFlag = pMonth->QualityControlFlag;
+			const TCHAR flag = csFlag.IsEmpty() ? _T( ' ' ) : csFlag[ 0 ];
+
+			m_arrMonths[ nMonth ].push_back( fValue );
+			m_arrFlags[ nMonth ].push_back( flag );
+			m_arrFlagBits[ nMonth ].push_back( pMonth->FlagBits );
+
+			m_zmMonths[ nMonth ].Update( fValue );
+			m_zmValue.Update( fValue );
+
+			// only flags on valid readings are interesting to a scan
+			if ( !pMonth->Missing )
+			{
+				m_dwFlagMask |= GetFlagBit( flag );
+			}
+		}
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// constructor given the measurement type of the rows
+	CColumnBlock( CClimateTemperature::MEASURE_TYPE eType )
+	{
+		m_eMeasurementType = eType;
+		m_dwFlagMask = 0;
+
+		m_arrStations.reserve( Capacity );
+		m_arrStationIndexes.reserve( Capacity );
+		m_arrYears.reserve( Capacity );
+		m_arrValidMasks.reserve( Capacity );
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			m_arrMonths[ nMonth ].reserve( Capacity );
+			m_arrFlags[ nMonth ].reserve( Capacity );
+			m_arrFlagBits[ nMonth ].reserve( Capacity );
+		}
+	}
+
+	// destructor
+	~CColumnBlock()
+	{
+	}
+};
@@ -0,0 +1,300 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "TraceLog.h"
+#include <math.h>
+#include <ppl.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// buffered comma separated value output. Rows are formatted by a caller
+// supplied function into character buffers with integer and fixed point
+// routines that produce exactly what the "%d" and "%0.nf" conversions of
+// CString::Format would, without parsing a format string per value. The
+// rows are cut into chunks that are formatted in parallel, and the chunks
+// are written to the file in order with one large write each.
+//
+// A fixed point value is rounded with integer arithmetic on the exact
+// binary value of the double. Only a value exactly half way between two
+// outputs (where the C runtime's rounding mode decides) and values too
+// large for the integer arithmetic are handed to the runtime.
+class CCsvWriter
+{
+// public definitions
+public:
+	// characters of one or more formatted rows
+	typedef vector<char> CSV_BUFFER;
+
+// protected data
+protected:
+	// file the rows are written to
+	CStdioFile* m_pFile;
+
+	// rows formatted by each parallel task
+	int m_nChunkRows;
+
+	// number of characters written
+	ULONGLONG m_ullCharacters;
+
+	// timeline the chunks are recorded in (nullptr for none)
+	CTraceLog* m_pTrace;
+
+// public properties
+public:
+	// rows formatted by each parallel task
+	inline int GetChunkRows()
+	{
+		return m_nChunkRows;
+	}
+	// rows formatted by each parallel task
+	inline void SetChunkRows( int value )
+	{
+		m_nChunkRows = max( 1, value );
+	}
+	// rows formatted by each parallel task
+	__declspec( property( get = GetChunkRows, put = SetChunkRows ) )
+		int ChunkRows;
+
+	// number of characters written
+	inline ULONGLONG GetCharacters()
+	{
+		return m_ullCharacters;
+	}
+	// number of characters written
+	__declspec( property( get = GetCharacters ) )
+		ULONGLONG Characters;
+
+	// timeline the chunks are recorded in (nullptr for none)
+	inline CTraceLog* GetTrace()
+	{
+		return m_pTrace;
+	}
+	// timeline the chunks are recorded in (nullptr for none)
+	inline void SetTrace( CTraceLog* value )
+	{
+		m_pTrace = value;
+	}
+	// timeline the chunks are recorded in (nullptr for none)
+	__declspec( property( get = GetTrace, put = SetTrace ) )
+		CTraceLog* Trace;
+
+// protected methods
+protected:
+	// append the decimal digits of an unsigned value
+	static void AppendDigits( CSV_BUFFER& buffer, ULONGLONG value )
+	{
+		char digits[ 24 ];
+		int nDigits = 0;
+		do
+		{
+			digits[ nDigits++ ] = char( '0' + value % 10 );
+			value /= 10;
+
+		} while ( value != 0 );
+
+		while ( nDigits > 0 )
+		{
+			buffer.push_back( digits[ --nDigits ] );
+		}
+	}
+
+	// let the runtime format a value the integer arithmetic cannot
+	static void AppendRuntime( CSV_BUFFER& buffer, double value, int nDecimals )
+	{
+		char text[ 512 ];
+		const int nLength =
+			_snprintf_s( text, _countof( text ), _TRUNCATE, "%0.*f", nDecimals, value );
+		if ( nLength > 0 )
+		{
+			buffer.insert( buffer.end(), text, text + nLength );
+		}
+	}
+
+// public methods
+public:
+	// append text
+	static void AppendText( CSV_BUFFER& buffer, LPCTSTR text )
+	{
+		for ( LPCTSTR p = text; *p != 0; p++ )
+		{
+			buffer.push_back( char( *p ));
+		}
+	}
+
+	// append a single character
+	static void AppendChar( CSV_BUFFER& buffer, char ch )
+	{
+		buffer.push_back( ch );
+	}
+
+	// append an integer as "%d" would
+	static void AppendInt( CSV_BUFFER& buffer, int value )
+	{
+		if ( value < 0 )
+		{
+			buffer.push_back( '-' );
+			AppendDigits( buffer, ULONGLONG( -(LONGLONG)value ));
+
+		} else
+		{
+			AppendDigits( buffer, ULONGLONG( value ));
+		}
+	}
+
+	// append a value with the given number of decimals (0 to 3) as
+	// "%0.nf" would
+	static void AppendFixed( CSV_BUFFER& buffer, double value, int nDecimals )
+	{
+		const double dMagnitude = fabs( value );
+		if ( !_finite( value ) || nDecimals < 0 || nDecimals > 3 ||
+			dMagnitude >= 1e15 )
+		{
+			AppendRuntime( buffer, value, nDecimals );
+			return;
+		}
+
+		// the magnitude is exactly ullMantissa * 2 ^ nShift
+		int nExponent = 0;
+		const double dFraction = frexp( dMagnitude, &nExponent );
+		const ULONGLONG ullMantissa = ULONGLONG( ldexp( dFraction, 53 ));
+		const int nShift = nExponent - 53;
+
+		ULONGLONG ullScale = 1;
+		for ( int n = 0; n < nDecimals; n++ )
+		{
+			ullScale *= 10;
+		}
+
+		// less than 2 ^ 63 since the mantissa has 53 bits and the scale is at
+		// most 1000
+		const ULONGLONG ullScaled = ullMantissa * ullScale;
+
+		// the magnitude in units of the last decimal rounded to nearest
+		ULONGLONG ullUnits = 0;
+		if ( nShift >= 0 )
+		{
+			ullUnits = ullScaled << nShift;
+
+		} else if ( -nShift < 64 )
+		{
+			const int nRight = -nShift;
+			const ULONGLONG ullRemainder = ullScaled & (( 1ULL << nRight ) - 1 );
+			const ULONGLONG ullHalf = 1ULL << ( nRight - 1 );
+			ullUnits = ullScaled >> nRight;
+			if ( ullRemainder == ullHalf )
+			{
+				AppendRuntime( buffer, value, nDecimals );
+				return;
+			}
+			if ( ullRemainder > ullHalf )
+			{
+				ullUnits++;
+			}
+		}
+
+		// the sign is kept even when the value rounds to zero
+		if ( value < 0.0 || ( value == 0.0 && _copysign( 1.0, value ) < 0.0 ))
+		{
+			buffer.push_back( '-' );
+		}
+
+		AppendDigits( buffer, ullUnits / ullScale );
+		if ( nDecimals > 0 )
+		{
+			buffer.push_back( '.' );
+			ULONGLONG ullFraction = ullUnits % ullScale;
+			for ( ULONGLONG ullDigit = ullScale / 10; ullDigit > 0; ullDigit /= 10 )
+			{
+				buffer.push_back( char( '0' + ullFraction / ullDigit ));
+				ullFraction %= ullDigit;
+			}
+		}
+	}
+
+	// write a buffer to the file in one call
+	void Flush( CSV_BUFFER& buffer )
+	{
+		if ( buffer.empty() )
+		{
+			return;
+		}
+
+		m_pFile->Write( buffer.data(), (UINT)buffer.size() );
+		m_ullCharacters += buffer.size();
+		buffer.clear();
+	}
+
+	// write text such as a heading
+	void WriteText( LPCTSTR text )
+	{
+		CSV_BUFFER buffer;
+		AppendText( buffer, text );
+		Flush( buffer );
+	}
+
+	// format the given number of rows with formatter( row, buffer ) in
+	// parallel chunks and write the chunks in row order, a batch of chunks
+	// at a time so only a few are held in memory
+	template <class FORMATTER> void WriteRows( int nRows, FORMATTER formatter )
+	{
+		const int nChunkRows = ChunkRows;
+		const int nChunks = ( nRows + nChunkRows - 1 ) / nChunkRows;
+		const int nBatch =
+			max( 1, int( concurrency::GetProcessorCount() ) * 2 );
+
+		vector<CSV_BUFFER> buffers( nBatch );
+		for ( int nFirst = 0; nFirst < nChunks; nFirst += nBatch )
+		{
+			const int nLast = min( nChunks, nFirst + nBatch );
+			concurrency::parallel_for
+			(
+				nFirst, nLast,
+				[&]( int nChunk )
+				{
+					CTraceLog::CTraceScope scope( m_pTrace, _T( "format chunk" ));
+					CSV_BUFFER& buffer = buffers[ nChunk - nFirst ];
+					const int nRow = nChunk * nChunkRows;
+					const int nEnd = min( nRows, nRow + nChunkRows );
+					buffer.reserve( ( nEnd - nRow ) * 128 );
+					for ( int row = nRow; row < nEnd; row++ )
+					{
+						formatter( row, buffer );
+					}
+				}
+			);
+
+			CTraceLog::CTraceScope scope( m_pTrace, _T( "write chunks" ));
+			for ( int nChunk = nFirst; nChunk < nLast; nChunk++ )
+			{
+				Flush( buffers[ nChunk - nFirst ] );
+			}
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// constructor writing to the given file
+	CCsvWriter( CStdioFile& file )
+	{
+		m_pFile = &file;
+		m_nChunkRows = 4096;
+		m_ullCharacters = 0;
+		m_pTrace = nullptr;
+	}
+
+	// destructor
+	~CCsvWriter()
+	{
+	}
+};
@@ -0,0 +1,901 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <atomic>
+#include <math.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// a synthetic climate tree for measuring the program at scales the real
+// data does not reach. A station file and the files of each dataset asked
+// for are written in the fixed width formats the parsers read, i.e.
+//
+//	ushcn-v2.5-stations.txt
+//	USH00000001.raw.tmax			(USHCN, a file per station and type)
+//	USH00000001.raw.tmin
+//	USH00000001.raw.tavg
+//	ghcnm.tmax.v4.0.1.synthetic.qcu.dat	(GHCN-Monthly, a file per type)
+//	ghcnm.tmin.v4.0.1.synthetic.qcu.dat
+//	ghcnm.tavg.v4.0.1.synthetic.qcu.dat
+//	USC00000001.dly				(GHCN-Daily, a file per station)
+//
+// The GHCN datasets share a second set of stations (USC...) so their
+// station years do not duplicate the USHCN ones, and the station file
+// describes both sets. The daily maximums and minimums of a station follow
+// its monthly readings with a day to day anomaly that persists for a few
+// days, so the heat waves and cold spells have something to find.
+//
+// The readings follow a simple climate: colder with latitude and
+// elevation, a seasonal cycle that grows with latitude, a slow warming
+// trend, and noise shared by the months of a year. Readings are missing,
+// months are short of days, quality control flags are raised and whole
+// years are absent at configurable rates.
+//
+// Every station draws from its own generator seeded by the seed, the
+// station number and the set of stations, so the tree is identical for a
+// given seed no matter how many threads write it.
+class CDataGenerator
+{
+// public definitions
+public:
+	// characters of a file being written
+	typedef vector<char> FILE_BUFFER;
+
+	// state of the random number generator (SplitMix64)
+	typedef ULONGLONG RANDOM;
+
+	// datasets a tree can hold
+	typedef enum
+	{
+		dsUshcn = 1,		// USHCN v2.5 .raw.tmax, .raw.tmin and .raw.tavg files
+		dsGhcnMonthly = 2,	// GHCN-Monthly v4 .dat files
+		dsGhcnDaily = 4,	// GHCN-Daily .dly files
+
+	} DATASET;
+
+	// sets of stations
+	typedef enum
+	{
+		snUshcn,			// the USHCN stations (USH...)
+		snGhcn,				// the stations of the GHCN datasets (USC...)
+		snDaily,			// the days of the GHCN stations
+
+	} STATION_NETWORK;
+
+	// the climate of a station in degrees centigrade
+	typedef struct tagSTATION_CLIMATE
+	{
+		// yearly mean, seasonal swing and daily range
+		double Mean;
+		double Season;
+		double Range;
+
+		// warming per year
+		double Trend;
+
+		// first year with readings
+		int FirstYear;
+
+	} STATION_CLIMATE;
+
+	// the readings of a month
+	typedef struct tagMONTH_READING
+	{
+		// hundredths of a degree of the maximum, minimum and average, or
+		// -9999 if missing
+		int Values[ 3 ];
+
+		// days missing, quality control and source flags
+		char DM;
+		char QC;
+		char DS;
+
+	} MONTH_READING;
+
+// protected data
+protected:
+	// number of stations
+	int m_nStations;
+
+	// number of years ending with the last year
+	int m_nYears;
+
+	// last year of every station
+	int m_nLastYear;
+
+	// seed of the random numbers
+	ULONGLONG m_ullSeed;
+
+	// datasets written (DATASET bits)
+	int m_nDatasets;
+
+	// share of the monthly readings that are missing
+	double m_dMissingRate;
+
+	// share of the valid readings with a quality control flag
+	double m_dFlagRate;
+
+	// share of the valid readings with days missing
+	double m_dDaysMissingRate;
+
+	// share of the station years without a line
+	double m_dGapRate;
+
+	// number of files written
+	atomic<int> m_nFiles;
+
+	// number of lines written
+	atomic<LONGLONG> m_llLines;
+
+	// number of bytes written
+	atomic<LONGLONG> m_llBytes;
+
+// public properties
+public:
+	// number of stations
+	inline int GetStations()
+	{
+		return m_nStations;
+	}
+	// number of stations
+	inline void SetStations( int value )
+	{
+		m_nStations = value;
+	}
+	// number of stations
+	__declspec( property( get = GetStations, put = SetStations ) )
+		int Stations;
+
+	// number of years ending with the last year
+	inline int GetYears()
+	{
+		return m_nYears;
+	}
+	// number of years ending with the last year
+	inline void SetYears( int value )
+	{
+		m_nYears = value;
+	}
+	// number of years ending with the last year
+	__declspec( property( get = GetYears, put = SetYears ) )
+		int Years;
+
+	// last year of every station
+	inline int GetLastYear()
+	{
+		return m_nLastYear;
+	}
+	// last year of every station
+	inline void SetLastYear( int value )
+	{
+		m_nLastYear = value;
+	}
+	// last year of every station
+	__declspec( property( get = GetLastYear, put = SetLastYear ) )
+		int LastYear;
+
+	// seed of the random numbers
+	inline ULONGLONG GetSeed()
+	{
+		return m_ullSeed;
+	}
+	// seed of the random numbers
+	inline void SetSeed( ULONGLONG value )
+	{
+		m_ullSeed = value;
+	}
+	// seed of the random numbers
+	__declspec( property( get = GetSeed, put = SetSeed ) )
+		ULONGLONG Seed;
+
+	// datasets written (DATASET bits)
+	inline int GetDatasets()
+	{
+		return m_nDatasets;
+	}
+	// datasets written (DATASET bits)
+	inline void SetDatasets( int value )
+	{
+		m_nDatasets = value;
+	}
+	// datasets written (DATASET bits)
+	__declspec( property( get = GetDatasets, put = SetDatasets ) )
+		int Datasets;
+
+	// letters of the datasets written (i.e. "um")
+	inline CString GetDatasetLetters()
+	{
+		CString value;
+		value += ( m_nDatasets & dsUshcn ) != 0 ? _T( "u" ) : _T( "" );
+		value += ( m_nDatasets & dsGhcnMonthly ) != 0 ? _T( "m" ) : _T( "" );
+		value += ( m_nDatasets & dsGhcnDaily ) != 0 ? _T( "d" ) : _T( "" );
+		return value;
+	}
+	// letters of the datasets written (i.e. "um")
+	__declspec( property( get = GetDatasetLetters ) )
+		CString DatasetLetters;
+
+	// share of the monthly readings that are missing
+	inline double GetMissingRate()
+	{
+		return m_dMissingRate;
+	}
+	// share of the monthly readings that are missing
+	inline void SetMissingRate( double value )
+	{
+		m_dMissingRate = value;
+	}
+	// share of the monthly readings that are missing
+	__declspec( property( get = GetMissingRate, put = SetMissingRate ) )
+		double MissingRate;
+
+	// share of the valid readings with a quality control flag
+	inline double GetFlagRate()
+	{
+		return m_dFlagRate;
+	}
+	// share of the valid readings with a quality control flag
+	inline void SetFlagRate( double value )
+	{
+		m_dFlagRate = value;
+	}
+	// share of the valid readings with a quality control flag
+	__declspec( property( get = GetFlagRate, put = SetFlagRate ) )
+		double FlagRate;
+
+	// number of files written
+	inline int GetFiles()
+	{
+		return m_nFiles;
+	}
+	// number of files written
+	__declspec( property( get = GetFiles ) )
+		int Files;
+
+	// number of lines written
+	inline LONGLONG GetLines()
+	{
+		return m_llLines;
+	}
+	// number of lines written
+	__declspec( property( get = GetLines ) )
+		LONGLONG Lines;
+
+	// number of bytes written
+	inline LONGLONG GetBytes()
+	{
+		return m_llBytes;
+	}
+	// number of bytes written
+	__declspec( property( get = GetBytes ) )
+		LONGLONG Bytes;
+
+// protected methods
+protected:
+	// next 64 random bits
+	static inline ULONGLONG GetNext( RANDOM& state )
+	{
+		state += 0x9E3779B97F4A7C15ULL;
+		ULONGLONG value = state;
+		value = ( value ^ ( value >> 30 )) * 0xBF58476D1CE4E5B9ULL;
+		value = ( value ^ ( value >> 27 )) * 0x94D049BB133111EBULL;
+		return value ^ ( value >> 31 );
+	}
+
+	// uniform random number from 0 up to 1
+	static inline double GetUniform( RANDOM& state )
+	{
+		return double( GetNext( state ) >> 11 ) / 9007199254740992.0;
+	}
+
+	// roughly normal random number with a mean of zero and a standard
+	// deviation of one (the sum of twelve uniform numbers less six)
+	static inline double GetNormal( RANDOM& state )
+	{
+		double value = -6.0;
+		for ( int n = 0; n < 12; n++ )
+		{
+			value += GetUniform( state );
+		}
+
+		return value;
+	}
+
+	// append text
+	static void AppendText( FILE_BUFFER& buffer, LPCSTR text )
+	{
+		for ( LPCSTR p = text; *p != 0; p++ )
+		{
+			buffer.push_back( *p );
+		}
+	}
+
+	// write a buffer to a new file
+	bool WriteFile( LPCTSTR pathname, FILE_BUFFER& buffer, int nLines )
+	{
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+
+		file.Write( buffer.data(), (UINT)buffer.size() );
+		file.Close();
+
+		m_nFiles++;
+		m_llLines += nLines;
+		m_llBytes += (LONGLONG)buffer.size();
+		return true;
+	}
+
+	// the first three characters of the station IDs of a set of stations
+	static LPCSTR GetNetwork( int eNetwork )
+	{
+		return eNetwork == snUshcn ? "USH" : "USC";
+	}
+
+	// the station ID of a station number (zero based)
+	static CString GetStation( int eNetwork, int nStation )
+	{
+		CString value;
+		value.Format( _T( "%s%08d" ), CString( GetNetwork( eNetwork )), nStation + 1 );
+		return value;
+	}
+
+	// the generator of a station of a set of stations, the USHCN stations
+	// draw the same numbers whether or not the GHCN datasets are written
+	inline RANDOM GetRandom( int eNetwork, int nStation )
+	{
+		RANDOM value = m_ullSeed ^ (( nStation + 1 ) * 0xD1B54A32D192ED03ULL ) ^
+			( ULONGLONG( eNetwork ) * 0x9E3779B97F4A7C15ULL );
+		GetNext( value );
+		return value;
+	}
+
+	// append the station file line of a station in the columns read by
+	// CStationList::ParseLine
+	static void AppendStation
+	(
+		FILE_BUFFER& buffer, int eNetwork, int nStation, RANDOM random
+	)
+	{
+		static const char* pStates[] =
+		{
+			"AL", "AZ", "AR", "CA", "CO", "CT", "DE", "FL", "GA", "ID",
+			"IL", "IN", "IA", "KS", "KY", "LA", "ME", "MD", "MA", "MI",
+			"MN", "MS", "MO", "MT", "NE", "NV", "NH", "NJ", "NM", "NY",
+			"NC", "ND", "OH", "OK", "OR", "PA", "RI", "SC", "SD", "TN",
+			"TX", "UT", "VT", "VA", "WA", "WV", "WI", "WY"
+		};
+
+		const double dLatitude = 25.0 + 24.0 * GetUniform( random );
+		const double dLongitude = -124.0 + 57.0 * GetUniform( random );
+		const double dElevation = 3000.0 * pow( GetUniform( random ), 3.0 );
+		const char* pState = pStates[ GetNext( random ) % _countof( pStates ) ];
+		const int nOffset = int( floor( dLongitude / 15.0 + 0.5 ));
+
+		char text[ 128 ];
+		_snprintf_s
+		(
+			text, _countof( text ), _TRUNCATE,
+			"%s%08d %8.4f %9.4f %6.1f %s %-30s ------ ------ ------ %+d\n",
+			GetNetwork( eNetwork ), nStation + 1, dLatitude, dLongitude, dElevation, pState,
+			"SYNTHETIC STATION", nOffset
+		);
+		AppendText( buffer, text );
+	}
+
+	// draw the climate of a station, the location draws the same numbers
+	// as the station file
+	void GetClimate( RANDOM& random, STATION_CLIMATE& climate )
+	{
+		const double dLatitude = 25.0 + 24.0 * GetUniform( random );
+		GetUniform( random );
+		const double dElevation = 3000.0 * pow( GetUniform( random ), 3.0 );
+		GetNext( random );
+
+		climate.Mean = 24.0 - 0.75 * ( dLatitude - 25.0 ) - 0.0065 * dElevation;
+		climate.Season = 6.0 + 0.5 * ( dLatitude - 25.0 );
+		climate.Range = 10.0 + 4.0 * GetUniform( random );
+		climate.Trend = 0.004 + 0.008 * GetUniform( random );
+
+		// most stations begin in the first year, some later
+		const int nYears = max( 1, m_nYears );
+		climate.FirstYear = m_nLastYear - nYears + 1 +
+			int( GetNext( random ) % ( nYears / 5 + 1 ));
+	}
+
+	// draw the readings of the months of a year, false if the station has
+	// no line for the year
+	bool GetYear
+	(
+		RANDOM& random, const STATION_CLIMATE& climate, int nYear,
+		MONTH_READING* pMonths
+	)
+	{
+		static const char chFlags[] = "DIKLMNORSTW";
+		static const char chSources[] = "000000000123";
+		const double dPi = 3.14159265358979323846;
+
+		const double dYear = climate.Trend * ( nYear - climate.FirstYear ) +
+			0.6 * GetNormal( random );
+		if ( GetUniform( random ) < m_dGapRate )
+		{
+			return false;
+		}
+
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			const double dAverage = climate.Mean + dYear -
+				climate.Season * cos( 2.0 * dPi * ( nMonth + 0.5 ) / 12.0 ) +
+				1.2 * GetNormal( random );
+			const double dHalfRange = 0.5 * ( climate.Range + GetNormal( random ));
+
+			// hundredths of a degree with the average of the rounded
+			// maximum and minimum as the distribution computes it
+			MONTH_READING& month = pMonths[ nMonth ];
+			int* pValues = month.Values;
+			pValues[ 0 ] = int( floor(( dAverage + dHalfRange ) * 100.0 + 0.5 ));
+			pValues[ 1 ] = int( floor(( dAverage - dHalfRange ) * 100.0 + 0.5 ));
+			pValues[ 2 ] = ( pValues[ 0 ] + pValues[ 1 ] ) / 2;
+
+			month.DM = ' ';
+			month.QC = ' ';
+			month.DS = chSources[ GetNext( random ) % ( _countof( chSources ) - 1 ) ];
+			if ( GetUniform( random ) < m_dMissingRate )
+			{
+				pValues[ 0 ] = pValues[ 1 ] = pValues[ 2 ] = -9999;
+				month.DS = ' ';
+
+			} else
+			{
+				if ( GetUniform( random ) < m_dDaysMissingRate )
+				{
+					month.DM = char( 'a' + GetNext( random ) % 9 );
+				}
+				if ( GetUniform( random ) < m_dFlagRate )
+				{
+					month.QC = chFlags[ GetNext( random ) % ( _countof( chFlags ) - 1 ) ];
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// write the three measurement files of a USHCN station
+	bool WriteStation( LPCTSTR folder, int nStation )
+	{
+		RANDOM random = GetRandom( snUshcn, nStation );
+		STATION_CLIMATE climate;
+		GetClimate( random, climate );
+
+		FILE_BUFFER buffers[ 3 ];
+		for ( auto& buffer : buffers )
+		{
+			buffer.reserve(( m_nLastYear - climate.FirstYear + 1 ) * 128 );
+		}
+
+		int nLines = 0;
+		MONTH_READING months[ 12 ];
+		for ( int nYear = climate.FirstYear; nYear <= m_nLastYear; nYear++ )
+		{
+			if ( !GetYear( random, climate, nYear, months ))
+			{
+				continue;
+			}
+
+			char text[ 32 ];
+			_snprintf_s
+			(
+				text, _countof( text ), _TRUNCATE, "USH%08d %04d",
+				nStation + 1, nYear
+			);
+			for ( auto& buffer : buffers )
+			{
+				AppendText( buffer, text );
+			}
+
+			for ( const MONTH_READING& month : months )
+			{
+				for ( int n = 0; n < 3; n++ )
+				{
+					_snprintf_s
+					(
+						text, _countof( text ), _TRUNCATE, "%6d%c%c%c",
+						month.Values[ n ], month.DM, month.QC, month.DS
+					);
+					AppendText( buffers[ n ], text );
+				}
+			}
+
+			for ( auto& buffer : buffers )
+			{
+				AppendText( buffer, "\n" );
+			}
+			nLines++;
+		}
+
+		static const LPCTSTR pExtensions[ 3 ] =
+		{
+			_T( ".tmax" ), _T( ".tmin" ), _T( ".tavg" )
+		};
+		const CString csStation = GetStation( snUshcn, nStation );
+		for ( int n = 0; n < 3; n++ )
+		{
+			CString csPath;
+			csPath.Format
+			(
+				_T( "%s\\%s.raw%s" ), folder, csStation, pExtensions[ n ]
+			);
+			if ( !WriteFile( csPath, buffers[ n ], nLines ))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// append the TMAX, TMIN and TAVG lines of a GHCN station to the
+	// buffers of the three GHCN-Monthly files and return the lines of each
+	int AppendGhcnMonthly( FILE_BUFFER* pBuffers, int nStation )
+	{
+		static const char* pElements[ 3 ] = { "TMAX", "TMIN", "TAVG" };
+
+		RANDOM random = GetRandom( snGhcn, nStation );
+		STATION_CLIMATE climate;
+		GetClimate( random, climate );
+
+		int value = 0;
+		MONTH_READING months[ 12 ];
+		for ( int nYear = climate.FirstYear; nYear <= m_nLastYear; nYear++ )
+		{
+			if ( !GetYear( random, climate, nYear, months ))
+			{
+				continue;
+			}
+
+			for ( int n = 0; n < 3; n++ )
+			{
+				char text[ 32 ];
+				_snprintf_s
+				(
+					text, _countof( text ), _TRUNCATE, "USC%08d%04d%s",
+					nStation + 1, nYear, pElements[ n ]
+				);
+				AppendText( pBuffers[ n ], text );
+
+				for ( const MONTH_READING& month : months )
+				{
+					_snprintf_s
+					(
+						text, _countof( text ), _TRUNCATE, "%5d%c%c%c",
+						month.Values[ n ], month.DM, month.QC, month.DS
+					);
+					AppendText( pBuffers[ n ], text );
+				}
+				AppendText( pBuffers[ n ], "\n" );
+			}
+			value++;
+		}
+
+		return value;
+	}
+
+	// write the three GHCN-Monthly files, a block of stations at a time is
+	// formatted in parallel and appended in station order
+	bool WriteGhcnMonthly( LPCTSTR folder )
+	{
+		static const LPCTSTR pElements[ 3 ] =
+		{
+			_T( "tmax" ), _T( "tmin" ), _T( "tavg" )
+		};
+
+		CFile files[ 3 ];
+		for ( int n = 0; n < 3; n++ )
+		{
+			CString csPath;
+			csPath.Format
+			(
+				_T( "%s\\ghcnm.%s.v4.0.1.synthetic.qcu.dat" ), folder, pElements[ n ]
+			);
+			if ( !files[ n ].Open( csPath, CFile::modeCreate | CFile::modeWrite ))
+			{
+				return false;
+			}
+			m_nFiles++;
+		}
+
+		const int nBlock = 1024;
+		vector<FILE_BUFFER> buffers( nBlock * 3 );
+		for ( int nFirst = 0; nFirst < m_nStations; nFirst += nBlock )
+		{
+			const int nStations = min( nBlock, m_nStations - nFirst );
+			concurrency::parallel_for
+			(
+				0, nStations,
+				[&]( int nStation )
+				{
+					FILE_BUFFER* pBuffers = &buffers[ nStation * 3 ];
+					for ( int n = 0; n < 3; n++ )
+					{
+						pBuffers[ n ].clear();
+					}
+					m_llLines += 3 * AppendGhcnMonthly( pBuffers, nFirst + nStation );
+				}
+			);
+
+			for ( int nStation = 0; nStation < nStations; nStation++ )
+			{
+				for ( int n = 0; n < 3; n++ )
+				{
+					FILE_BUFFER& buffer = buffers[ nStation * 3 + n ];
+					files[ n ].Write( buffer.data(), (UINT)buffer.size() );
+					m_llBytes += (LONGLONG)buffer.size();
+				}
+			}
+		}
+
+		for ( auto& file : files )
+		{
+			file.Close();
+		}
+
+		return true;
+	}
+
+	// write the GHCN-Daily file of a GHCN station, the TMAX and TMIN lines
+	// of each month follow the monthly readings of the station
+	bool WriteGhcnDaily( LPCTSTR folder, int nStation )
+	{
+		static const char chFlags[] = "DGIKLMNORSTWXZ";
+		static const char chSources[] = "0067";
+
+		RANDOM random = GetRandom( snGhcn, nStation );
+		RANDOM days = GetRandom( snDaily, nStation );
+		STATION_CLIMATE climate;
+		GetClimate( random, climate );
+
+		FILE_BUFFER buffer;
+		buffer.reserve(( m_nLastYear - climate.FirstYear + 1 ) * 24 * 272 );
+
+		// the anomaly of a day carries most of the day before so warm and
+		// cold days come in spells
+		double dAnomaly = 0.0;
+		int nLines = 0;
+		MONTH_READING months[ 12 ];
+		for ( int nYear = climate.FirstYear; nYear <= m_nLastYear; nYear++ )
+		{
+			if ( !GetYear( random, climate, nYear, months ))
+			{
+				continue;
+			}
+
+			for ( int nMonth = 0; nMonth < 12; nMonth++ )
+			{
+				static const int nMonthDays[ 12 ] =
+				{
+					31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+				};
+				const int nDays = nMonthDays[ nMonth ];
+
+				// tenths of a degree of the maximum and minimum of each day
+				short values[ 2 ][ 31 ];
+				char flags[ 31 ];
+				for ( int nDay = 0; nDay < 31; nDay++ )
+				{
+					dAnomaly = 0.7 * dAnomaly + 2.0 * GetNormal( days );
+					const bool bMissing = nDay >= nDays ||
+						months[ nMonth ].Values[ 0 ] == -9999 ||
+						GetUniform( days ) < m_dMissingRate;
+					for ( int n = 0; n < 2; n++ )
+					{
+						values[ n ][ nDay ] = bMissing ? -9999 : short
+						(
+							floor( months[ nMonth ].Values[ n ] / 10.0 + dAnomaly * 10.0 + 0.5 )
+						);
+					}
+					flags[ nDay ] = !bMissing && GetUniform( days ) < m_dFlagRate ?
+						chFlags[ GetNext( days ) % ( _countof( chFlags ) - 1 ) ] : ' ';
+				}
+
+				static const char* pElements[ 2 ] = { "TMAX", "TMIN" };
+				for ( int n = 0; n < 2; n++ )
+				{
+					char text[ 32 ];
+					_snprintf_s
+					(
+						text, _countof( text ), _TRUNCATE, "USC%08d%04d%02d%s",
+						nStation + 1, nYear, nMonth + 1, pElements[ n ]
+					);
+					AppendText( buffer, text );
+
+					for ( int nDay = 0; nDay < 31; nDay++ )
+					{
+						const bool bMissing = values[ n ][ nDay ] == -9999;
+						_snprintf_s
+						(
+							text, _countof( text ), _TRUNCATE, "%5d %c%c",
+							values[ n ][ nDay ], flags[ nDay ],
+							bMissing ? ' ' : chSources[ nDay % ( _countof( chSources ) - 1 ) ]
+						);
+						AppendText( buffer, text );
+					}
+					AppendText( buffer, "\n" );
+					nLines++;
+				}
+			}
+		}
+
+		CString csPath;
+		csPath.Format( _T( "%s\\%s.dly" ), folder, GetStation( snGhcn, nStation ));
+		return WriteFile( csPath, buffer, nLines );
+	}
+
+// public methods
+public:
+	// default folder of a tree under the temporary folder named after its
+	// size, seed and datasets
+	CString GetTempFolder()
+	{
+		TCHAR pBuffer[ _MAX_PATH ];
+		::GetTempPath( _MAX_PATH, pBuffer );
+
+		CString value;
+		value.Format
+		(
+			_T( "%sClimateHistory\\Synthetic-%dx%d-%I64u-%s" ),
+			pBuffer, m_nStations, m_nYears, m_ullSeed, DatasetLetters
+		);
+		return value;
+	}
+
+	// read the size from "stations:years[:seed[:datasets]]" (i.e.
+	// 1000:100:1221:umd) and return false if either count is out of range
+	// or a dataset is not u (USHCN), m (GHCN-Monthly) or d (GHCN-Daily)
+	bool Define( const CString& csValue )
+	{
+		int nStart = 0;
+		const CString csStations = csValue.Tokenize( _T( ":" ), nStart );
+		const CString csYears =
+			nStart == -1 ? CString() : csValue.Tokenize( _T( ":" ), nStart );
+		const CString csSeed =
+			nStart == -1 ? CString() : csValue.Tokenize( _T( ":" ), nStart );
+		const CString csDatasets =
+			nStart == -1 ? CString() : csValue.Tokenize( _T( ":" ), nStart );
+
+		if ( !csDatasets.IsEmpty() )
+		{
+			Datasets = 0;
+			for ( int n = 0; n < csDatasets.GetLength(); n++ )
+			{
+				switch ( _totlower( csDatasets[ n ] ))
+				{
+					case _T( 'u' ): Datasets |= dsUshcn; break;
+					case _T( 'm' ): Datasets |= dsGhcnMonthly; break;
+					case _T( 'd' ): Datasets |= dsGhcnDaily; break;
+					default: return false;
+				}
+			}
+		}
+
+		Stations = _ttoi( csStations );
+		if ( !csYears.IsEmpty() )
+		{
+			Years = _ttoi( csYears );
+		}
+		if ( !csSeed.IsEmpty() )
+		{
+			Seed = _tcstoui64( csSeed, NULL, 10 );
+		}
+
+		return Stations > 0 && Stations < 100000000 && Years > 0 && Years <= 1000 &&
+			Datasets != 0;
+	}
+
+	// write the station file and the climate files of every station of
+	// the datasets into the folder, creating it if needed
+	bool Generate( LPCTSTR folder )
+	{
+		m_nFiles = 0;
+		m_llLines = 0;
+		m_llBytes = 0;
+
+		if ( !::PathFileExists( folder ) && !CHelper::CreatePath( folder ))
+		{
+			return false;
+		}
+
+		const bool bUshcn = ( m_nDatasets & dsUshcn ) != 0;
+		const bool bDaily = ( m_nDatasets & dsGhcnDaily ) != 0;
+		const bool bGhcn = ( m_nDatasets & ( dsGhcnMonthly | dsGhcnDaily )) != 0;
+
+		FILE_BUFFER buffer;
+		buffer.reserve( m_nStations * 200 );
+		int nLines = 0;
+		for ( int eNetwork = snUshcn; eNetwork <= snGhcn; eNetwork++ )
+		{
+			if ( eNetwork == snUshcn ? !bUshcn : !bGhcn )
+			{
+				continue;
+			}
+			for ( int nStation = 0; nStation < m_nStations; nStation++ )
+			{
+				AppendStation
+				(
+					buffer, eNetwork, nStation, GetRandom( eNetwork, nStation )
+				);
+				nLines++;
+			}
+		}
+
+		CString csPath;
+		csPath.Format( _T( "%s\\ushcn-v2.5-stations.txt" ), folder );
+		if ( !WriteFile( csPath, buffer, nLines ))
+		{
+			return false;
+		}
+
+		// the stations are independent of each other
+		atomic<bool> bWritten( true );
+		concurrency::parallel_for
+		(
+			0, m_nStations,
+			[&]( int nStation )
+			{
+				if ( bWritten && bUshcn && !WriteStation( folder, nStation ))
+				{
+					bWritten = false;
+				}
+				if ( bWritten && bDaily && !WriteGhcnDaily( folder, nStation ))
+				{
+					bWritten = false;
+				}
+			}
+		);
+
+		if ( bWritten && ( m_nDatasets & dsGhcnMonthly ) != 0 )
+		{
+			bWritten = WriteGhcnMonthly( folder );
+		}
+
+		return bWritten;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CDataGenerator()
+	{
+		m_nStations = 1000;
+		m_nYears = 100;
+		m_nLastYear = 2022;
+		m_ullSeed = 1221;
+		m_nDatasets = dsUshcn | dsGhcnMonthly;
+		m_dMissingRate = 0.03;
+		m_dFlagRate = 0.01;
+		m_dDaysMissingRate = 0.05;
+		m_dGapRate = 0.02;
+		m_nFiles = 0;
+		m_llLines = 0;
+		m_llBytes = 0;
+	}
+
+	// destructor
+	~CDataGenerator()
+	{
+	}
+};
@@ -0,0 +1,215 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "KeyedCollection.h"
+#include "SchemaCollection.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// the collection definitions read from DataSchema.xml. The file is only
+// scanned for the <Collection> and <Stream> elements and their attributes
+// which is all the persistence classes need, so no XML parser is required.
+class CDataSchema
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// collection definitions keyed by name
+	CKeyedCollection<CString, CSchemaCollection> m_Collections;
+
+	// pathname the schema was loaded from
+	CString m_csPathname;
+
+// public properties
+public:
+	// collection definitions keyed by name
+	inline CKeyedCollection<CString, CSchemaCollection>& GetCollections()
+	{
+		return m_Collections;
+	}
+	// collection definitions keyed by name
+	__declspec( property( get = GetCollections ) )
+		CKeyedCollection<CString, CSchemaCollection> Collections;
+
+	// pathname the schema was loaded from
+	inline CString GetPathname()
+	{
+		return m_csPathname;
+	}
+	// pathname the schema was loaded from
+	__declspec( property( get = GetPathname ) )
+		CString Pathname;
+
+// protected methods
+protected:
+	// value of an attribute within the text of an element
+	static CString GetAttribute( const CString& element, LPCTSTR name )
+	{
+		CString value;
+
+		CString csFind;
+		csFind.Format( _T( " %s=\"" ), name );
+
+		int nStart = element.Find( csFind );
+		if ( nStart == -1 )
+		{
+			// attributes may also start on a new line or after a tab
+			csFind.SetAt( 0, _T( '\t' ));
+			nStart = element.Find( csFind );
+		}
+		if ( nStart == -1 )
+		{
+			csFind.SetAt( 0, _T( '\n' ));
+			nStart = element.Find( csFind );
+		}
+		if ( nStart == -1 )
+		{
+			return value;
+		}
+
+		nStart += csFind.GetLength();
+		const int nEnd = element.Find( _T( '"' ), nStart );
+		if ( nEnd != -1 )
+		{
+			value = element.Mid( nStart, nEnd - nStart );
+		}
+
+		return value;
+	}
+
+	// parse the streams of a collection from the text between the
+	// collection start and end tags
+	static void ParseStreams
+	(
+		const CString& text, shared_ptr<CSchemaCollection>& collection
+	)
+	{
+		int nPos = 0;
+		do
+		{
+			const int nStart = text.Find( _T( "<Stream" ), nPos );
+			if ( nStart == -1 )
+			{
+				break;
+			}
+
+			const int nEnd = text.Find( _T( "/>" ), nStart );
+			if ( nEnd == -1 )
+			{
+				break;
+			}
+
+			const CString element = text.Mid( nStart, nEnd - nStart );
+			nPos = nEnd + 2;
+
+			shared_ptr<CSchemaStream> stream =
+				shared_ptr<CSchemaStream>( new CSchemaStream );
+			stream->Name = GetAttribute( element, _T( "Name" ));
+			stream->Title = GetAttribute( element, _T( "Title" ));
+			stream->Type = CSchemaStream::ParseType
+			(
+				GetAttribute( element, _T( "Type" ))
+			);
+			stream->Size = _ttoi( GetAttribute( element, _T( "Size" )));
+
+			const CString csNull = GetAttribute( element, _T( "Null" ));
+			if ( !csNull.IsEmpty() )
+			{
+				stream->Null = _tstof( csNull );
+			}
+
+			stream->ParseEnumeration
+			(
+				GetAttribute( element, _T( "Enumeration" ))
+			);
+
+			collection->AddStream( stream );
+
+		} while ( true );
+	}
+
+// public methods
+public:
+	// find a collection definition by name
+	shared_ptr<CSchemaCollection> Find( LPCTSTR name )
+	{
+		return m_Collections.find( name );
+	}
+
+	// load the collection definitions from the given file
+	bool Load( LPCTSTR pathname )
+	{
+		m_Collections.clear();
+		m_csPathname = pathname;
+
+		CStdioFile file;
+		if ( !file.Open( pathname, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return false;
+		}
+
+		// the whole file is small enough to be scanned as one string
+		CString text;
+		CString csLine;
+		while ( file.ReadString( csLine ))
+		{
+			text += csLine;
+			text += _T( "\n" );
+		}
+		file.Close();
+
+		int nPos = 0;
+		do
+		{
+			const int nStart = text.Find( _T( "<Collection" ), nPos );
+			if ( nStart == -1 )
+			{
+				break;
+			}
+
+			const int nTagEnd = text.Find( _T( '>' ), nStart );
+			const int nEnd = text.Find( _T( "</Collection>" ), nStart );
+			if ( nTagEnd == -1 || nEnd == -1 )
+			{
+				break;
+			}
+
+			const CString element = text.Mid( nStart, nTagEnd - nStart );
+			const CString body = text.Mid( nTagEnd + 1, nEnd - nTagEnd - 1 );
+			nPos = nEnd;
+
+			shared_ptr<CSchemaCollection> collection =
+				shared_ptr<CSchemaCollection>( new CSchemaCollection );
+			collection->Name = GetAttribute( element, _T( "Name" ));
+			collection->Description = GetAttribute( element, _T( "Description" ));
+			collection->SetIndexKeys( GetAttribute( element, _T( "IndexKeys" )));
+			ParseStreams( body, collection );
+
+			m_Collections.add( collection->Name, collection );
+
+		} while ( true );
+
+		return m_Collections.Count > 0;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CDataSchema()
+	{
+	}
+
+	// destructor
+	~CDataSchema()
+	{
+	}
+};
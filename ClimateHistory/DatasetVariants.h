@@ -0,0 +1,554 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateYear.h"
+#include "ParseCache.h"
+#include "QueryFilter.h"
+#include "RunStatistics.h"
+#include "StationList.h"
+#include <ppl.h>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// several variants of the same dataset ingested in one run. The USHCN
+// distribution names each station's files after the processing applied to
+// them, i.e.
+//
+//	USH00011084.raw.tmax		unadjusted
+//	USH00011084.tob.tmax		time of observation adjusted
+//	USH00011084.FLs.52j.tmax	homogenized
+//
+// so the variant is the part of the file name between the station ID and
+// the extension. The tree is crawled once, every file of every variant is
+// parsed in parallel, and each variant is merged into its own collection of
+// climate years. All variants share the station list's dense indexes and
+// a parse cache, so a line repeated by another variant is decoded once.
+//
+// The first variant is the base the others are compared against. A station
+// year of another variant whose readings and flags match the base is
+// replaced by the base's object so identical rows are stored only once.
+class CDatasetVariants
+{
+// public definitions
+public:
+	// a climate file and the measurement type of its extension
+	typedef pair<CString, CClimateTemperature::MEASURE_TYPE> CLIMATE_FILE;
+
+	// sum of the paired differences of a year and the number of pairs
+	typedef pair<double, int> DELTA_SUM;
+
+	// one variant of the dataset
+	typedef struct tagDATASET_VARIANT
+	{
+		// name of the variant (i.e. raw, tob, or FLs.52j)
+		CString Name;
+
+		// climate files of the variant
+		vector<CLIMATE_FILE> Files;
+
+		// parsed station years by year
+		CKeyedCollection<CString, CClimateYear> ClimateYears;
+
+		// number of station years parsed
+		int Rows;
+
+		// number of station years shared with the base variant
+		int SharedRows;
+
+	} DATASET_VARIANT;
+
+// protected data
+protected:
+	// variants in the order given, the first is the base
+	vector<shared_ptr<DATASET_VARIANT> > m_arrVariants;
+
+// public properties
+public:
+	// number of variants
+	inline int GetCount()
+	{
+		return (int)m_arrVariants.size();
+	}
+	// number of variants
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+	// variant by index (0 is the base)
+	inline shared_ptr<DATASET_VARIANT> GetVariant( int index )
+	{
+		return m_arrVariants[ index ];
+	}
+	// variant by index (0 is the base)
+	__declspec( property( get = GetVariant ) )
+		shared_ptr<DATASET_VARIANT> Variant[];
+
+// protected methods
+protected:
+	// variant index of a file name or -1 if the variant was not requested
+	int FindVariant( LPCTSTR pathname )
+	{
+		// the file name without the measurement extension
+		const CString csName = CHelper::GetFileName( pathname );
+		const int nDot = csName.Find( _T( '.' ));
+		if ( nDot == -1 )
+		{
+			return -1;
+		}
+
+		const CString csVariant = csName.Mid( nDot + 1 );
+		const int nVariants = Count;
+		for ( int index = 0; index < nVariants; index++ )
+		{
+			if ( csVariant.CompareNoCase( m_arrVariants[ index ]->Name ) == 0 )
+			{
+				return index;
+			}
+		}
+
+		return -1;
+	}
+
+	// parse every line of a climate file that passes the filter, stations
+	// are looked up but not added so many files can be parsed at once
+	static void ParseFile
+	(
+		CLIMATE_FILE& file, CStationList& stations, CParseCache& cache,
+		CQueryFilter& filter, CRunStatistics& statistics,
+		vector<shared_ptr<CStationYear> >& rows
+	)
+	{
+		CTraceLog::CTraceScope scope( statistics.Trace, _T( "parse file" ), file.first );
+		CStdioFile fIn;
+		if ( !fIn.Open( file.first, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return;
+		}
+		statistics.AddFile( fIn );
+
+		const bool bFilter = filter.Active;
+		CString csLine;
+		while ( statistics.ReadString( fIn, csLine ))
+		{
+			if ( bFilter && !filter.AcceptLine( csLine, stations ))
+			{
+				if ( filter.IsPast( csLine ))
+				{
+					break;
+				}
+				continue;
+			}
+
+			// the indexer is only called for lines the cache decodes
+			rows.push_back( statistics.Time
+			(
+				CRunStatistics::spParse,
+				[&]()
+				{
+					return cache.Parse
+					(
+						csLine, file.second,
+						[&]( const CString& station )
+						{
+							statistics.Add( CRunStatistics::scDecoded );
+							return stations.Find( station );
+						}
+					);
+				}
+			));
+			statistics.AddRecord( rows.back()->ValidReadings );
+		}
+		fIn.Close();
+	}
+
+	// add the parsed rows of a variant to its climate years leaving out
+	// those with fewer valid months than the minimum
+	static void Merge
+	(
+		DATASET_VARIANT& variant, CRunStatistics& statistics,
+		vector<shared_ptr<CStationYear> >& rows, int nMinimumMonths
+	)
+	{
+		CTraceLog::CTraceScope scope( statistics.Trace, _T( "merge" ), variant.Name );
+		CRunStatistics::CPhaseTimer timer( statistics, CRunStatistics::spInsert );
+		for ( auto& StationYear : rows )
+		{
+			const CString csYear = StationYear->Year;
+			shared_ptr<CClimateYear> ClimateYear =
+				variant.ClimateYears.find( csYear );
+			if ( ClimateYear == nullptr )
+			{
+				ClimateYear = shared_ptr<CClimateYear>( new CClimateYear );
+				ClimateYear->Year = csYear;
+				variant.ClimateYears.add( csYear, ClimateYear );
+			}
+
+			if ( ClimateYear->WriteStationYear( StationYear, nMinimumMonths ))
+			{
+				variant.Rows++;
+
+			} else
+			{
+				statistics.Add( CRunStatistics::scDuplicates );
+			}
+		}
+	}
+
+	// replace the station years of a collection that match the base's
+	static int ShareRows
+	(
+		CKeyedCollection<CString, CStationYear>& base,
+		CKeyedCollection<CString, CStationYear>& variant
+	)
+	{
+		int value = 0;
+		for ( auto& node : variant.Items )
+		{
+			shared_ptr<CStationYear> pBase = base.find( node.first );
+			if ( pBase == nullptr )
+			{
+				continue;
+			}
+
+			// the parse cache already shares rows whose lines match
+			if ( pBase == node.second || pBase->SameReadings( *node.second ))
+			{
+				node.second = pBase;
+				value++;
+			}
+		}
+
+		return value;
+	}
+
+	// station years of a climate year by measurement type
+	static CKeyedCollection<CString, CStationYear>& GetStationYears
+	(
+		CClimateYear& year, CClimateTemperature::MEASURE_TYPE eType
+	)
+	{
+		switch ( eType )
+		{
+			case CClimateTemperature::mtMinimum:
+			{
+				return year.Minimums;
+			}
+			case CClimateTemperature::mtAverage:
+			{
+				return year.Averages;
+			}
+			default:
+			{
+				return year.Maximums;
+			}
+		}
+	}
+
+// public methods
+public:
+	// define the variants from a comma separated list, i.e.
+	// "raw,tob,FLs.52j", and return the number of variants
+	int Define( const CString& csVariants )
+	{
+		m_arrVariants.clear();
+
+		int nStart = 0;
+		CString csVariant = csVariants.Tokenize( _T( "," ), nStart );
+		while ( nStart != -1 )
+		{
+			csVariant.Trim();
+			if ( !csVariant.IsEmpty() )
+			{
+				shared_ptr<DATASET_VARIANT> pVariant =
+					shared_ptr<DATASET_VARIANT>( new DATASET_VARIANT );
+				pVariant->Name = csVariant;
+				pVariant->Rows = 0;
+				pVariant->SharedRows = 0;
+				m_arrVariants.push_back( pVariant );
+			}
+			csVariant = csVariants.Tokenize( _T( "," ), nStart );
+		}
+
+		return Count;
+	}
+
+	// crawl the tree once for the climate files of every variant and add
+	// their stations (the first 11 characters of the file name) to the
+	// station list before any parsing begins, files the filter rejects
+	// are left out
+	void Crawl
+	(
+		LPCTSTR path, CStationList& stations, CQueryFilter& filter,
+		CRunStatistics& statistics
+	)
+	{
+		CString csPathname = CString( path ).Trim( _T( "\\" ));
+
+		CString strWildcard;
+		strWildcard.Format( _T( "%s\\*.*" ), csPathname );
+
+		CFileFind finder;
+		BOOL bWorking = statistics.Time
+		(
+			CRunStatistics::spCrawl,
+			[&]() { return finder.FindFile( strWildcard ); }
+		);
+		while ( bWorking )
+		{
+			bWorking = statistics.Time
+			(
+				CRunStatistics::spCrawl,
+				[&]() { return finder.FindNextFile(); }
+			);
+
+			if ( finder.IsDots() )
+			{
+				continue;
+			}
+
+			if ( finder.IsDirectory() )
+			{
+				const CString folder =
+					finder.GetFilePath().TrimRight( _T( "\\" ) );
+				Crawl( folder, stations, filter, statistics );
+				continue;
+			}
+
+			const CString csPath = finder.GetFilePath();
+			const CString csExt = CHelper::GetExtension( csPath ).MakeLower();
+			CClimateTemperature::MEASURE_TYPE eType =
+				CClimateTemperature::mtMissing;
+			if ( csExt == _T( ".tmax" ))
+			{
+				eType = CClimateTemperature::mtMaximum;
+
+			} else if ( csExt == _T( ".tmin" ))
+			{
+				eType = CClimateTemperature::mtMinimum;
+
+			} else if ( csExt == _T( ".tavg" ))
+			{
+				eType = CClimateTemperature::mtAverage;
+			}
+
+			const int index = FindVariant( csPath );
+			if ( eType == CClimateTemperature::mtMissing || index == -1 )
+			{
+				continue;
+			}
+
+			if ( !filter.AcceptFile( csPath, eType, stations ))
+			{
+				continue;
+			}
+
+			m_arrVariants[ index ]->Files.push_back( CLIMATE_FILE( csPath, eType ));
+			stations.Add( CHelper::GetFileName( csPath ).Left( 11 ));
+		}
+
+		finder.Close();
+	}
+
+	// parse the files of every variant in parallel, merge each variant
+	// into its climate years, and share the rows that match the base
+	void Parse
+	(
+		CStationList& stations, CParseCache& cache, CQueryFilter& filter,
+		CRunStatistics& statistics
+	)
+	{
+		// every file of every variant is an independent task
+		vector<pair<int, CLIMATE_FILE*> > tasks;
+		const int nVariants = Count;
+		for ( int index = 0; index < nVariants; index++ )
+		{
+			for ( auto& file : m_arrVariants[ index ]->Files )
+			{
+				tasks.push_back( pair<int, CLIMATE_FILE*>( index, &file ));
+			}
+		}
+
+		const int nTasks = (int)tasks.size();
+		vector<vector<shared_ptr<CStationYear> > > arrRows( nTasks );
+		statistics.Progress->Total = nTasks;
+		{
+			CTraceLog::CTraceScope scope( statistics.Trace, _T( "parse" ));
+			concurrency::parallel_for
+			(
+				0, nTasks,
+				[&]( int nTask )
+				{
+					ParseFile
+					(
+						*tasks[ nTask ].second, stations, cache, filter,
+						statistics, arrRows[ nTask ]
+					);
+				}
+			);
+		}
+
+		// lines whose station differs from its file name are indexed here
+		// where the station list can safely grow
+		for ( auto& rows : arrRows )
+		{
+			for ( auto& StationYear : rows )
+			{
+				if ( StationYear->StationIndex == -1 )
+				{
+					StationYear->StationIndex = stations.Add( StationYear->Station );
+				}
+			}
+		}
+
+		// each variant only touches its own climate years
+		concurrency::parallel_for
+		(
+			0, nVariants,
+			[&]( int index )
+			{
+				DATASET_VARIANT& variant = *m_arrVariants[ index ];
+				for ( int nTask = 0; nTask < nTasks; nTask++ )
+				{
+					if ( tasks[ nTask ].first == index )
+					{
+						Merge
+						(
+							variant, statistics, arrRows[ nTask ],
+							filter.MinimumMonths
+						);
+						arrRows[ nTask ].clear();
+					}
+				}
+			}
+		);
+
+		if ( nVariants < 2 )
+		{
+			return;
+		}
+
+		// identical rows keep the base's object
+		CKeyedCollection<CString, CClimateYear>& base =
+			m_arrVariants[ 0 ]->ClimateYears;
+		concurrency::parallel_for
+		(
+			1, nVariants,
+			[&]( int index )
+			{
+				DATASET_VARIANT& variant = *m_arrVariants[ index ];
+				CTraceLog::CTraceScope scope
+				(
+					statistics.Trace, _T( "share rows" ), variant.Name
+				);
+				for ( auto& node : variant.ClimateYears.Items )
+				{
+					shared_ptr<CClimateYear> pBase = base.find( node.first );
+					if ( pBase == nullptr )
+					{
+						continue;
+					}
+
+					variant.SharedRows += ShareRows
+					(
+						pBase->Maximums, node.second->Maximums
+					);
+					variant.SharedRows += ShareRows
+					(
+						pBase->Minimums, node.second->Minimums
+					);
+					variant.SharedRows += ShareRows
+					(
+						pBase->Averages, node.second->Averages
+					);
+				}
+			}
+		);
+	}
+
+	// every year of any variant in year order
+	void GetYears( set<CString>& years )
+	{
+		for ( auto& pVariant : m_arrVariants )
+		{
+			for ( auto& node : pVariant->ClimateYears.Items )
+			{
+				years.insert( node.first );
+			}
+		}
+	}
+
+	// mean difference in degrees centigrade between a variant and the base
+	// over the stations with a value in both for a year and measurement
+	// type or missing, the number of stations is returned in nPairs
+	float GetDelta
+	(
+		int index, const CString& csYear,
+		CClimateTemperature::MEASURE_TYPE eType, int& nPairs
+	)
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		nPairs = 0;
+
+		shared_ptr<CClimateYear> pBase =
+			m_arrVariants[ 0 ]->ClimateYears.find( csYear );
+		shared_ptr<CClimateYear> pVariant =
+			m_arrVariants[ index ]->ClimateYears.find( csYear );
+		if ( pBase == nullptr || pVariant == nullptr )
+		{
+			return fMissing;
+		}
+
+		CKeyedCollection<CString, CStationYear>& base =
+			GetStationYears( *pBase, eType );
+		DELTA_SUM sum( 0.0, 0 );
+		for ( auto& node : GetStationYears( *pVariant, eType ).Items )
+		{
+			shared_ptr<CStationYear> pStation = base.find( node.first );
+			if ( pStation == nullptr )
+			{
+				continue;
+			}
+
+			const float fBase = pStation->Value;
+			const float fValue = node.second->Value;
+			if ( CHelper::NearlyEqual( fBase, fMissing ) ||
+				CHelper::NearlyEqual( fValue, fMissing ))
+			{
+				continue;
+			}
+
+			sum.first += fValue - fBase;
+			sum.second++;
+		}
+
+		nPairs = sum.second;
+		if ( nPairs == 0 )
+		{
+			return fMissing;
+		}
+
+		return float( sum.first / nPairs );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CDatasetVariants()
+	{
+	}
+
+	// destructor
+	~CDatasetVariants()
+	{
+	}
+};
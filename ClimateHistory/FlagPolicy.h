@@ -0,0 +1,487 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateTable.h"
+#include "ClimateYear.h"
+#include "KeyedCollection.h"
+#include <emmintrin.h>
+#include <float.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// yearly aggregates of the column blocks under a quality control policy.
+// Readings whose quality control letter is in the exclusion mask are left
+// out, and the months of a station year's mean can be weighted by the
+// share of days the a - i data measurement flag says were present.
+//
+// Four rows of a block are reduced at once with SSE2. The decoded flag
+// column of a month lines up with its temperature column one 32-bit lane
+// per reading, so a single AND and compare yields the exclusion mask of
+// four readings and it is combined with the valid reading mask before the
+// values are accumulated. An empty policy costs the same instructions as
+// any other, so filtering adds nothing to the reduction itself.
+//
+// A station year reduces to the highest valid month for maximums, the
+// lowest for minimums and the (weighted) mean for averages, the same as
+// CStationYear, and a year's value is the mean of its station years.
+class CFlagPolicy
+{
+// public definitions
+public:
+	// sums of one year indexed by measurement type
+	typedef struct tagYEAR_SUM
+	{
+		double Sum[ 4 ]; // sum of the station year values
+		int Values[ 4 ]; // station years with a value
+		int Readings[ 4 ]; // readings kept
+
+	} YEAR_SUM;
+
+	// result of reducing the rows of a block
+	typedef struct tagROW_VALUES
+	{
+		vector<float> Values; // station year value or missing
+		vector<int> Readings; // readings kept
+		int Excluded; // valid readings excluded by the mask
+
+	} ROW_VALUES;
+
+// protected data
+protected:
+	// quality control letters whose readings are excluded
+	DWORD m_dwExcludeMask;
+
+	// weight the months by the days present?
+	bool m_bWeightDays;
+
+	// first year of the table
+	int m_nFirstYear;
+
+	// sums indexed by year less the first year
+	vector<YEAR_SUM> m_arrYears;
+
+	// valid readings excluded by the mask
+	int m_nExcluded;
+
+// public properties
+public:
+	// quality control letters whose readings are excluded
+	inline DWORD GetExcludeMask()
+	{
+		return m_dwExcludeMask;
+	}
+	// quality control letters whose readings are excluded
+	inline void SetExcludeMask( DWORD value )
+	{
+		m_dwExcludeMask = value & CClimateTemperature::FLAG_LETTERS;
+	}
+	// quality control letters whose readings are excluded
+	__declspec( property( get = GetExcludeMask, put = SetExcludeMask ) )
+		DWORD ExcludeMask;
+
+	// weight the months by the days present?
+	inline bool GetWeightDays()
+	{
+		return m_bWeightDays;
+	}
+	// weight the months by the days present?
+	inline void SetWeightDays( bool value )
+	{
+		m_bWeightDays = value;
+	}
+	// weight the months by the days present?
+	__declspec( property( get = GetWeightDays, put = SetWeightDays ) )
+		bool WeightDays;
+
+	// does the policy change the aggregates?
+	inline bool GetActive()
+	{
+		return m_dwExcludeMask != 0 || m_bWeightDays;
+	}
+	// does the policy change the aggregates?
+	__declspec( property( get = GetActive ) )
+		bool Active;
+
+	// valid readings excluded by the mask
+	inline int GetExcluded()
+	{
+		return m_nExcluded;
+	}
+	// valid readings excluded by the mask
+	__declspec( property( get = GetExcluded ) )
+		int Excluded;
+
+	// days in a month (0 to 11) of a common year
+	inline static int GetDaysInMonth( int month )
+	{
+		static const int nDays[ 12 ] =
+		{
+			31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+		};
+		return nDays[ month ];
+	}
+
+// protected methods
+protected:
+	// reduce four rows starting at nRow of the given month columns into
+	// the four lanes of the results
+	void ReduceLanes
+	(
+		const float* pValues[ 12 ], const DWORD* pFlags[ 12 ], int nRow,
+		CClimateTemperature::MEASURE_TYPE eType,
+		float fValues[ 4 ], int nReadings[ 4 ], int nExcluded[ 4 ]
+	)
+	{
+		const __m128 vMissing =
+			_mm_set1_ps( CClimateTemperature::GetMissingValue() );
+		const __m128 vHighest = _mm_set1_ps( FLT_MAX );
+		const __m128 vLowest = _mm_set1_ps( -FLT_MAX );
+		const __m128 vOne = _mm_set1_ps( 1.0f );
+		const __m128i vExclude = _mm_set1_epi32( int( m_dwExcludeMask ));
+		const __m128i vDays =
+			_mm_set1_epi32( CClimateTemperature::DAYS_MISSING_MASK );
+		const __m128i vZero = _mm_setzero_si128();
+
+		__m128 vHigh = vLowest;
+		__m128 vLow = vHighest;
+		__m128 vSum = _mm_setzero_ps();
+		__m128 vWeights = _mm_setzero_ps();
+		__m128i vKept = vZero;
+		__m128i vDropped = vZero;
+
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			const __m128 vValue = _mm_loadu_ps( pValues[ nMonth ] + nRow );
+			const __m128i vFlags =
+				_mm_loadu_si128( (const __m128i*)( pFlags[ nMonth ] + nRow ));
+
+			// valid readings are all far above the missing value
+			const __m128 vValid = _mm_cmpgt_ps( vValue, vMissing );
+
+			// lanes whose letter is not in the exclusion mask
+			const __m128 vAllowed = _mm_castsi128_ps
+			(
+				_mm_cmpeq_epi32( _mm_and_si128( vFlags, vExclude ), vZero )
+			);
+			const __m128 vKeep = _mm_and_ps( vValid, vAllowed );
+
+			// the mask lanes are all ones (-1) so subtracting counts them
+			vKept = _mm_sub_epi32( vKept, _mm_castps_si128( vKeep ));
+			vDropped = _mm_sub_epi32
+			(
+				vDropped, _mm_castps_si128( _mm_andnot_ps( vAllowed, vValid ))
+			);
+
+			vHigh = _mm_max_ps
+			(
+				vHigh,
+				_mm_or_ps
+				(
+					_mm_and_ps( vKeep, vValue ), _mm_andnot_ps( vKeep, vLowest )
+				)
+			);
+			vLow = _mm_min_ps
+			(
+				vLow,
+				_mm_or_ps
+				(
+					_mm_and_ps( vKeep, vValue ), _mm_andnot_ps( vKeep, vHighest )
+				)
+			);
+
+			// a month counts by the share of its days that were present
+			__m128 vWeight = vOne;
+			if ( m_bWeightDays )
+			{
+				const __m128i vMissingDays = _mm_and_si128
+				(
+					_mm_srli_epi32
+					(
+						vFlags, CClimateTemperature::DAYS_MISSING_SHIFT
+					),
+					vDays
+				);
+				const __m128 vScale =
+					_mm_set1_ps( 1.0f / GetDaysInMonth( nMonth ));
+				vWeight = _mm_sub_ps
+				(
+					vOne, _mm_mul_ps( _mm_cvtepi32_ps( vMissingDays ), vScale )
+				);
+			}
+			vWeight = _mm_and_ps( vKeep, vWeight );
+			vSum = _mm_add_ps
+			(
+				vSum, _mm_mul_ps( _mm_and_ps( vKeep, vValue ), vWeight )
+			);
+			vWeights = _mm_add_ps( vWeights, vWeight );
+		}
+
+		float fHigh[ 4 ];
+		float fLow[ 4 ];
+		float fSum[ 4 ];
+		float fWeights[ 4 ];
+		_mm_storeu_ps( fHigh, vHigh );
+		_mm_storeu_ps( fLow, vLow );
+		_mm_storeu_ps( fSum, vSum );
+		_mm_storeu_ps( fWeights, vWeights );
+		_mm_storeu_si128( (__m128i*)nReadings, vKept );
+		_mm_storeu_si128( (__m128i*)nExcluded, vDropped );
+
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		for ( int nLane = 0; nLane < 4; nLane++ )
+		{
+			if ( nReadings[ nLane ] == 0 )
+			{
+				fValues[ nLane ] = fMissing;
+				continue;
+			}
+
+			switch ( eType )
+			{
+				case CClimateTemperature::mtMaximum:
+				{
+					fValues[ nLane ] = fHigh[ nLane ];
+					break;
+				}
+				case CClimateTemperature::mtMinimum:
+				{
+					fValues[ nLane ] = fLow[ nLane ];
+					break;
+				}
+				default:
+				{
+					fValues[ nLane ] = fSum[ nLane ] / fWeights[ nLane ];
+					break;
+				}
+			}
+		}
+	}
+
+	// reduce every row of a block to its station year value
+	void ReduceBlock( CColumnBlock& block, ROW_VALUES& rows )
+	{
+		const int nRows = block.Rows;
+		const CClimateTemperature::MEASURE_TYPE eType = block.MeasurementType;
+		rows.Values.resize( nRows );
+		rows.Readings.resize( nRows );
+		rows.Excluded = 0;
+
+		const float* pValues[ 12 ];
+		const DWORD* pFlags[ 12 ];
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			pValues[ nMonth ] = block.GetMonthColumn( nMonth );
+			pFlags[ nMonth ] = block.GetFlagBitsColumn( nMonth );
+		}
+
+		float fValues[ 4 ];
+		int nReadings[ 4 ];
+		int nExcluded[ 4 ];
+		int nRow = 0;
+		for ( ; nRow + 4 <= nRows; nRow += 4 )
+		{
+			ReduceLanes
+			(
+				pValues, pFlags, nRow, eType, fValues, nReadings, nExcluded
+			);
+			for ( int nLane = 0; nLane < 4; nLane++ )
+			{
+				rows.Values[ nRow + nLane ] = fValues[ nLane ];
+				rows.Readings[ nRow + nLane ] = nReadings[ nLane ];
+				rows.Excluded += nExcluded[ nLane ];
+			}
+		}
+
+		// the last few rows are copied into missing padded lanes
+		if ( nRow < nRows )
+		{
+			float fTail[ 12 ][ 4 ];
+			DWORD dwTail[ 12 ][ 4 ];
+			const float* pTailValues[ 12 ];
+			const DWORD* pTailFlags[ 12 ];
+			for ( int nMonth = 0; nMonth < 12; nMonth++ )
+			{
+				for ( int nLane = 0; nLane < 4; nLane++ )
+				{
+					const bool bRow = nRow + nLane < nRows;
+					fTail[ nMonth ][ nLane ] = bRow ?
+						pValues[ nMonth ][ nRow + nLane ] :
+						CClimateTemperature::GetMissingValue();
+					dwTail[ nMonth ][ nLane ] =
+						bRow ? pFlags[ nMonth ][ nRow + nLane ] : 0;
+				}
+				pTailValues[ nMonth ] = fTail[ nMonth ];
+				pTailFlags[ nMonth ] = dwTail[ nMonth ];
+			}
+
+			ReduceLanes
+			(
+				pTailValues, pTailFlags, 0, eType, fValues, nReadings, nExcluded
+			);
+			for ( int nLane = 0; nRow + nLane < nRows; nLane++ )
+			{
+				rows.Values[ nRow + nLane ] = fValues[ nLane ];
+				rows.Readings[ nRow + nLane ] = nReadings[ nLane ];
+				rows.Excluded += nExcluded[ nLane ];
+			}
+		}
+	}
+
+// public methods
+public:
+	// letters of the quality control flags to exclude (i.e. DIOS) and
+	// return the number of them, zero if any is not a letter
+	int SetExcludeFlags( const CString& csFlags )
+	{
+		return CClimateTemperature::GetQualityControlMask
+		(
+			csFlags, m_dwExcludeMask
+		);
+	}
+
+	// reduce the blocks in parallel and sum their station years by year
+	void Compute( CClimateTable& table )
+	{
+		vector<shared_ptr<CColumnBlock> >& blocks = table.Blocks;
+		const int nBlocks = (int)blocks.size();
+
+		m_nFirstYear = 0;
+		m_nExcluded = 0;
+		m_arrYears.clear();
+
+		int nLastYear = 0;
+		bool bFirst = true;
+		for ( auto& block : blocks )
+		{
+			CZoneMap& zone = block->YearZone;
+			if ( zone.Empty )
+			{
+				continue;
+			}
+
+			if ( bFirst )
+			{
+				m_nFirstYear = int( zone.Minimum );
+				nLastYear = int( zone.Maximum );
+				bFirst = false;
+
+			} else
+			{
+				m_nFirstYear = min( m_nFirstYear, int( zone.Minimum ));
+				nLastYear = max( nLastYear, int( zone.Maximum ));
+			}
+		}
+		if ( bFirst )
+		{
+			return;
+		}
+
+		YEAR_SUM empty;
+		ZeroMemory( &empty, sizeof( empty ));
+		m_arrYears.assign( nLastYear - m_nFirstYear + 1, empty );
+
+		vector<ROW_VALUES> arrRows( nBlocks );
+		concurrency::parallel_for
+		(
+			0, nBlocks,
+			[&]( int nBlock )
+			{
+				ReduceBlock( *blocks[ nBlock ], arrRows[ nBlock ] );
+			}
+		);
+
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		for ( int nBlock = 0; nBlock < nBlocks; nBlock++ )
+		{
+			CColumnBlock& block = *blocks[ nBlock ];
+			ROW_VALUES& rows = arrRows[ nBlock ];
+			const int eType = block.MeasurementType;
+			const int nRows = block.Rows;
+			for ( int row = 0; row < nRows; row++ )
+			{
+				YEAR_SUM& year = m_arrYears[ block.Year[ row ] - m_nFirstYear ];
+				year.Readings[ eType ] += rows.Readings[ row ];
+				if ( rows.Values[ row ] > fMissing )
+				{
+					year.Sum[ eType ] += rows.Values[ row ];
+					year.Values[ eType ]++;
+				}
+			}
+			m_nExcluded += rows.Excluded;
+		}
+	}
+
+	// mean in centigrade of a measurement type of a year or missing
+	float GetMean( int nYear, CClimateTemperature::MEASURE_TYPE eType )
+	{
+		const int index = nYear - m_nFirstYear;
+		if ( index < 0 || index >= (int)m_arrYears.size() ||
+			m_arrYears[ index ].Values[ eType ] == 0 )
+		{
+			return CClimateTemperature::GetMissingValue();
+		}
+
+		YEAR_SUM& year = m_arrYears[ index ];
+		return float( year.Sum[ eType ] / year.Values[ eType ] );
+	}
+
+	// readings kept of a measurement type of a year
+	int GetReadings( int nYear, CClimateTemperature::MEASURE_TYPE eType )
+	{
+		const int index = nYear - m_nFirstYear;
+		if ( index < 0 || index >= (int)m_arrYears.size() )
+		{
+			return 0;
+		}
+
+		return m_arrYears[ index ].Readings[ eType ];
+	}
+
+	// replace the yearly means and reading counts of the climate years
+	// with the ones computed under the policy
+	void Apply( CKeyedCollection<CString, CClimateYear>& years )
+	{
+		for ( auto& node : years.Items )
+		{
+			shared_ptr<CClimateYear>& pYear = node.second;
+			const int nYear = _ttoi( node.first );
+
+			pYear->Maximum = GetMean( nYear, CClimateTemperature::mtMaximum );
+			pYear->Minimum = GetMean( nYear, CClimateTemperature::mtMinimum );
+			pYear->Average = GetMean( nYear, CClimateTemperature::mtAverage );
+			pYear->MaxReadings =
+				GetReadings( nYear, CClimateTemperature::mtMaximum );
+			pYear->MinReadings =
+				GetReadings( nYear, CClimateTemperature::mtMinimum );
+			pYear->AvgReadings =
+				GetReadings( nYear, CClimateTemperature::mtAverage );
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor keeps every valid reading unweighted
+	CFlagPolicy()
+	{
+		m_dwExcludeMask = 0;
+		m_bWeightDays = false;
+		m_nFirstYear = 0;
+		m_nExcluded = 0;
+	}
+
+	// destructor
+	~CFlagPolicy()
+	{
+	}
+};
@@ -0,0 +1,258 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// just enough of a FlatBuffers builder to write the Arrow IPC metadata
+// without the FlatBuffers library. As in the reference builder the buffer
+// is filled from the back, so an object is identified by its distance from
+// the end of the buffer (its offset), and every object a table or vector
+// refers to is finished before the table or vector that refers to it.
+//
+// Tables are written with every field that is added (defaults are not
+// elided) and each table gets its own vtable.
+class CFlatBuilder
+{
+// public definitions
+public:
+	// a field of the table being built and the offset it was written at
+	typedef pair<int, UINT> TABLE_FIELD;
+
+// protected data
+protected:
+	// bytes of the buffer, the used part is from m_nHead to the end
+	vector<BYTE> m_arrData;
+
+	// first used byte of m_arrData
+	size_t m_nHead;
+
+	// largest alignment of anything written
+	size_t m_nMinAlign;
+
+	// size of the buffer when the current table was started
+	UINT m_nTableStart;
+
+	// fields of the current table
+	vector<TABLE_FIELD> m_arrFields;
+
+// public properties
+public:
+	// number of bytes written
+	inline UINT GetSize()
+	{
+		return UINT( m_arrData.size() - m_nHead );
+	}
+	// number of bytes written
+	__declspec( property( get = GetSize ) )
+		UINT Size;
+
+	// first byte of the finished buffer
+	inline const BYTE* GetData()
+	{
+		return m_arrData.data() + m_nHead;
+	}
+	// first byte of the finished buffer
+	__declspec( property( get = GetData ) )
+		const BYTE* Data;
+
+// protected methods
+protected:
+	// make room for the given number of bytes in front of the head
+	void Grow( size_t nBytes )
+	{
+		if ( m_nHead >= nBytes )
+		{
+			return;
+		}
+
+		const size_t nUsed = GetSize();
+		const size_t nCapacity = max( m_arrData.size() * 2, nUsed + nBytes + 256 );
+		vector<BYTE> arrData( nCapacity, 0 );
+		copy( m_arrData.begin() + m_nHead, m_arrData.end(), arrData.end() - nUsed );
+		m_arrData.swap( arrData );
+		m_nHead = nCapacity - nUsed;
+	}
+
+	// prepend raw bytes without any alignment
+	void Place( const void* pData, size_t nBytes )
+	{
+		Grow( nBytes );
+		m_nHead -= nBytes;
+		memcpy( m_arrData.data() + m_nHead, pData, nBytes );
+	}
+
+	// prepend zeros
+	void Pad( size_t nBytes )
+	{
+		Grow( nBytes );
+		m_nHead -= nBytes;
+		memset( m_arrData.data() + m_nHead, 0, nBytes );
+	}
+
+	// pad so that after nAdditional more bytes the size is a multiple of
+	// nAlign (a power of two)
+	void Prep( size_t nAlign, size_t nAdditional )
+	{
+		m_nMinAlign = max( m_nMinAlign, nAlign );
+		const size_t nPad = ( ~( GetSize() + nAdditional ) + 1 ) & ( nAlign - 1 );
+		Pad( nPad );
+	}
+
+	// prepend an unsigned offset to an object already written
+	void PushOffset( UINT nOffset )
+	{
+		Prep( sizeof( UINT ), 0 );
+		const UINT value = GetSize() - nOffset + sizeof( UINT );
+		Place( &value, sizeof( value ));
+	}
+
+// public methods
+public:
+	// prepend an aligned scalar
+	template <class T> void Push( T value )
+	{
+		Prep( sizeof( T ), 0 );
+		Place( &value, sizeof( T ));
+	}
+
+	// write a string and return its offset
+	UINT CreateString( const char* pText, size_t nLength )
+	{
+		Prep( sizeof( UINT ), nLength + 1 );
+		Pad( 1 );
+		Place( pText, nLength );
+		Push<UINT>( UINT( nLength ));
+		return GetSize();
+	}
+
+	// write a vector of structs (or scalars) of the given size and
+	// alignment and return its offset
+	UINT CreateVector
+	(
+		const void* pData, UINT nCount, size_t nSize, size_t nAlign
+	)
+	{
+		const size_t nBytes = nCount * nSize;
+		Prep( sizeof( UINT ), nBytes );
+		Prep( nAlign, nBytes );
+		Place( pData, nBytes );
+		Push<UINT>( nCount );
+		return GetSize();
+	}
+
+	// write a vector of offsets to objects already written and return its
+	// offset
+	UINT CreateOffsets( const vector<UINT>& offsets )
+	{
+		const UINT nCount = (UINT)offsets.size();
+		Prep( sizeof( UINT ), nCount * sizeof( UINT ));
+		for ( UINT n = nCount; n > 0; n-- )
+		{
+			PushOffset( offsets[ n - 1 ] );
+		}
+		Push<UINT>( nCount );
+		return GetSize();
+	}
+
+	// begin a table, its fields follow with AddScalar and AddOffset
+	void StartTable()
+	{
+		m_arrFields.clear();
+		m_nTableStart = GetSize();
+	}
+
+	// add a scalar field to the current table
+	template <class T> void AddScalar( int nField, T value )
+	{
+		Push<T>( value );
+		m_arrFields.push_back( TABLE_FIELD( nField, GetSize() ));
+	}
+
+	// add a field referring to an object already written
+	void AddOffset( int nField, UINT nOffset )
+	{
+		PushOffset( nOffset );
+		m_arrFields.push_back( TABLE_FIELD( nField, GetSize() ));
+	}
+
+	// finish the current table with its vtable and return its offset
+	UINT EndTable()
+	{
+		// the table begins with the signed offset to its vtable
+		Push<int>( 0 );
+		const UINT nTable = GetSize();
+
+		int nFields = 0;
+		for ( auto& field : m_arrFields )
+		{
+			nFields = max( nFields, field.first + 1 );
+		}
+
+		vector<USHORT> arrEntries( nFields, 0 );
+		for ( auto& field : m_arrFields )
+		{
+			arrEntries[ field.first ] = USHORT( nTable - field.second );
+		}
+
+		for ( int nField = nFields; nField > 0; nField-- )
+		{
+			Push<USHORT>( arrEntries[ nField - 1 ] );
+		}
+		Push<USHORT>( USHORT( nTable - m_nTableStart ));
+		Push<USHORT>( USHORT(( nFields + 2 ) * sizeof( USHORT )));
+		const UINT nVTable = GetSize();
+
+		// the vtable was written in front of the table
+		const int nDistance = int( nVTable - nTable );
+		memcpy
+		(
+			m_arrData.data() + m_arrData.size() - nTable, &nDistance, sizeof( int )
+		);
+
+		m_arrFields.clear();
+		return nTable;
+	}
+
+	// write the offset of the root table, the finished buffer is Data for
+	// Size bytes and its size is a multiple of the largest alignment
+	void Finish( UINT nRoot )
+	{
+		Prep( m_nMinAlign, sizeof( UINT ));
+		PushOffset( nRoot );
+	}
+
+	// start over with an empty buffer
+	void Clear()
+	{
+		m_arrData.clear();
+		m_nHead = 0;
+		m_nMinAlign = 1;
+		m_nTableStart = 0;
+		m_arrFields.clear();
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CFlatBuilder()
+	{
+		Clear();
+	}
+
+	// destructor
+	~CFlatBuilder()
+	{
+	}
+};
@@ -0,0 +1,974 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateYear.h"
+#include "KeyedCollection.h"
+#include "QueryFilter.h"
+#include "RunStatistics.h"
+#include "StationList.h"
+#include <algorithm>
+#include <emmintrin.h>
+#include <intrin.h>
+#include <limits.h>
+#include <math.h>
+#include <map>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// counts the days above the greater than limits (90 to 130 degrees
+// Fahrenheit) from the Global Historical Climatology Network - Daily files
+// (one .dly file per station) instead of from the monthly means, which
+// almost never reach the limits:
+//
+//	https://www.ncei.noaa.gov/pub/data/ghcn/daily/readme.txt
+//
+// Fragment of readme.txt describing the .dly files:
+//
+//	Variable   Columns   Type
+//	------------------------------
+//	ID            1-11   Character
+//	YEAR         12-15   Integer
+//	MONTH        16-17   Integer
+//	ELEMENT      18-21   Character
+//	VALUE1       22-26   Integer
+//	MFLAG1       27-27   Character
+//	QFLAG1       28-28   Character
+//	SFLAG1       29-29   Character
+//	  .            .         .
+//	VALUE31    262-266   Integer
+//	MFLAG31    267-267   Character
+//	QFLAG31    268-268   Character
+//	SFLAG31    269-269   Character
+//
+//	TMAX, TMIN and TAVG are in tenths of degrees C (missing = -9999) and
+//	a blank QFLAG means the value did not fail any quality assurance check.
+//
+// Only the TMAX, TMIN, and TAVG lines are decoded, and a day that failed
+// a quality check is treated as missing. The daily data is a hundred
+// times larger than the monthly data so no readings are kept: the files
+// are streamed a block at a time, parsed in parallel with a set of counts
+// for each thread, and only the counts of each year are combined. The
+// values of a line are decoded with SSE2 two days at a time, since each
+// day is eight characters a sixteen byte load holds two values and their
+// flags, and the days of a month are compared to the limits eight at once.
+//
+// Heat waves (maximums above a limit) and cold spells (minimums below a
+// limit) of at least a number of consecutive days are found in the same
+// pass. The compares of a month are packed into a bit mask with a bit for
+// each day and the runs are walked a run at a time with a bit scan, so a
+// month costs a few instructions for each change between run and gap
+// rather than for each day. A run is carried from month to month while
+// the lines follow one another, ends at a missing day, and is counted in
+// the year it started. When asked for, the runs of each station year are
+// also kept (one record for each station year with a run) since a file
+// holds one station.
+class CGhcnDaily
+{
+// public definitions
+public:
+	// kinds of runs of days
+	typedef enum
+	{
+		rtHeat,		// maximums above the heat wave limit
+		rtCold,		// minimums below the cold spell limit
+		rtCount
+
+	} RUN_TYPE;
+
+	// the limit and length of a kind of run
+	typedef struct tagRUN_SETTING
+	{
+		// degrees Fahrenheit
+		int Limit;
+
+		// the limit in tenths of a degree Celsius the days are compared to
+		short Tenths;
+
+		// fewest consecutive days counted as a run
+		int Days;
+
+	} RUN_SETTING;
+
+	// a run in progress while a file is parsed
+	typedef struct tagDAILY_RUN
+	{
+		// consecutive days so far
+		int Days;
+
+		// year the run started
+		int Year;
+
+		// months since year zero of the last line compared
+		int Month;
+
+		// last year a run was counted so a station counts once a year
+		int CountedYear;
+
+	} DAILY_RUN;
+
+	// counts of a year
+	typedef struct tagDAILY_YEAR
+	{
+		// valid days of each measurement type
+		int Days[ 4 ];
+
+		// maximum days above 90, 95, ... 130 degrees Fahrenheit
+		int Greater[ 9 ];
+
+		// runs, days in the runs, the longest run, and the stations with
+		// a run of each kind
+		int Runs[ rtCount ];
+		int RunDays[ rtCount ];
+		int LongestRun[ rtCount ];
+		int RunStations[ rtCount ];
+
+	} DAILY_YEAR;
+
+	// counts by year
+	typedef map<int, DAILY_YEAR> DAILY_YEARS;
+
+	// runs of a station year
+	typedef struct tagSTATION_RUNS
+	{
+		// station ID
+		CString Station;
+
+		// year the runs started in
+		int Year;
+
+		// runs, days in the runs and the longest run of each kind
+		int Runs[ rtCount ];
+		int RunDays[ rtCount ];
+		int LongestRun[ rtCount ];
+
+	} STATION_RUNS;
+
+	// runs of the years of one station by year
+	typedef map<int, STATION_RUNS> STATION_YEARS;
+
+	// the decoded values of a line
+	typedef struct tagDAILY_LINE
+	{
+		// year and month (1 to 12)
+		int Year;
+		int Month;
+
+		// element of the line
+		CClimateTemperature::MEASURE_TYPE Type;
+
+		// tenths of a degree Celsius or MissingValue for each day, the
+		// last is padding so the days fill four vectors
+		short Values[ 32 ];
+
+		// days that failed a quality check
+		int Excluded;
+
+	} DAILY_LINE;
+
+// protected data
+protected:
+	// .dly files found by the crawl
+	vector<CString> m_arrFiles;
+
+	// combined counts by year
+	DAILY_YEARS m_mapYears;
+
+	// valid days read and days that failed a quality check
+	LONGLONG m_llDays;
+	LONGLONG m_llExcluded;
+
+	// limit and length of each kind of run
+	RUN_SETTING m_Runs[ rtCount ];
+
+	// keep the runs of each station year?
+	bool m_bKeepStationRuns;
+
+	// runs of the station years with a run in station and year order
+	vector<STATION_RUNS> m_arrStationRuns;
+
+// public properties
+public:
+	// value of a missing day
+	static inline short GetMissingValue()
+	{
+		return -9999;
+	}
+	// value of a missing day
+	__declspec( property( get = GetMissingValue ) )
+		short MissingValue;
+
+	// length of a line with all 31 days
+	static inline int GetLineLength()
+	{
+		return 269;
+	}
+	// length of a line with all 31 days
+	__declspec( property( get = GetLineLength ) )
+		int LineLength;
+
+	// number of .dly files found
+	inline int GetFiles()
+	{
+		return (int)m_arrFiles.size();
+	}
+	// number of .dly files found
+	__declspec( property( get = GetFiles ) )
+		int Files;
+
+	// number of years with counts
+	inline int GetYears()
+	{
+		return (int)m_mapYears.size();
+	}
+	// number of years with counts
+	__declspec( property( get = GetYears ) )
+		int Years;
+
+	// valid days read
+	inline LONGLONG GetDays()
+	{
+		return m_llDays;
+	}
+	// valid days read
+	__declspec( property( get = GetDays ) )
+		LONGLONG Days;
+
+	// days that failed a quality check
+	inline LONGLONG GetExcluded()
+	{
+		return m_llExcluded;
+	}
+	// days that failed a quality check
+	__declspec( property( get = GetExcluded ) )
+		LONGLONG Excluded;
+
+	// limit and length of a kind of run
+	inline RUN_SETTING GetRun( int eRun )
+	{
+		return m_Runs[ eRun ];
+	}
+	// limit and length of a kind of run
+	__declspec( property( get = GetRun ) )
+		RUN_SETTING Run[];
+
+	// keep the runs of each station year?
+	inline bool GetKeepStationRuns()
+	{
+		return m_bKeepStationRuns;
+	}
+	// keep the runs of each station year?
+	inline void SetKeepStationRuns( bool value )
+	{
+		m_bKeepStationRuns = value;
+	}
+	// keep the runs of each station year?
+	__declspec( property( get = GetKeepStationRuns, put = SetKeepStationRuns ) )
+		bool KeepStationRuns;
+
+	// number of station years with a run
+	inline int GetStationRunCount()
+	{
+		return (int)m_arrStationRuns.size();
+	}
+	// number of station years with a run
+	__declspec( property( get = GetStationRunCount ) )
+		int StationRunCount;
+
+	// runs of a station year by index
+	inline const STATION_RUNS& GetStationRun( int index )
+	{
+		return m_arrStationRuns[ index ];
+	}
+	// runs of a station year by index
+	__declspec( property( get = GetStationRun ) )
+		STATION_RUNS StationRun[];
+
+// protected methods
+protected:
+	// Fahrenheit limit of a greater than count (90 to 130)
+	static inline int GetLimit( int index )
+	{
+		return 90 + index * 5;
+	}
+
+	// highest tenths of a degree Celsius that is not above a limit, a
+	// reading t is above n Fahrenheit when 9 t > 50 ( n - 32 )
+	static inline short GetLimitTenths( int index )
+	{
+		return short( 50 * ( GetLimit( index ) - 32 ) / 9 );
+	}
+
+	// decode the values of two days from the sixteen characters starting
+	// at the first one's value
+	static inline void DecodePair( const char* pText, short* pValues )
+	{
+		const __m128i vText = _mm_loadu_si128( (const __m128i*)pText );
+		const __m128i vZero = _mm_setzero_si128();
+
+		// digits are kept and every other character becomes zero
+		const __m128i vDigit = _mm_and_si128
+		(
+			_mm_cmpgt_epi8( vText, _mm_set1_epi8( '0' - 1 )),
+			_mm_cmplt_epi8( vText, _mm_set1_epi8( '9' + 1 ))
+		);
+		const __m128i vDigits =
+			_mm_and_si128( _mm_sub_epi8( vText, _mm_set1_epi8( '0' )), vDigit );
+
+		// the five value characters of each day are weighted by their
+		// place and summed in pairs, the flags are weighted by zero
+		const __m128i vWeights =
+			_mm_setr_epi16( 10000, 1000, 100, 10, 1, 0, 0, 0 );
+		const __m128i vFirst =
+			_mm_madd_epi16( _mm_unpacklo_epi8( vDigits, vZero ), vWeights );
+		const __m128i vSecond =
+			_mm_madd_epi16( _mm_unpackhi_epi8( vDigits, vZero ), vWeights );
+
+		// finish both sums at once, the first day ends up in lane 0 and
+		// the second in lane 2
+		__m128i vSum = _mm_add_epi32
+		(
+			_mm_unpacklo_epi64( vFirst, vSecond ),
+			_mm_unpackhi_epi64( vFirst, vSecond )
+		);
+		vSum = _mm_add_epi32( vSum, _mm_shuffle_epi32( vSum, _MM_SHUFFLE( 2, 3, 0, 1 )));
+
+		// a day without a digit (or too large for a short) is missing and
+		// a minus sign negates it
+		const int nDigits = _mm_movemask_epi8( vDigit );
+		const int nMinus = _mm_movemask_epi8
+		(
+			_mm_cmpeq_epi8( vText, _mm_set1_epi8( '-' ))
+		);
+		const int nValues[ 2 ] =
+		{
+			_mm_cvtsi128_si32( vSum ),
+			_mm_cvtsi128_si32( _mm_shuffle_epi32( vSum, _MM_SHUFFLE( 2, 2, 2, 2 )))
+		};
+		for ( int n = 0; n < 2; n++ )
+		{
+			const int nShift = n * 8;
+			if (( nDigits >> nShift & 0x1F ) == 0 || nValues[ n ] > SHRT_MAX )
+			{
+				pValues[ n ] = GetMissingValue();
+
+			} else
+			{
+				pValues[ n ] =
+					short(( nMinus >> nShift & 0x1F ) != 0 ? -nValues[ n ] : nValues[ n ] );
+			}
+		}
+	}
+
+	// days in a month (1 to 12) of a year
+	static inline int GetMonthDays( int nYear, int nMonth )
+	{
+		static const int nDays[ 12 ] =
+		{
+			31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+		};
+		const bool bLeap =
+			nYear % 4 == 0 && ( nYear % 100 != 0 || nYear % 400 == 0 );
+		return nMonth == 2 && bLeap ? 29 : nDays[ nMonth - 1 ];
+	}
+
+	// a bit for each day of a line above the limit, or below it and not
+	// missing, the four compares are packed to bytes two at a time
+	static inline DWORD GetMask( const DAILY_LINE& daily, short limit, bool bAbove )
+	{
+		const __m128i vLimit = _mm_set1_epi16( limit );
+		const __m128i vMissing = _mm_set1_epi16( GetMissingValue() );
+		const __m128i* pValues = (const __m128i*)daily.Values;
+
+		__m128i vCompare[ 4 ];
+		for ( int n = 0; n < 4; n++ )
+		{
+			const __m128i vValues = _mm_loadu_si128( pValues + n );
+			vCompare[ n ] = bAbove ?
+				_mm_cmpgt_epi16( vValues, vLimit ) :
+				_mm_and_si128
+				(
+					_mm_cmplt_epi16( vValues, vLimit ),
+					_mm_cmpgt_epi16( vValues, vMissing )
+				);
+		}
+
+		return
+			DWORD( _mm_movemask_epi8( _mm_packs_epi16( vCompare[ 0 ], vCompare[ 1 ] ))) |
+			DWORD( _mm_movemask_epi8( _mm_packs_epi16( vCompare[ 2 ], vCompare[ 3 ] ))) << 16;
+	}
+
+	// count a run that ended if it is long enough and start over, the
+	// station years are nullptr unless the runs of each are kept
+	void EndRun
+	(
+		int eRun, DAILY_RUN& run, DAILY_YEARS& years, STATION_YEARS* pStation
+	) const
+	{
+		if ( run.Days >= m_Runs[ eRun ].Days )
+		{
+			DAILY_YEAR& year = years[ run.Year ];
+			year.Runs[ eRun ]++;
+			year.RunDays[ eRun ] += run.Days;
+			year.LongestRun[ eRun ] = max( year.LongestRun[ eRun ], run.Days );
+			if ( run.CountedYear != run.Year )
+			{
+				year.RunStations[ eRun ]++;
+				run.CountedYear = run.Year;
+			}
+
+			if ( pStation != nullptr )
+			{
+				auto pos = pStation->find( run.Year );
+				if ( pos == pStation->end() )
+				{
+					STATION_RUNS value;
+					value.Year = run.Year;
+					for ( int n = 0; n < rtCount; n++ )
+					{
+						value.Runs[ n ] = 0;
+						value.RunDays[ n ] = 0;
+						value.LongestRun[ n ] = 0;
+					}
+					pos = pStation->insert( make_pair( run.Year, value )).first;
+				}
+
+				STATION_RUNS& station = pos->second;
+				station.Runs[ eRun ]++;
+				station.RunDays[ eRun ] += run.Days;
+				station.LongestRun[ eRun ] = max( station.LongestRun[ eRun ], run.Days );
+			}
+		}
+		run.Days = 0;
+	}
+
+	// extend and end the runs of a kind with the days of a line, walking
+	// the mask from one change between run and gap to the next
+	void AddRuns
+	(
+		int eRun, const DAILY_LINE& daily, DAILY_RUN& run, DAILY_YEARS& years,
+		STATION_YEARS* pStation
+	) const
+	{
+		// a run only carries over from the month before
+		const int nMonth = daily.Year * 12 + daily.Month - 1;
+		if ( nMonth != run.Month + 1 )
+		{
+			EndRun( eRun, run, years, pStation );
+		}
+		run.Month = nMonth;
+
+		const int nDays = GetMonthDays( daily.Year, daily.Month );
+		const DWORD dwMask =
+			GetMask( daily, m_Runs[ eRun ].Tenths, eRun == rtHeat ) &
+			(( 1UL << nDays ) - 1 );
+
+		int nDay = 0;
+		while ( nDay < nDays )
+		{
+			const DWORD dwRest = dwMask >> nDay;
+			unsigned long nIndex = 0;
+			if (( dwRest & 1 ) != 0 )
+			{
+				// the run lasts until the next clear bit, which the mask
+				// always has past the end of the month
+				_BitScanForward( &nIndex, ~dwRest );
+				if ( run.Days == 0 )
+				{
+					run.Year = daily.Year;
+				}
+				run.Days += int( nIndex );
+				nDay += int( nIndex );
+
+			} else
+			{
+				EndRun( eRun, run, years, pStation );
+				if ( !_BitScanForward( &nIndex, dwRest ))
+				{
+					break;
+				}
+				nDay += int( nIndex );
+			}
+		}
+	}
+
+	// add the valid days of a decoded line to the counts of its year
+	void AddLine
+	(
+		const DAILY_LINE& daily, DAILY_YEARS& years, DAILY_RUN* pRuns,
+		STATION_YEARS* pStation
+	) const
+	{
+		DAILY_YEAR& year = years[ daily.Year ];
+		const __m128i vMissing = _mm_set1_epi16( GetMissingValue() );
+		const __m128i* pValues = (const __m128i*)daily.Values;
+
+		int nValid = 0;
+		for ( int n = 0; n < 4; n++ )
+		{
+			const __m128i vValid =
+				_mm_cmpgt_epi16( _mm_loadu_si128( pValues + n ), vMissing );
+			nValid += CStationYear::CountMonths
+			(
+				WORD( _mm_movemask_epi8( vValid ))
+			) / 2;
+		}
+		year.Days[ daily.Type ] += nValid;
+
+		// heat waves are runs of the maximums and cold spells of the minimums
+		if ( daily.Type == CClimateTemperature::mtMaximum )
+		{
+			AddRuns( rtHeat, daily, pRuns[ rtHeat ], years, pStation );
+
+		} else if ( daily.Type == CClimateTemperature::mtMinimum )
+		{
+			AddRuns( rtCold, daily, pRuns[ rtCold ], years, pStation );
+		}
+
+		// the greater than counts are of the maximums like the monthly ones
+		if ( daily.Type != CClimateTemperature::mtMaximum )
+		{
+			return;
+		}
+		for ( int index = 0; index < 9; index++ )
+		{
+			const __m128i vLimit = _mm_set1_epi16( GetLimitTenths( index ));
+			int nAbove = 0;
+			for ( int n = 0; n < 4; n++ )
+			{
+				const __m128i vAbove =
+					_mm_cmpgt_epi16( _mm_loadu_si128( pValues + n ), vLimit );
+				nAbove += CStationYear::CountMonths
+				(
+					WORD( _mm_movemask_epi8( vAbove ))
+				) / 2;
+			}
+			year.Greater[ index ] += nAbove;
+		}
+	}
+
+	// read a .dly file a block at a time and count its lines of interest,
+	// adding the runs of its station years when they are kept
+	void ParseFile
+	(
+		const CString& pathname, CStationList& stations, CQueryFilter& filter,
+		CRunStatistics& statistics, DAILY_YEARS& years, LONGLONG& llExcluded,
+		vector<STATION_RUNS>& stationRuns
+	) const
+	{
+		CTraceLog::CTraceScope scope( statistics.Trace, _T( "parse file" ), pathname );
+
+		// the file name is the station ID
+		const CString csStation = CHelper::GetFileName( pathname ).Left( 11 );
+		if ( !filter.AcceptStation( csStation, csStation.GetLength(), stations ))
+		{
+			return;
+		}
+
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return;
+		}
+		statistics.AddFile( file );
+
+		const int nBlock = 65536;
+		const int nCarryLimit = 1024;
+		vector<char> arrBlock( nBlock + nCarryLimit );
+		int nCarry = 0;
+		DAILY_LINE daily;
+		STATION_YEARS stationYears;
+		STATION_YEARS* pStation = m_bKeepStationRuns ? &stationYears : nullptr;
+		DAILY_RUN runs[ rtCount ];
+		for ( auto& run : runs )
+		{
+			run.Days = 0;
+			run.Year = 0;
+			run.Month = -2;
+			run.CountedYear = 0;
+		}
+		for ( ;; )
+		{
+			const UINT nRead = statistics.Time
+			(
+				CRunStatistics::spRead,
+				[&]() { return file.Read( arrBlock.data() + nCarry, nBlock ); }
+			);
+			const int nText = nCarry + int( nRead );
+			const bool bLast = nRead == 0;
+
+			CRunStatistics::CPhaseTimer timer( statistics, CRunStatistics::spParse );
+			int nStart = 0;
+			for ( ;; )
+			{
+				const char* pStart = arrBlock.data() + nStart;
+				const char* pEnd = (const char*)memchr( pStart, '\n', nText - nStart );
+				if ( pEnd == nullptr )
+				{
+					// the last line of the file may not end with a newline
+					if ( !bLast || nStart == nText )
+					{
+						break;
+					}
+					pEnd = arrBlock.data() + nText;
+				}
+
+				int nLength = int( pEnd - pStart );
+				if ( nLength > 0 && pStart[ nLength - 1 ] == '\r' )
+				{
+					nLength--;
+				}
+				nStart = min( nText, int( pEnd - arrBlock.data() ) + 1 );
+				statistics.Add( CRunStatistics::scLines );
+
+				if ( !DecodeLine( pStart, nLength, daily ) ||
+					!filter.AcceptType( daily.Type ) ||
+					daily.Year < filter.FirstYear || daily.Year > filter.LastYear )
+				{
+					continue;
+				}
+
+				AddLine( daily, years, runs, pStation );
+				llExcluded += daily.Excluded;
+			}
+
+			if ( bLast )
+			{
+				break;
+			}
+
+			// keep the partial line for the next block, a line longer than
+			// a block is dropped
+			nCarry = nText - nStart;
+			if ( nCarry > nCarryLimit )
+			{
+				nCarry = 0;
+			}
+			memmove( arrBlock.data(), arrBlock.data() + nStart, nCarry );
+		}
+		file.Close();
+
+		// the runs still going end with the file
+		for ( int eRun = 0; eRun < rtCount; eRun++ )
+		{
+			EndRun( eRun, runs[ eRun ], years, pStation );
+		}
+
+		for ( auto& node : stationYears )
+		{
+			node.second.Station = csStation;
+			stationRuns.push_back( node.second );
+		}
+	}
+
+// public methods
+public:
+	// set the limit and length of a kind of run from "F:days" (i.e.
+	// "95:3"), false if either is not valid
+	bool DefineRun( int eRun, LPCTSTR value )
+	{
+		const CString csValue( value );
+		const int nColon = csValue.Find( _T( ':' ));
+		if ( nColon <= 0 ||
+			csValue.SpanIncluding( _T( "-0123456789" )).GetLength() != nColon )
+		{
+			return false;
+		}
+
+		const int nLimit = _ttoi( csValue );
+		const int nDays = _ttoi( csValue.Mid( nColon + 1 ));
+		if ( nLimit < -100 || nLimit > 150 || nDays <= 0 )
+		{
+			return false;
+		}
+
+		// a reading t is above n Fahrenheit when t > 50 ( n - 32 ) / 9 and
+		// below it when t < 50 ( n - 32 ) / 9
+		const double dTenths = 50.0 * ( nLimit - 32 ) / 9.0;
+		m_Runs[ eRun ].Limit = nLimit;
+		m_Runs[ eRun ].Tenths =
+			short( eRun == rtHeat ? floor( dTenths ) : ceil( dTenths ));
+		m_Runs[ eRun ].Days = nDays;
+		return true;
+	}
+
+	// forget the files and counts so the tree can be read again
+	void Clear()
+	{
+		m_arrFiles.clear();
+		m_mapYears.clear();
+		m_arrStationRuns.clear();
+		m_llDays = 0;
+		m_llExcluded = 0;
+	}
+
+	// counts of a year, false if the year has none
+	bool GetYear( int nYear, DAILY_YEAR& year )
+	{
+		auto pos = m_mapYears.find( nYear );
+		if ( pos == m_mapYears.end() )
+		{
+			return false;
+		}
+
+		year = pos->second;
+		return true;
+	}
+
+	// decode a line of a .dly file, false if it is not a TMAX, TMIN, or
+	// TAVG line or its year or month (1 - 12) is not a number
+	static bool DecodeLine( const char* pLine, int nLength, DAILY_LINE& daily )
+	{
+		if ( nLength < 21 )
+		{
+			return false;
+		}
+
+		const char* pElement = pLine + 17;
+		if ( strncmp( pElement, "TMAX", 4 ) == 0 )
+		{
+			daily.Type = CClimateTemperature::mtMaximum;
+
+		} else if ( strncmp( pElement, "TMIN", 4 ) == 0 )
+		{
+			daily.Type = CClimateTemperature::mtMinimum;
+
+		} else if ( strncmp( pElement, "TAVG", 4 ) == 0 )
+		{
+			daily.Type = CClimateTemperature::mtAverage;
+
+		} else
+		{
+			return false;
+		}
+
+		// the year and month are six digits in columns 12 - 17, the month
+		// indexes the days of the month so it must be in range
+		for ( int n = 11; n < 17; n++ )
+		{
+			if ( pLine[ n ] < '0' || pLine[ n ] > '9' )
+			{
+				return false;
+			}
+		}
+		daily.Year =
+			( pLine[ 11 ] - '0' ) * 1000 + ( pLine[ 12 ] - '0' ) * 100 +
+			( pLine[ 13 ] - '0' ) * 10 + ( pLine[ 14 ] - '0' );
+		daily.Month = ( pLine[ 15 ] - '0' ) * 10 + ( pLine[ 16 ] - '0' );
+		if ( daily.Month < 1 || daily.Month > 12 )
+		{
+			return false;
+		}
+
+		// the days are copied into blanks so the loads past a short line
+		// and the sixteen bytes of the last day stay inside the buffer
+		char szText[ 8 * 32 ];
+		memset( szText, ' ', sizeof( szText ));
+		memcpy( szText, pLine + 21, min( nLength - 21, 8 * 31 ));
+
+		daily.Excluded = 0;
+		for ( int nDay = 0; nDay < 32; nDay += 2 )
+		{
+			DecodePair( szText + nDay * 8, daily.Values + nDay );
+		}
+		daily.Values[ 31 ] = GetMissingValue();
+
+		// a day that failed a quality check is missing
+		for ( int nDay = 0; nDay < 31; nDay++ )
+		{
+			if ( szText[ nDay * 8 + 6 ] != ' ' &&
+				daily.Values[ nDay ] != GetMissingValue() )
+			{
+				daily.Values[ nDay ] = GetMissingValue();
+				daily.Excluded++;
+			}
+		}
+
+		return true;
+	}
+
+	// find the .dly files of the tree
+	void Crawl( LPCTSTR path, CRunStatistics& statistics )
+	{
+		CString csPathname = CString( path ).Trim( _T( "\\" ));
+		CString strWildcard;
+		strWildcard.Format( _T( "%s\\*.*" ), csPathname );
+
+		CFileFind finder;
+		BOOL bWorking = statistics.Time
+		(
+			CRunStatistics::spCrawl,
+			[&]() { return finder.FindFile( strWildcard ); }
+		);
+		while ( bWorking )
+		{
+			bWorking = statistics.Time
+			(
+				CRunStatistics::spCrawl,
+				[&]() { return finder.FindNextFile(); }
+			);
+			if ( finder.IsDots() )
+			{
+				continue;
+			}
+
+			const CString csPath = finder.GetFilePath();
+			if ( finder.IsDirectory() )
+			{
+				Crawl( csPath.TrimRight( _T( "\\" )), statistics );
+
+			} else if ( CHelper::GetExtension( csPath ).MakeLower() == _T( ".dly" ))
+			{
+				m_arrFiles.push_back( csPath );
+			}
+		}
+		finder.Close();
+	}
+
+	// parse the files in parallel, each thread counting into a map of its
+	// own, and combine the counts
+	void Parse( CStationList& stations, CQueryFilter& filter, CRunStatistics& statistics )
+	{
+		typedef struct tagDAILY_TOTALS
+		{
+			DAILY_YEARS Years;
+			LONGLONG Excluded;
+			vector<STATION_RUNS> StationRuns;
+
+		} DAILY_TOTALS;
+
+		concurrency::combinable<DAILY_TOTALS> totals
+		(
+			[]()
+			{
+				DAILY_TOTALS value;
+				value.Excluded = 0;
+				return value;
+			}
+		);
+
+		const int nFiles = Files;
+		concurrency::parallel_for
+		(
+			0, nFiles,
+			[&]( int nFile )
+			{
+				DAILY_TOTALS& local = totals.local();
+				ParseFile
+				(
+					m_arrFiles[ nFile ], stations, filter, statistics,
+					local.Years, local.Excluded, local.StationRuns
+				);
+			}
+		);
+
+		CRunStatistics::CPhaseTimer timer( statistics, CRunStatistics::spInsert );
+		totals.combine_each
+		(
+			[&]( DAILY_TOTALS& local )
+			{
+				for ( auto& node : local.Years )
+				{
+					DAILY_YEAR& year = m_mapYears[ node.first ];
+					for ( int eType = 0; eType < 4; eType++ )
+					{
+						year.Days[ eType ] += node.second.Days[ eType ];
+						m_llDays += node.second.Days[ eType ];
+					}
+					for ( int index = 0; index < 9; index++ )
+					{
+						year.Greater[ index ] += node.second.Greater[ index ];
+					}
+					for ( int eRun = 0; eRun < rtCount; eRun++ )
+					{
+						year.Runs[ eRun ] += node.second.Runs[ eRun ];
+						year.RunDays[ eRun ] += node.second.RunDays[ eRun ];
+						year.LongestRun[ eRun ] =
+							max( year.LongestRun[ eRun ], node.second.LongestRun[ eRun ] );
+						year.RunStations[ eRun ] += node.second.RunStations[ eRun ];
+					}
+				}
+				m_llExcluded += local.Excluded;
+				m_arrStationRuns.insert
+				(
+					m_arrStationRuns.end(),
+					local.StationRuns.begin(), local.StationRuns.end()
+				);
+			}
+		);
+
+		// the threads took the files in no particular order
+		sort
+		(
+			m_arrStationRuns.begin(), m_arrStationRuns.end(),
+			[]( const STATION_RUNS& left, const STATION_RUNS& right )
+			{
+				const int nCompare = left.Station.Compare( right.Station );
+				return nCompare != 0 ? nCompare < 0 : left.Year < right.Year;
+			}
+		);
+	}
+
+	// replace the greater than counts of the climate years with the daily
+	// counts, adding the years that only have daily data
+	void Apply( CKeyedCollection<CString, CClimateYear>& ClimateYears )
+	{
+		for ( auto& node : m_mapYears )
+		{
+			const DAILY_YEAR& year = node.second;
+			const int nDays = year.Days[ CClimateTemperature::mtMaximum ];
+			if ( nDays == 0 )
+			{
+				continue;
+			}
+
+			CString csYear;
+			csYear.Format( _T( "%04d" ), node.first );
+			shared_ptr<CClimateYear> ClimateYear = ClimateYears.find( csYear );
+			if ( ClimateYear == nullptr )
+			{
+				ClimateYear = shared_ptr<CClimateYear>( new CClimateYear );
+				ClimateYear->Year = csYear;
+				ClimateYears.add( csYear, ClimateYear );
+			}
+
+			vector<CStationYear::GREATER_COUNT> counts;
+			for ( int index = 0; index < 9; index++ )
+			{
+				counts.push_back
+				(
+					CStationYear::GREATER_COUNT( GetLimit( index ), year.Greater[ index ] )
+				);
+			}
+			ClimateYear->GreaterCounts = counts;
+			ClimateYear->GreaterReadings = nDays;
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CGhcnDaily()
+	{
+		m_llDays = 0;
+		m_llExcluded = 0;
+		m_bKeepStationRuns = false;
+		DefineRun( rtHeat, _T( "95:3" ));
+		DefineRun( rtCold, _T( "32:3" ));
+	}
+
+	// destructor
+	~CGhcnDaily()
+	{
+	}
+};
@@ -0,0 +1,467 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ParseCache.h"
+#include "QueryFilter.h"
+#include "RunStatistics.h"
+#include "StationList.h"
+#include <functional>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// reads the Global Historical Climatology Network - Monthly version 4
+// files (i.e. ghcnm.tavg.v4.0.1.20220901.qcu.dat) which hold every station
+// of an element in one large file:
+//
+//	https://www.ncei.noaa.gov/pub/data/ghcn/v4/readme.txt
+//
+// Fragment of readme.txt describing the data file:
+//
+//	Variable          Columns      Type
+//	--------          -------      ----
+//
+//	ID                 1-11        Integer
+//	YEAR              12-15        Integer
+//	ELEMENT           16-19        Character
+//	VALUE1            20-24        Integer
+//	DMFLAG1           25-25        Character
+//	QCFLAG1           26-26        Character
+//	DSFLAG1           27-27        Character
+//	  .                 .             .
+//	  .                 .             .
+//	  .                 .             .
+//	VALUE12          108-112       Integer
+//	DMFLAG12         113-113       Character
+//	QCFLAG12         114-114       Character
+//	DSFLAG12         115-115       Character
+//
+//	VALUE: monthly value (MISSING=-9999). Temperature values are in
+//		hundredths of a degree Celsius.
+//
+// The flags use the same "3 flag" layout as USHCN v2.5, so a line is
+// rewritten into the USHCN column layout (a blank after the ID, a six
+// character value) and everything downstream of the line (the query
+// filter, the parse cache, and CStationYear) reads it unchanged. The
+// measurement type comes from the ELEMENT of each line instead of the
+// file extension.
+//
+// One file holds every station so the file is split into byte ranges
+// that are parsed in parallel. A range owns the lines that start inside
+// it, so a range skips the partial line it starts in and reads past its
+// end to finish its last line. Under a memory limit the ranges are parsed
+// a batch at a time and each batch is handed over before the next is read.
+class CGhcnMonthly
+{
+// public definitions
+public:
+	// first and last byte (exclusive) of a range of the file
+	typedef pair<LONGLONG, LONGLONG> BYTE_RANGE;
+
+	// receives the rows of a batch of ranges in the order of the file
+	typedef function<void( vector<shared_ptr<CStationYear> >& )> ROWS_CALLBACK;
+
+// protected data
+protected:
+
+// public properties
+public:
+	// start position of the source element
+	static inline int GetElementStart()
+	{
+		return 15;
+	}
+	// start position of the source element
+	__declspec( property( get = GetElementStart ) )
+		int ElementStart;
+
+	// start position of the first source month
+	static inline int GetMonthStart()
+	{
+		return 19;
+	}
+	// start position of the first source month
+	__declspec( property( get = GetMonthStart ) )
+		int MonthStart;
+
+	// length of a source value
+	static inline int GetValueLength()
+	{
+		return 5;
+	}
+	// length of a source value
+	__declspec( property( get = GetValueLength ) )
+		int ValueLength;
+
+	// length of a line rewritten in the USHCN column layout
+	static inline int GetSourceLength()
+	{
+		return 124;
+	}
+	// length of a line rewritten in the USHCN column layout
+	__declspec( property( get = GetSourceLength ) )
+		int SourceLength;
+
+	// smallest range worth a task of its own
+	static inline LONGLONG GetMinimumRange()
+	{
+		return 1048576;
+	}
+	// smallest range worth a task of its own
+	__declspec( property( get = GetMinimumRange ) )
+		LONGLONG MinimumRange;
+
+// protected methods
+protected:
+	// read the lines that start inside a range into the given text, the
+	// text starts at the first whole line and ends with the last one
+	static bool ReadRange( CFile& file, const BYTE_RANGE& range, CString& text )
+	{
+		// start one byte early to tell whether the range starts a line
+		const LONGLONG llFirst = max( 0LL, range.first - 1 );
+		const LONGLONG llLength = (LONGLONG)file.GetLength();
+		file.Seek( llFirst, CFile::begin );
+
+		// a line is 115 characters so a little more than the range is
+		// nearly always enough to finish its last line
+		LONGLONG llRead = min( llLength, range.second + 256 ) - llFirst;
+		CString csBuffer;
+		LPTSTR pBuffer = csBuffer.GetBuffer( int( llRead ));
+		UINT nRead = file.Read( pBuffer, UINT( llRead ));
+		csBuffer.ReleaseBuffer( nRead );
+
+		// a range that does not start a line skips the line it is in
+		int nStart = 0;
+		if ( range.first > 0 )
+		{
+			nStart = csBuffer.Find( _T( '\n' )) + 1;
+			if ( nStart == 0 || llFirst + nStart >= range.second )
+			{
+				text.Empty();
+				return true;
+			}
+		}
+
+		// finish the last line that starts inside the range
+		const int nLast = int( range.second - 1 - llFirst );
+		int nEnd = csBuffer.Find( _T( '\n' ), max( nStart, nLast ));
+		while ( nEnd == -1 && llFirst + csBuffer.GetLength() < llLength )
+		{
+			TCHAR chBuffer[ 256 ];
+			nRead = file.Read( chBuffer, sizeof( chBuffer ));
+			if ( nRead == 0 )
+			{
+				break;
+			}
+			const int nOld = csBuffer.GetLength();
+			csBuffer.Append( chBuffer, nRead );
+			nEnd = csBuffer.Find( _T( '\n' ), nOld );
+		}
+		if ( nEnd == -1 )
+		{
+			nEnd = csBuffer.GetLength();
+		}
+
+		text = csBuffer.Mid( nStart, nEnd - nStart );
+		return true;
+	}
+
+	// parse the lines of one range of a file
+	static void ParseRange
+	(
+		LPCTSTR pathname, const BYTE_RANGE& range, CStationList& stations,
+		CParseCache& cache, CQueryFilter& filter, CRunStatistics& statistics,
+		vector<shared_ptr<CStationYear> >& rows
+	)
+	{
+		CTraceLog::CTraceScope scope( statistics.Trace, _T( "parse range" ), pathname );
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return;
+		}
+
+		CString csText;
+		const bool bRead = statistics.Time
+		(
+			CRunStatistics::spRead,
+			[&]() { return ReadRange( file, range, csText ); }
+		);
+		file.Close();
+		if ( !bRead )
+		{
+			return;
+		}
+
+		const bool bFilter = filter.Active;
+		CString csSource;
+		CClimateTemperature::MEASURE_TYPE eType;
+		int nStart = 0;
+		const int nLength = csText.GetLength();
+		while ( nStart < nLength )
+		{
+			int nEnd = csText.Find( _T( '\n' ), nStart );
+			if ( nEnd == -1 )
+			{
+				nEnd = nLength;
+			}
+			const int nLine = nEnd > nStart && csText[ nEnd - 1 ] == _T( '\r' ) ?
+				nEnd - 1 : nEnd;
+			const CString csLine = csText.Mid( nStart, nLine - nStart );
+			nStart = nEnd + 1;
+			statistics.Add( CRunStatistics::scLines );
+
+			// lines of other elements (i.e. precipitation) are skipped
+			if ( !GetSource( csLine, csSource, eType ) ||
+				!filter.AcceptType( eType ))
+			{
+				continue;
+			}
+
+			// the stations are interleaved so a year past the filter does
+			// not end the range
+			if ( bFilter && !filter.AcceptLine( csSource, stations ))
+			{
+				continue;
+			}
+
+			// the indexer is only called for lines the cache decodes
+			rows.push_back( statistics.Time
+			(
+				CRunStatistics::spParse,
+				[&]()
+				{
+					return cache.Parse
+					(
+						csSource, eType,
+						[&]( const CString& station )
+						{
+							statistics.Add( CRunStatistics::scDecoded );
+							return stations.Find( station );
+						}
+					);
+				}
+			));
+			statistics.AddRecord( rows.back()->ValidReadings );
+		}
+	}
+
+// public methods
+public:
+	// measurement type of a line's element or mtMissing if the element is
+	// not a temperature
+	static CClimateTemperature::MEASURE_TYPE GetMeasurementType( const CString& line )
+	{
+		if ( line.GetLength() < GetMonthStart() )
+		{
+			return CClimateTemperature::mtMissing;
+		}
+
+		LPCTSTR pElement = line.GetString() + GetElementStart();
+		if ( _tcsncmp( pElement, _T( "TMAX" ), 4 ) == 0 )
+		{
+			return CClimateTemperature::mtMaximum;
+
+		} else if ( _tcsncmp( pElement, _T( "TMIN" ), 4 ) == 0 )
+		{
+			return CClimateTemperature::mtMinimum;
+
+		} else if ( _tcsncmp( pElement, _T( "TAVG" ), 4 ) == 0 )
+		{
+			return CClimateTemperature::mtAverage;
+		}
+
+		return CClimateTemperature::mtMissing;
+	}
+
+	// is the line in the GHCN-Monthly layout? The year follows the ID
+	// without the blank of a USHCN line, and an element follows the year.
+	static bool IsSourceLine( const CString& line )
+	{
+		if ( line.GetLength() < GetMonthStart() )
+		{
+			return false;
+		}
+
+		for ( int n = 0; n < GetElementStart(); n++ )
+		{
+			if ( !_istalnum( line[ n ] ))
+			{
+				return false;
+			}
+		}
+
+		return GetMeasurementType( line ) != CClimateTemperature::mtMissing;
+	}
+
+	// rewrite a GHCN-Monthly line in the USHCN column layout and return
+	// the measurement type of its element, false if the line is not a
+	// temperature
+	static bool GetSource
+	(
+		const CString& line, CString& source,
+		CClimateTemperature::MEASURE_TYPE& eType
+	)
+	{
+		eType = GetMeasurementType( line );
+		if ( eType == CClimateTemperature::mtMissing )
+		{
+			return false;
+		}
+
+		const int nLength = line.GetLength();
+		LPCTSTR pLine = line.GetString();
+		LPTSTR pSource = source.GetBuffer( GetSourceLength() );
+
+		// the ID, a blank, and the year
+		int nSource = 0;
+		for ( int n = 0; n < 11; n++ )
+		{
+			pSource[ nSource++ ] = pLine[ n ];
+		}
+		pSource[ nSource++ ] = _T( ' ' );
+		for ( int n = 11; n < GetElementStart(); n++ )
+		{
+			pSource[ nSource++ ] = pLine[ n ];
+		}
+
+		// each month widens its value by a leading blank and keeps its flags
+		int nLine = GetMonthStart();
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			pSource[ nSource++ ] = _T( ' ' );
+			for ( int n = 0; n < GetValueLength() + 3; n++, nLine++ )
+			{
+				pSource[ nSource++ ] = nLine < nLength ? pLine[ nLine ] : _T( ' ' );
+			}
+		}
+		source.ReleaseBuffer( nSource );
+
+		return true;
+	}
+
+	// does the file start with a GHCN-Monthly line?
+	static bool IsSourceFile( LPCTSTR pathname )
+	{
+		CStdioFile file;
+		if ( !file.Open( pathname, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return false;
+		}
+
+		CString csLine;
+		const bool value = file.ReadString( csLine ) && IsSourceLine( csLine );
+		file.Close();
+
+		return value;
+	}
+
+	// split a file into byte ranges for the given number of tasks, the
+	// ranges are never smaller than MinimumRange unless that is more than
+	// the given maximum size (0 for none)
+	static void GetRanges
+	(
+		LONGLONG llLength, int nTasks, LONGLONG llMaximum, vector<BYTE_RANGE>& ranges
+	)
+	{
+		ranges.clear();
+		LONGLONG llRanges = max
+		(
+			1LL, min( LONGLONG( nTasks ), llLength / GetMinimumRange() )
+		);
+		if ( llMaximum > 0 )
+		{
+			llRanges = max( llRanges, ( llLength + llMaximum - 1 ) / llMaximum );
+		}
+		const LONGLONG llSize = ( llLength + llRanges - 1 ) / llRanges;
+		for ( LONGLONG llFirst = 0; llFirst < llLength; llFirst += llSize )
+		{
+			ranges.push_back( BYTE_RANGE( llFirst, min( llLength, llFirst + llSize )));
+		}
+	}
+
+	// parse every temperature line of a file in parallel byte ranges, the
+	// rows are handed to the callback in the order of the file and
+	// stations are looked up but not added so the ranges can be parsed at
+	// once. With a batch size (0 for the whole file) only that many bytes
+	// of the file are parsed and held at a time.
+	static bool Parse
+	(
+		LPCTSTR pathname, CStationList& stations, CParseCache& cache,
+		CQueryFilter& filter, CRunStatistics& statistics, LONGLONG llBatch,
+		ROWS_CALLBACK callback
+	)
+	{
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return false;
+		}
+		statistics.AddFile( file );
+		const LONGLONG llLength = (LONGLONG)file.GetLength();
+		file.Close();
+
+		// several ranges for every processor so a range of short lines
+		// does not leave the other processors idle, a batch is a range for
+		// every processor
+		const int nProcessors = int( concurrency::GetProcessorCount() );
+		vector<BYTE_RANGE> ranges;
+		GetRanges
+		(
+			llLength, nProcessors * 4, llBatch == 0 ? 0 : llBatch / nProcessors,
+			ranges
+		);
+
+		const int nRanges = (int)ranges.size();
+		const int nBatch = llBatch == 0 ? nRanges : nProcessors;
+		for ( int nFirst = 0; nFirst < nRanges; nFirst += nBatch )
+		{
+			const int nLast = min( nRanges, nFirst + nBatch );
+			vector<vector<shared_ptr<CStationYear> > > arrRows( nLast - nFirst );
+			concurrency::parallel_for
+			(
+				nFirst, nLast,
+				[&]( int nRange )
+				{
+					ParseRange
+					(
+						pathname, ranges[ nRange ], stations, cache, filter,
+						statistics, arrRows[ nRange - nFirst ]
+					);
+				}
+			);
+
+			vector<shared_ptr<CStationYear> > rows;
+			for ( auto& range : arrRows )
+			{
+				rows.insert( rows.end(), range.begin(), range.end() );
+				range.clear();
+			}
+			callback( rows );
+		}
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CGhcnMonthly()
+	{
+	}
+
+	// destructor
+	~CGhcnMonthly()
+	{
+	}
+};
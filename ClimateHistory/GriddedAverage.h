@@ -0,0 +1,250 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateYear.h"
+#include "StationList.h"
+#include <algorithm>
+#include <math.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// area weighted national series of the yearly station values. The
+// described stations are placed into latitude / longitude cells of a
+// given size, the stations reporting in a year are averaged within each
+// cell, and the cell averages are weighted by the cosine of the latitude
+// of the cell's center (proportional to the cell's area). Unlike the
+// plain station mean of CClimateYear, a region with many stations counts
+// no more than a region of the same area with few stations.
+//
+// Every year is independent so the years are reduced in parallel.
+class CGriddedAverage
+{
+// public definitions
+public:
+	// area weighted values of one year
+	typedef struct tagGRIDDED_YEAR
+	{
+		CString Year;
+
+		// degrees centigrade or missing indexed by measurement type
+		// (mtMaximum, mtMinimum, and mtAverage)
+		float Value[ 4 ];
+
+		// number of cells that contributed indexed by measurement type
+		int Cells[ 4 ];
+
+	} GRIDDED_YEAR;
+
+// protected data
+protected:
+	// size of a cell in degrees
+	float m_fCellSize;
+
+	// number of columns (longitudes) of cells
+	int m_nColumns;
+
+	// cell of each station index (-1 if the station has no coordinates)
+	vector<int> m_arrCells;
+
+	// area weight of each row (latitude) of cells
+	vector<double> m_arrWeights;
+
+	// area weighted values of each year in year order
+	vector<GRIDDED_YEAR> m_arrYears;
+
+// public properties
+public:
+	// size of a cell in degrees
+	inline float GetCellSize()
+	{
+		return m_fCellSize;
+	}
+	// size of a cell in degrees
+	__declspec( property( get = GetCellSize ) )
+		float CellSize;
+
+	// area weighted values of each year in year order
+	inline vector<GRIDDED_YEAR>& GetYears()
+	{
+		return m_arrYears;
+	}
+	// area weighted values of each year in year order
+	__declspec( property( get = GetYears ) )
+		vector<GRIDDED_YEAR> Years;
+
+// protected methods
+protected:
+	// assign the described stations to cells and weight the rows
+	void BuildCells( CStationList& stations )
+	{
+		const int nRows = (int)ceil( 180.0 / m_fCellSize );
+		m_nColumns = (int)ceil( 360.0 / m_fCellSize );
+
+		m_arrWeights.resize( nRows );
+		for ( int nRow = 0; nRow < nRows; nRow++ )
+		{
+			const double dCenter =
+				min( 90.0, ( nRow + 0.5 ) * m_fCellSize - 90.0 );
+			m_arrWeights[ nRow ] = cos( dCenter * 3.14159265358979323846 / 180.0 );
+		}
+
+		const int nStations = stations.Count;
+		m_arrCells.assign( nStations, -1 );
+		for ( int index = 0; index < nStations; index++ )
+		{
+			if ( !stations.Described[ index ] )
+			{
+				continue;
+			}
+
+			const int nRow = max( 0, min
+			(
+				nRows - 1,
+				int( floor(( stations.Latitude[ index ] + 90.0 ) / m_fCellSize ))
+			));
+			const int nColumn = max( 0, min
+			(
+				m_nColumns - 1,
+				int( floor(( stations.Longitude[ index ] + 180.0 ) / m_fCellSize ))
+			));
+			m_arrCells[ index ] = nRow * m_nColumns + nColumn;
+		}
+	}
+
+	// area weighted mean of the station years of one measurement type,
+	// returns the number of cells that contributed
+	int Reduce
+	(
+		CKeyedCollection<CString, CStationYear>& StationYears, float& fValue
+	)
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		fValue = fMissing;
+
+		// (cell, value) of every station with coordinates and a value
+		vector<pair<int, float> > values;
+		values.reserve( StationYears.Count );
+		for ( auto& node : StationYears.Items )
+		{
+			const int index = node.second->StationIndex;
+			if ( index < 0 || index >= (int)m_arrCells.size() || m_arrCells[ index ] == -1 )
+			{
+				continue;
+			}
+
+			const float fStation = node.second->Value;
+			if ( CHelper::NearlyEqual( fStation, fMissing ))
+			{
+				continue;
+			}
+
+			values.push_back( pair<int, float>( m_arrCells[ index ], fStation ));
+		}
+
+		// sorting brings the stations of each cell together
+		sort( values.begin(), values.end() );
+
+		double dSum = 0.0;
+		double dWeights = 0.0;
+		int value = 0;
+		for ( size_t nFirst = 0; nFirst < values.size(); )
+		{
+			const int nCell = values[ nFirst ].first;
+			double dCell = 0.0;
+			size_t nLast = nFirst;
+			for ( ; nLast < values.size() && values[ nLast ].first == nCell; nLast++ )
+			{
+				dCell += values[ nLast ].second;
+			}
+
+			const double dWeight = m_arrWeights[ nCell / m_nColumns ];
+			dSum += dWeight * dCell / ( nLast - nFirst );
+			dWeights += dWeight;
+			value++;
+
+			nFirst = nLast;
+		}
+
+		if ( dWeights > 0.0 )
+		{
+			fValue = float( dSum / dWeights );
+		}
+
+		return value;
+	}
+
+// public methods
+public:
+	// compute the area weighted series of every year for a cell size
+	void Compute
+	(
+		CKeyedCollection<CString, CClimateYear>& ClimateYears,
+		CStationList& stations, float fCellSize
+	)
+	{
+		m_fCellSize = fCellSize;
+		BuildCells( stations );
+
+		vector<shared_ptr<CClimateYear> > arrYears;
+		for ( auto& node : ClimateYears.Items )
+		{
+			arrYears.push_back( node.second );
+		}
+
+		const int nYears = (int)arrYears.size();
+		m_arrYears.assign( nYears, GRIDDED_YEAR() );
+
+		// each year only touches its own station years and result
+		concurrency::parallel_for
+		(
+			0, nYears,
+			[&]( int n )
+			{
+				shared_ptr<CClimateYear>& pYear = arrYears[ n ];
+				GRIDDED_YEAR& year = m_arrYears[ n ];
+				year.Year = pYear->Year;
+				year.Value[ CClimateTemperature::mtMissing ] =
+					CClimateTemperature::GetMissingValue();
+				year.Cells[ CClimateTemperature::mtMissing ] = 0;
+
+				year.Cells[ CClimateTemperature::mtMaximum ] = Reduce
+				(
+					pYear->Maximums, year.Value[ CClimateTemperature::mtMaximum ]
+				);
+				year.Cells[ CClimateTemperature::mtMinimum ] = Reduce
+				(
+					pYear->Minimums, year.Value[ CClimateTemperature::mtMinimum ]
+				);
+				year.Cells[ CClimateTemperature::mtAverage ] = Reduce
+				(
+					pYear->Averages, year.Value[ CClimateTemperature::mtAverage ]
+				);
+			}
+		);
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CGriddedAverage()
+	{
+		m_fCellSize = 1.0f;
+		m_nColumns = 0;
+	}
+
+	// destructor
+	~CGriddedAverage()
+	{
+	}
+};
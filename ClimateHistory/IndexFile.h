@@ -0,0 +1,336 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "MappedFile.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// persistent index of a collection built from the streams named by the
+// IndexKeys attribute of the schema. The index is a sorted run of
+// (key, row) entries followed by a sparse fence array holding the first
+// key of every page of entries:
+//
+//	header | entry 0 ... entry N-1 | fence 0 ... fence P-1
+//
+// Keys are the memcmp ordered encodings produced by
+// CSchemaStream::EncodeKey. A lookup binary searches the mapped fences to
+// find the page and then binary searches the page itself, so a point or
+// range lookup reads O(log n) pages of the file instead of the whole
+// collection. Lookups may use a prefix of the key (i.e. the first two of
+// three key streams).
+class CIndexFile
+{
+// public definitions
+public:
+	// fixed size header at the start of the file
+	typedef struct tagINDEX_HEADER
+	{
+		DWORD Magic; // 'CHIX'
+		DWORD Version; // file format version
+		DWORD KeySize; // bytes in each key
+		DWORD PageSize; // entries per page (one fence per page)
+		ULONGLONG Entries; // number of entries
+		ULONGLONG Fences; // number of fences
+		ULONGLONG EntryOffset; // file offset of the first entry
+		ULONGLONG FenceOffset; // file offset of the first fence
+
+	} INDEX_HEADER;
+
+// protected data
+protected:
+	// memory mapped index file
+	CMappedFile m_File;
+
+	// header of the mapped file
+	INDEX_HEADER m_Header;
+
+// public properties
+public:
+	// value identifying an index file
+	inline static DWORD GetMagic()
+	{
+		return 0x58494843; // "CHIX"
+	}
+	// value identifying an index file
+	__declspec( property( get = GetMagic ) )
+		DWORD Magic;
+
+	// number of entries in each page of the index
+	inline static DWORD GetPageSize()
+	{
+		return 128;
+	}
+	// number of entries in each page of the index
+	__declspec( property( get = GetPageSize ) )
+		DWORD PageSize;
+
+	// is an index file open?
+	inline bool GetIsOpen()
+	{
+		return m_File.IsOpen;
+	}
+	// is an index file open?
+	__declspec( property( get = GetIsOpen ) )
+		bool IsOpen;
+
+	// number of entries (rows) in the index
+	inline int GetCount()
+	{
+		return IsOpen ? (int)m_Header.Entries : 0;
+	}
+	// number of entries (rows) in the index
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+	// bytes in each key
+	inline int GetKeySize()
+	{
+		return IsOpen ? (int)m_Header.KeySize : 0;
+	}
+	// bytes in each key
+	__declspec( property( get = GetKeySize ) )
+		int KeySize;
+
+	// key of an entry
+	inline const BYTE* GetKey( int entry )
+	{
+		const ULONGLONG ullEntrySize = m_Header.KeySize + sizeof( DWORD );
+		return m_File.Data + m_Header.EntryOffset + entry * ullEntrySize;
+	}
+	// key of an entry
+	__declspec( property( get = GetKey ) )
+		const BYTE* Key[];
+
+	// row of the collection an entry refers to
+	inline int GetRow( int entry )
+	{
+		DWORD value = 0;
+		memcpy( &value, Key[ entry ] + m_Header.KeySize, sizeof( DWORD ));
+		return (int)value;
+	}
+	// row of the collection an entry refers to
+	__declspec( property( get = GetRow ) )
+		int Row[];
+
+	// first key of a page
+	inline const BYTE* GetFence( int page )
+	{
+		return m_File.Data + m_Header.FenceOffset + page * m_Header.KeySize;
+	}
+	// first key of a page
+	__declspec( property( get = GetFence ) )
+		const BYTE* Fence[];
+
+// protected methods
+protected:
+	// first entry whose key prefix is not less than (bUpper false) or
+	// is greater than (bUpper true) the probe
+	int Bound( const BYTE* pProbe, int nBytes, bool bUpper )
+	{
+		// test a key against the probe for the kind of bound
+		auto before = [&]( const BYTE* pKey ) -> bool
+		{
+			const int nCompare = memcmp( pKey, pProbe, nBytes );
+			return bUpper ? nCompare <= 0 : nCompare < 0;
+		};
+
+		// binary search of the fences for the first page that begins
+		// at or after the bound
+		int nLow = 0;
+		int nHigh = (int)m_Header.Fences;
+		while ( nLow < nHigh )
+		{
+			const int nMid = ( nLow + nHigh ) / 2;
+			if ( before( Fence[ nMid ] ))
+			{
+				nLow = nMid + 1;
+
+			} else
+			{
+				nHigh = nMid;
+			}
+		}
+
+		// the bound is within the page before that fence
+		const int nPageSize = (int)m_Header.PageSize;
+		const int nPage = nLow;
+		nLow = max( 0, ( nPage - 1 ) * nPageSize );
+		nHigh = min( Count, nPage * nPageSize );
+
+		while ( nLow < nHigh )
+		{
+			const int nMid = ( nLow + nHigh ) / 2;
+			if ( before( Key[ nMid ] ))
+			{
+				nLow = nMid + 1;
+
+			} else
+			{
+				nHigh = nMid;
+			}
+		}
+
+		return nLow;
+	}
+
+// public methods
+public:
+	// map an index file
+	bool Open( LPCTSTR pathname )
+	{
+		if ( !m_File.Open( pathname ))
+		{
+			return false;
+		}
+
+		if ( m_File.Size < sizeof( INDEX_HEADER ))
+		{
+			m_File.Close();
+			return false;
+		}
+
+		memcpy( &m_Header, m_File.Data, sizeof( INDEX_HEADER ));
+		if ( m_Header.Magic != Magic || m_Header.Version != 1 )
+		{
+			m_File.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	// release the mapped index file
+	void Close()
+	{
+		m_File.Close();
+	}
+
+	// rows whose keys begin with the given encoded key (which may be a
+	// prefix of the full key)
+	void Find( const BYTE* pKey, int nBytes, vector<int>& rows )
+	{
+		FindRange( pKey, pKey, nBytes, rows );
+	}
+
+	// rows whose keys fall between the given encoded keys (inclusive)
+	// in key order
+	void FindRange
+	(
+		const BYTE* pLow, const BYTE* pHigh, int nBytes, vector<int>& rows
+	)
+	{
+		if ( !IsOpen )
+		{
+			return;
+		}
+
+		nBytes = min( nBytes, KeySize );
+		const int nFirst = Bound( pLow, nBytes, false );
+		const int nLast = Bound( pHigh, nBytes, true );
+		for ( int entry = nFirst; entry < nLast; entry++ )
+		{
+			rows.push_back( Row[ entry ] );
+		}
+	}
+
+	// sort the encoded keys (one per row) and write them as an index file
+	static bool Build
+	(
+		LPCTSTR pathname, int nKeySize, const vector<BYTE>& keys
+	)
+	{
+		const int nRows = nKeySize == 0 ? 0 : (int)( keys.size() / nKeySize );
+
+		// order the rows by key (and by row for equal keys)
+		vector<int> order( nRows );
+		for ( int row = 0; row < nRows; row++ )
+		{
+			order[ row ] = row;
+		}
+
+		const BYTE* pKeys = keys.empty() ? nullptr : &keys[ 0 ];
+		stable_sort
+		(
+			order.begin(), order.end(),
+			[&]( int row1, int row2 ) -> bool
+			{
+				return memcmp
+				(
+					pKeys + row1 * nKeySize, pKeys + row2 * nKeySize, nKeySize
+				) < 0;
+			}
+		);
+
+		INDEX_HEADER header;
+		memset( &header, 0, sizeof( header ));
+		header.Magic = GetMagic();
+		header.Version = 1;
+		header.KeySize = nKeySize;
+		header.PageSize = GetPageSize();
+		header.Entries = nRows;
+		header.Fences = ( nRows + header.PageSize - 1 ) / header.PageSize;
+		header.EntryOffset = sizeof( INDEX_HEADER );
+		header.FenceOffset =
+			header.EntryOffset + header.Entries * ( nKeySize + sizeof( DWORD ));
+
+		CFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+
+		file.Write( &header, sizeof( header ));
+
+		// entries in key order
+		vector<BYTE> buffer;
+		buffer.reserve( nRows * ( nKeySize + sizeof( DWORD )));
+		for ( int row : order )
+		{
+			const BYTE* pKey = pKeys + row * nKeySize;
+			buffer.insert( buffer.end(), pKey, pKey + nKeySize );
+
+			const DWORD dwRow = row;
+			const BYTE* pRow = (const BYTE*)&dwRow;
+			buffer.insert( buffer.end(), pRow, pRow + sizeof( DWORD ));
+		}
+
+		// the first key of every page
+		for ( int entry = 0; entry < nRows; entry += header.PageSize )
+		{
+			const BYTE* pKey = pKeys + order[ entry ] * nKeySize;
+			buffer.insert( buffer.end(), pKey, pKey + nKeySize );
+		}
+
+		if ( !buffer.empty() )
+		{
+			file.Write( &buffer[ 0 ], (UINT)buffer.size() );
+		}
+		file.Close();
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CIndexFile()
+	{
+		memset( &m_Header, 0, sizeof( m_Header ));
+	}
+
+	// destructor
+	~CIndexFile()
+	{
+	}
+};
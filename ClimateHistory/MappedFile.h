@@ -0,0 +1,154 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////
+// read only memory mapped view of an entire file. Only the pages that are
+// actually touched are read from disk, so a binary search over a mapped
+// index costs a logarithmic number of page reads.
+class CMappedFile
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// handle of the open file
+	HANDLE m_hFile;
+
+	// handle of the file mapping object
+	HANDLE m_hMapping;
+
+	// first byte of the mapped view
+	const BYTE* m_pData;
+
+	// size of the file in bytes
+	ULONGLONG m_ullSize;
+
+// public properties
+public:
+	// first byte of the mapped view
+	inline const BYTE* GetData()
+	{
+		return m_pData;
+	}
+	// first byte of the mapped view
+	__declspec( property( get = GetData ) )
+		const BYTE* Data;
+
+	// size of the file in bytes
+	inline ULONGLONG GetSize()
+	{
+		return m_ullSize;
+	}
+	// size of the file in bytes
+	__declspec( property( get = GetSize ) )
+		ULONGLONG Size;
+
+	// is a file mapped?
+	inline bool GetIsOpen()
+	{
+		return m_pData != nullptr;
+	}
+	// is a file mapped?
+	__declspec( property( get = GetIsOpen ) )
+		bool IsOpen;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// map the whole file into memory for reading
+	bool Open( LPCTSTR pathname )
+	{
+		Close();
+
+		m_hFile = ::CreateFile
+		(
+			pathname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL
+		);
+		if ( m_hFile == INVALID_HANDLE_VALUE )
+		{
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if ( !::GetFileSizeEx( m_hFile, &size ) || size.QuadPart == 0 )
+		{
+			// an empty file cannot be mapped
+			Close();
+			return false;
+		}
+		m_ullSize = size.QuadPart;
+
+		m_hMapping = ::CreateFileMapping
+		(
+			m_hFile, NULL, PAGE_READONLY, 0, 0, NULL
+		);
+		if ( m_hMapping == NULL )
+		{
+			Close();
+			return false;
+		}
+
+		m_pData = (const BYTE*)::MapViewOfFile
+		(
+			m_hMapping, FILE_MAP_READ, 0, 0, 0
+		);
+		if ( m_pData == nullptr )
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	// unmap the view and close the handles
+	void Close()
+	{
+		if ( m_pData != nullptr )
+		{
+			::UnmapViewOfFile( m_pData );
+			m_pData = nullptr;
+		}
+		if ( m_hMapping != NULL )
+		{
+			::CloseHandle( m_hMapping );
+			m_hMapping = NULL;
+		}
+		if ( m_hFile != INVALID_HANDLE_VALUE )
+		{
+			::CloseHandle( m_hFile );
+			m_hFile = INVALID_HANDLE_VALUE;
+		}
+		m_ullSize = 0;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CMappedFile()
+	{
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_hMapping = NULL;
+		m_pData = nullptr;
+		m_ullSize = 0;
+	}
+
+	// destructor
+	~CMappedFile()
+	{
+		Close();
+	}
+};
@@ -0,0 +1,408 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateYear.h"
+#include "KeyedCollection.h"
+#include "ParseCache.h"
+#include <psapi.h>
+#include <set>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// an accounting of the memory held by the parsed climate years, broken
+// down by structure. The collections are walked and every object is sized
+// from its type and the capacity of its containers, so the figures are an
+// estimate of what the heap holds rather than a measurement:
+//
+//	each allocation is rounded up to the heap's 16 byte granularity after
+//		a pointer sized header
+//	each map node holds three links and a color beside its key and value
+//	each CString buffer holds a header, its characters and a terminator
+//		and is counted once however many CStrings share it
+//	each shared_ptr made from new has its own control block holding a
+//		table pointer, the object pointer and two counts
+//
+// Station years shared between collections (i.e. by the parse cache) are
+// counted once. The parse cache row holds the cache's map nodes and the
+// station years only the cache holds (i.e. duplicates the climate years
+// rejected), the ones it shares are counted with the climate years. The
+// peak working set of the process is reported beside
+// the estimate as the measured ceiling.
+class CMemoryReport
+{
+// public definitions
+public:
+	// structures the memory is broken down by
+	typedef enum
+	{
+		mcClimateYears,		// climate year objects and their map nodes
+		mcStationMaps,		// map nodes of the station years of each year
+		mcStationYears,		// station year objects
+		mcMonthVectors,		// month pointer vectors of the station years
+		mcTemperatures,		// monthly temperature objects without flags
+		mcFlags,			// flag characters and bits of the temperatures
+		mcGreaterCounts,	// greater count vectors
+		mcControlBlocks,	// shared_ptr control blocks
+		mcStrings,			// CString buffers
+		mcParseCache,		// parse cache nodes and the station years only it holds
+		mcCount
+
+	} MEMORY_CATEGORY;
+
+	// bytes and objects of a structure
+	typedef struct tagMEMORY_USAGE
+	{
+		LONGLONG Bytes;
+		LONGLONG Objects;
+
+	} MEMORY_USAGE;
+
+// protected data
+protected:
+	// usage of each structure
+	MEMORY_USAGE m_Usage[ mcCount ];
+
+	// number of distinct station years
+	LONGLONG m_llStationYears;
+
+	// largest working set of the process in bytes
+	LONGLONG m_llPeakWorkingSet;
+
+	// working set of the process in bytes when measured
+	LONGLONG m_llWorkingSet;
+
+	// CString buffers already counted
+	set<const void*> m_setStrings;
+
+	// station years already counted
+	set<const void*> m_setStationYears;
+
+// public properties
+public:
+	// usage of a structure
+	inline MEMORY_USAGE GetUsage( int eCategory )
+	{
+		return m_Usage[ eCategory ];
+	}
+	// usage of a structure
+	__declspec( property( get = GetUsage ) )
+		MEMORY_USAGE Usage[];
+
+	// estimated bytes of every structure
+	inline LONGLONG GetBytes()
+	{
+		LONGLONG value = 0;
+		for ( auto& usage : m_Usage )
+		{
+			value += usage.Bytes;
+		}
+
+		return value;
+	}
+	// estimated bytes of every structure
+	__declspec( property( get = GetBytes ) )
+		LONGLONG Bytes;
+
+	// number of distinct station years
+	inline LONGLONG GetStationYears()
+	{
+		return m_llStationYears;
+	}
+	// number of distinct station years
+	__declspec( property( get = GetStationYears ) )
+		LONGLONG StationYears;
+
+	// estimated bytes for each station year
+	inline double GetBytesPerStationYear()
+	{
+		return m_llStationYears == 0 ? 0.0 : double( Bytes ) / m_llStationYears;
+	}
+	// estimated bytes for each station year
+	__declspec( property( get = GetBytesPerStationYear ) )
+		double BytesPerStationYear;
+
+	// largest working set of the process in bytes
+	inline LONGLONG GetPeakWorkingSet()
+	{
+		return m_llPeakWorkingSet;
+	}
+	// largest working set of the process in bytes
+	__declspec( property( get = GetPeakWorkingSet ) )
+		LONGLONG PeakWorkingSet;
+
+// protected methods
+protected:
+	// name of a structure in the report
+	static LPCTSTR GetCategoryName( int eCategory )
+	{
+		static const LPCTSTR pNames[ mcCount ] =
+		{
+			_T( "Climate years" ), _T( "Station maps" ), _T( "Station years" ),
+			_T( "Month vectors" ), _T( "Temperatures" ), _T( "Flags" ),
+			_T( "Greater counts" ), _T( "Control blocks" ), _T( "Strings" ),
+			_T( "Parse cache" )
+		};
+		return pNames[ eCategory ];
+	}
+
+	// estimated heap bytes of an allocation of the given size
+	static inline LONGLONG GetHeapBytes( size_t nBytes )
+	{
+		if ( nBytes == 0 )
+		{
+			return 0;
+		}
+
+		return LONGLONG(( nBytes + sizeof( void* ) + 15 ) & ~size_t( 15 ));
+	}
+
+	// estimated heap bytes of a map node holding the given value type
+	template <class VALUE> static inline LONGLONG GetNodeBytes()
+	{
+		return GetHeapBytes( 3 * sizeof( void* ) + 2 + sizeof( VALUE ));
+	}
+
+	// estimated heap bytes of a shared_ptr control block
+	static inline LONGLONG GetControlBytes()
+	{
+		return GetHeapBytes( 2 * sizeof( void* ) + 2 * sizeof( long ));
+	}
+
+	// add to a structure's usage
+	inline void Add( MEMORY_CATEGORY eCategory, LONGLONG llBytes, LONGLONG llObjects = 1 )
+	{
+		m_Usage[ eCategory ].Bytes += llBytes;
+		m_Usage[ eCategory ].Objects += llObjects;
+	}
+
+	// count a CString buffer unless it was already counted
+	void AddString( const CString& value )
+	{
+		const CStringData* pData = value.GetData();
+		if ( value.IsEmpty() || !m_setStrings.insert( pData ).second )
+		{
+			return;
+		}
+
+		Add
+		(
+			mcStrings,
+			GetHeapBytes
+			(
+				sizeof( CStringData ) + ( pData->nAllocLength + 1 ) * sizeof( TCHAR )
+			)
+		);
+	}
+
+	// count a station year and its months unless it was already counted
+	void AddStationYear( shared_ptr<CStationYear>& pStationYear )
+	{
+		if ( !m_setStationYears.insert( pStationYear.get() ).second )
+		{
+			return;
+		}
+		m_llStationYears++;
+
+		CStationYear& year = *pStationYear;
+		Add( mcStationYears, GetHeapBytes( sizeof( CStationYear )));
+		Add( mcControlBlocks, GetControlBytes() );
+		AddString( year.Station );
+		AddString( year.Year );
+
+		Add
+		(
+			mcMonthVectors,
+			GetHeapBytes( year.MonthCapacity * sizeof( shared_ptr<CClimateTemperature> ))
+		);
+		if ( year.GreaterCapacity > 0 )
+		{
+			Add
+			(
+				mcGreaterCounts,
+				GetHeapBytes( year.GreaterCapacity * sizeof( CStationYear::GREATER_COUNT ))
+			);
+		}
+
+		// the flags are three characters and the decoded bits inside each
+		// temperature object
+		const LONGLONG llFlags = 3 * sizeof( TCHAR ) + sizeof( DWORD );
+		const int nMonths = year.MonthCount;
+		Add
+		(
+			mcTemperatures,
+			nMonths * ( GetHeapBytes( sizeof( CClimateTemperature )) - llFlags ),
+			nMonths
+		);
+		Add( mcFlags, nMonths * llFlags, nMonths );
+		Add( mcControlBlocks, nMonths * GetControlBytes(), nMonths );
+	}
+
+	// count the map nodes and station years of a collection
+	void AddStationMap( CKeyedCollection<CString, CStationYear>& map )
+	{
+		const LONGLONG llNodes = map.Count;
+		Add
+		(
+			mcStationMaps,
+			llNodes * GetNodeBytes<CKeyedCollection<CString, CStationYear>::PAIR_KEY_PTR>(),
+			llNodes
+		);
+
+		for ( auto& node : map.Items )
+		{
+			AddString( node.first );
+			AddStationYear( node.second );
+		}
+	}
+
+	// count the map nodes of the parse cache and the station years only it
+	// holds as the parse cache row, called after the climate years are
+	// counted so the station years they share are not counted again
+	void AddParseCache( CParseCache& cache )
+	{
+		MEMORY_USAGE usage[ mcCount ];
+		memcpy( usage, m_Usage, sizeof( m_Usage ));
+		const LONGLONG llStationYears = m_llStationYears;
+
+		for ( auto& node : cache.Items )
+		{
+			AddStationYear( node.second );
+		}
+
+		// the station years only the cache holds move to its row
+		LONGLONG llBytes = 0;
+		for ( int eCategory = 0; eCategory < mcCount; eCategory++ )
+		{
+			llBytes += m_Usage[ eCategory ].Bytes - usage[ eCategory ].Bytes;
+		}
+		memcpy( m_Usage, usage, sizeof( m_Usage ));
+		m_llStationYears = llStationYears;
+
+		const LONGLONG llNodes = cache.Count;
+		Add
+		(
+			mcParseCache,
+			llBytes + llNodes * GetNodeBytes<CParseCache::MAP_ROWS::value_type>(),
+			llNodes
+		);
+	}
+
+// public methods
+public:
+	// account for the memory held by the climate years and the parse cache
+	// and measure the working set of the process
+	void Measure
+	(
+		CKeyedCollection<CString, CClimateYear>& ClimateYears, CParseCache& cache
+	)
+	{
+		ZeroMemory( m_Usage, sizeof( m_Usage ));
+		m_setStrings.clear();
+		m_setStationYears.clear();
+		m_llStationYears = 0;
+
+		const LONGLONG llYears = ClimateYears.Count;
+		Add
+		(
+			mcClimateYears,
+			llYears * ( GetHeapBytes( sizeof( CClimateYear )) +
+				GetNodeBytes<CKeyedCollection<CString, CClimateYear>::PAIR_KEY_PTR>() ),
+			llYears
+		);
+		Add( mcControlBlocks, llYears * GetControlBytes(), llYears );
+
+		for ( auto& node : ClimateYears.Items )
+		{
+			CClimateYear& year = *node.second;
+			AddString( node.first );
+			AddString( year.Year );
+
+			const size_t nCounts = year.GreaterCounts.capacity();
+			if ( nCounts > 0 )
+			{
+				Add
+				(
+					mcGreaterCounts,
+					GetHeapBytes( nCounts * sizeof( CStationYear::GREATER_COUNT ))
+				);
+			}
+
+			AddStationMap( year.Maximums );
+			AddStationMap( year.Minimums );
+			AddStationMap( year.Averages );
+		}
+		AddParseCache( cache );
+
+		// the counted pointers are not needed after the walk
+		m_setStrings.clear();
+		m_setStationYears.clear();
+
+		PROCESS_MEMORY_COUNTERS counters;
+		ZeroMemory( &counters, sizeof( counters ));
+		counters.cb = sizeof( counters );
+		if ( ::GetProcessMemoryInfo( ::GetCurrentProcess(), &counters, sizeof( counters )))
+		{
+			m_llPeakWorkingSet = (LONGLONG)counters.PeakWorkingSetSize;
+			m_llWorkingSet = (LONGLONG)counters.WorkingSetSize;
+		}
+	}
+
+	// write the accounting as comma separated values
+	void Write( CStdioFile& fOut )
+	{
+		CString csLine;
+		const LONGLONG llBytes = Bytes;
+		fOut.WriteString( _T( "Structure,Objects,Bytes,Percent,Bytes per Station Year\n" ) );
+		for ( int eCategory = 0; eCategory < mcCount; eCategory++ )
+		{
+			const MEMORY_USAGE& usage = m_Usage[ eCategory ];
+			csLine.Format
+			(
+				_T( "%s,%I64d,%I64d,%0.1f,%0.1f\n" ),
+				GetCategoryName( eCategory ), usage.Objects, usage.Bytes,
+				llBytes == 0 ? 0.0 : usage.Bytes * 100.0 / llBytes,
+				m_llStationYears == 0 ? 0.0 : double( usage.Bytes ) / m_llStationYears
+			);
+			fOut.WriteString( csLine );
+		}
+
+		csLine.Format
+		(
+			_T( "Total,%I64d,%I64d,100.0,%0.1f\n" ),
+			m_llStationYears, llBytes, BytesPerStationYear
+		);
+		fOut.WriteString( csLine );
+
+		csLine.Format
+		(
+			_T( "Working set,,%I64d,,\nPeak working set,,%I64d,,\n" ),
+			m_llWorkingSet, m_llPeakWorkingSet
+		);
+		fOut.WriteString( csLine );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CMemoryReport()
+	{
+		ZeroMemory( m_Usage, sizeof( m_Usage ));
+		m_llStationYears = 0;
+		m_llPeakWorkingSet = 0;
+		m_llWorkingSet = 0;
+	}
+
+	// destructor
+	~CMemoryReport()
+	{
+	}
+};
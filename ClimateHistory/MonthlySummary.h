@@ -0,0 +1,250 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateTable.h"
+#include <algorithm>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// year by month statistics of every measurement type reduced from the
+// month columns of a climate table. Each calendar month is an independent
+// reduction over its own column of every block into its own accumulators,
+// so the twelve months run in parallel and the data is read once in total
+// instead of once per month.
+class CMonthlySummary
+{
+// public definitions
+public:
+	// the greater than limits in degrees Fahrenheit (90 to 130 by 5)
+	enum { GREATER_LIMITS = 9 };
+
+	// statistics of one year and month indexed by measurement type
+	typedef struct tagMONTH_SUMMARY
+	{
+		int Stations[ 4 ]; // station years reported (valid or not)
+		int Readings[ 4 ]; // valid readings
+		double Sum[ 4 ]; // sum of the valid readings in centigrade
+		float High[ 4 ]; // highest valid reading in centigrade
+		float Low[ 4 ]; // lowest valid reading in centigrade
+
+		// valid readings greater than each limit
+		int Greater[ 4 ][ GREATER_LIMITS ];
+
+	} MONTH_SUMMARY;
+
+// protected data
+protected:
+	// first year of the table
+	int m_nFirstYear;
+
+	// number of years from the first to the last of the table
+	int m_nYears;
+
+	// statistics indexed by month then year less the first year
+	vector<MONTH_SUMMARY> m_arrMonths[ 12 ];
+
+	// quality control flags whose readings are left out
+	DWORD m_dwExcludeMask;
+
+// public properties
+public:
+	// first year of the table
+	inline int GetFirstYear()
+	{
+		return m_nFirstYear;
+	}
+	// first year of the table
+	__declspec( property( get = GetFirstYear ) )
+		int FirstYear;
+
+	// number of years from the first to the last of the table
+	inline int GetYears()
+	{
+		return m_nYears;
+	}
+	// number of years from the first to the last of the table
+	__declspec( property( get = GetYears ) )
+		int Years;
+
+	// quality control flags whose readings are left out
+	inline DWORD GetExcludeMask()
+	{
+		return m_dwExcludeMask;
+	}
+	// quality control flags whose readings are left out
+	inline void SetExcludeMask( DWORD value )
+	{
+		m_dwExcludeMask = value;
+	}
+	// quality control flags whose readings are left out
+	__declspec( property( get = GetExcludeMask, put = SetExcludeMask ) )
+		DWORD ExcludeMask;
+
+	// greater than limit in degrees Fahrenheit by index
+	inline static int GetGreaterLimit( int index )
+	{
+		return 90 + index * 5;
+	}
+
+// protected methods
+protected:
+	// reduce one month column of every block
+	void ReduceMonth( CClimateTable& table, int nMonth )
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+
+		MONTH_SUMMARY empty;
+		ZeroMemory( &empty, sizeof( empty ));
+		for ( int nType = 0; nType < 4; nType++ )
+		{
+			empty.High[ nType ] = fMissing;
+			empty.Low[ nType ] = fMissing;
+		}
+
+		// the limits converted to centigrade once
+		float fLimits[ GREATER_LIMITS ];
+		for ( int index = 0; index < GREATER_LIMITS; index++ )
+		{
+			fLimits[ index ] = ( GetGreaterLimit( index ) - 32.0f ) / 1.8f;
+		}
+
+		vector<MONTH_SUMMARY>& months = m_arrMonths[ nMonth ];
+		months.assign( m_nYears, empty );
+		const DWORD dwExclude = m_dwExcludeMask;
+
+		for ( auto& block : table.Blocks )
+		{
+			const int eType = block->MeasurementType;
+			const float* pValues = block->GetMonthColumn( nMonth );
+			const DWORD* pFlags = block->GetFlagBitsColumn( nMonth );
+			const int nRows = block->Rows;
+			for ( int row = 0; row < nRows; row++ )
+			{
+				MONTH_SUMMARY& month = months[ block->Year[ row ] - m_nFirstYear ];
+				month.Stations[ eType ]++;
+
+				// valid readings are all far above the missing value
+				const float fValue = pValues[ row ];
+				if ( fValue <= fMissing || ( pFlags[ row ] & dwExclude ) != 0 )
+				{
+					continue;
+				}
+
+				if ( month.Readings[ eType ] == 0 )
+				{
+					month.High[ eType ] = fValue;
+					month.Low[ eType ] = fValue;
+
+				} else
+				{
+					month.High[ eType ] = max( month.High[ eType ], fValue );
+					month.Low[ eType ] = min( month.Low[ eType ], fValue );
+				}
+				month.Readings[ eType ]++;
+				month.Sum[ eType ] += fValue;
+
+				int* pGreater = month.Greater[ eType ];
+				for ( int index = 0; index < GREATER_LIMITS; index++ )
+				{
+					if ( fValue > fLimits[ index ] )
+					{
+						pGreater[ index ]++;
+					}
+				}
+			}
+		}
+	}
+
+// public methods
+public:
+	// reduce every month of the table in parallel
+	void Compute( CClimateTable& table )
+	{
+		m_nFirstYear = 0;
+		m_nYears = 0;
+
+		// the year zone maps bound the years without reading any rows
+		int nLastYear = 0;
+		for ( auto& block : table.Blocks )
+		{
+			CZoneMap& zone = block->YearZone;
+			if ( zone.Empty )
+			{
+				continue;
+			}
+
+			const int nFirst = int( zone.Minimum );
+			const int nLast = int( zone.Maximum );
+			if ( m_nYears == 0 )
+			{
+				m_nFirstYear = nFirst;
+				nLastYear = nLast;
+				m_nYears = 1;
+
+			} else
+			{
+				m_nFirstYear = min( m_nFirstYear, nFirst );
+				nLastYear = max( nLastYear, nLast );
+			}
+		}
+		if ( m_nYears != 0 )
+		{
+			m_nYears = nLastYear - m_nFirstYear + 1;
+		}
+
+		concurrency::parallel_for
+		(
+			0, 12,
+			[&]( int nMonth )
+			{
+				ReduceMonth( table, nMonth );
+			}
+		);
+	}
+
+	// statistics of a year and month (0 to 11)
+	MONTH_SUMMARY& GetSummary( int nYear, int nMonth )
+	{
+		return m_arrMonths[ nMonth ][ nYear - m_nFirstYear ];
+	}
+
+	// mean in centigrade of a measurement type of a summary or missing
+	static float GetMean
+	(
+		MONTH_SUMMARY& summary, CClimateTemperature::MEASURE_TYPE eType
+	)
+	{
+		if ( summary.Readings[ eType ] == 0 )
+		{
+			return CClimateTemperature::GetMissingValue();
+		}
+
+		return float( summary.Sum[ eType ] / summary.Readings[ eType ] );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CMonthlySummary()
+	{
+		m_nFirstYear = 0;
+		m_nYears = 0;
+		m_dwExcludeMask = 0;
+	}
+
+	// destructor
+	~CMonthlySummary()
+	{
+	}
+};
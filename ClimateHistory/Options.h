@@ -0,0 +1,192 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <map>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// command line switches of the form "--name" or "--name value" which can
+// be mixed with the positional arguments (pathname and station file name).
+// Each switch is defined before parsing so the usage text can be generated
+// and so the parser knows whether a switch consumes the following argument.
+class COptions
+{
+// public definitions
+public:
+	// whether the switch takes a value and the usage text of the switch
+	typedef pair<bool, CString> SWITCH_DEFINITION;
+
+// protected data
+protected:
+	// defined switches keyed by lower case name without the dashes
+	map<CString, SWITCH_DEFINITION> m_mapDefinitions;
+
+	// switch names in the order they were defined (for the usage text)
+	vector<CString> m_arrOrder;
+
+	// switches found on the command line and their values
+	map<CString, CString> m_mapSwitches;
+
+	// positional arguments with the switches removed
+	vector<CString> m_arrArguments;
+
+	// description of the last parsing error
+	CString m_csError;
+
+// public properties
+public:
+	// positional arguments with the switches removed (the first
+	// argument is the executable pathname)
+	inline vector<CString>& GetArguments()
+	{
+		return m_arrArguments;
+	}
+	// positional arguments with the switches removed
+	__declspec( property( get = GetArguments ) )
+		vector<CString> Arguments;
+
+	// was the switch given on the command line?
+	inline bool GetExists( LPCTSTR name )
+	{
+		const CString csName = CString( name ).MakeLower();
+		return m_mapSwitches.find( csName ) != m_mapSwitches.end();
+	}
+	// was the switch given on the command line?
+	__declspec( property( get = GetExists ) )
+		bool Exists[];
+
+	// value given to the switch on the command line (empty if missing)
+	inline CString GetValue( LPCTSTR name )
+	{
+		CString value;
+		const CString csName = CString( name ).MakeLower();
+		auto pos = m_mapSwitches.find( csName );
+		if ( pos != m_mapSwitches.end() )
+		{
+			value = pos->second;
+		}
+
+		return value;
+	}
+	// value given to the switch on the command line (empty if missing)
+	__declspec( property( get = GetValue ) )
+		CString Value[];
+
+	// description of the last parsing error
+	inline CString GetError()
+	{
+		return m_csError;
+	}
+	// description of the last parsing error
+	__declspec( property( get = GetError ) )
+		CString Error;
+
+	// usage text describing every defined switch
+	inline CString GetUsage()
+	{
+		CString value;
+		for ( auto& name : m_arrOrder )
+		{
+			SWITCH_DEFINITION& definition = m_mapDefinitions[ name ];
+
+			CString csLine;
+			csLine.Format
+			(
+				_T( ".  --%s%s\n.      %s\n" ), name,
+				definition.first ? _T( " value" ) : _T( "" ),
+				definition.second
+			);
+			value += csLine;
+		}
+
+		return value;
+	}
+	// usage text describing every defined switch
+	__declspec( property( get = GetUsage ) )
+		CString Usage;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// define a switch before the command line is parsed
+	void Define( LPCTSTR name, bool bHasValue, LPCTSTR usage )
+	{
+		const CString csName = CString( name ).MakeLower();
+		if ( m_mapDefinitions.find( csName ) == m_mapDefinitions.end() )
+		{
+			m_arrOrder.push_back( csName );
+		}
+
+		m_mapDefinitions[ csName ] = SWITCH_DEFINITION( bHasValue, usage );
+	}
+
+	// separate the switches from the positional arguments, returns false
+	// and sets the Error property on an unknown switch or missing value
+	bool Parse( vector<CString>& arrArgs )
+	{
+		m_mapSwitches.clear();
+		m_arrArguments.clear();
+		m_csError.Empty();
+
+		const size_t nArgs = arrArgs.size();
+		for ( size_t arg = 0; arg < nArgs; arg++ )
+		{
+			const CString csArg = arrArgs[ arg ];
+
+			// anything not starting with a double dash is positional
+			if ( csArg.Left( 2 ) != _T( "--" ) || csArg.GetLength() < 3 )
+			{
+				m_arrArguments.push_back( csArg );
+				continue;
+			}
+
+			const CString csName = csArg.Mid( 2 ).MakeLower();
+			auto pos = m_mapDefinitions.find( csName );
+			if ( pos == m_mapDefinitions.end() )
+			{
+				m_csError.Format( _T( "Unknown switch: %s" ), csArg );
+				return false;
+			}
+
+			CString csValue;
+			if ( pos->second.first )
+			{
+				if ( arg + 1 >= nArgs )
+				{
+					m_csError.Format( _T( "Missing value for switch: %s" ), csArg );
+					return false;
+				}
+
+				csValue = arrArgs[ ++arg ];
+			}
+
+			m_mapSwitches[ csName ] = csValue;
+		}
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	COptions()
+	{
+	}
+
+	// destructor
+	~COptions()
+	{
+	}
+};
@@ -0,0 +1,241 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include "StationYear.h"
+#include "ChunkStore.h"
+#include <atomic>
+#include <concurrent_unordered_map.h>
+#include <memory>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// decoded station years keyed by a 64-bit hash of their source line. The
+// raw, time of observation, and homogenized variants (and consecutive
+// releases) repeat most lines byte for byte, and a repeated line decodes
+// to the same station year, so the first decode is reused and the twelve
+// CClimateTemperature objects are not built again. The station and year
+// of a hit are checked against the line to guard against a collision.
+//
+// The map is a concurrent one so the parallel parsers of the dataset
+// variants can share the cache. Station years found here are shared by
+// every collection holding them, so their station index is assigned
+// before they are added.
+//
+// Every station year decoded is held until the cache is cleared, so the
+// cache is only enabled for the dataset variants (--variants) whose lines
+// repeat. Otherwise each line is decoded into a station year that only
+// its climate year holds.
+class CParseCache
+{
+// public definitions
+public:
+	// decoded station years keyed by the hash of the line and type
+	typedef concurrency::concurrent_unordered_map
+		<ULONGLONG, shared_ptr<CStationYear> > MAP_ROWS;
+
+// protected data
+protected:
+	// decoded station years keyed by the hash of the line and type
+	MAP_ROWS m_mapRows;
+
+	// are the decoded station years held and looked up?
+	bool m_bEnabled;
+
+	// lines looked up and lines found
+	atomic<int> m_nLookups;
+	atomic<int> m_nHits;
+
+	// performance counter ticks spent decoding the misses and hashing
+	atomic<LONGLONG> m_llDecodeTicks;
+	atomic<LONGLONG> m_llHashTicks;
+
+// public properties
+public:
+	// are the decoded station years held and looked up?
+	inline bool GetEnabled()
+	{
+		return m_bEnabled;
+	}
+	// are the decoded station years held and looked up?
+	inline void SetEnabled( bool value )
+	{
+		m_bEnabled = value;
+	}
+	// are the decoded station years held and looked up?
+	__declspec( property( get = GetEnabled, put = SetEnabled ) )
+		bool Enabled;
+
+	// number of station years held
+	inline int GetCount()
+	{
+		return (int)m_mapRows.size();
+	}
+	// number of station years held
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+	// decoded station years keyed by the hash of the line and type
+	inline MAP_ROWS& GetItems()
+	{
+		return m_mapRows;
+	}
+	// decoded station years keyed by the hash of the line and type
+	__declspec( property( get = GetItems ) )
+		MAP_ROWS Items;
+
+	// number of lines looked up
+	inline int GetLookups()
+	{
+		return m_nLookups;
+	}
+	// number of lines looked up
+	__declspec( property( get = GetLookups ) )
+		int Lookups;
+
+	// number of lines decoded by an earlier lookup
+	inline int GetHits()
+	{
+		return m_nHits;
+	}
+	// number of lines decoded by an earlier lookup
+	__declspec( property( get = GetHits ) )
+		int Hits;
+
+	// percentage of the lookups that were hits
+	inline float GetHitRate()
+	{
+		const int nLookups = Lookups;
+		return nLookups == 0 ? 0.0f : float( Hits * 100.0 / nLookups );
+	}
+	// percentage of the lookups that were hits
+	__declspec( property( get = GetHitRate ) )
+		float HitRate;
+
+	// milliseconds the hits would have spent decoding at the mean decode
+	// time of the misses, less the time spent hashing every line
+	inline float GetMillisecondsSaved()
+	{
+		const int nMisses = Lookups - Hits;
+		LARGE_INTEGER frequency;
+		if ( nMisses == 0 || !::QueryPerformanceFrequency( &frequency ))
+		{
+			return 0.0f;
+		}
+
+		const double dDecode = double( m_llDecodeTicks ) / nMisses;
+		const double dSaved = dDecode * Hits - double( m_llHashTicks );
+		return float( dSaved * 1000.0 / frequency.QuadPart );
+	}
+	// milliseconds the hits would have spent decoding at the mean decode
+	// time of the misses, less the time spent hashing every line
+	__declspec( property( get = GetMillisecondsSaved ) )
+		float MillisecondsSaved;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// hash of a source line and the measurement type it was read as
+	static ULONGLONG GetKey
+	(
+		const CString& source, CClimateTemperature::MEASURE_TYPE eType
+	)
+	{
+		const ULONGLONG value = CChunkStore::GetHash
+		(
+			(const BYTE*)source.GetString(), source.GetLength() * sizeof( TCHAR )
+		);
+
+		return ( value ^ eType ) * 1099511628211ULL;
+	}
+
+	// decoded station year of a source line, decoding and indexing it with
+	// the given station list lookup only if the line has not been seen,
+	// or always when the cache is not enabled
+	template <class INDEXER> shared_ptr<CStationYear> Parse
+	(
+		CString& source, CClimateTemperature::MEASURE_TYPE eType,
+		INDEXER indexer
+	)
+	{
+		if ( !m_bEnabled )
+		{
+			shared_ptr<CStationYear> value = shared_ptr<CStationYear>
+			(
+				new CStationYear( source, eType )
+			);
+			value->StationIndex = indexer( value->Station );
+			return value;
+		}
+
+		m_nLookups++;
+
+		const LONGLONG llStart = CHelper::GetTicks();
+		const ULONGLONG ullKey = GetKey( source, eType );
+		auto pos = m_mapRows.find( ullKey );
+		if ( pos != m_mapRows.end() )
+		{
+			shared_ptr<CStationYear>& value = pos->second;
+			if ( source.Left( value->StationLength ) == value->Station &&
+				source.Mid( value->YearStart, value->YearLength ) == value->Year )
+			{
+				m_nHits++;
+				m_llHashTicks += CHelper::GetTicks() - llStart;
+				return value;
+			}
+		}
+		const LONGLONG llDecode = CHelper::GetTicks();
+		m_llHashTicks += llDecode - llStart;
+
+		shared_ptr<CStationYear> value = shared_ptr<CStationYear>
+		(
+			new CStationYear( source, eType )
+		);
+		value->StationIndex = indexer( value->Station );
+		m_llDecodeTicks += CHelper::GetTicks() - llDecode;
+
+		// another thread may have decoded the same line first, either copy
+		// is fine and a collision simply keeps the first entry
+		m_mapRows.insert( make_pair( ullKey, value ));
+
+		return value;
+	}
+
+	// forget every line
+	void Clear()
+	{
+		m_mapRows.clear();
+		m_nLookups = 0;
+		m_nHits = 0;
+		m_llDecodeTicks = 0;
+		m_llHashTicks = 0;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CParseCache()
+	{
+		m_bEnabled = false;
+		m_nLookups = 0;
+		m_nHits = 0;
+		m_llDecodeTicks = 0;
+		m_llHashTicks = 0;
+	}
+
+	// destructor
+	~CParseCache()
+	{
+	}
+};
@@ -0,0 +1,314 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <concrt.h>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// progress of the ingestion written to standard error by a thread of its
+// own, so a slow terminal or log collector never holds up the threads
+// parsing the files.
+//
+// The parsing threads post a message for every file they open onto a lock
+// free stack: a message is linked in with a compare and exchange of the
+// head, and the logging thread takes every waiting message at once by
+// exchanging the head with nullptr, then reverses them into the order they
+// were posted. Any number of threads can post at once without a lock or a
+// wait. The logging thread wakes at the report interval and writes one
+// line with the files read, files and megabytes per second, the estimated
+// time left when the number of files is known, and the last station read.
+// Text posted with Post is written in order between the progress lines,
+// and quiet mode writes only that text.
+class CProgressLog
+{
+// public definitions
+public:
+	// a file read or a line of text to write
+	typedef struct tagPROGRESS_MESSAGE
+	{
+		// next message on the stack
+		tagPROGRESS_MESSAGE* Next;
+
+		// file title of a file or the text to write
+		CString Text;
+
+		// bytes of a file
+		LONGLONG Bytes;
+
+		// is this a file rather than text?
+		bool File;
+
+	} PROGRESS_MESSAGE;
+
+// protected data
+protected:
+	// most recently posted message
+	atomic<PROGRESS_MESSAGE*> m_pHead;
+
+	// is the logging thread running? (read by the posting threads)
+	atomic<bool> m_bRunning;
+
+	// write only posted text?
+	bool m_bQuiet;
+
+	// seconds between progress lines
+	double m_dInterval;
+
+	// number of files expected (0 if not known)
+	atomic<int> m_nTotal;
+
+	// files and bytes read, only touched by the logging thread
+	LONGLONG m_llFiles;
+	LONGLONG m_llBytes;
+
+	// title of the last file read, only touched by the logging thread
+	CString m_csLast;
+
+	// performance counter when logging started
+	LONGLONG m_llStart;
+
+	// signaled to stop the logging thread
+	concurrency::event m_evStop;
+
+	// the logging thread
+	thread m_thread;
+
+// public properties
+public:
+	// is the logging thread running?
+	inline bool GetRunning()
+	{
+		return m_bRunning;
+	}
+	// is the logging thread running?
+	__declspec( property( get = GetRunning ) )
+		bool Running;
+
+	// number of files expected (0 if not known)
+	inline int GetTotal()
+	{
+		return m_nTotal;
+	}
+	// number of files expected (0 if not known)
+	inline void SetTotal( int value )
+	{
+		m_nTotal = value;
+	}
+	// number of files expected (0 if not known)
+	__declspec( property( get = GetTotal, put = SetTotal ) )
+		int Total;
+
+// protected methods
+protected:
+	// link a message onto the stack
+	void Push( PROGRESS_MESSAGE* pMessage )
+	{
+		pMessage->Next = m_pHead.load( memory_order_relaxed );
+		while ( !m_pHead.compare_exchange_weak
+		(
+			pMessage->Next, pMessage,
+			memory_order_release, memory_order_relaxed
+		))
+		{
+		}
+	}
+
+	// take every waiting message, count the files and write the text
+	void Drain( CStdioFile& fErr )
+	{
+		PROGRESS_MESSAGE* pMessage = m_pHead.exchange( nullptr, memory_order_acquire );
+
+		// the stack is newest first
+		PROGRESS_MESSAGE* pFirst = nullptr;
+		while ( pMessage != nullptr )
+		{
+			PROGRESS_MESSAGE* pNext = pMessage->Next;
+			pMessage->Next = pFirst;
+			pFirst = pMessage;
+			pMessage = pNext;
+		}
+
+		while ( pFirst != nullptr )
+		{
+			PROGRESS_MESSAGE* pNext = pFirst->Next;
+			if ( pFirst->File )
+			{
+				m_llFiles++;
+				m_llBytes += pFirst->Bytes;
+				m_csLast = pFirst->Text;
+
+			} else
+			{
+				fErr.WriteString( pFirst->Text );
+			}
+
+			delete pFirst;
+			pFirst = pNext;
+		}
+	}
+
+	// write a line with the files read, their rates, and the time left
+	void Report( CStdioFile& fErr )
+	{
+		LARGE_INTEGER frequency;
+		::QueryPerformanceFrequency( &frequency );
+		const double dSeconds =
+			( CHelper::GetTicks() - m_llStart ) / double( frequency.QuadPart );
+		const double dFiles = dSeconds <= 0.0 ? 0.0 : m_llFiles / dSeconds;
+		const double dMegabytes =
+			dSeconds <= 0.0 ? 0.0 : m_llBytes / ( dSeconds * 1048576.0 );
+
+		CString csLine;
+		csLine.Format
+		(
+			_T( "%7I64d files %8.1f files/s %7.1f MB/s" ),
+			m_llFiles, dFiles, dMegabytes
+		);
+
+		const int nTotal = m_nTotal;
+		if ( nTotal > 0 && dFiles > 0.0 )
+		{
+			const int nLeft =
+				int( max( 0.0, ( nTotal - m_llFiles ) / dFiles ) + 0.5 );
+			CString csLeft;
+			csLeft.Format
+			(
+				_T( "  ETA %d:%02d:%02d" ),
+				nLeft / 3600, nLeft / 60 % 60, nLeft % 60
+			);
+			csLine += csLeft;
+		}
+
+		csLine += _T( "  " ) + m_csLast + _T( "\n" );
+		fErr.WriteString( csLine );
+		fErr.Flush();
+	}
+
+	// wake at every interval until stopped
+	void Run()
+	{
+		CStdioFile fErr( stderr );
+		const unsigned nMilliseconds = unsigned( m_dInterval * 1000.0 );
+		bool bStopping = false;
+		while ( !bStopping )
+		{
+			bStopping = m_evStop.wait( nMilliseconds ) == 0;
+
+			const LONGLONG llFiles = m_llFiles;
+			Drain( fErr );
+			if ( !m_bQuiet && m_llFiles != llFiles )
+			{
+				Report( fErr );
+			}
+		}
+	}
+
+// public methods
+public:
+	// start the logging thread with a progress line at most every
+	// interval in seconds
+	void Start( double dInterval, bool bQuiet )
+	{
+		Stop();
+
+		m_dInterval = max( 0.01, dInterval );
+		m_bQuiet = bQuiet;
+		m_nTotal = 0;
+		m_llFiles = 0;
+		m_llBytes = 0;
+		m_csLast.Empty();
+		m_llStart = CHelper::GetTicks();
+		m_evStop.reset();
+		m_thread = thread( [this]() { Run(); } );
+		m_bRunning = true;
+	}
+
+	// write whatever is waiting and stop the logging thread
+	void Stop()
+	{
+		// posts from here on are written directly
+		if ( !m_bRunning.exchange( false ))
+		{
+			return;
+		}
+
+		m_evStop.set();
+		m_thread.join();
+
+		// a message pushed while the thread was stopping is written and
+		// freed here instead of left on the stack
+		CStdioFile fErr( stderr );
+		const LONGLONG llFiles = m_llFiles;
+		Drain( fErr );
+		if ( !m_bQuiet && m_llFiles != llFiles )
+		{
+			Report( fErr );
+		}
+	}
+
+	// count a file opened by any thread
+	void AddFile( LPCTSTR title, LONGLONG llBytes )
+	{
+		if ( !m_bRunning )
+		{
+			return;
+		}
+
+		PROGRESS_MESSAGE* pMessage = new PROGRESS_MESSAGE;
+		pMessage->Text = title;
+		pMessage->Bytes = llBytes;
+		pMessage->File = true;
+		Push( pMessage );
+	}
+
+	// write a line of text from any thread in the order it was posted,
+	// directly when the logging thread is not running
+	void Post( LPCTSTR text )
+	{
+		if ( !m_bRunning )
+		{
+			CStdioFile fErr( stderr );
+			fErr.WriteString( text );
+			return;
+		}
+
+		PROGRESS_MESSAGE* pMessage = new PROGRESS_MESSAGE;
+		pMessage->Text = text;
+		pMessage->Bytes = 0;
+		pMessage->File = false;
+		Push( pMessage );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CProgressLog()
+	{
+		m_pHead = nullptr;
+		m_bRunning = false;
+		m_bQuiet = false;
+		m_dInterval = 1.0;
+		m_nTotal = 0;
+		m_llFiles = 0;
+		m_llBytes = 0;
+		m_llStart = 0;
+	}
+
+	// destructor
+	~CProgressLog()
+	{
+		Stop();
+	}
+};
@@ -0,0 +1,447 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "StationList.h"
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// command line filters on the year, station, state and measurement type
+// applied while the climate files are read instead of to the parsed data.
+// The measurement type and station are known from a file's extension and
+// name, so files that cannot match are never opened. The station and year
+// of a line are in columns 1 - 16 and are tested before any of the twelve
+// CClimateTemperature values are decoded. Readings are never changed, the
+// quality control flags are left to CFlagPolicy during aggregation. The
+// minimum number of valid months is tested against the validity mask of a
+// station year as it is written to its climate year.
+//
+// The filter is only read while the files are parsed so the parallel
+// parsers of the dataset variants can share it.
+class CQueryFilter
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// first year of interest (inclusive)
+	int m_nFirstYear;
+
+	// last year of interest (inclusive)
+	int m_nLastYear;
+
+	// station IDs or wild card patterns (* and ?), empty for any
+	vector<CString> m_arrStations;
+
+	// packed states (see CStationList::PackState), empty for any
+	vector<WORD> m_arrStates;
+
+	// measurement types of interest indexed by type
+	bool m_bTypes[ 4 ];
+
+	// fewest valid months a station year needs to be aggregated
+	int m_nMinimumMonths;
+
+	// files skipped without being opened
+	atomic<int> m_nFilesSkipped;
+
+	// lines read and lines rejected before decoding
+	atomic<int> m_nLinesRead;
+	atomic<int> m_nLinesRejected;
+
+// public properties
+public:
+	// first year of interest (inclusive)
+	inline int GetFirstYear()
+	{
+		return m_nFirstYear;
+	}
+	// first year of interest (inclusive)
+	__declspec( property( get = GetFirstYear ) )
+		int FirstYear;
+
+	// last year of interest (inclusive)
+	inline int GetLastYear()
+	{
+		return m_nLastYear;
+	}
+	// last year of interest (inclusive)
+	__declspec( property( get = GetLastYear ) )
+		int LastYear;
+
+	// fewest valid months a station year needs to be aggregated
+	inline int GetMinimumMonths()
+	{
+		return m_nMinimumMonths;
+	}
+	// fewest valid months a station year needs to be aggregated
+	__declspec( property( get = GetMinimumMonths ) )
+		int MinimumMonths;
+
+	// does any condition restrict the lines that are decoded?
+	inline bool GetActive()
+	{
+		return
+			m_nFirstYear != INT_MIN || m_nLastYear != INT_MAX ||
+			!m_arrStations.empty() || !m_arrStates.empty() ||
+			!m_bTypes[ CClimateTemperature::mtMaximum ] ||
+			!m_bTypes[ CClimateTemperature::mtMinimum ] ||
+			!m_bTypes[ CClimateTemperature::mtAverage ];
+	}
+	// does any condition restrict the lines that are decoded?
+	__declspec( property( get = GetActive ) )
+		bool Active;
+
+	// files skipped without being opened
+	inline int GetFilesSkipped()
+	{
+		return m_nFilesSkipped;
+	}
+	// files skipped without being opened
+	__declspec( property( get = GetFilesSkipped ) )
+		int FilesSkipped;
+
+	// lines read from the files that were opened
+	inline int GetLinesRead()
+	{
+		return m_nLinesRead;
+	}
+	// lines read from the files that were opened
+	__declspec( property( get = GetLinesRead ) )
+		int LinesRead;
+
+	// lines rejected before decoding
+	inline int GetLinesRejected()
+	{
+		return m_nLinesRejected;
+	}
+	// lines rejected before decoding
+	__declspec( property( get = GetLinesRejected ) )
+		int LinesRejected;
+
+// protected methods
+protected:
+	// does the text match a pattern of literal characters, ? for any
+	// character, and * for any run of characters (ignoring case)?
+	static bool Matches( LPCTSTR text, int nLength, LPCTSTR pattern )
+	{
+		int nText = 0;
+		int nStar = -1;
+		int nResume = 0;
+		LPCTSTR p = pattern;
+		while ( nText < nLength )
+		{
+			if ( *p == _T( '*' ))
+			{
+				nStar = int( p - pattern );
+				nResume = nText;
+				p++;
+
+			} else if
+			(
+				*p != 0 && ( *p == _T( '?' ) ||
+				_totupper( *p ) == _totupper( text[ nText ] ))
+			)
+			{
+				p++;
+				nText++;
+
+			} else if ( nStar != -1 )
+			{
+				// let the last star absorb one more character
+				p = pattern + nStar + 1;
+				nText = ++nResume;
+
+			} else
+			{
+				return false;
+			}
+		}
+
+		while ( *p == _T( '*' ))
+		{
+			p++;
+		}
+
+		return *p == 0;
+	}
+
+	// year in columns 13 - 16 of a line without building a string,
+	// -1 if the columns are not all digits
+	static int GetLineYear( const CString& line )
+	{
+		if ( line.GetLength() < 16 )
+		{
+			return -1;
+		}
+
+		int value = 0;
+		LPCTSTR pYear = line.GetString() + 12;
+		for ( int n = 0; n < 4; n++ )
+		{
+			const TCHAR ch = pYear[ n ];
+			if ( ch < _T( '0' ) || ch > _T( '9' ))
+			{
+				return -1;
+			}
+			value = value * 10 + ( ch - _T( '0' ));
+		}
+
+		return value;
+	}
+
+	// split a comma separated list into trimmed upper case items
+	static void Split( const CString& csList, vector<CString>& items )
+	{
+		items.clear();
+
+		int nStart = 0;
+		CString csItem = csList.Tokenize( _T( "," ), nStart );
+		while ( nStart != -1 )
+		{
+			csItem.Trim();
+			if ( !csItem.IsEmpty() )
+			{
+				items.push_back( csItem.MakeUpper() );
+			}
+			csItem = csList.Tokenize( _T( "," ), nStart );
+		}
+	}
+
+// public methods
+public:
+	// years as "first-last" or a single year, false if invalid
+	bool SetYears( const CString& csYears )
+	{
+		const int nDash = csYears.Find( _T( '-' ));
+		const int nFirst = _ttoi( csYears );
+		const int nLast = nDash == -1 ? nFirst : _ttoi( csYears.Mid( nDash + 1 ));
+		if ( nFirst <= 0 || nLast < nFirst )
+		{
+			return false;
+		}
+
+		m_nFirstYear = nFirst;
+		m_nLastYear = nLast;
+		return true;
+	}
+
+	// fewest valid months (0 - 12) a station year needs to be
+	// aggregated, false if invalid
+	bool SetMinimumMonths( const CString& csMonths )
+	{
+		const CString csDigits = csMonths.SpanIncluding( _T( "0123456789" ));
+		const int nMonths = _ttoi( csMonths );
+		if ( csMonths.IsEmpty() || csDigits != csMonths || nMonths > 12 )
+		{
+			return false;
+		}
+
+		m_nMinimumMonths = nMonths;
+		return true;
+	}
+
+	// comma separated station IDs or wild card patterns (i.e.
+	// USH00011084,USH0004*) and return the number of them
+	int SetStations( const CString& csStations )
+	{
+		Split( csStations, m_arrStations );
+		return (int)m_arrStations.size();
+	}
+
+	// comma separated two letter states (i.e. AL,GA) and return the
+	// number of them, zero if any is not two letters
+	int SetStates( const CString& csStates )
+	{
+		m_arrStates.clear();
+
+		vector<CString> states;
+		Split( csStates, states );
+		for ( auto& state : states )
+		{
+			if ( state.GetLength() != 2 )
+			{
+				m_arrStates.clear();
+				return 0;
+			}
+			m_arrStates.push_back( CStationList::PackState( state ));
+		}
+
+		return (int)m_arrStates.size();
+	}
+
+	// comma separated measurement types (tmax, tmin, tavg) and return the
+	// number of them, zero if any is not recognized
+	int SetTypes( const CString& csTypes )
+	{
+		bool bTypes[ 4 ] = { false, false, false, false };
+		int value = 0;
+
+		vector<CString> types;
+		Split( csTypes, types );
+		for ( auto& type : types )
+		{
+			CClimateTemperature::MEASURE_TYPE eType = GetType( type );
+			if ( eType == CClimateTemperature::mtMissing )
+			{
+				return 0;
+			}
+			if ( !bTypes[ eType ] )
+			{
+				bTypes[ eType ] = true;
+				value++;
+			}
+		}
+
+		if ( value > 0 )
+		{
+			memcpy( m_bTypes, bTypes, sizeof( m_bTypes ));
+		}
+
+		return value;
+	}
+
+	// measurement type of a file extension or type name (i.e. ".tmax",
+	// "tmin" or "avg"), mtMissing if it is not one
+	static CClimateTemperature::MEASURE_TYPE GetType( CString csType )
+	{
+		csType.Trim( _T( ". " ));
+		csType.MakeLower();
+		if ( csType == _T( "tmax" ) || csType == _T( "max" ))
+		{
+			return CClimateTemperature::mtMaximum;
+
+		} else if ( csType == _T( "tmin" ) || csType == _T( "min" ))
+		{
+			return CClimateTemperature::mtMinimum;
+
+		} else if ( csType == _T( "tavg" ) || csType == _T( "avg" ))
+		{
+			return CClimateTemperature::mtAverage;
+		}
+
+		return CClimateTemperature::mtMissing;
+	}
+
+	// is the measurement type of interest?
+	inline bool AcceptType( CClimateTemperature::MEASURE_TYPE eType )
+	{
+		return eType >= 0 && eType < 4 && m_bTypes[ eType ];
+	}
+
+	// is the 11 character station ID at the start of the text of interest?
+	// A station must be described in the station file to pass a state.
+	bool AcceptStation( LPCTSTR station, int nLength, CStationList& stations )
+	{
+		if ( !m_arrStations.empty() )
+		{
+			bool bFound = false;
+			for ( auto& pattern : m_arrStations )
+			{
+				if ( Matches( station, nLength, pattern ))
+				{
+					bFound = true;
+					break;
+				}
+			}
+			if ( !bFound )
+			{
+				return false;
+			}
+		}
+
+		if ( !m_arrStates.empty() )
+		{
+			const int index = stations.Find( CString( station, nLength ));
+			if ( index == -1 || !stations.Described[ index ] )
+			{
+				return false;
+			}
+
+			const WORD wState = stations.StateCode[ index ];
+			if ( find( m_arrStates.begin(), m_arrStates.end(), wState ) ==
+				m_arrStates.end() )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// can a climate file of the given type hold data of interest? Its
+	// station is the first 11 characters of the file name.
+	bool AcceptFile
+	(
+		LPCTSTR pathname, CClimateTemperature::MEASURE_TYPE eType,
+		CStationList& stations
+	)
+	{
+		const CString csStation = CHelper::GetFileName( pathname ).Left( 11 );
+		const bool value = AcceptType( eType ) &&
+			AcceptStation( csStation, csStation.GetLength(), stations );
+		if ( !value )
+		{
+			m_nFilesSkipped++;
+		}
+
+		return value;
+	}
+
+	// station files are in year order so no line after one beyond the
+	// last year can be of interest
+	inline bool IsPast( const CString& line )
+	{
+		return m_nLastYear != INT_MAX && GetLineYear( line ) > m_nLastYear;
+	}
+
+	// test the year and station of a line (columns 1 - 16) before it is
+	// decoded, false if the line is not of interest
+	bool AcceptLine( CString& line, CStationList& stations )
+	{
+		m_nLinesRead++;
+
+		const int nYear = GetLineYear( line );
+		if ( nYear < m_nFirstYear || nYear > m_nLastYear ||
+			!AcceptStation( line.GetString(), min( 11, line.GetLength() ), stations ))
+		{
+			m_nLinesRejected++;
+			return false;
+		}
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor accepts everything
+	CQueryFilter()
+	{
+		m_nFirstYear = INT_MIN;
+		m_nLastYear = INT_MAX;
+		m_bTypes[ CClimateTemperature::mtMissing ] = false;
+		m_bTypes[ CClimateTemperature::mtMaximum ] = true;
+		m_bTypes[ CClimateTemperature::mtMinimum ] = true;
+		m_bTypes[ CClimateTemperature::mtAverage ] = true;
+		m_nMinimumMonths = 0;
+		m_nFilesSkipped = 0;
+		m_nLinesRead = 0;
+		m_nLinesRejected = 0;
+	}
+
+	// destructor
+	~CQueryFilter()
+	{
+	}
+};
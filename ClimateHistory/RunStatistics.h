@@ -0,0 +1,416 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include "TraceLog.h"
+#include "ProgressLog.h"
+#include <concrt.h>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// phase timers and counters of a run broken down by thread. Each thread
+// that records anything gets its own block of totals the first time, found
+// again through a thread local pointer, so recording is a plain addition
+// to memory no other thread writes. The blocks are only summed when the
+// report is written after the work is done.
+//
+// Nothing is recorded until the statistics are enabled, a disabled timer
+// or counter costs a single test of the Enabled flag. The timeline of the
+// run kept by Trace is enabled separately, and the files counted by AddFile
+// are also posted to the progress log kept by Progress while it runs.
+class CRunStatistics
+{
+// public definitions
+public:
+	// phases the time of a run is divided into
+	typedef enum
+	{
+		spCrawl,		// directory enumeration
+		spRead,			// reading lines (ReadString)
+		spParse,		// decoding lines into station years
+		spInsert,		// adding station years to the climate years
+		spAggregate,	// column blocks, flag policy, and greater counts
+		spOutput,		// writing the selected output
+		spCount
+
+	} STATISTICS_PHASE;
+
+	// quantities counted during a run
+	typedef enum
+	{
+		scFiles,		// climate files read
+		scBytes,		// bytes of the climate files read
+		scLines,		// lines read
+		scRecords,		// station years parsed
+		scMissing,		// missing monthly readings of the station years
+		scDuplicates,	// station years the climate years already held
+		scDecoded,		// lines decoded instead of found in the parse cache
+		scBlocksScanned,	// column blocks the zone map scans visited
+		scBlocksSkipped,	// column blocks the zone maps let the scans skip
+		scCount
+
+	} STATISTICS_COUNTER;
+
+	// totals of one thread
+	typedef struct tagTHREAD_STATISTICS
+	{
+		// operating system thread ID
+		DWORD ThreadId;
+
+		// performance counter ticks spent in each phase
+		LONGLONG Ticks[ spCount ];
+
+		// number of times each phase was timed
+		LONGLONG Calls[ spCount ];
+
+		// counted quantities
+		LONGLONG Counters[ scCount ];
+
+	} THREAD_STATISTICS;
+
+	// time the enclosing scope as a phase of the calling thread
+	class CPhaseTimer
+	{
+	protected:
+		// block of the calling thread or nullptr when disabled
+		THREAD_STATISTICS* m_pThread;
+
+		// phase being timed
+		STATISTICS_PHASE m_ePhase;
+
+		// performance counter at the start of the scope
+		LONGLONG m_llStart;
+
+	public:
+		// start timing if the statistics are enabled
+		CPhaseTimer( CRunStatistics& statistics, STATISTICS_PHASE ePhase )
+		{
+			m_pThread = statistics.Enabled ? statistics.GetThread() : nullptr;
+			m_ePhase = ePhase;
+			m_llStart = m_pThread == nullptr ? 0 : CHelper::GetTicks();
+		}
+
+		// add the time of the scope to the phase
+		~CPhaseTimer()
+		{
+			if ( m_pThread != nullptr )
+			{
+				m_pThread->Ticks[ m_ePhase ] += CHelper::GetTicks() - m_llStart;
+				m_pThread->Calls[ m_ePhase ]++;
+			}
+		}
+	};
+
+// protected data
+protected:
+	// is anything being recorded?
+	bool m_bEnabled;
+
+	// changes whenever the blocks are discarded so cached pointers to
+	// them are found again
+	int m_nGeneration;
+
+	// performance counter when the statistics were enabled
+	LONGLONG m_llStart;
+
+	// blocks of every thread that recorded anything
+	vector<shared_ptr<THREAD_STATISTICS> > m_arrThreads;
+
+	// guards the list of blocks while a thread adds its own
+	concurrency::critical_section m_csThreads;
+
+	// timeline of the run
+	CTraceLog m_Trace;
+
+	// progress of the ingestion
+	CProgressLog m_Progress;
+
+// public properties
+public:
+	// is anything being recorded?
+	inline bool GetEnabled()
+	{
+		return m_bEnabled;
+	}
+	// is anything being recorded?
+	__declspec( property( get = GetEnabled ) )
+		bool Enabled;
+
+	// number of threads that recorded anything
+	inline int GetThreads()
+	{
+		return (int)m_arrThreads.size();
+	}
+	// number of threads that recorded anything
+	__declspec( property( get = GetThreads ) )
+		int Threads;
+
+	// timeline of the run
+	inline CTraceLog* GetTrace()
+	{
+		return &m_Trace;
+	}
+	// timeline of the run
+	__declspec( property( get = GetTrace ) )
+		CTraceLog* Trace;
+
+	// progress of the ingestion
+	inline CProgressLog* GetProgress()
+	{
+		return &m_Progress;
+	}
+	// progress of the ingestion
+	__declspec( property( get = GetProgress ) )
+		CProgressLog* Progress;
+
+// protected methods
+protected:
+	// the phases and counters of a block as JSON members
+	CString GetJson( const THREAD_STATISTICS& totals, double dFrequency, LPCTSTR indent )
+	{
+		CString value;
+		CString csItem;
+		value.Format( _T( "%s\"phases\": {" ), indent );
+		for ( int ePhase = 0; ePhase < spCount; ePhase++ )
+		{
+			csItem.Format
+			(
+				_T( "%s\n%s  \"%s\": { \"milliseconds\": %0.3f, \"calls\": %I64d }" ),
+				ePhase == 0 ? _T( "" ) : _T( "," ), indent,
+				GetPhaseName( ePhase ), totals.Ticks[ ePhase ] * 1000.0 / dFrequency,
+				totals.Calls[ ePhase ]
+			);
+			value += csItem;
+		}
+		csItem.Format( _T( "\n%s},\n%s\"counters\": {" ), indent, indent );
+		value += csItem;
+		for ( int eCounter = 0; eCounter < scCount; eCounter++ )
+		{
+			csItem.Format
+			(
+				_T( "%s\n%s  \"%s\": %I64d" ),
+				eCounter == 0 ? _T( "" ) : _T( "," ), indent,
+				GetCounterName( eCounter ), totals.Counters[ eCounter ]
+			);
+			value += csItem;
+		}
+
+		// the objects are estimated rather than counted: every decoded
+		// line allocates a station year and its twelve monthly
+		// temperatures (lines_decoded * 13), a line found in the parse
+		// cache shares the objects of the first and allocates none
+		csItem.Format
+		(
+			_T( ",\n%s  \"estimated_objects\": %I64d\n%s}" ), indent,
+			totals.Counters[ scDecoded ] * 13, indent
+		);
+		value += csItem;
+
+		return value;
+	}
+
+// public methods
+public:
+	// name of a phase in the report
+	static LPCTSTR GetPhaseName( int ePhase )
+	{
+		static const LPCTSTR pNames[ spCount ] =
+		{
+			_T( "crawl" ), _T( "read" ), _T( "parse" ), _T( "insert" ),
+			_T( "aggregate" ), _T( "output" )
+		};
+		return pNames[ ePhase ];
+	}
+
+	// name of a counter in the report
+	static LPCTSTR GetCounterName( int eCounter )
+	{
+		static const LPCTSTR pNames[ scCount ] =
+		{
+			_T( "files" ), _T( "bytes" ), _T( "lines" ), _T( "records" ),
+			_T( "missing_values" ), _T( "duplicates_rejected" ),
+			_T( "lines_decoded" ), _T( "blocks_scanned" ), _T( "blocks_skipped" )
+		};
+		return pNames[ eCounter ];
+	}
+
+	// block of the calling thread, added the first time the thread asks
+	THREAD_STATISTICS* GetThread()
+	{
+		return CHelper::GetThreadBlock<THREAD_STATISTICS>
+		(
+			this, m_nGeneration,
+			[this]()
+			{
+				shared_ptr<THREAD_STATISTICS> pThread =
+					shared_ptr<THREAD_STATISTICS>( new THREAD_STATISTICS );
+				ZeroMemory( pThread.get(), sizeof( THREAD_STATISTICS ));
+				pThread->ThreadId = ::GetCurrentThreadId();
+
+				concurrency::critical_section::scoped_lock lock( m_csThreads );
+				m_arrThreads.push_back( pThread );
+				return pThread.get();
+			}
+		);
+	}
+
+	// call a function as a phase of the calling thread and return its
+	// result
+	template <class FUNCTION> auto Time
+	(
+		STATISTICS_PHASE ePhase, FUNCTION function
+	) -> decltype( function() )
+	{
+		CPhaseTimer timer( *this, ePhase );
+		return function();
+	}
+
+	// read a line of a climate file as part of the read phase and count it
+	bool ReadString( CStdioFile& file, CString& csLine )
+	{
+		CPhaseTimer timer( *this, spRead );
+		if ( !file.ReadString( csLine ))
+		{
+			return false;
+		}
+
+		Add( scLines );
+		return true;
+	}
+
+	// count a climate file opened for reading and its bytes
+	void AddFile( CFile& file )
+	{
+		if ( m_bEnabled )
+		{
+			Add( scFiles );
+			Add( scBytes, (LONGLONG)file.GetLength() );
+		}
+
+		if ( m_Progress.Running )
+		{
+			m_Progress.AddFile( file.GetFileTitle(), (LONGLONG)file.GetLength() );
+		}
+	}
+
+	// count a parsed station year and its missing months
+	void AddRecord( int nValidReadings )
+	{
+		if ( m_bEnabled )
+		{
+			Add( scRecords );
+			Add( scMissing, 12 - nValidReadings );
+		}
+	}
+
+	// add to a counter of the calling thread
+	inline void Add( STATISTICS_COUNTER eCounter, LONGLONG value = 1 )
+	{
+		if ( m_bEnabled )
+		{
+			GetThread()->Counters[ eCounter ] += value;
+		}
+	}
+
+	// discard everything recorded and start or stop recording
+	void Enable( bool value )
+	{
+		concurrency::critical_section::scoped_lock lock( m_csThreads );
+		m_arrThreads.clear();
+		m_nGeneration++;
+		m_llStart = CHelper::GetTicks();
+		m_bEnabled = value;
+	}
+
+	// the sum of every thread's block
+	void GetTotals( THREAD_STATISTICS& totals )
+	{
+		ZeroMemory( &totals, sizeof( totals ));
+		for ( auto& pThread : m_arrThreads )
+		{
+			for ( int ePhase = 0; ePhase < spCount; ePhase++ )
+			{
+				totals.Ticks[ ePhase ] += pThread->Ticks[ ePhase ];
+				totals.Calls[ ePhase ] += pThread->Calls[ ePhase ];
+			}
+			for ( int eCounter = 0; eCounter < scCount; eCounter++ )
+			{
+				totals.Counters[ eCounter ] += pThread->Counters[ eCounter ];
+			}
+		}
+	}
+
+	// write the totals and the breakdown by thread as JSON, the phase
+	// times of the totals are summed over the threads so they can exceed
+	// the elapsed time when the threads ran at once
+	bool Write( LPCTSTR pathname )
+	{
+		CStdioFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+
+		LARGE_INTEGER frequency;
+		::QueryPerformanceFrequency( &frequency );
+		const double dFrequency = double( frequency.QuadPart );
+
+		THREAD_STATISTICS totals;
+		GetTotals( totals );
+
+		CString csText;
+		csText.Format
+		(
+			_T( "{\n  \"elapsed_milliseconds\": %0.3f,\n" ),
+			( CHelper::GetTicks() - m_llStart ) * 1000.0 / dFrequency
+		);
+		file.WriteString( csText );
+		file.WriteString( GetJson( totals, dFrequency, _T( "  " )));
+		file.WriteString( _T( ",\n  \"threads\": [" ));
+
+		const int nThreads = Threads;
+		for ( int index = 0; index < nThreads; index++ )
+		{
+			const THREAD_STATISTICS& thread = *m_arrThreads[ index ];
+			csText.Format
+			(
+				_T( "%s\n    {\n      \"thread_id\": %u,\n" ),
+				index == 0 ? _T( "" ) : _T( "," ), thread.ThreadId
+			);
+			file.WriteString( csText );
+			file.WriteString( GetJson( thread, dFrequency, _T( "      " )));
+			file.WriteString( _T( "\n    }" ));
+		}
+
+		file.WriteString( _T( "\n  ]\n}\n" ));
+		file.Close();
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CRunStatistics()
+	{
+		m_bEnabled = false;
+		m_nGeneration = 0;
+		m_llStart = 0;
+	}
+
+	// destructor
+	~CRunStatistics()
+	{
+	}
+};
@@ -0,0 +1,327 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ColumnBlock.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// a conjunction of simple conditions on the year, measurement type,
+// temperature and quality control flag of a station year. A row satisfies
+// the predicate when its year and type match and at least one of the
+// selected months holds a valid temperature within the (exclusive)
+// Fahrenheit bounds carrying one of the requested flags.
+//
+// The predicate can be tested against a whole block's zone maps with
+// CanSkip() before any row of the block is touched.
+class CScanPredicate
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// first year of interest (inclusive)
+	int m_nFirstYear;
+
+	// last year of interest (inclusive)
+	int m_nLastYear;
+
+	// measurement type of interest, mtMissing for all types
+	CClimateTemperature::MEASURE_TYPE m_eMeasurementType;
+
+	// month of interest (0 to 11), -1 for any month
+	int m_nMonth;
+
+	// temperatures must be above this Fahrenheit value
+	float m_fAbove;
+
+	// temperatures must be below this Fahrenheit value
+	float m_fBelow;
+
+	// quality control flags of interest, zero for any flag
+	DWORD m_dwFlagMask;
+
+	// quality control flags whose readings never match
+	DWORD m_dwExcludeMask;
+
+	// stations of interest indexed by station index, empty for any
+	vector<bool> m_arrStationMask;
+
+// public properties
+public:
+	// first year of interest (inclusive)
+	inline int GetFirstYear()
+	{
+		return m_nFirstYear;
+	}
+	// first year of interest (inclusive)
+	inline void SetFirstYear( int value )
+	{
+		m_nFirstYear = value;
+	}
+	// first year of interest (inclusive)
+	__declspec( property( get = GetFirstYear, put = SetFirstYear ) )
+		int FirstYear;
+
+	// last year of interest (inclusive)
+	inline int GetLastYear()
+	{
+		return m_nLastYear;
+	}
+	// last year of interest (inclusive)
+	inline void SetLastYear( int value )
+	{
+		m_nLastYear = value;
+	}
+	// last year of interest (inclusive)
+	__declspec( property( get = GetLastYear, put = SetLastYear ) )
+		int LastYear;
+
+	// measurement type of interest, mtMissing for all types
+	inline CClimateTemperature::MEASURE_TYPE GetMeasurementType()
+	{
+		return m_eMeasurementType;
+	}
+	// measurement type of interest, mtMissing for all types
+	inline void SetMeasurementType( CClimateTemperature::MEASURE_TYPE value )
+	{
+		m_eMeasurementType = value;
+	}
+	// measurement type of interest, mtMissing for all types
+	__declspec( property( get = GetMeasurementType, put = SetMeasurementType ) )
+		CClimateTemperature::MEASURE_TYPE MeasurementType;
+
+	// month of interest (0 to 11), -1 for any month
+	inline int GetMonth()
+	{
+		return m_nMonth;
+	}
+	// month of interest (0 to 11), -1 for any month
+	inline void SetMonth( int value )
+	{
+		m_nMonth = value;
+	}
+	// month of interest (0 to 11), -1 for any month
+	__declspec( property( get = GetMonth, put = SetMonth ) )
+		int Month;
+
+	// temperatures must be above this Fahrenheit value
+	inline float GetAbove()
+	{
+		return m_fAbove;
+	}
+	// temperatures must be above this Fahrenheit value
+	inline void SetAbove( float value )
+	{
+		m_fAbove = value;
+	}
+	// temperatures must be above this Fahrenheit value
+	__declspec( property( get = GetAbove, put = SetAbove ) )
+		float Above;
+
+	// temperatures must be below this Fahrenheit value
+	inline float GetBelow()
+	{
+		return m_fBelow;
+	}
+	// temperatures must be below this Fahrenheit value
+	inline void SetBelow( float value )
+	{
+		m_fBelow = value;
+	}
+	// temperatures must be below this Fahrenheit value
+	__declspec( property( get = GetBelow, put = SetBelow ) )
+		float Below;
+
+	// quality control flags of interest, zero for any flag
+	inline DWORD GetFlagMask()
+	{
+		return m_dwFlagMask;
+	}
+	// quality control flags of interest, zero for any flag
+	inline void SetFlagMask( DWORD value )
+	{
+		m_dwFlagMask = value;
+	}
+	// quality control flags of interest, zero for any flag
+	__declspec( property( get = GetFlagMask, put = SetFlagMask ) )
+		DWORD FlagMask;
+
+	// quality control flags whose readings never match
+	inline DWORD GetExcludeMask()
+	{
+		return m_dwExcludeMask;
+	}
+	// quality control flags whose readings never match
+	inline void SetExcludeMask( DWORD value )
+	{
+		m_dwExcludeMask = value;
+	}
+	// quality control flags whose readings never match
+	__declspec( property( get = GetExcludeMask, put = SetExcludeMask ) )
+		DWORD ExcludeMask;
+
+	// stations of interest indexed by station index, empty for any
+	// (see CStationList::SelectState, SelectElevation and GetMask)
+	inline vector<bool>& GetStationMask()
+	{
+		return m_arrStationMask;
+	}
+	// stations of interest indexed by station index, empty for any
+	// (see CStationList::SelectState, SelectElevation and GetMask)
+	inline void SetStationMask( vector<bool>& value )
+	{
+		m_arrStationMask = value;
+	}
+	// stations of interest indexed by station index, empty for any
+	// (see CStationList::SelectState, SelectElevation and GetMask)
+	__declspec( property( get = GetStationMask, put = SetStationMask ) )
+		vector<bool> StationMask;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// true when the zone maps prove no row of the block can match
+	bool CanSkip( CColumnBlock& block )
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+
+		// wrong measurement type
+		if ( MeasurementType != CClimateTemperature::mtMissing &&
+			MeasurementType != block.MeasurementType )
+		{
+			return true;
+		}
+
+		// years outside of the requested range
+		if ( !block.YearZone.CanContain( float( FirstYear ), float( LastYear )))
+		{
+			return true;
+		}
+
+		// none of the requested flags appear on a valid reading
+		if ( FlagMask != 0 && ( block.FlagMask & FlagMask ) == 0 )
+		{
+			return true;
+		}
+
+		// the zone map of the month (or all months) of interest
+		CZoneMap& zone =
+			Month < 0 ? block.ValueZone : block.GetMonthZone( Month );
+		if ( zone.Empty )
+		{
+			return true;
+		}
+
+		// the conversion to Fahrenheit is monotonic so the converted zone
+		// bounds are the bounds of the converted values
+		const float fHigh = CHelper::GetFahrenheit( zone.Maximum, fMissing );
+		const float fLow = CHelper::GetFahrenheit( zone.Minimum, fMissing );
+		if ( fHigh <= Above || fLow >= Below )
+		{
+			return true;
+		}
+
+		return false;
+	}
+
+	// does the given month of a row satisfy the temperature and
+	// flag conditions? (the year is tested by MatchesRow and the type
+	// by CanSkip)
+	inline bool MatchesMonth( CColumnBlock& block, int row, int month )
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		const float fValue = block.GetCentigrade( row, month );
+		if ( CHelper::NearlyEqual( fValue, fMissing ))
+		{
+			return false;
+		}
+
+		const float fF = CHelper::GetFahrenheit( fValue, fMissing );
+		if ( !( fF > Above && fF < Below ))
+		{
+			return false;
+		}
+
+		if ( FlagMask != 0 )
+		{
+			const TCHAR flag = block.GetFlag( row, month );
+			if (( CColumnBlock::GetFlagBit( flag ) & FlagMask ) == 0 )
+			{
+				return false;
+			}
+		}
+
+		if ( ExcludeMask != 0 &&
+			( block.GetFlagBitsColumn( month )[ row ] & ExcludeMask ) != 0 )
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	// does a row of the block satisfy the predicate?
+	bool MatchesRow( CColumnBlock& block, int row )
+	{
+		const int nYear = block.Year[ row ];
+		if ( nYear < FirstYear || nYear > LastYear )
+		{
+			return false;
+		}
+
+		if ( !m_arrStationMask.empty() )
+		{
+			const int nStation = block.StationIndex[ row ];
+			if ( nStation < 0 || nStation >= (int)m_arrStationMask.size() ||
+				!m_arrStationMask[ nStation ] )
+			{
+				return false;
+			}
+		}
+
+		if ( Month >= 0 )
+		{
+			return MatchesMonth( block, row, Month );
+		}
+
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			if ( MatchesMonth( block, row, nMonth ))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor matches every valid reading
+	CScanPredicate()
+	{
+		FirstYear = INT_MIN;
+		LastYear = INT_MAX;
+		MeasurementType = CClimateTemperature::mtMissing;
+		Month = -1;
+		Above = -FLT_MAX;
+		Below = FLT_MAX;
+		FlagMask = 0;
+		ExcludeMask = 0;
+	}
+
+	// destructor
+	~CScanPredicate()
+	{
+	}
+};
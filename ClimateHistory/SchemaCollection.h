@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "SchemaStream.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// definition of a collection (table) as described by a <Collection>
+// element of DataSchema.xml, for example:
+//
+//	<Collection Name="StationList" ... IndexKeys="Station">
+//		<Stream Name="Station" Type="VT_I1" Size="10" ... />
+//		...
+//	</Collection>
+//
+// The IndexKeys attribute names the streams whose concatenated values
+// are used to build the index of the collection.
+class CSchemaCollection
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// name of the collection
+	CString m_csName;
+
+	// description of the collection
+	CString m_csDescription;
+
+	// streams (columns) of the collection in schema order
+	vector<shared_ptr<CSchemaStream> > m_arrStreams;
+
+	// names of the streams the collection is indexed by
+	vector<CString> m_arrIndexKeys;
+
+// public properties
+public:
+	// name of the collection
+	inline CString GetName()
+	{
+		return m_csName;
+	}
+	// name of the collection
+	inline void SetName( CString value )
+	{
+		m_csName = value;
+	}
+	// name of the collection
+	__declspec( property( get = GetName, put = SetName ) )
+		CString Name;
+
+	// description of the collection
+	inline CString GetDescription()
+	{
+		return m_csDescription;
+	}
+	// description of the collection
+	inline void SetDescription( CString value )
+	{
+		m_csDescription = value;
+	}
+	// description of the collection
+	__declspec( property( get = GetDescription, put = SetDescription ) )
+		CString Description;
+
+	// streams (columns) of the collection in schema order
+	inline vector<shared_ptr<CSchemaStream> >& GetStreams()
+	{
+		return m_arrStreams;
+	}
+	// streams (columns) of the collection in schema order
+	__declspec( property( get = GetStreams ) )
+		vector<shared_ptr<CSchemaStream> > Streams;
+
+	// names of the streams the collection is indexed by
+	inline vector<CString>& GetIndexKeys()
+	{
+		return m_arrIndexKeys;
+	}
+	// names of the streams the collection is indexed by
+	__declspec( property( get = GetIndexKeys ) )
+		vector<CString> IndexKeys;
+
+	// number of bytes in an encoded index key
+	inline int GetKeySize()
+	{
+		int value = 0;
+		for ( auto& csKey : m_arrIndexKeys )
+		{
+			shared_ptr<CSchemaStream> stream = Find( csKey );
+			if ( stream != nullptr )
+			{
+				value += stream->Size;
+			}
+		}
+
+		return value;
+	}
+	// number of bytes in an encoded index key
+	__declspec( property( get = GetKeySize ) )
+		int KeySize;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// find a stream by name (case insensitive)
+	shared_ptr<CSchemaStream> Find( LPCTSTR name )
+	{
+		shared_ptr<CSchemaStream> value;
+		for ( auto& stream : m_arrStreams )
+		{
+			if ( stream->Name.CompareNoCase( name ) == 0 )
+			{
+				value = stream;
+				break;
+			}
+		}
+
+		return value;
+	}
+
+	// add a stream definition
+	void AddStream( shared_ptr<CSchemaStream> stream )
+	{
+		m_arrStreams.push_back( stream );
+	}
+
+	// set the index keys from the comma separated IndexKeys attribute
+	void SetIndexKeys( LPCTSTR keys )
+	{
+		m_arrIndexKeys.clear();
+
+		const CString csKeys( keys );
+		int nStart = 0;
+		do
+		{
+			const CString csToken = csKeys.Tokenize( _T( "," ), nStart );
+			if ( csToken.IsEmpty() )
+			{
+				break;
+			}
+
+			m_arrIndexKeys.push_back( CString( csToken ).Trim() );
+
+		} while ( true );
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CSchemaCollection()
+	{
+	}
+
+	// destructor
+	~CSchemaCollection()
+	{
+	}
+};
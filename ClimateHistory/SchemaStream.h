@@ -0,0 +1,322 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// definition of a single stream (column) of a collection as described by
+// a <Stream> element of DataSchema.xml, for example:
+//
+//	<Stream Name="Latitude" Type="VT_R4" Size="4" ... />
+//
+// A stream is persisted as a flat array of fixed size cells so the value
+// of any row is found at row * Size bytes into the stream.
+class CSchemaStream
+{
+// public definitions
+public:
+	// numbered enumeration value and its text
+	typedef pair<int, CString> ENUMERATION;
+
+// protected data
+protected:
+	// name of the stream
+	CString m_csName;
+
+	// title of the stream
+	CString m_csTitle;
+
+	// subset of VARENUM describing the data type of a cell
+	VARTYPE m_vt;
+
+	// size of a cell in bytes
+	int m_nSize;
+
+	// value representing missing data (if there is one)
+	double m_dNull;
+
+	// does the stream have a value representing missing data?
+	bool m_bHasNull;
+
+	// values of a numbered enumeration (i.e. "0,none,1,a,2,b")
+	vector<ENUMERATION> m_arrEnumeration;
+
+// public properties
+public:
+	// name of the stream
+	inline CString GetName()
+	{
+		return m_csName;
+	}
+	// name of the stream
+	inline void SetName( CString value )
+	{
+		m_csName = value;
+	}
+	// name of the stream
+	__declspec( property( get = GetName, put = SetName ) )
+		CString Name;
+
+	// title of the stream
+	inline CString GetTitle()
+	{
+		return m_csTitle;
+	}
+	// title of the stream
+	inline void SetTitle( CString value )
+	{
+		m_csTitle = value;
+	}
+	// title of the stream
+	__declspec( property( get = GetTitle, put = SetTitle ) )
+		CString Title;
+
+	// subset of VARENUM describing the data type of a cell
+	inline VARTYPE GetType()
+	{
+		return m_vt;
+	}
+	// subset of VARENUM describing the data type of a cell
+	inline void SetType( VARTYPE value )
+	{
+		m_vt = value;
+	}
+	// subset of VARENUM describing the data type of a cell
+	__declspec( property( get = GetType, put = SetType ) )
+		VARTYPE Type;
+
+	// size of a cell in bytes
+	inline int GetSize()
+	{
+		return m_nSize;
+	}
+	// size of a cell in bytes
+	inline void SetSize( int value )
+	{
+		m_nSize = value;
+	}
+	// size of a cell in bytes
+	__declspec( property( get = GetSize, put = SetSize ) )
+		int Size;
+
+	// value representing missing data (if there is one)
+	inline double GetNull()
+	{
+		return m_dNull;
+	}
+	// value representing missing data (if there is one)
+	inline void SetNull( double value )
+	{
+		m_dNull = value;
+		m_bHasNull = true;
+	}
+	// value representing missing data (if there is one)
+	__declspec( property( get = GetNull, put = SetNull ) )
+		double Null;
+
+	// does the stream have a value representing missing data?
+	inline bool GetHasNull()
+	{
+		return m_bHasNull;
+	}
+	// does the stream have a value representing missing data?
+	__declspec( property( get = GetHasNull ) )
+		bool HasNull;
+
+	// is the stream fixed length text (single byte characters)?
+	inline bool GetText()
+	{
+		return Type == VT_I1 || Type == VT_BSTR;
+	}
+	// is the stream fixed length text (single byte characters)?
+	__declspec( property( get = GetText ) )
+		bool Text;
+
+	// is the stream a floating point number?
+	inline bool GetReal()
+	{
+		return Type == VT_R4 || Type == VT_R8 || Type == VT_DATE;
+	}
+	// is the stream a floating point number?
+	__declspec( property( get = GetReal ) )
+		bool Real;
+
+	// values of a numbered enumeration
+	inline vector<ENUMERATION>& GetEnumeration()
+	{
+		return m_arrEnumeration;
+	}
+	// values of a numbered enumeration
+	__declspec( property( get = GetEnumeration ) )
+		vector<ENUMERATION> Enumeration;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// parse the Enumeration attribute of a numbered enumeration which
+	// alternates values and their text, i.e. "0,none,1,a,2,b"
+	void ParseEnumeration( LPCTSTR text )
+	{
+		m_arrEnumeration.clear();
+
+		const CString csText( text );
+		int nStart = 0;
+		do
+		{
+			const CString csValue = csText.Tokenize( _T( "," ), nStart );
+			if ( csValue.IsEmpty() )
+			{
+				break;
+			}
+
+			const CString csName = csText.Tokenize( _T( "," ), nStart );
+			if ( csName.IsEmpty() )
+			{
+				break;
+			}
+
+			m_arrEnumeration.push_back
+			(
+				ENUMERATION( _ttoi( csValue ), csName )
+			);
+
+		} while ( true );
+	}
+
+	// numbered enumeration value of a flag character where a blank
+	// flag is "none", returns zero when the character is not listed
+	int EncodeFlag( TCHAR flag )
+	{
+		CString csFlag( flag, 1 );
+		if ( flag == _T( ' ' ) || flag == 0 )
+		{
+			csFlag = _T( "none" );
+		}
+
+		// the first listing wins where the schema repeats a flag
+		for ( auto& node : m_arrEnumeration )
+		{
+			if ( node.second == csFlag )
+			{
+				return node.first;
+			}
+		}
+
+		return 0;
+	}
+
+	// flag character of a numbered enumeration value where "none" is
+	// returned as a blank
+	TCHAR DecodeFlag( int value )
+	{
+		for ( auto& node : m_arrEnumeration )
+		{
+			if ( node.first == value )
+			{
+				if ( node.second == _T( "none" ))
+				{
+					break;
+				}
+
+				return node.second[ 0 ];
+			}
+		}
+
+		return _T( ' ' );
+	}
+
+	// convert a type name from the schema (i.e. "VT_R4") to a VARTYPE
+	static VARTYPE ParseType( LPCTSTR name )
+	{
+		const CString csName = CString( name ).Trim().MakeUpper();
+
+		if ( csName == _T( "VT_I2" )) return VT_I2;
+		if ( csName == _T( "VT_I4" )) return VT_I4;
+		if ( csName == _T( "VT_R4" )) return VT_R4;
+		if ( csName == _T( "VT_R8" )) return VT_R8;
+		if ( csName == _T( "VT_DATE" )) return VT_DATE;
+		if ( csName == _T( "VT_BSTR" )) return VT_BSTR;
+		if ( csName == _T( "VT_I1" )) return VT_I1;
+		if ( csName == _T( "VT_UI1" )) return VT_UI1;
+		if ( csName == _T( "VT_UI2" )) return VT_UI2;
+		if ( csName == _T( "VT_UI4" )) return VT_UI4;
+		if ( csName == _T( "VT_I8" )) return VT_I8;
+		if ( csName == _T( "VT_UI8" )) return VT_UI8;
+
+		return VT_EMPTY;
+	}
+
+	// write a cell in a form whose bytes sort (with memcmp) in the same
+	// order as the values: text is copied as is, integers and reals are
+	// written most significant byte first with their sign bits adjusted
+	void EncodeKey( const BYTE* pCell, BYTE* pKey )
+	{
+		const int nSize = Size;
+
+		// text already compares correctly byte by byte
+		if ( Text )
+		{
+			memcpy( pKey, pCell, nSize );
+			return;
+		}
+
+		// gather the little endian cell into an unsigned integer
+		ULONGLONG bits = 0;
+		for ( int n = nSize - 1; n >= 0; n-- )
+		{
+			bits = ( bits << 8 ) | pCell[ n ];
+		}
+
+		const int nBits = nSize * 8;
+		const ULONGLONG signBit = ULONGLONG( 1 ) << ( nBits - 1 );
+		const ULONGLONG allBits =
+			nBits == 64 ? ~ULONGLONG( 0 ) : ( signBit << 1 ) - 1;
+
+		if ( Real )
+		{
+			// negative reals reverse their order, positive reals move
+			// above all of the negative values
+			bits = ( bits & signBit ) ? ( ~bits & allBits ) : ( bits | signBit );
+
+		} else if ( Type == VT_I2 || Type == VT_I4 || Type == VT_I8 )
+		{
+			// signed integers move the negative values below the positive
+			bits ^= signBit;
+		}
+
+		// most significant byte first
+		for ( int n = 0; n < nSize; n++ )
+		{
+			pKey[ n ] = BYTE( bits >> (( nSize - 1 - n ) * 8 ));
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CSchemaStream()
+	{
+		m_vt = VT_EMPTY;
+		m_nSize = 0;
+		m_dNull = 0.0;
+		m_bHasNull = false;
+	}
+
+	// destructor
+	~CSchemaStream()
+	{
+	}
+};
@@ -0,0 +1,542 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "StationList.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// latitude / longitude grid over the described stations of a station list.
+// The grid is kept as two flat arrays, the station indexes sorted by cell
+// and the first position of each cell, so the stations of a cell are a
+// contiguous run. A query only visits the cells overlapping the bounding
+// box of its search radius and measures great circle distances to the
+// stations in those cells. Queries do not modify the index so any number
+// of them can run in parallel.
+class CSpatialIndex
+{
+// public definitions
+public:
+	// distance in kilometers and station index of a neighbor
+	typedef pair<float, int> NEIGHBOR;
+
+	// latitude and longitude of a polygon vertex
+	typedef pair<float, float> VERTEX;
+
+// protected data
+protected:
+	// size of a cell in degrees
+	float m_fCellSize;
+
+	// number of rows (latitudes) of cells
+	int m_nRows;
+
+	// number of columns (longitudes) of cells
+	int m_nColumns;
+
+	// first position in m_arrCellStations of each cell plus one
+	// position past the end
+	vector<int> m_arrCellStarts;
+
+	// station indexes sorted by cell
+	vector<int> m_arrCellStations;
+
+	// latitude of each station index in radians
+	vector<double> m_arrLatitudes;
+
+	// longitude of each station index in radians
+	vector<double> m_arrLongitudes;
+
+	// cosine of the latitude of each station index
+	vector<double> m_arrCosines;
+
+	// is the station index in the grid?
+	vector<bool> m_arrIndexed;
+
+// public properties
+public:
+	// mean radius of the earth in kilometers
+	inline static double GetEarthRadius()
+	{
+		return 6371.0088;
+	}
+	// mean radius of the earth in kilometers
+	__declspec( property( get = GetEarthRadius ) )
+		double EarthRadius;
+
+	// size of a cell in degrees
+	inline float GetCellSize()
+	{
+		return m_fCellSize;
+	}
+	// size of a cell in degrees
+	__declspec( property( get = GetCellSize ) )
+		float CellSize;
+
+	// number of cells in the grid
+	inline int GetCellCount()
+	{
+		return m_nRows * m_nColumns;
+	}
+	// number of cells in the grid
+	__declspec( property( get = GetCellCount ) )
+		int CellCount;
+
+	// number of stations in the grid
+	inline int GetCount()
+	{
+		return (int)m_arrCellStations.size();
+	}
+	// number of stations in the grid
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+// protected methods
+protected:
+	// convert degrees to radians
+	static inline double GetRadians( double degrees )
+	{
+		return degrees * 3.14159265358979323846 / 180.0;
+	}
+
+	// convert radians to degrees
+	static inline double GetDegrees( double radians )
+	{
+		return radians * 180.0 / 3.14159265358979323846;
+	}
+
+	// row of the cell containing a latitude
+	inline int GetRow( double latitude )
+	{
+		const int value = int( floor(( latitude + 90.0 ) / m_fCellSize ));
+		return max( 0, min( m_nRows - 1, value ));
+	}
+
+	// column of the cell containing a longitude (wrapped to -180 to 180)
+	inline int GetColumn( double longitude )
+	{
+		while ( longitude < -180.0 )
+		{
+			longitude += 360.0;
+		}
+		while ( longitude >= 180.0 )
+		{
+			longitude -= 360.0;
+		}
+
+		const int value = int( floor(( longitude + 180.0 ) / m_fCellSize ));
+		return max( 0, min( m_nColumns - 1, value ));
+	}
+
+	// great circle distance in kilometers from a point given in radians
+	// (with the cosine of its latitude) to a station index
+	inline double GetStationDistance
+	(
+		double latitude, double longitude, double cosine, int index
+	)
+	{
+		const double dLat = m_arrLatitudes[ index ] - latitude;
+		const double dLon = m_arrLongitudes[ index ] - longitude;
+		const double dSinLat = sin( dLat / 2 );
+		const double dSinLon = sin( dLon / 2 );
+		const double a =
+			dSinLat * dSinLat + cosine * m_arrCosines[ index ] * dSinLon * dSinLon;
+		return 2 * EarthRadius * asin( min( 1.0, sqrt( a )));
+	}
+
+	// visit the stations of every cell overlapping a box of latitudes and
+	// longitudes, the longitudes may cross the date line (west > east)
+	template <class VISIT> void VisitBox
+	(
+		double south, double north, double west, double east, VISIT visit
+	)
+	{
+		if ( m_arrCellStarts.empty() )
+		{
+			return;
+		}
+
+		const int nFirstRow = GetRow( south );
+		const int nLastRow = GetRow( north );
+
+		// the columns of the box, wrapping around the date line
+		int nFirstColumn = 0;
+		int nColumns = m_nColumns;
+		if ( east - west < 360.0 )
+		{
+			nFirstColumn = GetColumn( west );
+			const int nLastColumn = GetColumn( east );
+			nColumns = nLastColumn >= nFirstColumn ?
+				nLastColumn - nFirstColumn + 1 :
+				m_nColumns - nFirstColumn + nLastColumn + 1;
+		}
+
+		for ( int nRow = nFirstRow; nRow <= nLastRow; nRow++ )
+		{
+			for ( int n = 0; n < nColumns; n++ )
+			{
+				const int nCell = nRow * m_nColumns + ( nFirstColumn + n ) % m_nColumns;
+				const int nEnd = m_arrCellStarts[ nCell + 1 ];
+				for ( int pos = m_arrCellStarts[ nCell ]; pos < nEnd; pos++ )
+				{
+					visit( m_arrCellStations[ pos ] );
+				}
+			}
+		}
+	}
+
+	// the stations within a distance of a point in no particular order
+	void Gather
+	(
+		float latitude, float longitude, float fKilometers,
+		vector<NEIGHBOR>& neighbors
+	)
+	{
+		const double dLat = GetRadians( latitude );
+		const double dLon = GetRadians( longitude );
+		const double dCos = cos( dLat );
+
+		// degrees of latitude covered by the radius and the degrees of
+		// longitude at the widest latitude within the radius
+		const double dDegrees = GetDegrees( fKilometers / EarthRadius );
+		const double dSouth = latitude - dDegrees;
+		const double dNorth = latitude + dDegrees;
+		const double dWidest = max( fabs( dSouth ), fabs( dNorth ));
+
+		double dWest = -180.0;
+		double dEast = 180.0;
+		if ( dWidest < 89.0 )
+		{
+			const double dSpan = min( 180.0, dDegrees / cos( GetRadians( dWidest )));
+			if ( dSpan < 180.0 )
+			{
+				dWest = longitude - dSpan;
+				dEast = longitude + dSpan;
+			}
+		}
+
+		VisitBox
+		(
+			dSouth, dNorth, dWest, dEast,
+			[&]( int index )
+			{
+				const double dDistance = GetStationDistance( dLat, dLon, dCos, index );
+				if ( dDistance <= fKilometers )
+				{
+					neighbors.push_back( NEIGHBOR( (float)dDistance, index ));
+				}
+			}
+		);
+	}
+
+// public methods
+public:
+	// build the grid from the described stations of a station list
+	void Build( CStationList& stations, float fCellSize = 1.0f )
+	{
+		m_fCellSize = fCellSize;
+		m_nRows = (int)ceil( 180.0 / fCellSize );
+		m_nColumns = (int)ceil( 360.0 / fCellSize );
+
+		const int nStations = stations.Count;
+		m_arrLatitudes.assign( nStations, 0.0 );
+		m_arrLongitudes.assign( nStations, 0.0 );
+		m_arrCosines.assign( nStations, 0.0 );
+		m_arrIndexed.assign( nStations, false );
+
+		// count the stations of each cell
+		vector<int> arrCells( nStations, -1 );
+		m_arrCellStarts.assign( CellCount + 1, 0 );
+		for ( int index = 0; index < nStations; index++ )
+		{
+			if ( !stations.Described[ index ] )
+			{
+				continue;
+			}
+
+			const float fLat = stations.Latitude[ index ];
+			const float fLon = stations.Longitude[ index ];
+			m_arrLatitudes[ index ] = GetRadians( fLat );
+			m_arrLongitudes[ index ] = GetRadians( fLon );
+			m_arrCosines[ index ] = cos( m_arrLatitudes[ index ] );
+			m_arrIndexed[ index ] = true;
+
+			arrCells[ index ] = GetRow( fLat ) * m_nColumns + GetColumn( fLon );
+			m_arrCellStarts[ arrCells[ index ] + 1 ]++;
+		}
+
+		// running totals become the first position of each cell
+		for ( int nCell = 0; nCell < CellCount; nCell++ )
+		{
+			m_arrCellStarts[ nCell + 1 ] += m_arrCellStarts[ nCell ];
+		}
+
+		m_arrCellStations.assign( m_arrCellStarts[ CellCount ], -1 );
+		vector<int> arrNext( m_arrCellStarts.begin(), m_arrCellStarts.end() - 1 );
+		for ( int index = 0; index < nStations; index++ )
+		{
+			if ( arrCells[ index ] != -1 )
+			{
+				m_arrCellStations[ arrNext[ arrCells[ index ] ]++ ] = index;
+			}
+		}
+	}
+
+	// great circle (haversine) distance in kilometers between two points
+	// given in degrees
+	static double GetDistance
+	(
+		double lat1, double lon1, double lat2, double lon2
+	)
+	{
+		const double dLat = GetRadians( lat2 - lat1 );
+		const double dLon = GetRadians( lon2 - lon1 );
+		const double dSinLat = sin( dLat / 2 );
+		const double dSinLon = sin( dLon / 2 );
+		const double a =
+			dSinLat * dSinLat +
+			cos( GetRadians( lat1 )) * cos( GetRadians( lat2 )) * dSinLon * dSinLon;
+		return 2 * GetEarthRadius() * asin( min( 1.0, sqrt( a )));
+	}
+
+	// the stations within a distance of a point, nearest first
+	void Within
+	(
+		float latitude, float longitude, float fKilometers,
+		vector<NEIGHBOR>& neighbors
+	)
+	{
+		neighbors.clear();
+		Gather( latitude, longitude, fKilometers, neighbors );
+		sort( neighbors.begin(), neighbors.end() );
+	}
+
+	// the k nearest stations to a point that are no further than the
+	// given distance, nearest first
+	void Nearest
+	(
+		float latitude, float longitude, int k, float fKilometers,
+		vector<NEIGHBOR>& neighbors
+	)
+	{
+		neighbors.clear();
+		if ( k <= 0 || Count == 0 )
+		{
+			return;
+		}
+
+		// grow the radius until it holds k stations (or the limit) so
+		// only nearby cells are visited, no station outside the radius
+		// can be nearer than one inside it
+		const float fLimit = min( fKilometers, float( EarthRadius * 3.15 ));
+		float fRadius = min( fLimit, float( m_fCellSize * 111.0 ));
+		do
+		{
+			neighbors.clear();
+			Gather( latitude, longitude, fRadius, neighbors );
+			if ( (int)neighbors.size() >= k || fRadius >= fLimit )
+			{
+				break;
+			}
+			fRadius = min( fLimit, fRadius * 2 );
+
+		} while ( true );
+
+		const int nKeep = min( k, (int)neighbors.size() );
+		partial_sort( neighbors.begin(), neighbors.begin() + nKeep, neighbors.end() );
+		neighbors.resize( nKeep );
+	}
+
+	// the k nearest neighbors of a station index within the given
+	// distance, the station itself is excluded
+	void Nearest
+	(
+		int index, int k, float fKilometers, vector<NEIGHBOR>& neighbors
+	)
+	{
+		neighbors.clear();
+		if ( index < 0 || index >= (int)m_arrIndexed.size() || !m_arrIndexed[ index ] )
+		{
+			return;
+		}
+
+		const float fLat = float( GetDegrees( m_arrLatitudes[ index ] ));
+		const float fLon = float( GetDegrees( m_arrLongitudes[ index ] ));
+		Nearest( fLat, fLon, k + 1, fKilometers, neighbors );
+
+		auto pos = find_if
+		(
+			neighbors.begin(), neighbors.end(),
+			[&]( NEIGHBOR& neighbor ) { return neighbor.second == index; }
+		);
+		if ( pos != neighbors.end() )
+		{
+			neighbors.erase( pos );
+
+		} else if ( (int)neighbors.size() > k )
+		{
+			neighbors.resize( k );
+		}
+	}
+
+	// the stations inside a box of latitudes and longitudes in degrees,
+	// the box crosses the date line when west is greater than east
+	void InBox
+	(
+		float south, float north, float west, float east, vector<int>& indexes
+	)
+	{
+		const bool bWrap = west > east;
+		VisitBox
+		(
+			south, north, west, bWrap ? east + 360.0 : east,
+			[&]( int index )
+			{
+				const double dLat = GetDegrees( m_arrLatitudes[ index ] );
+				const double dLon = GetDegrees( m_arrLongitudes[ index ] );
+				const bool bLon = bWrap ?
+					dLon >= west || dLon <= east : dLon >= west && dLon <= east;
+				if ( bLon && dLat >= south && dLat <= north )
+				{
+					indexes.push_back( index );
+				}
+			}
+		);
+	}
+
+	// the stations inside a polygon of latitude / longitude vertices
+	// (even-odd rule, the polygon may not cross the date line)
+	void InPolygon( vector<VERTEX>& polygon, vector<int>& indexes )
+	{
+		if ( polygon.size() < 3 )
+		{
+			return;
+		}
+
+		float fSouth = FLT_MAX;
+		float fNorth = -FLT_MAX;
+		float fWest = FLT_MAX;
+		float fEast = -FLT_MAX;
+		for ( auto& vertex : polygon )
+		{
+			fSouth = min( fSouth, vertex.first );
+			fNorth = max( fNorth, vertex.first );
+			fWest = min( fWest, vertex.second );
+			fEast = max( fEast, vertex.second );
+		}
+
+		vector<int> candidates;
+		InBox( fSouth, fNorth, fWest, fEast, candidates );
+
+		const size_t nVertices = polygon.size();
+		for ( int index : candidates )
+		{
+			const double y = GetDegrees( m_arrLatitudes[ index ] );
+			const double x = GetDegrees( m_arrLongitudes[ index ] );
+
+			// count the edges a ray to the east crosses
+			bool bInside = false;
+			for ( size_t i = 0, j = nVertices - 1; i < nVertices; j = i++ )
+			{
+				const double yi = polygon[ i ].first;
+				const double xi = polygon[ i ].second;
+				const double yj = polygon[ j ].first;
+				const double xj = polygon[ j ].second;
+				if (( yi > y ) != ( yj > y ) &&
+					x < ( xj - xi ) * ( y - yi ) / ( yj - yi ) + xi )
+				{
+					bInside = !bInside;
+				}
+			}
+
+			if ( bInside )
+			{
+				indexes.push_back( index );
+			}
+		}
+	}
+
+	// the stations in the cell containing a point
+	void InCell( float latitude, float longitude, vector<int>& indexes )
+	{
+		if ( m_arrCellStarts.empty() )
+		{
+			return;
+		}
+
+		const int nCell = GetRow( latitude ) * m_nColumns + GetColumn( longitude );
+		indexes.insert
+		(
+			indexes.end(),
+			m_arrCellStations.begin() + m_arrCellStarts[ nCell ],
+			m_arrCellStations.begin() + m_arrCellStarts[ nCell + 1 ]
+		);
+	}
+
+	// number of stations in each cell that holds any, keyed by the
+	// latitude and longitude of the cell's south west corner
+	void GetCellCounts( vector<pair<VERTEX, int> >& counts )
+	{
+		for ( int nCell = 0; nCell < (int)m_arrCellStarts.size() - 1; nCell++ )
+		{
+			const int nCount = m_arrCellStarts[ nCell + 1 ] - m_arrCellStarts[ nCell ];
+			if ( nCount == 0 )
+			{
+				continue;
+			}
+
+			const float fLat = ( nCell / m_nColumns ) * m_fCellSize - 90.0f;
+			const float fLon = ( nCell % m_nColumns ) * m_fCellSize - 180.0f;
+			counts.push_back( pair<VERTEX, int>( VERTEX( fLat, fLon ), nCount ));
+		}
+	}
+
+	// the k nearest neighbors within the given distance of every station
+	// index, computed in parallel (lists of stations that are not in the
+	// grid are empty)
+	void GetNeighborLists
+	(
+		int k, float fKilometers, vector<vector<NEIGHBOR> >& lists
+	)
+	{
+		const int nStations = (int)m_arrIndexed.size();
+		lists.assign( nStations, vector<NEIGHBOR>() );
+
+		concurrency::parallel_for
+		(
+			0, nStations,
+			[&]( int index )
+			{
+				Nearest( index, k, fKilometers, lists[ index ] );
+			}
+		);
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CSpatialIndex()
+	{
+		m_fCellSize = 1.0f;
+		m_nRows = 0;
+		m_nColumns = 0;
+	}
+
+	// destructor
+	~CSpatialIndex()
+	{
+	}
+};
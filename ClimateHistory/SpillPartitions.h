@@ -0,0 +1,546 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateYear.h"
+#include "KeyedCollection.h"
+#include "RunStatistics.h"
+#include <concrt.h>
+#include <functional>
+#include <map>
+#include <math.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// out of core processing of the station years for data sets larger than
+// memory (--mem-limit). Instead of being added to the climate years, each
+// parsed station year is written as a line of text into the partition of
+// its decade:
+//
+//	type index station year and months in the USHCN layout
+//	1 1204 USH00011084 1900 -9999    -9999   ...  2067a 3
+//
+// The lines are buffered in memory and every buffer is appended to its
+// partition's spill file whenever the buffers reach the limit. The parse
+// cache is not enabled with --mem-limit so a station year is let go of
+// once its line is buffered. Once the files are read,
+// the partitions are aggregated in parallel, as many at once as fit in
+// the limit: a partition's lines are parsed back into climate years of
+// its own, aggregated by the caller, and reduced to the values of each
+// year before they are merged into the result.
+//
+// A year is never split between partitions and the lines of a partition
+// stay in the order they were parsed, so the first of duplicate station
+// years is kept and every year is aggregated from the same station years
+// as when everything is held in memory.
+class CSpillPartitions
+{
+// public definitions
+public:
+	// a decade of station years
+	typedef struct tagSPILL_PARTITION
+	{
+		// first year of the decade
+		int FirstYear;
+
+		// spill file (blank until the first spill)
+		CString Pathname;
+
+		// lines not yet spilled
+		CString Buffer;
+
+		// station years of the partition
+		int Records;
+
+	} SPILL_PARTITION;
+
+	// aggregates the climate years of one partition
+	typedef function<void( CKeyedCollection<CString, CClimateYear>& )> PARTITION_CALLBACK;
+
+// protected data
+protected:
+	// bytes the station years may hold (0 when not active)
+	LONGLONG m_llLimit;
+
+	// folder of the spill files
+	CString m_csFolder;
+
+	// partitions by first year
+	map<int, SPILL_PARTITION> m_mapPartitions;
+
+	// bytes held by the buffers since the last spill
+	LONGLONG m_llHeld;
+
+	// times the buffers were spilled
+	int m_nSpills;
+
+	// bytes written to the spill files
+	LONGLONG m_llSpilled;
+
+	// station years added
+	int m_nRecords;
+
+	// groups of partitions aggregated at once
+	int m_nBatches;
+
+	// did a spill file fail to be written or read?
+	bool m_bFailed;
+
+// public properties
+public:
+	// are the station years being spilled?
+	inline bool GetActive()
+	{
+		return m_llLimit > 0;
+	}
+	// are the station years being spilled?
+	__declspec( property( get = GetActive ) )
+		bool Active;
+
+	// bytes the station years may hold (0 when not active)
+	inline LONGLONG GetLimit()
+	{
+		return m_llLimit;
+	}
+	// bytes the station years may hold (0 when not active)
+	__declspec( property( get = GetLimit ) )
+		LONGLONG Limit;
+
+	// years in each partition
+	static inline int GetSpan()
+	{
+		return 10;
+	}
+	// years in each partition
+	__declspec( property( get = GetSpan ) )
+		int Span;
+
+	// estimated heap bytes of a parsed station year: the object, its
+	// twelve temperatures with their control blocks, and its map node
+	static inline LONGLONG GetRecordBytes()
+	{
+		return
+			sizeof( CStationYear ) + 12 * ( sizeof( CClimateTemperature ) +
+			sizeof( shared_ptr<CClimateTemperature> ) + 48 ) + 128;
+	}
+	// estimated heap bytes of a parsed station year: the object, its
+	// twelve temperatures with their control blocks, and its map node
+	__declspec( property( get = GetRecordBytes ) )
+		LONGLONG RecordBytes;
+
+	// estimated heap bytes of a station year while its partition is
+	// aggregated: the line read back from the spill file (under 136
+	// characters), the parsed station year, and its row of the column
+	// blocks the partition callback builds
+	static inline LONGLONG GetAggregateBytes()
+	{
+		return
+			136 * sizeof( TCHAR ) + 32 + GetRecordBytes() +
+			12 * ( sizeof( float ) + sizeof( TCHAR ) + sizeof( DWORD )) + 16;
+	}
+	// estimated heap bytes of a station year while its partition is
+	// aggregated: the line read back from the spill file (under 136
+	// characters), the parsed station year, and its row of the column
+	// blocks the partition callback builds
+	__declspec( property( get = GetAggregateBytes ) )
+		LONGLONG AggregateBytes;
+
+	// folder of the spill files
+	inline CString GetFolder()
+	{
+		return m_csFolder;
+	}
+	// folder of the spill files
+	__declspec( property( get = GetFolder ) )
+		CString Folder;
+
+	// number of partitions
+	inline int GetPartitions()
+	{
+		return (int)m_mapPartitions.size();
+	}
+	// number of partitions
+	__declspec( property( get = GetPartitions ) )
+		int Partitions;
+
+	// station years added
+	inline int GetRecords()
+	{
+		return m_nRecords;
+	}
+	// station years added
+	__declspec( property( get = GetRecords ) )
+		int Records;
+
+	// times the buffers were spilled
+	inline int GetSpills()
+	{
+		return m_nSpills;
+	}
+	// times the buffers were spilled
+	__declspec( property( get = GetSpills ) )
+		int Spills;
+
+	// bytes written to the spill files
+	inline LONGLONG GetSpilledBytes()
+	{
+		return m_llSpilled;
+	}
+	// bytes written to the spill files
+	__declspec( property( get = GetSpilledBytes ) )
+		LONGLONG SpilledBytes;
+
+	// groups of partitions aggregated at once
+	inline int GetBatches()
+	{
+		return m_nBatches;
+	}
+	// groups of partitions aggregated at once
+	__declspec( property( get = GetBatches ) )
+		int Batches;
+
+	// did a spill file fail to be written or read?
+	inline bool GetFailed()
+	{
+		return m_bFailed;
+	}
+	// did a spill file fail to be written or read?
+	__declspec( property( get = GetFailed ) )
+		bool Failed;
+
+// protected methods
+protected:
+	// the line of a station year with its type and station index ahead of
+	// the USHCN layout, values are in hundredths of a degree centigrade
+	static CString GetRecord( CStationYear& StationYear )
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+
+		CString value;
+		value.Format
+		(
+			_T( "%d %d %-11s %s" ), (int)StationYear.MeasurementType,
+			StationYear.StationIndex, StationYear.Station, StationYear.Year
+		);
+
+		CString csMonth;
+		const int nMonths = StationYear.MonthCount;
+		for ( int nMonth = 0; nMonth < 12; nMonth++ )
+		{
+			int nValue = int( fMissing );
+			CString csFlags( _T( "   " ));
+			if ( nMonth < nMonths )
+			{
+				shared_ptr<CClimateTemperature> pMonth = StationYear.Month[ nMonth ];
+				const float fValue = pMonth->Centigrade;
+				if ( !CHelper::NearlyEqual( fValue, fMissing ))
+				{
+					nValue = int( floor( fValue * 100.0f + 0.5f ));
+				}
+
+				const CString csFlag[ 3 ] =
+				{
+					pMonth->DataMeasurementFlag, pMonth->QualityControlFlag,
+					pMonth->DataSourceFlag
+				};
+				for ( int n = 0; n < 3; n++ )
+				{
+					if ( !csFlag[ n ].IsEmpty() )
+					{
+						csFlags.SetAt( n, csFlag[ n ][ 0 ] );
+					}
+				}
+			}
+
+			csMonth.Format( _T( "%6d%s" ), nValue, csFlags );
+			value += csMonth;
+		}
+
+		return value;
+	}
+
+	// parse a line written by GetRecord back into a station year
+	static shared_ptr<CStationYear> ParseRecord( CString& record )
+	{
+		int nStart = 0;
+		const CString csType = record.Tokenize( _T( " " ), nStart );
+		const CString csIndex = record.Tokenize( _T( " " ), nStart );
+		CString csSource = record.Mid( nStart );
+
+		shared_ptr<CStationYear> value = shared_ptr<CStationYear>
+		(
+			new CStationYear
+			(
+				csSource, (CClimateTemperature::MEASURE_TYPE)_ttoi( csType )
+			)
+		);
+		value->StationIndex = _ttoi( csIndex );
+		return value;
+	}
+
+	// append every buffer to its spill file, a buffer that cannot be
+	// written is kept in memory
+	void Spill()
+	{
+		for ( auto& node : m_mapPartitions )
+		{
+			SPILL_PARTITION& partition = node.second;
+			if ( partition.Buffer.IsEmpty() )
+			{
+				continue;
+			}
+
+			if ( partition.Pathname.IsEmpty() )
+			{
+				partition.Pathname.Format
+				(
+					_T( "%s\\%04d.spill" ), m_csFolder, partition.FirstYear
+				);
+			}
+
+			CFile file;
+			const UINT nFlags =
+				CFile::modeCreate | CFile::modeNoTruncate | CFile::modeWrite;
+			if ( !file.Open( partition.Pathname, nFlags ))
+			{
+				m_bFailed = true;
+				continue;
+			}
+			file.SeekToEnd();
+			file.Write( partition.Buffer, partition.Buffer.GetLength() );
+			file.Close();
+
+			m_llSpilled += partition.Buffer.GetLength();
+			partition.Buffer.Empty();
+		}
+
+		m_llHeld = 0;
+		m_nSpills++;
+	}
+
+	// parse the lines of a partition into climate years of its own
+	// leaving out the station years with fewer valid months than the
+	// minimum, false if its spill file cannot be read
+	bool ReadPartition
+	(
+		SPILL_PARTITION& partition, CKeyedCollection<CString, CClimateYear>& ClimateYears,
+		CRunStatistics& statistics, int nMinimumMonths
+	)
+	{
+		vector<CString> arrRecords;
+		if ( !partition.Pathname.IsEmpty() )
+		{
+			CStdioFile file;
+			if ( !file.Open( partition.Pathname, CFile::modeRead | CFile::shareDenyNone ))
+			{
+				return false;
+			}
+
+			CString csLine;
+			while ( statistics.ReadString( file, csLine ))
+			{
+				arrRecords.push_back( csLine );
+			}
+			file.Close();
+		}
+
+		// the lines still buffered follow the spilled ones
+		int nStart = 0;
+		CString csLine = partition.Buffer.Tokenize( _T( "\n" ), nStart );
+		while ( nStart != -1 )
+		{
+			arrRecords.push_back( csLine );
+			csLine = partition.Buffer.Tokenize( _T( "\n" ), nStart );
+		}
+		partition.Buffer.Empty();
+
+		CRunStatistics::CPhaseTimer timer( statistics, CRunStatistics::spInsert );
+		for ( auto& record : arrRecords )
+		{
+			shared_ptr<CStationYear> StationYear = ParseRecord( record );
+			const CString csYear = StationYear->Year;
+			shared_ptr<CClimateYear> ClimateYear = ClimateYears.find( csYear );
+			if ( ClimateYear == nullptr )
+			{
+				ClimateYear = shared_ptr<CClimateYear>( new CClimateYear );
+				ClimateYear->Year = csYear;
+				ClimateYears.add( csYear, ClimateYear );
+			}
+
+			if ( !ClimateYear->WriteStationYear( StationYear, nMinimumMonths ))
+			{
+				statistics.Add( CRunStatistics::scDuplicates );
+			}
+		}
+
+		return true;
+	}
+
+// public methods
+public:
+	// start spilling the station years into a new folder under the
+	// temporary folder once they hold the given bytes
+	bool Start( LONGLONG llLimit )
+	{
+		TCHAR pBuffer[ _MAX_PATH ];
+		::GetTempPath( _MAX_PATH, pBuffer );
+		m_csFolder.Format
+		(
+			_T( "%sClimateHistory\\Spill-%u" ), pBuffer, ::GetCurrentProcessId()
+		);
+		if ( !CHelper::CreatePath( m_csFolder ) &&
+			::GetFileAttributes( m_csFolder ) == INVALID_FILE_ATTRIBUTES )
+		{
+			return false;
+		}
+
+		m_mapPartitions.clear();
+		m_llLimit = llLimit;
+		m_llHeld = 0;
+		m_nSpills = 0;
+		m_llSpilled = 0;
+		m_nRecords = 0;
+		m_nBatches = 0;
+		m_bFailed = false;
+		return true;
+	}
+
+	// add a station year to the buffer of its partition and spill the
+	// buffers when they reach the limit
+	void Add( shared_ptr<CStationYear>& StationYear )
+	{
+		const int nYear = _ttoi( StationYear->Year );
+		const int nFirst = nYear - nYear % Span;
+		auto pos = m_mapPartitions.find( nFirst );
+		if ( pos == m_mapPartitions.end() )
+		{
+			SPILL_PARTITION value;
+			value.FirstYear = nFirst;
+			value.Records = 0;
+			pos = m_mapPartitions.insert( make_pair( nFirst, value )).first;
+		}
+		SPILL_PARTITION& partition = pos->second;
+
+		const CString csRecord = GetRecord( *StationYear );
+		partition.Buffer += csRecord;
+		partition.Buffer += _T( '\n' );
+		partition.Records++;
+		m_nRecords++;
+
+		// the buffered line is all that is held of the station year
+		m_llHeld += ( csRecord.GetLength() + 1 ) * sizeof( TCHAR );
+		if ( m_llHeld >= m_llLimit )
+		{
+			Spill();
+		}
+	}
+
+	// aggregate the partitions in parallel, as many at once as the limit
+	// allows, and add the values of their years to the climate years,
+	// false if a spill file cannot be read
+	bool Aggregate
+	(
+		CKeyedCollection<CString, CClimateYear>& ClimateYears,
+		CRunStatistics& statistics, int nMinimumMonths,
+		PARTITION_CALLBACK callback
+	)
+	{
+		vector<SPILL_PARTITION*> arrPartitions;
+		for ( auto& node : m_mapPartitions )
+		{
+			arrPartitions.push_back( &node.second );
+		}
+
+		concurrency::critical_section csMerge;
+		const int nPartitions = (int)arrPartitions.size();
+		int nFirst = 0;
+		while ( nFirst < nPartitions )
+		{
+			// the partitions of a batch fit in the limit together
+			int nLast = nFirst + 1;
+			LONGLONG llBytes = arrPartitions[ nFirst ]->Records * AggregateBytes;
+			while ( nLast < nPartitions )
+			{
+				llBytes += arrPartitions[ nLast ]->Records * AggregateBytes;
+				if ( llBytes > m_llLimit )
+				{
+					break;
+				}
+				nLast++;
+			}
+
+			concurrency::parallel_for
+			(
+				nFirst, nLast,
+				[&]( int index )
+				{
+					SPILL_PARTITION& partition = *arrPartitions[ index ];
+					CKeyedCollection<CString, CClimateYear> years;
+					const bool bRead = ReadPartition
+					(
+						partition, years, statistics, nMinimumMonths
+					);
+					callback( years );
+					for ( auto& node : years.Items )
+					{
+						node.second->Release();
+					}
+
+					concurrency::critical_section::scoped_lock lock( csMerge );
+					if ( !bRead )
+					{
+						m_bFailed = true;
+					}
+					for ( auto& node : years.Items )
+					{
+						ClimateYears.add( node.first, node.second );
+					}
+				}
+			);
+
+			m_nBatches++;
+			nFirst = nLast;
+		}
+
+		// the spill files are not needed once their years are aggregated
+		for ( SPILL_PARTITION* pPartition : arrPartitions )
+		{
+			if ( !pPartition->Pathname.IsEmpty() )
+			{
+				::DeleteFile( pPartition->Pathname );
+			}
+		}
+		::RemoveDirectory( m_csFolder );
+
+		return !m_bFailed;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CSpillPartitions()
+	{
+		m_llLimit = 0;
+		m_llHeld = 0;
+		m_nSpills = 0;
+		m_llSpilled = 0;
+		m_nRecords = 0;
+		m_nBatches = 0;
+		m_bFailed = false;
+	}
+
+	// destructor
+	~CSpillPartitions()
+	{
+	}
+};
@@ -0,0 +1,447 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// station metadata read from the ushcn-v2.5-stations.txt file and kept in
+// columns indexed by a dense station index. The index is shared with the
+// temperature data (CStationYear::StationIndex) so joining a reading to
+// its station is an array access, and the state and elevation columns can
+// be filtered without any string work per station.
+//
+// Fragment of readme.txt describing the station file:
+//
+//	Variable          Columns      Type
+//	--------          -------      ----
+//
+//	ID                 1-11        Character
+//	LATITUDE          13-20        Real
+//	LONGITUDE         22-30        Real
+//	ELEVATION         32-37        Real
+//	STATE             39-40        Character
+//	NAME              42-71        Character
+//	COMPONENT 1       73-78        Character
+//	COMPONENT 2       80-85        Character
+//	COMPONENT 3       87-92        Character
+//	UTC OFFSET        94-95        Integer
+//
+//	ELEVATION is in meters (missing = -999.9)
+//
+// The GHCN-Monthly version 4 inventory (a .inv file) has the same first
+// four columns followed by the name and no state:
+//
+//	NAME              39-68        Character
+//
+class CStationList
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// dense station index keyed by the packed station ID
+	unordered_map<ULONGLONG, int> m_mapIndexes;
+
+	// station IDs (columns 1 - 11)
+	vector<CString> m_arrStations;
+
+	// latitudes in degrees (columns 13 - 20)
+	vector<float> m_arrLatitudes;
+
+	// longitudes in degrees (columns 22 - 30)
+	vector<float> m_arrLongitudes;
+
+	// elevations in meters or ElevationMissing (columns 32 - 37)
+	vector<float> m_arrElevations;
+
+	// two character state codes packed into a WORD (columns 39 - 40)
+	vector<WORD> m_arrStates;
+
+	// station location names (columns 42 - 71)
+	vector<CString> m_arrLocations;
+
+	// coop IDs of the component stations (columns 73 - 92)
+	vector<CString> m_arrComponents[ 3 ];
+
+	// hours from UTC (columns 94 - 95)
+	vector<short> m_arrOffsets;
+
+	// is there metadata for the station?
+	vector<bool> m_arrDescribed;
+
+// public properties
+public:
+	// elevation value which indicates missing data
+	inline static float GetElevationMissing()
+	{
+		return -999.9f;
+	}
+	// elevation value which indicates missing data
+	__declspec( property( get = GetElevationMissing ) )
+		float ElevationMissing;
+
+	// number of stations
+	inline int GetCount()
+	{
+		return (int)m_arrStations.size();
+	}
+	// number of stations
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+	// station ID of a station index
+	inline CString GetStation( int index )
+	{
+		return m_arrStations[ index ];
+	}
+	// station ID of a station index
+	__declspec( property( get = GetStation ) )
+		CString Station[];
+
+	// latitude in degrees of a station index
+	inline float GetLatitude( int index )
+	{
+		return m_arrLatitudes[ index ];
+	}
+	// latitude in degrees of a station index
+	__declspec( property( get = GetLatitude ) )
+		float Latitude[];
+
+	// longitude in degrees of a station index
+	inline float GetLongitude( int index )
+	{
+		return m_arrLongitudes[ index ];
+	}
+	// longitude in degrees of a station index
+	__declspec( property( get = GetLongitude ) )
+		float Longitude[];
+
+	// elevation in meters of a station index
+	inline float GetElevation( int index )
+	{
+		return m_arrElevations[ index ];
+	}
+	// elevation in meters of a station index
+	__declspec( property( get = GetElevation ) )
+		float Elevation[];
+
+	// packed state code of a station index
+	inline WORD GetStateCode( int index )
+	{
+		return m_arrStates[ index ];
+	}
+	// packed state code of a station index
+	__declspec( property( get = GetStateCode ) )
+		WORD StateCode[];
+
+	// two character state of a station index
+	inline CString GetState( int index )
+	{
+		const WORD wState = m_arrStates[ index ];
+		CString value;
+		if ( wState != 0 )
+		{
+			value.Format( _T( "%c%c" ), TCHAR( wState >> 8 ), TCHAR( wState & 0xff ));
+		}
+		return value;
+	}
+	// two character state of a station index
+	__declspec( property( get = GetState ) )
+		CString State[];
+
+	// location name of a station index
+	inline CString GetLocation( int index )
+	{
+		return m_arrLocations[ index ];
+	}
+	// location name of a station index
+	__declspec( property( get = GetLocation ) )
+		CString Location[];
+
+	// hours from UTC of a station index
+	inline short GetOffsetUTC( int index )
+	{
+		return m_arrOffsets[ index ];
+	}
+	// hours from UTC of a station index
+	__declspec( property( get = GetOffsetUTC ) )
+		short OffsetUTC[];
+
+	// was the station described by the station file?
+	inline bool GetDescribed( int index )
+	{
+		return m_arrDescribed[ index ];
+	}
+	// was the station described by the station file?
+	__declspec( property( get = GetDescribed ) )
+		bool Described[];
+
+// protected methods
+protected:
+	// value of a base 37 digit (0-9, A-Z, and everything else)
+	static inline ULONGLONG GetDigit( TCHAR ch )
+	{
+		if ( ch >= _T( '0' ) && ch <= _T( '9' ))
+		{
+			return ch - _T( '0' );
+		}
+		ch = (TCHAR)_totupper( ch );
+		if ( ch >= _T( 'A' ) && ch <= _T( 'Z' ))
+		{
+			return 10 + ch - _T( 'A' );
+		}
+		return 36;
+	}
+
+	// text of the given one based inclusive columns, trimmed
+	static CString GetColumns( const CString& line, int nFirst, int nLast )
+	{
+		CString value = line.Mid( nFirst - 1, nLast - nFirst + 1 );
+		return value.Trim();
+	}
+
+// public methods
+public:
+	// pack an 11 character station ID into a 64-bit key, 37 ^ 11 is less
+	// than 2 ^ 64 so every alphanumeric ID has its own key
+	static ULONGLONG GetKey( LPCTSTR station )
+	{
+		ULONGLONG value = 0;
+		for ( int n = 0; n < 11; n++ )
+		{
+			const TCHAR ch = station[ n ];
+			if ( ch == 0 )
+			{
+				break;
+			}
+			value = value * 37 + GetDigit( ch );
+		}
+
+		return value;
+	}
+
+	// pack a two character state into a WORD
+	static WORD PackState( LPCTSTR state )
+	{
+		if ( state == nullptr || state[ 0 ] == 0 || state[ 1 ] == 0 )
+		{
+			return 0;
+		}
+
+		return WORD(( BYTE( _totupper( state[ 0 ] )) << 8 ) | BYTE( _totupper( state[ 1 ] )));
+	}
+
+	// station index of a station ID or -1 if the station is unknown
+	int Find( LPCTSTR station )
+	{
+		auto pos = m_mapIndexes.find( GetKey( station ));
+		if ( pos == m_mapIndexes.end() )
+		{
+			return -1;
+		}
+
+		return pos->second;
+	}
+
+	// station index of a station ID, stations that are not in the station
+	// file are added without metadata so every reading has an index
+	int Add( LPCTSTR station )
+	{
+		const ULONGLONG ullKey = GetKey( station );
+		auto pos = m_mapIndexes.find( ullKey );
+		if ( pos != m_mapIndexes.end() )
+		{
+			return pos->second;
+		}
+
+		const int value = Count;
+		m_mapIndexes[ ullKey ] = value;
+		m_arrStations.push_back( station );
+		m_arrLatitudes.push_back( 0.0f );
+		m_arrLongitudes.push_back( 0.0f );
+		m_arrElevations.push_back( ElevationMissing );
+		m_arrStates.push_back( 0 );
+		m_arrLocations.push_back( CString() );
+		for ( auto& arrComponents : m_arrComponents )
+		{
+			arrComponents.push_back( CString() );
+		}
+		m_arrOffsets.push_back( 0 );
+		m_arrDescribed.push_back( false );
+
+		return value;
+	}
+
+	// coop ID of a component station (0 to 2) of a station index
+	CString GetComponent( int index, int component )
+	{
+		return m_arrComponents[ component ][ index ];
+	}
+
+	// parse a single line of the station file
+	int ParseLine( const CString& line )
+	{
+		const CString csStation = GetColumns( line, 1, 11 );
+		if ( csStation.GetLength() != 11 )
+		{
+			return -1;
+		}
+
+		const int value = Add( csStation );
+		m_arrLatitudes[ value ] = (float)_tstof( GetColumns( line, 13, 20 ));
+		m_arrLongitudes[ value ] = (float)_tstof( GetColumns( line, 22, 30 ));
+
+		const CString csElevation = GetColumns( line, 32, 37 );
+		m_arrElevations[ value ] = csElevation.IsEmpty() ?
+			ElevationMissing : (float)_tstof( csElevation );
+
+		m_arrStates[ value ] = PackState( GetColumns( line, 39, 40 ));
+		m_arrLocations[ value ] = GetColumns( line, 42, 71 );
+		m_arrComponents[ 0 ][ value ] = GetColumns( line, 73, 78 );
+		m_arrComponents[ 1 ][ value ] = GetColumns( line, 80, 85 );
+		m_arrComponents[ 2 ][ value ] = GetColumns( line, 87, 92 );
+		m_arrOffsets[ value ] = (short)_ttoi( GetColumns( line, 94, 95 ));
+		m_arrDescribed[ value ] = true;
+
+		return value;
+	}
+
+	// parse a single line of a GHCN-Monthly inventory
+	int ParseInventoryLine( const CString& line )
+	{
+		const CString csStation = GetColumns( line, 1, 11 );
+		if ( csStation.GetLength() != 11 )
+		{
+			return -1;
+		}
+
+		const int value = Add( csStation );
+		m_arrLatitudes[ value ] = (float)_tstof( GetColumns( line, 13, 20 ));
+		m_arrLongitudes[ value ] = (float)_tstof( GetColumns( line, 22, 30 ));
+
+		const CString csElevation = GetColumns( line, 32, 37 );
+		m_arrElevations[ value ] = csElevation.IsEmpty() ?
+			ElevationMissing : (float)_tstof( csElevation );
+
+		m_arrLocations[ value ] = GetColumns( line, 39, 68 );
+		m_arrDescribed[ value ] = true;
+
+		return value;
+	}
+
+	// read the station file and return the number of stations described,
+	// a .inv extension is read as a GHCN-Monthly inventory
+	int Load( LPCTSTR pathname )
+	{
+		int value = 0;
+		const bool bInventory =
+			CHelper::GetExtension( pathname ).MakeLower() == _T( ".inv" );
+
+		CStdioFile file;
+		if ( !file.Open( pathname, CFile::modeRead | CFile::shareDenyNone ))
+		{
+			return value;
+		}
+
+		CString csLine;
+		while ( file.ReadString( csLine ))
+		{
+			const int index =
+				bInventory ? ParseInventoryLine( csLine ) : ParseLine( csLine );
+			if ( index != -1 )
+			{
+				value++;
+			}
+		}
+		file.Close();
+
+		return value;
+	}
+
+	// indexes of the stations in the given state
+	void SelectState( LPCTSTR state, vector<int>& indexes )
+	{
+		const WORD wState = PackState( state );
+		const int nCount = Count;
+		for ( int index = 0; index < nCount; index++ )
+		{
+			if ( m_arrStates[ index ] == wState )
+			{
+				indexes.push_back( index );
+			}
+		}
+	}
+
+	// indexes of the stations between the given elevations (inclusive),
+	// stations without an elevation are never selected
+	void SelectElevation( float fLow, float fHigh, vector<int>& indexes )
+	{
+		const float fMissing = ElevationMissing;
+		const int nCount = Count;
+		for ( int index = 0; index < nCount; index++ )
+		{
+			const float fElevation = m_arrElevations[ index ];
+			if ( CHelper::NearlyEqual( fElevation, fMissing ))
+			{
+				continue;
+			}
+			if ( fElevation >= fLow && fElevation <= fHigh )
+			{
+				indexes.push_back( index );
+			}
+		}
+	}
+
+	// mark the given station indexes in a mask indexed by station index
+	void GetMask( vector<int>& indexes, vector<bool>& mask )
+	{
+		mask.assign( Count, false );
+		for ( int index : indexes )
+		{
+			mask[ index ] = true;
+		}
+	}
+
+	// remove all stations
+	void Clear()
+	{
+		m_mapIndexes.clear();
+		m_arrStations.clear();
+		m_arrLatitudes.clear();
+		m_arrLongitudes.clear();
+		m_arrElevations.clear();
+		m_arrStates.clear();
+		m_arrLocations.clear();
+		for ( auto& arrComponents : m_arrComponents )
+		{
+			arrComponents.clear();
+		}
+		m_arrOffsets.clear();
+		m_arrDescribed.clear();
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CStationList()
+	{
+	}
+
+	// destructor
+	~CStationList()
+	{
+	}
+};
@@ -94,8 +94,11 @@ protected:
 	// the second number is the number of temperatures greater than the first number
 	vector<GREATER_COUNT> m_GreaterCounts;
 
-	// number of valid readings
-	int m_nValidReadings;
+	// one bit for each month (bit 0 is January) with a valid reading
+	WORD m_wValidMask;
+
+	// dense index of the station in the station list (-1 if not indexed)
+	int m_nStationIndex;
 
 // public properties
 public:
@@ -231,8 +234,22 @@ public:
 		} else if ( month == nMonths )
 		{
 			m_arrMonths.push_back( value );
+
+		} else
+		{
+			return;
 		}
 
+		// keep the month's bit of the validity mask current
+		const WORD wBit = WORD( 1 << month );
+		if ( value->Missing )
+		{
+			m_wValidMask &= ~wBit;
+
+		} else
+		{
+			m_wValidMask |= wBit;
+		}
 	}
 	// monthly data is indexed from 0 to 11 (Jan to Dec)
 	__declspec( property( get = GetMonth, put = SetMonth ) )
@@ -460,39 +477,65 @@ public:
 	// number of valid readings
 	inline int GetValidReadings()
 	{
-		int value = m_nValidReadings;
-
-		// if the current value is -1, calculate it
-		if ( value == -1 )
-		{
-			// begin with zero readings
-			value = 0;
-
-			// sum up the valid readings from each month
-			for ( auto& node : m_arrMonths )
-			{
-				if ( !node->Missing )
-				{
-					value++;
-				}
-			}
-		}
+		const int value = CountMonths( m_wValidMask );
 
 		ASSERT( value >= 0 && value <= 12 );
 
-		// persist the reading
-		ValidReadings = value;
-
 		return value;
 	}
 	// number of valid readings
-	inline void SetValidReadings( int value )
+	__declspec( property( get = GetValidReadings ))
+		int ValidReadings;
+
+	// one bit for each month (bit 0 is January) with a valid reading
+	inline WORD GetValidMask()
 	{
-		m_nValidReadings = value;
+		return m_wValidMask;
 	}
-	// number of valid readings
-	__declspec( property( get = GetValidReadings, put = SetValidReadings ))
-		int ValidReadings;
+	// one bit for each month (bit 0 is January) with a valid reading
+	__declspec( property( get = GetValidMask ))
+		WORD ValidMask;
+
+	// number of months held
+	inline int GetMonthCount()
+	{
+		return (int)m_arrMonths.size();
+	}
+	// number of months held
+	__declspec( property( get = GetMonthCount ))
+		int MonthCount;
+
+	// number of month pointers the month vector has room for
+	inline int GetMonthCapacity()
+	{
+		return (int)m_arrMonths.capacity();
+	}
+	// number of month pointers the month vector has room for
+	__declspec( property( get = GetMonthCapacity ))
+		int MonthCapacity;
+
+	// number of pairs the greater count vector has room for
+	inline int GetGreaterCapacity()
+	{
+		return (int)m_GreaterCounts.capacity();
+	}
+	// number of pairs the greater count vector has room for
+	__declspec( property( get = GetGreaterCapacity ))
+		int GreaterCapacity;
+
+	// dense index of the station in the station list (-1 if not indexed)
+	inline int GetStationIndex()
+	{
+		return m_nStationIndex;
+	}
+	// dense index of the station in the station list (-1 if not indexed)
+	inline void SetStationIndex( int value )
+	{
+		m_nStationIndex = value;
+	}
+	// dense index of the station in the station list (-1 if not indexed)
+	__declspec( property( get = GetStationIndex, put = SetStationIndex ))
+		int StationIndex;
 
 	// array of Greater Than pairs
 	// first number is the Fahrenheit temperature 
@@ -566,6 +609,42 @@ protected:
 
 // public methods
 public:
+	// number of bits set in a validity mask, the bits are summed in pairs,
+	// then nibbles, then bytes instead of one month at a time
+	static inline int CountMonths( WORD wMask )
+	{
+		DWORD value = wMask - (( wMask >> 1 ) & 0x5555 );
+		value = ( value & 0x3333 ) + (( value >> 2 ) & 0x3333 );
+		value = ( value + ( value >> 4 )) & 0x0F0F;
+		return int(( value + ( value >> 8 )) & 0x1F );
+	}
+
+	// do both station years hold the same readings and flags for every
+	// month? (i.e. a row that an adjusted dataset left unchanged)
+	bool SameReadings( CStationYear& other )
+	{
+		if ( MeasurementType != other.MeasurementType ||
+			m_arrMonths.size() != other.m_arrMonths.size() )
+		{
+			return false;
+		}
+
+		const int nMonths = (int)m_arrMonths.size();
+		for ( int nMonth = 0; nMonth < nMonths; nMonth++ )
+		{
+			shared_ptr<CClimateTemperature>& pMonth = m_arrMonths[ nMonth ];
+			shared_ptr<CClimateTemperature>& pOther = other.m_arrMonths[ nMonth ];
+			if ( pMonth->Centigrade != pOther->Centigrade ||
+				pMonth->DataMeasurementFlag != pOther->DataMeasurementFlag ||
+				pMonth->QualityControlFlag != pOther->QualityControlFlag ||
+				pMonth->DataSourceFlag != pOther->DataSourceFlag )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
 
 // protected overrides
 protected:
@@ -584,11 +663,14 @@ public:
 		// initialize the value to missing to force a calculation
 		Value = fMissing;
 
-		// number of valid readings
-		ValidReadings = -1;
+		// the months set the validity mask as they are parsed
+		m_wValidMask = 0;
 
 		// mark the object and undefined
 		MeasurementType = CClimateTemperature::mtMissing;
+
+		// the station list assigns the index
+		StationIndex = -1;
 	}
 
 	// constructor using a source line of text and the measurement type
@@ -600,12 +682,15 @@ public:
 		// initialize the value to missing to force a calculation
 		Value = fMissing;
 
-		// number of valid readings
-		ValidReadings = -1;
+		// the months set the validity mask as they are parsed
+		m_wValidMask = 0;
 
 		// record the measurement type
 		MeasurementType = eType;
 
+		// the station list assigns the index
+		StationIndex = -1;
+
 		// parse single line of stations text file into properties
 		ParseSource( source );
 
@@ -0,0 +1,276 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <concrt.h>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// a timeline of the run in the Chrome Trace Event format, which Perfetto
+// and about:tracing display with a row for every thread. A scope adds a
+// begin event when it opens and an end event when it closes.
+//
+// Every thread appends its events to its own buffer, found again through
+// a thread local pointer, so recording an event takes no lock and never
+// waits on another thread. The buffers are only read when the trace is
+// written at the end of the run. Event names are string literals so an
+// event only copies a pointer unless it carries a detail such as a file
+// name.
+class CTraceLog
+{
+// public definitions
+public:
+	// one begin or end event
+	typedef struct tagTRACE_EVENT
+	{
+		// name of the event (a string literal)
+		LPCTSTR Name;
+
+		// 'B' for begin or 'E' for end
+		char Phase;
+
+		// performance counter when the event happened
+		LONGLONG Ticks;
+
+		// optional detail shown with a begin event (i.e. the file name)
+		CString Detail;
+
+	} TRACE_EVENT;
+
+	// the events of one thread
+	typedef struct tagTRACE_THREAD
+	{
+		// operating system thread ID
+		DWORD ThreadId;
+
+		// events in the order they happened
+		vector<TRACE_EVENT> Events;
+
+	} TRACE_THREAD;
+
+	// record the enclosing scope as a begin and end event
+	class CTraceScope
+	{
+	protected:
+		// trace being recorded or nullptr when disabled
+		CTraceLog* m_pTrace;
+
+		// name of the event
+		LPCTSTR m_pName;
+
+	public:
+		// add the begin event if the trace is enabled
+		CTraceScope( CTraceLog* pTrace, LPCTSTR name, LPCTSTR detail = nullptr )
+		{
+			m_pTrace = pTrace != nullptr && pTrace->Enabled ? pTrace : nullptr;
+			m_pName = name;
+			if ( m_pTrace != nullptr )
+			{
+				m_pTrace->Add( name, 'B', detail );
+			}
+		}
+
+		// add the end event
+		~CTraceScope()
+		{
+			if ( m_pTrace != nullptr )
+			{
+				m_pTrace->Add( m_pName, 'E', nullptr );
+			}
+		}
+	};
+
+// protected data
+protected:
+	// are events being recorded?
+	bool m_bEnabled;
+
+	// changes whenever the buffers are discarded so cached pointers to
+	// them are found again
+	int m_nGeneration;
+
+	// performance counter when the trace was enabled
+	LONGLONG m_llStart;
+
+	// thread that enabled the trace
+	DWORD m_dwThreadId;
+
+	// buffers of every thread that recorded an event
+	vector<shared_ptr<TRACE_THREAD> > m_arrThreads;
+
+	// guards the list of buffers while a thread adds its own
+	concurrency::critical_section m_csThreads;
+
+// public properties
+public:
+	// are events being recorded?
+	inline bool GetEnabled()
+	{
+		return m_bEnabled;
+	}
+	// are events being recorded?
+	__declspec( property( get = GetEnabled ) )
+		bool Enabled;
+
+	// number of events recorded by every thread
+	inline int GetEvents()
+	{
+		int value = 0;
+		for ( auto& pThread : m_arrThreads )
+		{
+			value += (int)pThread->Events.size();
+		}
+
+		return value;
+	}
+	// number of events recorded by every thread
+	__declspec( property( get = GetEvents ) )
+		int Events;
+
+// protected methods
+protected:
+	// buffer of the calling thread, added the first time the thread asks
+	TRACE_THREAD* GetThread()
+	{
+		return CHelper::GetThreadBlock<TRACE_THREAD>
+		(
+			this, m_nGeneration,
+			[this]()
+			{
+				shared_ptr<TRACE_THREAD> pThread =
+					shared_ptr<TRACE_THREAD>( new TRACE_THREAD );
+				pThread->ThreadId = ::GetCurrentThreadId();
+				pThread->Events.reserve( 4096 );
+
+				concurrency::critical_section::scoped_lock lock( m_csThreads );
+				m_arrThreads.push_back( pThread );
+				return pThread.get();
+			}
+		);
+	}
+
+	// append an event to the calling thread's buffer
+	void Add( LPCTSTR name, char chPhase, LPCTSTR detail )
+	{
+		TRACE_THREAD* pThread = GetThread();
+		pThread->Events.push_back( TRACE_EVENT() );
+		TRACE_EVENT& event = pThread->Events.back();
+		event.Name = name;
+		event.Phase = chPhase;
+		if ( detail != nullptr )
+		{
+			event.Detail = detail;
+		}
+		event.Ticks = CHelper::GetTicks();
+	}
+
+// public methods
+public:
+	// discard every event and start or stop recording
+	void Enable( bool value )
+	{
+		concurrency::critical_section::scoped_lock lock( m_csThreads );
+		m_arrThreads.clear();
+		m_nGeneration++;
+		m_llStart = CHelper::GetTicks();
+		m_dwThreadId = ::GetCurrentThreadId();
+		m_bEnabled = value;
+	}
+
+	// write every thread's events as a JSON trace with the times in
+	// microseconds from when the trace was enabled, the thread that
+	// enabled the trace is named "main" and the others by their order
+	bool Write( LPCTSTR pathname )
+	{
+		CStdioFile file;
+		if ( !file.Open( pathname, CFile::modeCreate | CFile::modeWrite ))
+		{
+			return false;
+		}
+
+		LARGE_INTEGER frequency;
+		::QueryPerformanceFrequency( &frequency );
+		const double dMicroseconds = 1000000.0 / frequency.QuadPart;
+		const DWORD dwProcess = ::GetCurrentProcessId();
+
+		file.WriteString( _T( "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [" ));
+
+		CString csText;
+		bool bFirst = true;
+		int nWorker = 0;
+		for ( auto& pThread : m_arrThreads )
+		{
+			const TRACE_THREAD& thread = *pThread;
+
+			CString csName( _T( "main" ));
+			if ( thread.ThreadId != m_dwThreadId )
+			{
+				csName.Format( _T( "worker %d" ), ++nWorker );
+			}
+			csText.Format
+			(
+				_T( "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u," )
+				_T( "\"tid\":%u,\"args\":{\"name\":\"%s\"}}" ),
+				bFirst ? _T( "" ) : _T( "," ), dwProcess, thread.ThreadId,
+				csName
+			);
+			file.WriteString( csText );
+			bFirst = false;
+
+			for ( auto& event : thread.Events )
+			{
+				csText.Format
+				(
+					_T( ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%0.3f," )
+					_T( "\"pid\":%u,\"tid\":%u" ),
+					event.Name, event.Phase,
+					( event.Ticks - m_llStart ) * dMicroseconds, dwProcess,
+					thread.ThreadId
+				);
+				file.WriteString( csText );
+				if ( !event.Detail.IsEmpty() )
+				{
+					csText.Format
+					(
+						_T( ",\"args\":{\"detail\":%s}" ),
+						CHelper::GetJsonString( event.Detail )
+					);
+					file.WriteString( csText );
+				}
+				file.WriteString( _T( "}" ));
+			}
+		}
+
+		file.WriteString( _T( "\n]\n}\n" ));
+		file.Close();
+
+		return true;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CTraceLog()
+	{
+		m_bEnabled = false;
+		m_nGeneration = 0;
+		m_llStart = 0;
+		m_dwThreadId = 0;
+	}
+
+	// destructor
+	~CTraceLog()
+	{
+	}
+};
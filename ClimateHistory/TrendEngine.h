@@ -0,0 +1,289 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "ClimateTable.h"
+#include <algorithm>
+#include <math.h>
+#include <ppl.h>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////
+// ordinary least squares trend of the annual means of every station and
+// measurement type. The fit only needs the sums of x, y, x*x, x*y and y*y
+// over a window of years, so each series is turned into running (prefix)
+// sums once and the sums of any window are the difference of two entries
+// found by binary search. Fitting several windows of the same series costs
+// O(log n) each instead of a pass over the data, and the stations are
+// fitted in parallel.
+class CTrendEngine
+{
+// public definitions
+public:
+	// year and annual mean in degrees centigrade
+	typedef pair<int, float> YEAR_MEAN;
+
+	// fitted trend of one station, measurement type and window
+	typedef struct tagTREND
+	{
+		int Station; // station index
+		CClimateTemperature::MEASURE_TYPE Type;
+		int FirstYear; // first year of the window (inclusive)
+		int LastYear; // last year of the window (inclusive)
+		int Years; // number of annual means in the window
+		float Slope; // degrees Fahrenheit per decade
+		float StandardError; // of the slope in degrees Fahrenheit per decade
+
+	} TREND;
+
+	// first and last years (inclusive) of a window to fit
+	typedef pair<int, int> WINDOW;
+
+// protected data
+protected:
+	// fewest valid months needed for an annual mean
+	int m_nMinimumMonths;
+
+	// annual means of each station index indexed by measurement type
+	vector<vector<YEAR_MEAN> > m_arrSeries[ 4 ];
+
+// public properties
+public:
+	// fewest valid months needed for an annual mean
+	inline int GetMinimumMonths()
+	{
+		return m_nMinimumMonths;
+	}
+	// fewest valid months needed for an annual mean
+	inline void SetMinimumMonths( int value )
+	{
+		m_nMinimumMonths = value;
+	}
+	// fewest valid months needed for an annual mean
+	__declspec( property( get = GetMinimumMonths, put = SetMinimumMonths ) )
+		int MinimumMonths;
+
+	// number of station indexes with series
+	inline int GetStations()
+	{
+		return (int)m_arrSeries[ CClimateTemperature::mtMaximum ].size();
+	}
+	// number of station indexes with series
+	__declspec( property( get = GetStations ) )
+		int Stations;
+
+// protected methods
+protected:
+	// least squares fit of the prefix sums between two positions
+	// (first inclusive, last exclusive)
+	static void FitWindow
+	(
+		vector<double>& sums, int nFirst, int nLast, TREND& trend
+	)
+	{
+		// each prefix holds x, y, x*x, x*y and y*y
+		const double* pLast = &sums[ nLast * 5 ];
+		const double* pFirst = &sums[ nFirst * 5 ];
+		const double n = nLast - nFirst;
+		const double dX = pLast[ 0 ] - pFirst[ 0 ];
+		const double dY = pLast[ 1 ] - pFirst[ 1 ];
+		const double dXX = pLast[ 2 ] - pFirst[ 2 ];
+		const double dXY = pLast[ 3 ] - pFirst[ 3 ];
+		const double dYY = pLast[ 4 ] - pFirst[ 4 ];
+
+		const double dSxx = dXX - dX * dX / n;
+		const double dSxy = dXY - dX * dY / n;
+		const double dSyy = dYY - dY * dY / n;
+		if ( dSxx <= 0.0 )
+		{
+			return;
+		}
+
+		const double dSlope = dSxy / dSxx;
+		const double dResiduals = max( 0.0, dSyy - dSlope * dSxy );
+		const double dError = sqrt( dResiduals / ( n - 2 ) / dSxx );
+
+		// degrees centigrade per year to degrees Fahrenheit per decade
+		trend.Slope = float( dSlope * 18.0 );
+		trend.StandardError = float( dError * 18.0 );
+	}
+
+	// fit the windows of one series
+	void FitSeries
+	(
+		int nStation, CClimateTemperature::MEASURE_TYPE eType,
+		vector<WINDOW>& windows, vector<double>& sums, vector<TREND>& trends
+	)
+	{
+		vector<YEAR_MEAN>& series = m_arrSeries[ eType ][ nStation ];
+		const int nPoints = (int)series.size();
+		if ( nPoints < 3 )
+		{
+			return;
+		}
+
+		// x is measured from the first year to keep the sums small
+		const int nBase = series[ 0 ].first;
+		sums.assign(( nPoints + 1 ) * 5, 0.0 );
+		for ( int n = 0; n < nPoints; n++ )
+		{
+			const double x = series[ n ].first - nBase;
+			const double y = series[ n ].second;
+			const double* pPrior = &sums[ n * 5 ];
+			double* pNext = &sums[( n + 1 ) * 5 ];
+			pNext[ 0 ] = pPrior[ 0 ] + x;
+			pNext[ 1 ] = pPrior[ 1 ] + y;
+			pNext[ 2 ] = pPrior[ 2 ] + x * x;
+			pNext[ 3 ] = pPrior[ 3 ] + x * y;
+			pNext[ 4 ] = pPrior[ 4 ] + y * y;
+		}
+
+		for ( auto& window : windows )
+		{
+			const int nFirst = int( lower_bound
+			(
+				series.begin(), series.end(), YEAR_MEAN( window.first, -FLT_MAX )
+			) - series.begin() );
+			const int nLast = int( upper_bound
+			(
+				series.begin(), series.end(), YEAR_MEAN( window.second, FLT_MAX )
+			) - series.begin() );
+			if ( nLast - nFirst < 3 )
+			{
+				continue;
+			}
+
+			TREND trend;
+			trend.Station = nStation;
+			trend.Type = eType;
+			trend.FirstYear = window.first;
+			trend.LastYear = window.second;
+			trend.Years = nLast - nFirst;
+			trend.Slope = 0.0f;
+			trend.StandardError = 0.0f;
+			FitWindow( sums, nFirst, nLast, trend );
+			trends.push_back( trend );
+		}
+	}
+
+// public methods
+public:
+	// gather the annual means of every station from the month columns
+	void Build( CClimateTable& table, int nStations )
+	{
+		const float fMissing = CClimateTemperature::GetMissingValue();
+		for ( auto& series : m_arrSeries )
+		{
+			series.assign( nStations, vector<YEAR_MEAN>() );
+		}
+
+		vector<double> sums;
+		vector<int> counts;
+		for ( auto& block : table.Blocks )
+		{
+			const int nRows = block->Rows;
+			sums.assign( nRows, 0.0 );
+			counts.assign( nRows, 0 );
+
+			// the coverage of a row is the population count of its mask
+			const WORD* pMasks = block->GetValidMaskColumn();
+			for ( int row = 0; row < nRows; row++ )
+			{
+				counts[ row ] = CStationYear::CountMonths( pMasks[ row ] );
+			}
+
+			// one contiguous month column at a time
+			for ( int nMonth = 0; nMonth < 12; nMonth++ )
+			{
+				const float* pValues = block->GetMonthColumn( nMonth );
+				for ( int row = 0; row < nRows; row++ )
+				{
+					// valid readings are all far above the missing value
+					if ( pValues[ row ] > fMissing )
+					{
+						sums[ row ] += pValues[ row ];
+					}
+				}
+			}
+
+			vector<vector<YEAR_MEAN> >& series = m_arrSeries[ block->MeasurementType ];
+			for ( int row = 0; row < nRows; row++ )
+			{
+				const int nStation = block->StationIndex[ row ];
+				if ( nStation < 0 || nStation >= nStations ||
+					counts[ row ] < MinimumMonths || counts[ row ] == 0 )
+				{
+					continue;
+				}
+
+				series[ nStation ].push_back
+				(
+					YEAR_MEAN( block->Year[ row ], float( sums[ row ] / counts[ row ] ))
+				);
+			}
+		}
+
+		// the table is in year order already, but nothing depends on it
+		for ( auto& types : m_arrSeries )
+		{
+			for ( auto& series : types )
+			{
+				sort( series.begin(), series.end() );
+			}
+		}
+	}
+
+	// fit every station, measurement type and window in parallel and
+	// return the trends in station index order
+	void Fit( vector<WINDOW>& windows, vector<TREND>& trends )
+	{
+		const int nStations = Stations;
+		vector<vector<TREND> > arrTrends( nStations );
+
+		concurrency::parallel_for
+		(
+			0, nStations,
+			[&]( int nStation )
+			{
+				vector<double> sums;
+				for ( int nType = CClimateTemperature::mtMaximum;
+					nType <= CClimateTemperature::mtAverage; nType++ )
+				{
+					FitSeries
+					(
+						nStation, CClimateTemperature::MEASURE_TYPE( nType ),
+						windows, sums, arrTrends[ nStation ]
+					);
+				}
+			}
+		);
+
+		trends.clear();
+		for ( auto& station : arrTrends )
+		{
+			trends.insert( trends.end(), station.begin(), station.end() );
+		}
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CTrendEngine()
+	{
+		MinimumMonths = 10;
+	}
+
+	// destructor
+	~CTrendEngine()
+	{
+	}
+};
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright  2022 by W. T. Block, all rights reserved
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "CHelper.h"
+#include <float.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// minimum, maximum and valid value count of a single column within a
+// block of rows. A scan can compare a predicate against these statistics
+// and skip the entire block when none of its rows could possibly satisfy
+// the predicate.
+class CZoneMap
+{
+// public definitions
+public:
+
+// protected data
+protected:
+	// value which indicates missing data
+	float m_fMissing;
+
+	// smallest valid value in the block
+	float m_fMinimum;
+
+	// largest valid value in the block
+	float m_fMaximum;
+
+	// number of valid (non-missing) values in the block
+	int m_nValidCount;
+
+	// number of values in the block including missing values
+	int m_nCount;
+
+// public properties
+public:
+	// value which indicates missing data
+	inline float GetMissingValue()
+	{
+		return m_fMissing;
+	}
+	// value which indicates missing data
+	inline void SetMissingValue( float value )
+	{
+		m_fMissing = value;
+	}
+	// value which indicates missing data
+	__declspec( property( get = GetMissingValue, put = SetMissingValue ) )
+		float MissingValue;
+
+	// smallest valid value in the block
+	inline float GetMinimum()
+	{
+		return m_fMinimum;
+	}
+	// smallest valid value in the block
+	__declspec( property( get = GetMinimum ) )
+		float Minimum;
+
+	// largest valid value in the block
+	inline float GetMaximum()
+	{
+		return m_fMaximum;
+	}
+	// largest valid value in the block
+	__declspec( property( get = GetMaximum ) )
+		float Maximum;
+
+	// number of valid (non-missing) values in the block
+	inline int GetValidCount()
+	{
+		return m_nValidCount;
+	}
+	// number of valid (non-missing) values in the block
+	__declspec( property( get = GetValidCount ) )
+		int ValidCount;
+
+	// number of values in the block including missing values
+	inline int GetCount()
+	{
+		return m_nCount;
+	}
+	// number of values in the block including missing values
+	__declspec( property( get = GetCount ) )
+		int Count;
+
+	// true if the block has no valid values at all
+	inline bool GetEmpty()
+	{
+		return m_nValidCount == 0;
+	}
+	// true if the block has no valid values at all
+	__declspec( property( get = GetEmpty ) )
+		bool Empty;
+
+// protected methods
+protected:
+
+// public methods
+public:
+	// reset the statistics to an empty block
+	void Clear()
+	{
+		m_fMinimum = FLT_MAX;
+		m_fMaximum = -FLT_MAX;
+		m_nValidCount = 0;
+		m_nCount = 0;
+	}
+
+	// fold a single value into the statistics
+	inline void Update( float value )
+	{
+		m_nCount++;
+
+		// missing values only contribute to the total count
+		if ( CHelper::NearlyEqual( value, m_fMissing ))
+		{
+			return;
+		}
+
+		m_nValidCount++;
+		m_fMinimum = min( m_fMinimum, value );
+		m_fMaximum = max( m_fMaximum, value );
+	}
+
+	// fold the statistics of another block into this one
+	void Merge( CZoneMap& other )
+	{
+		m_nCount += other.Count;
+		if ( other.Empty )
+		{
+			return;
+		}
+
+		m_nValidCount += other.ValidCount;
+		m_fMinimum = min( m_fMinimum, other.Minimum );
+		m_fMaximum = max( m_fMaximum, other.Maximum );
+	}
+
+	// can any valid value in the block fall within the inclusive range?
+	inline bool CanContain( float fLow, float fHigh )
+	{
+		if ( Empty )
+		{
+			return false;
+		}
+
+		return !( m_fMaximum < fLow || m_fMinimum > fHigh );
+	}
+
+	// restore statistics that were read back from a persisted zone map
+	void Restore( float fMinimum, float fMaximum, int nValid, int nCount )
+	{
+		m_fMinimum = fMinimum;
+		m_fMaximum = fMaximum;
+		m_nValidCount = nValid;
+		m_nCount = nCount;
+	}
+
+// protected overrides
+protected:
+
+// public overrides
+public:
+
+// public constructor
+public:
+	// default constructor
+	CZoneMap()
+	{
+		MissingValue = -9999.0f;
+		Clear();
+	}
+
+	// constructor given the value which indicates missing data
+	CZoneMap( float fMissing )
+	{
+		MissingValue = fMissing;
+		Clear();
+	}
+
+	// destructor
+	~CZoneMap()
+	{
+	}
+};